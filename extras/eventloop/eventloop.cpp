@@ -0,0 +1,209 @@
+// Loop iteration and wakeup benchmark for BlinkerEventLoop.
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++11 -O2 -Isrc extras/eventloop/eventloop.cpp src/Blinker/BlinkerEventLoop.cpp -o eventloop
+//   ./eventloop [seconds] [us per loop]
+//
+// A device runs the MQTT loop for an hour of simulated time. The loop
+// handles broker messages, the ping before BLINKER_MQTT_PING_TIMEOUT, the
+// heartbeat and an optional 1 s sketch ticker.
+// - "polling" is run() without BLINKER_IDLE_SLEEP: loop() spins, every
+//   iteration polls.
+// - "idle sleep" is BlinkerApi::idle() with BLINKER_IDLE_SLEEP. Each
+//   iteration takes the signalled events, registers the deadlines and
+//   sleeps for idleFor().
+// delay() isn't cut short by incoming data, so a message that arrives
+// during a sleep waits for the wakeup. The latency columns show that cost.
+//
+// Each row shows loop iterations and wakeups a second, the share of time
+// awake and the message latency.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Blinker/BlinkerEventLoop.h"
+
+#define SIM_PING_TIMEOUT    30000UL     // BLINKER_MQTT_PING_TIMEOUT
+#define SIM_HEARTBEAT       600000UL    // BLINKER_DEVICE_HEARTBEAT_TIME
+#define SIM_TICKER          1000UL
+
+static uint32_t sim_rand()
+{
+    static uint32_t x = 2463534242UL;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return x;
+}
+
+struct SimResult
+{
+    uint64_t                iterations;
+    uint64_t                wakeups;
+    uint64_t                awake;      // us
+    std::vector<uint32_t>   latency;    // us
+};
+
+// Broker messages as a Poisson process, times in us
+static std::vector<uint64_t> arrivals(uint64_t span, double perSecond)
+{
+    std::vector<uint64_t> times;
+
+    if (perSecond <= 0) return times;
+
+    for (double t = 0;;)
+    {
+        double u = (sim_rand() % 1000000 + 1) / 1000001.0;
+
+        t += -log(u) / perSecond * 1000000.0;
+        if (t >= span) break;
+
+        times.push_back((uint64_t)t);
+    }
+
+    return times;
+}
+
+static SimResult run(uint64_t span, uint32_t cost, const std::vector<uint64_t> & msgs,
+                    bool ticker, bool sleep)
+{
+    BlinkerEventLoop loop;
+    SimResult r = { 0, 0, 0, std::vector<uint32_t>() };
+
+    uint64_t now = 0;
+    size_t next = 0;
+    uint32_t pingTime = 0;
+    uint32_t heartTime = 0;
+    uint32_t tickTime = 0;
+
+    while (now < span)
+    {
+        uint32_t ms = now / 1000;
+        bool work = false;
+
+        // subscribe(), the broker socket
+        while (next < msgs.size() && msgs[next] <= now)
+        {
+            loop.signal(BLINKER_EVENT_NET);
+            r.latency.push_back(now - msgs[next]);
+            next++;
+        }
+
+        if (ms - pingTime >= SIM_PING_TIMEOUT)
+        {
+            pingTime = ms;
+            work = true;
+        }
+        loop.at(BLINKER_DUE_KEEPALIVE, pingTime + SIM_PING_TIMEOUT);
+
+        if (ms - heartTime >= SIM_HEARTBEAT)
+        {
+            heartTime = ms;
+            work = true;
+        }
+
+        if (ticker && ms - tickTime >= SIM_TICKER)
+        {
+            tickTime += SIM_TICKER;
+            loop.signal(BLINKER_EVENT_TIMER);
+        }
+
+        now += cost;
+        r.awake += cost;
+
+        // BlinkerApi::idle()
+        uint8_t events = loop.take();
+
+        loop.ran(events != 0 || work);
+
+        if (!sleep || events) continue;
+
+        ms = now / 1000;
+
+        loop.at(BLINKER_DUE_HEARTBEAT, heartTime + SIM_HEARTBEAT);
+
+        if (ticker) loop.at(BLINKER_DUE_WHEEL, tickTime + SIM_TICKER);
+        else loop.cancel(BLINKER_DUE_WHEEL);
+
+        uint32_t wait = loop.idleFor(ms, BLINKER_IDLE_SLEEP_MAX);
+
+        if (wait)
+        {
+            now += (uint64_t)wait * 1000;
+            loop.slept(wait);
+        }
+    }
+
+    r.iterations = loop.iterations();
+    r.wakeups = loop.wakeups();
+
+    return r;
+}
+
+static uint32_t percentile(std::vector<uint32_t> & v, uint32_t pct)
+{
+    if (v.empty()) return 0;
+
+    size_t num = (v.size() - 1) * pct / 100;
+
+    std::nth_element(v.begin(), v.begin() + num, v.end());
+
+    return v[num];
+}
+
+static void row(const char * name, double rate, bool ticker, SimResult & r,
+                uint64_t span)
+{
+    double s = span / 1000000.0;
+
+    printf("%-11s %7.2f  %-6s %11.1f %9.2f %7.2f%%  %7.1f %7.1f\n",
+            name, rate, ticker ? "yes" : "no",
+            r.iterations / s, r.wakeups / s, 100.0 * r.awake / span,
+            percentile(r.latency, 50) / 1000.0, percentile(r.latency, 99) / 1000.0);
+}
+
+int main(int argc, char * argv[])
+{
+    uint32_t seconds = argc > 1 ? atol(argv[1]) : 3600;
+    uint32_t cost = argc > 2 ? atol(argv[2]) : 200;
+
+    if (seconds == 0 || cost == 0)
+    {
+        printf("usage: %s [seconds] [us per loop]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t span = (uint64_t)seconds * 1000000;
+    const double rates[] = { 0, 1 / 60.0, 1, 10 };
+
+    printf("%lu s, %lu us per loop, sleeping at most %lu ms\n\n",
+            (unsigned long)seconds, (unsigned long)cost,
+            (unsigned long)BLINKER_IDLE_SLEEP_MAX);
+    printf("%-11s %7s  %-6s %11s %9s %8s  %7s %7s\n",
+            "loop", "msg/s", "ticker", "iter/s", "wakeup/s", "awake",
+            "p50 ms", "p99 ms");
+
+    for (size_t num = 0; num < sizeof(rates) / sizeof(rates[0]); num++)
+    {
+        for (int ticker = 0; ticker < 2; ticker++)
+        {
+            std::vector<uint64_t> msgs = arrivals(span, rates[num]);
+
+            SimResult poll = run(span, cost, msgs, ticker, false);
+            SimResult idle = run(span, cost, msgs, ticker, true);
+
+            row("polling", rates[num], ticker, poll, span);
+            row("idle sleep", rates[num], ticker, idle, span);
+        }
+    }
+
+    return 0;
+}
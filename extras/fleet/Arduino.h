@@ -0,0 +1,207 @@
+#ifndef BLINKER_FLEET_ARDUINO_H
+#define BLINKER_FLEET_ARDUINO_H
+
+// The part of the ESP8266 Arduino core the library uses, enough to build
+// the library on Linux for the fleet simulator. millis() reads the
+// simulated clock, not the wall clock.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <functional>
+#include <string>
+
+extern uint32_t fleet_now;
+
+inline unsigned long millis()   { return fleet_now; }
+inline unsigned long micros()   { return fleet_now * 1000UL; }
+inline void delay(unsigned long) {}
+
+// a device waiting on the network in a loop lets the fleet clock go on
+inline void yield()             { fleet_now++; }
+
+uint32_t fleet_rand();
+
+inline long random(long howbig)             { return howbig ? fleet_rand() % howbig : 0; }
+inline long random(long howsmall, long howbig)
+{
+    return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+// Flash strings are plain ones on a host, the type keeps the overloads apart
+class __FlashStringHelper;
+
+#define F(s)        (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PROGMEM
+#define PGM_P       const char *
+#define strlen_P    strlen
+#define memcpy_P    memcpy
+
+class String
+{
+    public :
+        String() {}
+        String(const char * s) : _s(s ? s : "") {}
+        String(const __FlashStringHelper * s) : _s(s ? (PGM_P)s : "") {}
+        String(char c) : _s(1, c) {}
+        String(unsigned char v)     { number("%u", (unsigned)v); }
+        String(int v)               { number("%d", v); }
+        String(unsigned int v)      { number("%u", v); }
+        String(long v)              { number("%ld", v); }
+        String(unsigned long v)     { number("%lu", v); }
+        String(double v)            { number("%.2f", v); }
+
+        const char * c_str() const  { return _s.c_str(); }
+        unsigned int length() const { return _s.size(); }
+        bool reserve(unsigned int n) { _s.reserve(n); return true; }
+
+        String & operator+=(const String & s)   { _s += s._s; return *this; }
+        String & operator+=(const char * s)     { _s += s; return *this; }
+        String & operator+=(const __FlashStringHelper * s) { _s += (PGM_P)s; return *this; }
+        String & operator+=(char c)             { _s += c; return *this; }
+        bool concat(const String & s)           { _s += s._s; return true; }
+        bool concat(char c)                     { _s += c; return true; }
+
+        bool operator==(const String & s) const { return _s == s._s; }
+        bool operator==(const char * s) const   { return _s == s; }
+        bool operator!=(const String & s) const { return _s != s._s; }
+        bool operator!=(const char * s) const   { return _s != s; }
+
+        char operator[](unsigned int n) const   { return n < _s.size() ? _s[n] : 0; }
+        char charAt(unsigned int n) const       { return (*this)[n]; }
+
+        int indexOf(char c, unsigned int from = 0) const
+        {
+            return at(_s.find(c, from));
+        }
+        int indexOf(const String & s, unsigned int from = 0) const
+        {
+            return at(_s.find(s._s, from));
+        }
+        int lastIndexOf(char c) const           { return at(_s.rfind(c)); }
+
+        bool startsWith(const String & s) const { return _s.compare(0, s._s.size(), s._s) == 0; }
+        bool endsWith(const String & s) const
+        {
+            return _s.size() >= s._s.size() &&
+                _s.compare(_s.size() - s._s.size(), s._s.size(), s._s) == 0;
+        }
+
+        // Arduino semantics, the bounds are swapped and clamped
+        String substring(unsigned int left) const { return substring(left, _s.size()); }
+        String substring(unsigned int left, unsigned int right) const
+        {
+            if (left > right) { unsigned int t = left; left = right; right = t; }
+            if (left >= _s.size()) return String();
+            if (right > _s.size()) right = _s.size();
+
+            return String(_s.substr(left, right - left).c_str());
+        }
+
+        void trim()
+        {
+            size_t begin = _s.find_first_not_of(" \t\r\n");
+            size_t end = _s.find_last_not_of(" \t\r\n");
+
+            _s = begin == std::string::npos ? "" : _s.substr(begin, end - begin + 1);
+        }
+
+        float toFloat() const       { return atof(_s.c_str()); }
+        long toInt() const          { return atol(_s.c_str()); }
+
+    private :
+        std::string _s;
+
+        static int at(size_t pos)   { return pos == std::string::npos ? -1 : (int)pos; }
+
+        template <typename T>
+        void number(const char * format, T v)
+        {
+            char buf[32];
+
+            snprintf(buf, sizeof(buf), format, v);
+            _s = buf;
+        }
+};
+
+class StringSumHelper : public String
+{
+    public :
+        StringSumHelper(const String & s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String & a, const String & b)
+{
+    StringSumHelper s(a);
+    s += b;
+    return s;
+}
+
+inline bool operator==(const char * a, const String & b) { return b == a; }
+
+class IPAddress
+{
+    public :
+        IPAddress()                 { memset(_ip, 0, sizeof(_ip)); }
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        {
+            _ip[0] = a; _ip[1] = b; _ip[2] = c; _ip[3] = d;
+        }
+
+        uint8_t operator[](int n) const { return _ip[n]; }
+
+    private :
+        uint8_t _ip[4];
+};
+
+class Stream
+{
+    public :
+        virtual ~Stream() {}
+
+        template <typename T> void print(const T &) {}
+        template <typename T> void println(const T &) {}
+        void println() {}
+
+        int available()                 { return 0; }
+        int read()                      { return -1; }
+        String readStringUntil(char)    { return String(); }
+        void setTimeout(unsigned long)  {}
+        void flush()                    {}
+};
+
+class EspClass
+{
+    public :
+        uint32_t getFreeHeap()          { return 40960; }
+        uint16_t getMaxFreeBlockSize()  { return 32768; }
+        void restart()                  {}
+};
+
+extern EspClass ESP;
+
+#define LOW         0
+#define HIGH        1
+
+// boot mode register, read when the device decides how it was started
+#define GPI         0UL
+
+// the device time is the fleet clock, NTP is never asked
+inline void configTime(long, int, const char *, const char * = NULL, const char * = NULL) {}
+
+inline char * utoa(unsigned int v, char * buf, int)
+{
+    sprintf(buf, "%u", v);
+    return buf;
+}
+
+inline char * ultoa(unsigned long v, char * buf, int)
+{
+    sprintf(buf, "%lu", v);
+    return buf;
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef BLINKER_FLEET_EEPROM_H
+#define BLINKER_FLEET_EEPROM_H
+
+// EEPROM of the device being run
+
+#include <Arduino.h>
+#include "FleetLink.h"
+
+class EEPROMClass
+{
+    public :
+        void begin(size_t)                          {}
+        bool commit()                               { return true; }
+        void end()                                  {}
+
+        uint8_t read(int addr)                      { return fleet_link->eeprom[addr]; }
+        void write(int addr, uint8_t v)             { fleet_link->eeprom[addr] = v; }
+
+        template <typename T>
+        T & get(int addr, T & t)
+        {
+            memcpy(&t, fleet_link->eeprom + addr, sizeof(T));
+            return t;
+        }
+
+        template <typename T>
+        const T & put(int addr, const T & t)
+        {
+            memcpy(fleet_link->eeprom + addr, &t, sizeof(T));
+            return t;
+        }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
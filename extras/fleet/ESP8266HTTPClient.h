@@ -0,0 +1,42 @@
+#ifndef BLINKER_FLEET_ESP8266HTTPCLIENT_H
+#define BLINKER_FLEET_ESP8266HTTPCLIENT_H
+
+// The cloud answers the auth request of a device with its own reply
+
+#include <memory>
+
+#include <Arduino.h>
+#include "ESP8266WiFi.h"
+#include "FleetLink.h"
+
+#define HTTP_CODE_OK                    200
+#define HTTP_CODE_MOVED_PERMANENTLY     301
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+
+class HTTPClient
+{
+    public :
+        bool begin(WiFiClient &, const String &)    { return true; }
+        bool begin(const String &)                  { return true; }
+
+        int GET()
+        {
+            if (!fleet_link->wifi) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+            _payload = fleet_link->auth.c_str();
+            return HTTP_CODE_OK;
+        }
+
+        // the fleet cloud only answers the auth request
+        void addHeader(const String &, const String &) {}
+        int POST(const String &)                    { return HTTPC_ERROR_CONNECTION_REFUSED; }
+
+        String getString()                          { return _payload; }
+        String errorToString(int)                   { return "connection refused"; }
+        void end()                                  {}
+
+    private :
+        String _payload;
+};
+
+#endif
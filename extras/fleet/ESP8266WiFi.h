@@ -0,0 +1,61 @@
+#ifndef BLINKER_FLEET_ESP8266WIFI_H
+#define BLINKER_FLEET_ESP8266WIFI_H
+
+// WiFi of the device being run, connected unless the fleet took it down.
+// The clients never open a socket, the MQTT stand-in routes through the
+// fleet broker.
+
+#include <Arduino.h>
+#include "FleetLink.h"
+
+#define WL_CONNECTED        3
+#define WL_DISCONNECTED     6
+
+enum WiFiMode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+enum WiFiSleepType_t { WIFI_NONE_SLEEP, WIFI_LIGHT_SLEEP, WIFI_MODEM_SLEEP };
+
+class Client : public Stream
+{
+    public :
+        int connect(const char *, uint16_t) { return 0; }
+        uint8_t connected()         { return 0; }
+        void stop()                 {}
+};
+
+class WiFiClient : public Client {};
+
+namespace BearSSL
+{
+    class WiFiClientSecure : public WiFiClient
+    {
+        public :
+            void setInsecure()      {}
+            void setBufferSizes(int, int) {}
+            bool probeMaxFragmentLength(const String &, uint16_t, uint16_t) { return false; }
+    };
+}
+
+class FleetWiFi
+{
+    public :
+        int status()                { return fleet_link->wifi ? WL_CONNECTED : WL_DISCONNECTED; }
+        IPAddress localIP()         { return IPAddress(192, 168, 1, 2); }
+
+        bool mode(WiFiMode_t)       { return true; }
+        bool hostname(const char *) { return true; }
+        bool setSleepMode(WiFiSleepType_t) { return true; }
+        int begin()                 { return status(); }
+        int begin(const char *, const char * = NULL) { return status(); }
+        bool reconnect()            { return true; }
+        bool disconnect()           { return true; }
+
+        bool beginSmartConfig()     { return false; }
+        bool smartConfigDone()      { return false; }
+        bool stopSmartConfig()      { return true; }
+        String SSID()               { return "fleet"; }
+        String psk()                { return ""; }
+};
+
+extern FleetWiFi WiFi;
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef BLINKER_FLEET_ESP8266HTTPUPDATE_H
+#define BLINKER_FLEET_ESP8266HTTPUPDATE_H
+
+// BlinkerOTA brings its own updater, the core one isn't used
+
+#include <Arduino.h>
+#include "ESP8266HTTPClient.h"
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef BLINKER_FLEET_ESP8266MDNS_H
+#define BLINKER_FLEET_ESP8266MDNS_H
+
+// Nobody browses for the virtual devices
+
+#include <Arduino.h>
+
+class FleetMDNS
+{
+    public :
+        bool begin(const char *, IPAddress = IPAddress()) { return true; }
+        bool addService(const char *, const char *, uint16_t) { return true; }
+        bool addServiceTxt(const char *, const char *, const char *, const String &) { return true; }
+        bool update()               { return true; }
+        void end()                  {}
+};
+
+extern FleetMDNS MDNS;
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef BLINKER_FLEET_LINK_H
+#define BLINKER_FLEET_LINK_H
+
+// What one virtual device has of the outside world: its WiFi, its broker
+// connection and inbox, its EEPROM and the auth reply the cloud gives it.
+// The WiFi, EEPROM, HTTP and MQTT stand-ins work on fleet_link, the device
+// being run, which fleet.cpp switches before every event.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <deque>
+#include <string>
+
+#define FLEET_EEP_SIZE      4096
+
+struct FleetLink
+{
+    bool                    wifi;       // WiFi.status() == WL_CONNECTED
+    bool                    reachable;  // the broker accepts a connect
+    bool                    up;         // MQTT session open
+    std::deque<std::string> inbox;      // messages for the subscription
+    std::string             auth;       // reply to the auth request
+    uint8_t                 eeprom[FLEET_EEP_SIZE];
+    uint32_t                connects;
+    uint32_t                refused;
+
+    FleetLink() : wifi(true), reachable(true), up(false), connects(0), refused(0)
+    {
+        memset(eeprom, 0xFF, sizeof(eeprom));
+    }
+};
+
+extern FleetLink * fleet_link;
+
+// The broker side, in fleet.cpp
+bool fleet_publish(FleetLink * link, const char * topic, const char * payload);
+
+#endif
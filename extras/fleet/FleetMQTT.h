@@ -0,0 +1,132 @@
+#ifndef BLINKER_FLEET_MQTT_H
+#define BLINKER_FLEET_MQTT_H
+
+// Stand-ins for the modules BlinkerMQTT.h includes by path, the Adafruit
+// MQTT client and the WebSockets server. Include this first, the include
+// guards defined here keep the real ones out.
+//
+// The client is the broker session of the device that created it:
+// connect() fails while the fleet holds its broker unreachable, publish()
+// hands the message to the fleet broker and readSubscription() takes the
+// next message from the device inbox.
+
+#define WEBSOCKETSSERVER_H_
+#define _ADAFRUIT_MQTT_H_
+#define _ADAFRUIT_MQTT_CLIENT_H_
+
+#include <Arduino.h>
+#include "ESP8266WiFi.h"
+#include "FleetLink.h"
+
+#define SUBSCRIPTIONDATALEN 1024
+
+class Adafruit_MQTT_Client;
+
+class Adafruit_MQTT_Subscribe
+{
+    public :
+        Adafruit_MQTT_Subscribe(Adafruit_MQTT_Client *, const char * feed, uint8_t q = 0)
+            : topic(feed), qos(q), datalen(0)
+        {
+            lastread[0] = '\0';
+        }
+
+        const char *    topic;
+        uint8_t         qos;
+        uint8_t         lastread[SUBSCRIPTIONDATALEN];
+        uint16_t        datalen;
+};
+
+class Adafruit_MQTT_Client
+{
+    public :
+        Adafruit_MQTT_Client(Client *, const char *, uint16_t,
+                            const char *, const char *, const char *)
+            : _link(fleet_link), _sub(NULL)
+        {}
+
+        int8_t connect()
+        {
+            if (!_link->wifi || !_link->reachable)
+            {
+                _link->refused++;
+                return -1;
+            }
+
+            _link->up = true;
+            _link->connects++;
+            return 0;
+        }
+
+        const __FlashStringHelper * connectErrorString(int8_t)
+        {
+            return F("Connection failed");
+        }
+
+        bool connected()            { return _link->up; }
+        bool disconnect()           { _link->up = false; return true; }
+        bool ping(uint8_t = 1)      { return _link->up; }
+
+        bool publish(const char * topic, const char * payload, uint8_t = 0)
+        {
+            return _link->up && fleet_publish(_link, topic, payload);
+        }
+
+        bool subscribe(Adafruit_MQTT_Subscribe * sub) { _sub = sub; return true; }
+        bool subscribeTopic(const char *) { return _link->up; }
+
+        int available()             { return _link->up && !_link->inbox.empty(); }
+
+        Adafruit_MQTT_Subscribe * readSubscription(int16_t = 0)
+        {
+            if (!available() || _sub == NULL) return NULL;
+
+            std::string & msg = _link->inbox.front();
+
+            _sub->datalen = msg.size() < SUBSCRIPTIONDATALEN - 1 ?
+                            msg.size() : SUBSCRIPTIONDATALEN - 1;
+            memcpy(_sub->lastread, msg.data(), _sub->datalen);
+            _sub->lastread[_sub->datalen] = '\0';
+
+            _link->inbox.pop_front();
+
+            return _sub;
+        }
+
+    private :
+        FleetLink *                 _link;
+        Adafruit_MQTT_Subscribe *   _sub;
+};
+
+typedef enum
+{
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN
+} WStype_t;
+
+// No LAN client ever connects
+class WebSocketsServer
+{
+    public :
+        typedef void (*WebSocketServerEvent)(uint8_t num, WStype_t type,
+                                            uint8_t * payload, size_t length);
+
+        WebSocketsServer(uint16_t) {}
+
+        void begin()                {}
+        void close()                {}
+        void loop()                 {}
+        void onEvent(WebSocketServerEvent) {}
+        void disconnect()           {}
+
+        bool sendTXT(uint8_t, const char *, size_t = 0)     { return false; }
+        bool sendTXT(uint8_t, const uint8_t *, size_t)      { return false; }
+        bool sendBIN(uint8_t, const uint8_t *, size_t)      { return false; }
+
+        IPAddress remoteIP(uint8_t) { return IPAddress(); }
+};
+
+#endif
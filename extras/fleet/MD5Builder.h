@@ -0,0 +1,21 @@
+#ifndef BLINKER_FLEET_MD5BUILDER_H
+#define BLINKER_FLEET_MD5BUILDER_H
+
+// OTA checks its image with it, the fleet never updates
+
+#include <Arduino.h>
+
+class MD5Builder
+{
+    public :
+        void begin()                                {}
+        void add(const uint8_t *, uint16_t)         {}
+        void add(const char *)                      {}
+        void add(const String &)                    {}
+        void calculate()                            {}
+        void getBytes(uint8_t * out)                { memset(out, 0, 16); }
+        void getChars(char * out)                   { memset(out, '0', 32); out[32] = '\0'; }
+        String toString()                           { return "00000000000000000000000000000000"; }
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef BLINKER_FLEET_TICKER_H
+#define BLINKER_FLEET_TICKER_H
+
+// The countdown, loop and timing timers are never armed in the fleet
+
+#include <Arduino.h>
+
+class Ticker
+{
+    public :
+        template <typename F>
+        void once(float, F)                         {}
+        template <typename F, typename A>
+        void once(float, F, A)                      {}
+        template <typename F>
+        void attach(float, F)                       {}
+        template <typename F, typename A>
+        void attach(float, F, A)                    {}
+        void detach()                               {}
+};
+
+#endif
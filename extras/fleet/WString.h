@@ -0,0 +1,8 @@
+#ifndef BLINKER_FLEET_WSTRING_H
+#define BLINKER_FLEET_WSTRING_H
+
+// ArduinoJson looks for String here
+
+#include <Arduino.h>
+
+#endif
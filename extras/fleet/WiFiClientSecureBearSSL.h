@@ -0,0 +1,6 @@
+#ifndef BLINKER_FLEET_WIFICLIENTSECUREBEARSSL_H
+#define BLINKER_FLEET_WIFICLIENTSECUREBEARSSL_H
+
+#include "ESP8266WiFi.h"
+
+#endif
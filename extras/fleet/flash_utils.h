@@ -0,0 +1,10 @@
+#ifndef BLINKER_FLEET_FLASH_UTILS_H
+#define BLINKER_FLEET_FLASH_UTILS_H
+
+// What the OTA updater declares against, it never runs in the fleet
+
+#include <Arduino.h>
+
+#define FLASH_SECTOR_SIZE   0x1000
+
+#endif
@@ -0,0 +1,691 @@
+// Fleet simulator, thousands of virtual devices in one process.
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++11 -O2 -fno-rtti -DARDUINO=100 -DESP8266 -Iextras/fleet -Isrc extras/fleet/fleet.cpp src/Blinker/BlinkerSupervisor.cpp src/Blinker/BlinkerEventLoop.cpp src/Blinker/BlinkerUtility.cpp src/Blinker/BlinkerTimer.cpp src/Blinker/BlinkerWheel.cpp -o fleet
+//   ./fleet [devices] [seconds] [broker msg/s] [app share %]
+//
+// -fno-rtti as on the ESP8266 core. Add -DBLINKER_WITHOUT_WIDGET_DELTA to
+// compare against sending every print, -DBLINKER_WITHOUT_SNAPSHOT to run
+// the heartbeat callback on every heartbeat.
+//
+// Every device runs the library's own BlinkerApi over its BlinkerMQTT
+// adapter, with the library widgets (BlinkerNumber, BlinkerText,
+// BlinkerSlider and BlinkerRGB, each with its BlinkerWidgetDelta). The
+// headers next to this file stand in for WiFi, mDNS, EEPROM, NTP, the
+// cloud requests and the MQTT client, so the real run(), parse(),
+// heartbeat and snapshot code, auth, connect, subscribe, print limits and
+// reconnect backoff run per device. Only OTA is left out. The adapter
+// keeps its state in globals, fleet.cpp swaps them in and out around every
+// device it runs. The timers of BlinkerApi are globals too and shared, the
+// fleet sets none.
+//
+// Devices with an app open also get heartbeats and slider commands. The
+// broker stand-in is one queue serving a given number of messages a
+// second, behind a network delay.
+//
+// Halfway through, the broker drops every device and takes it back within
+// FLEET_STORM_SPREAD. Each app asks for the state as soon as its device is
+// back. The report shows traffic and latency before and after that point,
+// and how long the fleet took to settle.
+//
+// Everything runs on a simulated clock, so an hour of fleet time takes
+// seconds.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#define BLINKER_MQTT
+#define BLINKER_LOG_LEVEL               BLINKER_LOG_LEVEL_NONE
+#define BLINKER_ARDUINOJSON
+#define BLINKER_WITH_METRICS
+#define ARDUINOJSON_ENABLE_STD_STRING       0
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING   1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM   0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT    0
+#define ARDUINOJSON_ENABLE_PROGMEM          0
+
+#include <Arduino.h>
+#include "FleetMQTT.h"
+#include "Adapters/BlinkerMQTT.h"
+#include "Blinker/BlinkerApi.h"
+
+#define FLEET_LOOP_SPAN         500UL
+#define FLEET_HEARTBEAT_SPAN    25000UL
+#define FLEET_COMMAND_SPAN      60000UL
+#define FLEET_STORM_SPREAD      10000UL
+#define FLEET_NET_DELAY_US      20000UL
+#define FLEET_NET_JITTER_US     10000UL
+
+uint32_t fleet_now = 0;
+FleetLink * fleet_link = NULL;
+
+FleetWiFi   WiFi;
+FleetMDNS   MDNS;
+EEPROMClass EEPROM;
+EspClass    ESP;
+
+BlinkerDebug BLINKER_DEBUG;
+void BLINKER_LOG_TIME() {}
+void BLINKER_LOG_T() {}
+void BLINKER_LOG_FreeHeap() {}
+void BLINKER_LOG_FreeHeap_ALL() {}
+
+// OTA never runs in the fleet, BlinkerUpdater.cpp needs the flash SDK
+BlinkerUpdaterClass::BlinkerUpdaterClass() {}
+bool BlinkerUpdaterClass::begin(size_t, int, int, uint8_t)  { return false; }
+size_t BlinkerUpdaterClass::writeStream(Stream &)           { return 0; }
+bool BlinkerUpdaterClass::end(bool)                         { return false; }
+bool BlinkerUpdaterClass::setMD5(const char *)              { return false; }
+
+BlinkerUpdaterClass BlinkerUpdater;
+
+uint32_t fleet_rand()
+{
+    static uint32_t x = 2463534242UL;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return x;
+}
+
+struct FleetPhase
+{
+    uint32_t                messages;
+    uint64_t                bytes;
+    uint32_t                sketchPrints;
+    uint32_t                sent;
+    uint32_t                prints;
+    uint32_t                offline;
+    uint32_t                noApp;
+    uint32_t                limited;
+    uint32_t                beats;
+    uint32_t                callbacks;
+    uint32_t                drops[2];   // BLINKER_CNT_DROP_SPAN, _CAN_PRINT
+    std::vector<uint32_t>   latency;
+
+    FleetPhase()
+        : messages(0), bytes(0), sketchPrints(0), sent(0), prints(0), offline(0)
+        , noApp(0), limited(0), beats(0), callbacks(0)
+    {
+        drops[0] = drops[1] = 0;
+    }
+};
+
+static FleetPhase phases[2];
+static uint8_t phase = 0;
+
+// The adapter as is, the failed prints are sorted by what stopped them
+class FleetMQTT : public BlinkerMQTT
+{
+    public :
+        uint32_t    beats;  // heartbeats read
+
+        FleetMQTT() : beats(0) {}
+
+        int available()
+        {
+            if (!BlinkerMQTT::available()) return false;
+
+            if (strstr(lastRead(), "\"get\":\"state\""))
+            {
+                phases[phase].beats++;
+                beats++;
+            }
+            return true;
+        }
+
+        int print(char * data, bool needCheck = true)
+        {
+            FleetPhase & p = phases[phase];
+
+            p.prints++;
+
+            if (BlinkerMQTT::print(data, needCheck)) return true;
+
+            if (!mqtt_MQTT->connected()) p.offline++;
+            else if (!isAlive) p.noApp++;
+            else p.limited++;
+
+            return false;
+        }
+};
+
+// The library's BlinkerApi, set up the way BlinkerESPMQTT::begin() does
+// with an SSID given. It counts the widget updates that went into a message.
+class FleetApi : public BlinkerApi
+{
+    public :
+        uint32_t    widgetPrints;
+
+        FleetApi() : widgetPrints(0) {}
+
+        void begin(FleetMQTT & mqtt, const char * auth)
+        {
+            BlinkerApi::begin();
+
+            mqtt.aliType("");
+            mqtt.duerType("");
+            mqtt.miType("");
+            mqtt.begin(auth);
+
+            transport(mqtt);
+
+            mqtt.commonBegin("fleet", "");
+            loadTimer();
+        }
+
+        void widgetEnd(const BlinkerWidgetName & name, BlinkerWidgetWriter & w,
+                        BlinkerWidgetDelta * delta, bool keep)
+        {
+            if (!w.full() && keep && !heartbeating()) widgetPrints++;
+
+            BlinkerApi::widgetEnd(name, w, delta, keep);
+        }
+};
+
+// What the widgets call on Blinker, for the device being run
+class FleetBlinker
+{
+    public :
+        FleetApi *  api;
+
+        FleetBlinker() : api(NULL) {}
+
+        BlinkerWidgetWriter widgetBegin(const BlinkerWidgetName & name)
+        { return api->widgetBegin(name); }
+        void widgetEnd(const BlinkerWidgetName & name, BlinkerWidgetWriter & w,
+                        BlinkerWidgetDelta * delta = NULL, bool keep = true)
+        { api->widgetEnd(name, w, delta, keep); }
+        void printNumArray(char * name, const String & data)
+        { api->printNumArray(name, data); }
+        bool heartbeating()                     { return api->heartbeating(); }
+
+        template <typename F>
+        uint8_t attachWidget(char * name, F func) { return api->attachWidget(name, func); }
+        template <typename F>
+        void freshAttachWidget(char * name, F func) { api->freshAttachWidget(name, func); }
+
+        char * widgetName_int(uint8_t num)      { return api->widgetName_int(num); }
+        char * widgetName_rgb(uint8_t num)      { return api->widgetName_rgb(num); }
+};
+
+FleetBlinker Blinker;
+
+#include "Functions/BlinkerNumber.h"
+#include "Functions/BlinkerText.h"
+#include "Functions/BlinkerSlider.h"
+#include "Functions/BlinkerRGB.h"
+
+static char nameTemp[]  = "num-temp";
+static char nameHumi[]  = "num-humi";
+static char nameState[] = "tex-state";
+static char nameDim[]   = "ran-dim";
+static char nameColor[] = "rgb-color";
+
+// Single queue broker, times in us
+class FleetBroker
+{
+    public :
+        FleetBroker(uint32_t rate) : last(0), _service(1000000UL / rate), _busy(0) {}
+
+        uint64_t    last;   // delivery of the latest message
+
+        void publish(FleetPhase & phase, size_t len)
+        {
+            uint64_t now = (uint64_t)fleet_now * 1000;
+            uint64_t in = now + FLEET_NET_DELAY_US + fleet_rand() % FLEET_NET_JITTER_US;
+
+            _busy = std::max(_busy, in) + _service;
+
+            last = _busy + FLEET_NET_DELAY_US + fleet_rand() % FLEET_NET_JITTER_US;
+
+            phase.messages++;
+            phase.bytes += len;
+            phase.latency.push_back(last - now);
+        }
+
+    private :
+        uint64_t    _service;
+        uint64_t    _busy;
+};
+
+static FleetBroker * broker;
+
+bool fleet_publish(FleetLink *, const char *, const char * payload)
+{
+    broker->publish(phases[phase], strlen(payload));
+    return true;
+}
+
+// The adapter globals of one device while another one runs
+struct FleetGlobals
+{
+    char *                      host;
+    char *                      id;
+    char *                      name;
+    char *                      key;
+    char *                      productInfo;
+    char *                      uuid;
+    char *                      deviceName;
+    char *                      pubTopic;
+    char *                      subTopic;
+    uint16_t                    port;
+    Adafruit_MQTT_Client *      mqtt;
+    Adafruit_MQTT_Subscribe *   sub;
+    char *                      msgBuf;
+    bool                        isFresh;
+    bool                        isConnect;
+    bool                        isAvail;
+    bool                        isApCfg;
+    uint8_t                     dataFrom;
+    BlinkerSupervisor           supervisor;
+    BlinkerEventLoop            loop;
+
+    FleetGlobals()
+        : host(NULL), id(NULL), name(NULL), key(NULL), productInfo(NULL), uuid(NULL)
+        , deviceName(NULL), pubTopic(NULL), subTopic(NULL), port(0), mqtt(NULL), sub(NULL)
+        , msgBuf(NULL), isFresh(false), isConnect(false), isAvail(false), isApCfg(false)
+        , dataFrom(BLINKER_MSG_FROM_MQTT)
+    {}
+
+    void swap()
+    {
+        std::swap(host, MQTT_HOST_MQTT);
+        std::swap(id, MQTT_ID_MQTT);
+        std::swap(name, MQTT_NAME_MQTT);
+        std::swap(key, MQTT_KEY_MQTT);
+        std::swap(productInfo, MQTT_PRODUCTINFO_MQTT);
+        std::swap(uuid, UUID_MQTT);
+        std::swap(deviceName, DEVICE_NAME_MQTT);
+        std::swap(pubTopic, BLINKER_PUB_TOPIC_MQTT);
+        std::swap(subTopic, BLINKER_SUB_TOPIC_MQTT);
+        std::swap(port, MQTT_PORT_MQTT);
+        std::swap(mqtt, mqtt_MQTT);
+        std::swap(sub, iotSub_MQTT);
+        std::swap(msgBuf, msgBuf_MQTT);
+        std::swap(isFresh, isFresh_MQTT);
+        std::swap(isConnect, isConnect_MQTT);
+        std::swap(isAvail, isAvail_MQTT);
+        std::swap(isApCfg, ::isApCfg);
+        std::swap(dataFrom, dataFrom_MQTT);
+        std::swap(supervisor, BLINKER_SUPERVISOR);
+        std::swap(loop, BLINKER_LOOP);
+    }
+};
+
+struct FleetDevice
+{
+    FleetLink       link;
+    FleetGlobals    globals;
+    FleetMQTT       mqtt;
+    FleetApi        api;
+
+    BlinkerNumber * temp;
+    BlinkerNumber * humi;
+    BlinkerText *   state;
+    BlinkerSlider * dim;
+    BlinkerRGB *    color;
+
+    bool            app;
+    uint32_t        nextRun;
+    uint32_t        beatTime;   // next heartbeat, older ones are dropped
+    bool            storm;      // dropped, waiting for the app to ask
+    bool            asked;
+    uint32_t        answered;   // mqtt.beats when the app asked
+
+    float           t;
+    float           h;
+    int32_t         level;
+    uint32_t        loops;
+
+    FleetDevice(uint32_t num, bool withApp);
+};
+
+static FleetDevice * current;
+
+static void enter(FleetDevice & d)
+{
+    current = &d;
+    fleet_link = &d.link;
+    Blinker.api = &d.api;
+    d.globals.swap();
+}
+
+static void leave(FleetDevice & d)
+{
+    d.globals.swap();
+}
+
+static void sketchPrint(FleetDevice & d)
+{
+    d.temp->print(roundf(d.t * 10) / 10.0);
+    d.humi->print(roundf(d.h * 10) / 10.0);
+    d.state->print(d.t > 30 ? "hot" : "ok");
+    d.dim->print(d.level);
+    d.color->print(255, d.level * 2, 0, 128);
+}
+
+static void heartbeatCallback()
+{
+    phases[phase].callbacks++;
+    sketchPrint(*current);
+}
+
+// echoes the new level at once
+static void dimCallback(int32_t value)
+{
+    FleetPhase & p = phases[phase];
+    uint32_t before = current->api.widgetPrints;
+
+    current->level = value;
+    current->dim->print(value);
+
+    p.sketchPrints++;
+    p.sent += current->api.widgetPrints - before;
+}
+
+FleetDevice::FleetDevice(uint32_t num, bool withApp)
+    : app(withApp), nextRun(0), beatTime(0), storm(false), asked(false), answered(0)
+    , t(20 + fleet_rand() % 100 / 10.0), h(40 + fleet_rand() % 200 / 10.0)
+    , level(50), loops(0)
+{
+    char buf[256];
+
+    snprintf(buf, sizeof(buf),
+        "{\"message\":1000,\"detail\":{\"deviceName\":\"DEV%05lu\",\"iotId\":\"id%05lu\","
+        "\"iotToken\":\"token\",\"productKey\":\"blinker\",\"broker\":\"aliyun\","
+        "\"uuid\":\"APP%05lu\"}}",
+        (unsigned long)num, (unsigned long)num, (unsigned long)num);
+    link.auth = buf;
+
+    snprintf(buf, sizeof(buf), "fleetkey%05lu", (unsigned long)num);
+
+    enter(*this);
+
+    api.begin(mqtt, buf);
+
+    temp  = new BlinkerNumber(nameTemp);
+    humi  = new BlinkerNumber(nameHumi);
+    state = new BlinkerText(nameState);
+    dim   = new BlinkerSlider(nameDim, dimCallback);
+    color = new BlinkerRGB(nameColor);
+
+    humi->deadband(0.5);
+    api.attachHeartbeat(heartbeatCallback);
+
+    leave(*this);
+}
+
+enum fleet_event_t
+{
+    FLEET_RUN,
+    FLEET_LOOP,
+    FLEET_HEARTBEAT,
+    FLEET_COMMAND,
+    FLEET_DROP,
+    FLEET_RECONNECT
+};
+
+struct FleetEvent
+{
+    uint32_t    time;
+    uint32_t    device;
+    uint8_t     type;
+
+    bool operator>(const FleetEvent & e) const { return time > e.time; }
+};
+
+static std::priority_queue<FleetEvent, std::vector<FleetEvent>,
+                            std::greater<FleetEvent> > events;
+static std::vector<FleetDevice *> devices;
+static uint32_t stormTime;
+static uint64_t settled;
+
+static void at(uint32_t time, uint32_t device, uint8_t type)
+{
+    FleetEvent e = { time, device, type };
+    events.push(e);
+}
+
+// Blinker.run() as soon as possible, instead of the pending one
+static void wake(FleetDevice & d, uint32_t num)
+{
+    if (d.nextRun == fleet_now) return;
+
+    d.nextRun = fleet_now;
+    at(fleet_now, num, FLEET_RUN);
+}
+
+static void appSend(FleetDevice & d, const char * data)
+{
+    char buf[160];
+
+    snprintf(buf, sizeof(buf),
+        "{\"data\":%s,\"fromDevice\":\"%s\",\"toDevice\":\"%s\",\"deviceType\":\"OwnApp\"}",
+        data, UUID_MQTT, MQTT_ID_MQTT);
+
+    d.link.inbox.push_back(buf);
+}
+
+static void run(const FleetEvent & e)
+{
+    FleetDevice & d = *devices[e.device];
+    FleetPhase & p = phases[phase];
+
+    fleet_now = e.time;
+
+    if (e.type == FLEET_RUN && e.time != d.nextRun) return;
+
+    enter(d);
+
+    switch (e.type)
+    {
+        case FLEET_RUN :
+            d.api.run();
+
+            if (d.storm && d.link.up && !d.asked)
+            {
+                d.asked = true;
+                d.answered = d.mqtt.beats;
+
+                if (d.app) appSend(d, "{\"get\":\"state\"}");
+                else d.storm = false;
+            }
+            else if (d.storm && d.asked && d.mqtt.beats != d.answered)
+            {
+                d.storm = false;
+                settled = std::max(settled, broker->last);
+            }
+
+            d.nextRun = fleet_now + std::max(1UL, (unsigned long)BLINKER_LOOP.idleFor(
+                            fleet_now, d.link.inbox.empty() ? BLINKER_IDLE_SLEEP_MAX : 1));
+            at(d.nextRun, e.device, FLEET_RUN);
+            break;
+
+        case FLEET_LOOP :
+            at(fleet_now + FLEET_LOOP_SPAN, e.device, FLEET_LOOP);
+
+            d.t += ((int32_t)(fleet_rand() % 21) - 10) / 100.0;
+            d.h += ((int32_t)(fleet_rand() % 21) - 10) / 50.0;
+
+            {
+                uint32_t before = d.api.widgetPrints;
+
+                d.temp->print(roundf(d.t * 10) / 10.0);
+                d.humi->print(roundf(d.h * 10) / 10.0);
+                if (d.loops % 10 == 0) d.state->print(d.t > 30 ? "hot" : "ok");
+
+                p.sketchPrints += d.loops % 10 == 0 ? 3 : 2;
+                p.sent += d.api.widgetPrints - before;
+            }
+
+            d.loops++;
+            break;
+
+        case FLEET_HEARTBEAT :
+            if (e.time != d.beatTime) break;
+
+            if (d.app && d.link.up)
+            {
+                appSend(d, "{\"get\":\"state\"}");
+                wake(d, e.device);
+            }
+
+            d.beatTime = fleet_now + FLEET_HEARTBEAT_SPAN;
+            at(d.beatTime, e.device, FLEET_HEARTBEAT);
+            break;
+
+        case FLEET_COMMAND :
+            if (d.app && d.link.up)
+            {
+                char buf[32];
+
+                snprintf(buf, sizeof(buf), "{\"%s\":%lu}",
+                        nameDim, (unsigned long)(fleet_rand() % 101));
+                appSend(d, buf);
+                wake(d, e.device);
+            }
+            at(fleet_now + FLEET_COMMAND_SPAN + fleet_rand() % FLEET_COMMAND_SPAN,
+                e.device, FLEET_COMMAND);
+            break;
+
+        case FLEET_DROP :
+            d.link.reachable = false;
+            d.link.up = false;
+            d.link.inbox.clear();
+            d.storm = true;
+            d.asked = false;
+            at(fleet_now + fleet_rand() % FLEET_STORM_SPREAD, e.device, FLEET_RECONNECT);
+            break;
+
+        case FLEET_RECONNECT :
+            d.link.reachable = true;
+            break;
+    }
+
+    leave(d);
+}
+
+static uint32_t percentile(std::vector<uint32_t> & v, uint32_t pct)
+{
+    if (v.empty()) return 0;
+
+    size_t num = (v.size() - 1) * pct / 100;
+
+    std::nth_element(v.begin(), v.begin() + num, v.end());
+
+    return v[num];
+}
+
+static void report(const char * name, FleetPhase & p, uint32_t span)
+{
+    printf("%s, %lu s\n", name, (unsigned long)(span / 1000));
+    printf("  sketch prints     %lu\n", (unsigned long)p.sketchPrints);
+    printf("  widget prints     %lu, %.1f%% dropped as unchanged\n",
+            (unsigned long)p.sent,
+            p.sketchPrints ? 100.0 * (p.sketchPrints - p.sent) / p.sketchPrints : 0);
+    printf("  adapter prints    %lu, not sent: %lu offline, %lu without an app, "
+            "%lu over a limit\n",
+            (unsigned long)p.prints, (unsigned long)p.offline,
+            (unsigned long)p.noApp, (unsigned long)p.limited);
+    printf("  drop metrics      span %lu, can print %lu\n",
+            (unsigned long)p.drops[0], (unsigned long)p.drops[1]);
+    printf("  heartbeat cb      %lu run, %lu from snapshot\n",
+            (unsigned long)p.callbacks, (unsigned long)(p.beats - p.callbacks));
+    printf("  messages          %lu, %.1f/s, %.1f kB/s\n",
+            (unsigned long)p.messages,
+            span ? 1000.0 * p.messages / span : 0,
+            span ? 1.0 * p.bytes / span : 0);
+    printf("  latency ms        p50 %.1f  p95 %.1f  p99 %.1f  max %.1f\n",
+            percentile(p.latency, 50) / 1000.0, percentile(p.latency, 95) / 1000.0,
+            percentile(p.latency, 99) / 1000.0, percentile(p.latency, 100) / 1000.0);
+}
+
+int main(int argc, char * argv[])
+{
+    uint32_t count   = argc > 1 ? atol(argv[1]) : 1000;
+    uint32_t seconds = argc > 2 ? atol(argv[2]) : 600;
+    uint32_t rate    = argc > 3 ? atol(argv[3]) : 2000;
+    uint32_t share   = argc > 4 ? atol(argv[4]) : 30;
+
+    if (count == 0 || seconds < 2 || rate == 0)
+    {
+        printf("usage: %s [devices] [seconds] [broker msg/s] [app share %%]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t end = seconds * 1000;
+
+    stormTime = end / 2;
+    broker = new FleetBroker(rate);
+
+    for (uint32_t num = 0; num < count; num++)
+    {
+        FleetDevice * d = new FleetDevice(num, fleet_rand() % 100 < share);
+
+        devices.push_back(d);
+
+        at(0, num, FLEET_RUN);
+        at(fleet_rand() % FLEET_LOOP_SPAN, num, FLEET_LOOP);
+        d->beatTime = fleet_rand() % FLEET_HEARTBEAT_SPAN;
+        at(d->beatTime, num, FLEET_HEARTBEAT);
+        at(fleet_rand() % FLEET_COMMAND_SPAN, num, FLEET_COMMAND);
+        at(stormTime, num, FLEET_DROP);
+    }
+
+    uint32_t drops[2] = { 0, 0 };
+
+    while (!events.empty() && events.top().time < end)
+    {
+        FleetEvent e = events.top();
+        events.pop();
+
+        if (phase == 0 && e.time >= stormTime)
+        {
+            phases[0].drops[0] = BLINKER_METRICS.counter(BLINKER_CNT_DROP_SPAN);
+            phases[0].drops[1] = BLINKER_METRICS.counter(BLINKER_CNT_DROP_CAN_PRINT);
+            drops[0] = phases[0].drops[0];
+            drops[1] = phases[0].drops[1];
+            phase = 1;
+        }
+
+        run(e);
+    }
+
+    phases[1].drops[0] = BLINKER_METRICS.counter(BLINKER_CNT_DROP_SPAN) - drops[0];
+    phases[1].drops[1] = BLINKER_METRICS.counter(BLINKER_CNT_DROP_CAN_PRINT) - drops[1];
+
+    uint32_t connects = 0;
+    uint32_t refused = 0;
+
+    for (uint32_t num = 0; num < count; num++)
+    {
+        connects += devices[num]->link.connects;
+        refused += devices[num]->link.refused;
+    }
+
+    printf("%lu devices, %lu%% with the app open, broker %lu msg/s\n\n",
+            (unsigned long)count, (unsigned long)share, (unsigned long)rate);
+
+    report("before the storm", phases[0], stormTime);
+    report("storm and after", phases[1], end - stormTime);
+
+    printf("\nbroker connects %lu, %lu refused\n",
+            (unsigned long)connects, (unsigned long)refused);
+
+    if (settled)
+    {
+        printf("storm settled after %.1f s\n",
+                (settled - (uint64_t)stormTime * 1000) / 1000000.0);
+    }
+
+    return 0;
+}
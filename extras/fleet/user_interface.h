@@ -0,0 +1,17 @@
+#ifndef BLINKER_FLEET_USER_INTERFACE_H
+#define BLINKER_FLEET_USER_INTERFACE_H
+
+// The one SDK call BlinkerUtility.cpp makes
+
+#include <stdint.h>
+#include <string.h>
+
+static inline bool wifi_get_macaddr(uint8_t, uint8_t * mac)
+{
+    static const uint8_t fleet_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    memcpy(mac, fleet_mac, sizeof(fleet_mac));
+    return true;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef BLINKER_LAN_ARDUINO_H
+#define BLINKER_LAN_ARDUINO_H
+
+// The part of the Arduino core BlinkerLan.h uses, enough to build it on
+// Linux for the loopback test. Time is passed to BlinkerLan, the clock is
+// never read.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+inline unsigned long millis()   { return 0; }
+inline unsigned long micros()   { return 0; }
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+#define F(s)        (s)
+
+class Stream
+{
+    public :
+        template <typename T> void print(const T & v)   { out(v); }
+        template <typename T> void println(const T & v) { out(v); putchar('\n'); }
+        void println()                                  { putchar('\n'); }
+
+    private :
+        void out(const char * s)        { fputs(s, stdout); }
+        void out(unsigned long v)       { printf("%lu", v); }
+        void out(long v)                { printf("%ld", v); }
+        void out(unsigned int v)        { printf("%u", v); }
+        void out(int v)                 { printf("%d", v); }
+};
+
+#endif
@@ -0,0 +1,362 @@
+// Loopback test for BlinkerLan, the local WebSocket clients of a device.
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++11 -O2 -DARDUINO=100 -Iextras/lan -Isrc extras/lan/lan.cpp -o lan
+//   ./lan
+//
+// Every client is a real TCP connection over 127.0.0.1. The send function
+// given to BlinkerLan writes WebSocket server frames, text or binary, to
+// the accepted socket the way the WebSockets library does, and refuses a
+// frame while the socket still holds the tail of an earlier one. The test
+// reads the frames back on the client side:
+// - a message reaches a text client as the json and a msgpack client as
+//   the same document in MessagePack;
+// - a message that isn't json reaches a msgpack client as a text frame,
+//   straight away and from the queue;
+// - a client over its budget gets its backlog on the next span, the
+//   oldest frames dropped;
+// - a client that stops reading doesn't hold up the others and gets the
+//   newest frames once it reads again.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <string>
+#include <vector>
+
+// What an ESP with MQTT and a LAN port has, std::string in place of the
+// Arduino String
+#define BLINKER_MAX_SEND_SIZE           1024
+#define BLINKER_LOG_LEVEL               BLINKER_LOG_LEVEL_NONE
+#define ARDUINOJSON_ENABLE_STD_STRING       1
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING   0
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM   0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT    0
+#define ARDUINOJSON_ENABLE_PROGMEM          0
+
+#include <Arduino.h>
+#include "Blinker/BlinkerConfig.h"
+#include "Blinker/BlinkerDebug.h"
+#include "Blinker/BlinkerLan.h"
+
+#define SIM_CLIENTS         3
+#define SIM_BUFFER          4096
+
+BlinkerDebug BLINKER_DEBUG;
+void BLINKER_LOG_TIME() {}
+void BLINKER_LOG_T() {}
+
+static uint32_t failed = 0;
+
+static void check(bool ok, const char * what)
+{
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failed++;
+}
+
+struct SimFrame
+{
+    bool        binary;
+    std::string data;
+};
+
+// Device side of a client, the accepted socket and what it hasn't taken yet
+struct SimLink
+{
+    int         fd;
+    std::string tail;
+};
+
+static SimLink links[SIM_CLIENTS];
+static int peers[SIM_CLIENTS];
+
+static bool drain(SimLink & link)
+{
+    while (link.tail.size())
+    {
+        ssize_t n = send(link.fd, link.tail.data(), link.tail.size(), MSG_DONTWAIT);
+
+        if (n <= 0) return false;
+
+        link.tail.erase(0, n);
+    }
+    return true;
+}
+
+// blinker_lan_send_t, one unmasked server frame
+static bool lanSend(uint8_t num, const uint8_t * data, size_t len, bool binary)
+{
+    SimLink & link = links[num];
+
+    if (!drain(link)) return false;
+
+    std::string frame(1, (char)(0x80 | (binary ? 0x2 : 0x1)));
+
+    if (len < 126)
+    {
+        frame += (char)len;
+    }
+    else
+    {
+        frame += (char)126;
+        frame += (char)(len >> 8);
+        frame += (char)(len & 0xFF);
+    }
+    frame.append((const char *)data, len);
+
+    link.tail = frame;
+    drain(link);
+
+    return true;
+}
+
+static bool readAll(int fd, uint8_t * buf, size_t len)
+{
+    while (len)
+    {
+        struct pollfd p = { fd, POLLIN, 0 };
+
+        if (poll(&p, 1, 1000) <= 0) return false;
+
+        ssize_t n = recv(fd, buf, len, 0);
+
+        if (n <= 0) return false;
+
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Next frame a client got, false when none came within a second
+static bool receive(uint8_t num, SimFrame & f)
+{
+    uint8_t head[4];
+
+    if (!readAll(peers[num], head, 2)) return false;
+
+    size_t len = head[1] & 0x7F;
+
+    if (len == 126)
+    {
+        if (!readAll(peers[num], head + 2, 2)) return false;
+        len = (head[2] << 8) | head[3];
+    }
+
+    f.binary = (head[0] & 0x0F) == 0x2;
+    f.data.resize(len);
+
+    return len == 0 || readAll(peers[num], (uint8_t *)&f.data[0], len);
+}
+
+// Nothing more arrives for a client
+static bool quiet(uint8_t num)
+{
+    struct pollfd p = { peers[num], POLLIN, 0 };
+
+    return poll(&p, 1, 50) == 0;
+}
+
+// The json a frame carries, MessagePack converted back
+static std::string json(const SimFrame & f)
+{
+    if (!f.binary) return f.data;
+
+    DynamicJsonDocument doc(BLINKER_MAX_SEND_SIZE);
+    std::string out;
+
+    if (deserializeMsgPack(doc, f.data.data(), f.data.size())) return "";
+
+    serializeJson(doc, out);
+
+    return out;
+}
+
+static void open()
+{
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    socklen_t size = sizeof(addr);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (server < 0 ||
+        bind(server, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(server, SIM_CLIENTS) ||
+        getsockname(server, (struct sockaddr *)&addr, &size))
+    {
+        perror("loopback");
+        exit(1);
+    }
+
+    for (uint8_t num = 0; num < SIM_CLIENTS; num++)
+    {
+        // small buffers so a client that stops reading fills them quickly
+        int small = SIM_BUFFER;
+        int one = 1;
+
+        peers[num] = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(peers[num], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+
+        if (connect(peers[num], (struct sockaddr *)&addr, sizeof(addr)))
+        {
+            perror("connect");
+            exit(1);
+        }
+
+        links[num].fd = accept(server, NULL, NULL);
+        setsockopt(links[num].fd, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+        setsockopt(links[num].fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    close(server);
+}
+
+int main()
+{
+    BlinkerLan lan;
+    SimFrame f;
+    uint32_t now = 0;
+
+    open();
+
+    lan.begin(lanSend);
+    lan.connect(0, false, now);
+    lan.connect(1, true, now);
+    lan.connect(2, true, now);
+
+    const char * state = "{\"btn-abc\":{\"swi\":\"on\"},\"num-abc\":{\"val\":42.5},\"state\":\"online\"}";
+
+    printf("fan out\n");
+    check(lan.clients() == SIM_CLIENTS, "every client connected");
+    check(lan.broadcast(state, now) == SIM_CLIENTS, "every client reached");
+    check(receive(0, f) && !f.binary && f.data == state, "text client got the json");
+    check(receive(1, f) && f.binary && json(f) == state, "msgpack client got the same document");
+    check(f.data.size() < strlen(state), "MessagePack is the smaller frame");
+    check(receive(2, f) && f.binary && json(f) == state, "second msgpack client too");
+
+    printf("not json\n");
+    lan.broadcast("hello", now);
+    check(receive(1, f) && !f.binary && f.data == "hello", "msgpack client got a text frame");
+    receive(0, f);
+    receive(2, f);
+
+    // The budget runs out, the rest waits in the queue for the next span
+    for (uint32_t num = 2; num < BLINKER_LAN_MSG_LIMIT; num++)
+    {
+        lan.broadcast(state, now);
+        for (uint8_t c = 0; c < SIM_CLIENTS; c++) receive(c, f);
+    }
+    lan.broadcast("hello", now);
+    lan.flush(now + BLINKER_LAN_MSG_SPAN - 1);
+    check(quiet(1), "nothing over budget went out");
+
+    lan.flush(now + BLINKER_LAN_MSG_SPAN);
+    check(receive(1, f) && !f.binary && f.data == "hello", "queued text frame went out as text");
+    receive(0, f);
+    receive(2, f);
+
+    printf("over budget\n");
+    now += 2 * BLINKER_LAN_MSG_SPAN;
+
+    std::vector<std::string> sent;
+    uint32_t dropped = lan.dropped();
+    bool inOrder = true;
+
+    for (uint32_t num = 0; num < BLINKER_LAN_MSG_LIMIT + BLINKER_LAN_QUEUE_SIZE + 2; num++)
+    {
+        char buf[32];
+
+        snprintf(buf, sizeof(buf), "{\"num\":%lu}", (unsigned long)num);
+        sent.push_back(buf);
+        lan.broadcast(buf, now);
+
+        if (num >= BLINKER_LAN_MSG_LIMIT) continue;
+
+        inOrder = inOrder && receive(0, f) && f.data == sent[num];
+        inOrder = inOrder && receive(1, f) && json(f) == sent[num];
+        receive(2, f);
+    }
+
+    check(inOrder && quiet(0), "budget spent in order");
+    check(lan.dropped() - dropped == 2 * SIM_CLIENTS, "oldest two dropped for every client");
+
+    now += BLINKER_LAN_MSG_SPAN;
+    lan.flush(now);
+
+    for (uint32_t num = BLINKER_LAN_MSG_LIMIT + 2; num < sent.size(); num++)
+    {
+        inOrder = inOrder && receive(0, f) && f.data == sent[num];
+        inOrder = inOrder && receive(1, f) && f.binary && json(f) == sent[num];
+        receive(2, f);
+    }
+    check(inOrder, "newest frames kept for the next span");
+
+    printf("slow client\n");
+    now += BLINKER_LAN_MSG_SPAN;
+
+    // Client 2 stops reading, large messages fill its window
+    std::string big = "{\"txt-abc\":\"" + std::string(400, 'x') + "\",\"n\":";
+    uint32_t others = 0;
+    uint32_t count = 0;
+
+    dropped = lan.dropped();
+
+    for (; count < BLINKER_LAN_MSG_LIMIT - 1; count++)
+    {
+        std::string msg = big + std::to_string(count) + "}";
+
+        lan.broadcast(msg.c_str(), now);
+
+        if (receive(0, f) && f.data == msg) others++;
+        if (receive(1, f) && json(f) == msg) others++;
+    }
+
+    dropped = lan.dropped() - dropped;
+
+    check(others == 2 * count, "the others got every message");
+    check(dropped > 0, "the slow client dropped its oldest");
+
+    // It reads again, the last frames it got before its window filled and
+    // the newest ones from the queue
+    std::string last;
+    uint32_t got = 0;
+
+    now += BLINKER_LAN_MSG_SPAN;
+
+    while (true)
+    {
+        lan.flush(now);
+        if (!receive(2, f)) break;
+        last = json(f);
+        got++;
+    }
+
+    check(got > 0 && got < count, "it caught up on part of the backlog");
+    check(last == big + std::to_string(count - 1) + "}", "its last frame is the newest message");
+
+    lan.disconnect(2);
+    check(lan.clients() == SIM_CLIENTS - 1, "it left");
+
+    for (uint8_t num = 0; num < SIM_CLIENTS; num++)
+    {
+        close(links[num].fd);
+        close(peers[num]);
+    }
+
+    printf("\n%s\n", failed ? "FAILED" : "passed");
+
+    return failed ? 1 : 0;
+}
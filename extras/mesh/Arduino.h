@@ -0,0 +1,279 @@
+#ifndef BLINKER_MESH_ARDUINO_H
+#define BLINKER_MESH_ARDUINO_H
+
+// The part of the ESP8266 Arduino core painlessMesh and the gateway and
+// sub-device adapters use, enough to build them on Linux with
+// PAINLESSMESH_BOOST for the mesh harness. millis() and micros() are the
+// wall clock, the nodes talk over real loopback sockets.
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <string>
+
+// ArduinoJson with the Arduino String and the std::string of painlessMesh,
+// the same in every file so they share one ArduinoJson namespace
+#define ARDUINOJSON_ENABLE_STD_STRING       1
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING   1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM   0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT    0
+#define ARDUINOJSON_ENABLE_PROGMEM          0
+
+// Ahead of F(), boost has templates with an F parameter
+#include <boost/asio.hpp>
+
+unsigned long millis(void);
+unsigned long micros(void);
+
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+inline long random(long howbig)             { return howbig ? rand() % howbig : 0; }
+inline long random(long howsmall, long howbig)
+{
+    return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+#define F(s)                (s)
+#define PROGMEM
+#define PGM_P               const char *
+#define strlen_P            strlen
+#define strcmp_P            strcmp
+#define strncmp_P           strncmp
+#define memcpy_P            memcpy
+#define pgm_read_byte_near(p)   (*(const uint8_t *)(p))
+#define ICACHE_FLASH_ATTR
+
+class __FlashStringHelper;
+
+// Arduino String over std::string, painlessMesh itself keeps std::string
+// as TSTRING on a host
+class String
+{
+    public :
+        String() {}
+        String(const char * s) : _s(s ? s : "") {}
+        String(char c) : _s(1, c) {}
+        String(unsigned char v)     { number("%u", (unsigned)v); }
+        String(int v)               { number("%d", v); }
+        String(unsigned int v)      { number("%u", v); }
+        String(long v)              { number("%ld", v); }
+        String(unsigned long v)     { number("%lu", v); }
+        String(double v)            { number("%.2f", v); }
+
+        const char * c_str() const  { return _s.c_str(); }
+        unsigned int length() const { return _s.size(); }
+        bool reserve(unsigned int n) { _s.reserve(n); return true; }
+
+        String & operator+=(const String & s)   { _s += s._s; return *this; }
+        String & operator+=(const char * s)     { _s += s; return *this; }
+        String & operator+=(char c)             { _s += c; return *this; }
+        String & operator+=(int v)              { return *this += String(v); }
+        String & operator+=(unsigned int v)     { return *this += String(v); }
+        String & operator+=(long v)             { return *this += String(v); }
+        String & operator+=(unsigned long v)    { return *this += String(v); }
+        bool concat(const String & s)           { _s += s._s; return true; }
+        bool concat(const char * s)             { _s += s; return true; }
+        bool concat(const char * s, unsigned int n) { _s.append(s, n); return true; }
+        bool concat(char c)                     { _s += c; return true; }
+
+        bool operator==(const String & s) const { return _s == s._s; }
+        bool operator==(const char * s) const   { return _s == s; }
+        bool operator!=(const String & s) const { return _s != s._s; }
+        bool operator!=(const char * s) const   { return _s != s; }
+        bool operator<(const String & s) const  { return _s < s._s; }
+
+        char operator[](unsigned int n) const   { return n < _s.size() ? _s[n] : 0; }
+        char charAt(unsigned int n) const       { return (*this)[n]; }
+
+        int indexOf(char c, unsigned int from = 0) const
+        {
+            return at(_s.find(c, from));
+        }
+        int indexOf(const String & s, unsigned int from = 0) const
+        {
+            return at(_s.find(s._s, from));
+        }
+        int lastIndexOf(char c) const           { return at(_s.rfind(c)); }
+
+        bool startsWith(const String & s) const { return _s.compare(0, s._s.size(), s._s) == 0; }
+        bool endsWith(const String & s) const
+        {
+            return _s.size() >= s._s.size() &&
+                _s.compare(_s.size() - s._s.size(), s._s.size(), s._s) == 0;
+        }
+
+        // Arduino semantics, the bounds are swapped and clamped
+        String substring(unsigned int left) const { return substring(left, _s.size()); }
+        String substring(unsigned int left, unsigned int right) const
+        {
+            if (left > right) { unsigned int t = left; left = right; right = t; }
+            if (left >= _s.size()) return String();
+            if (right > _s.size()) right = _s.size();
+
+            return String(_s.substr(left, right - left).c_str());
+        }
+
+        void trim()
+        {
+            size_t begin = _s.find_first_not_of(" \t\r\n");
+            size_t end = _s.find_last_not_of(" \t\r\n");
+
+            _s = begin == std::string::npos ? "" : _s.substr(begin, end - begin + 1);
+        }
+
+        float toFloat() const       { return atof(_s.c_str()); }
+        long toInt() const          { return atol(_s.c_str()); }
+
+    private :
+        std::string _s;
+
+        static int at(size_t pos)   { return pos == std::string::npos ? -1 : (int)pos; }
+
+        template <typename T>
+        void number(const char * format, T v)
+        {
+            char buf[32];
+
+            snprintf(buf, sizeof(buf), format, v);
+            _s = buf;
+        }
+};
+
+class StringSumHelper : public String
+{
+    public :
+        StringSumHelper(const String & s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String & a, const String & b)
+{
+    StringSumHelper s(a);
+    s += b;
+    return s;
+}
+
+inline StringSumHelper operator+(const String & a, const char * b)   { return a + String(b); }
+inline StringSumHelper operator+(const char * a, const String & b)   { return String(a) + b; }
+inline bool operator==(const char * a, const String & b) { return b == a; }
+
+// IPAddress of the core, painlessMesh has its own IPAddress with
+// PAINLESSMESH_BOOST, gate.cpp and sub.cpp define IPAddress to this one
+// after they included painlessMesh
+class MeshIPAddress
+{
+    public :
+        MeshIPAddress()             { memset(_ip, 0, sizeof(_ip)); }
+        MeshIPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        {
+            _ip[0] = a; _ip[1] = b; _ip[2] = c; _ip[3] = d;
+        }
+
+        uint8_t operator[](int n) const { return _ip[n]; }
+
+        String toString() const
+        {
+            char buf[16];
+
+            snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _ip[0], _ip[1], _ip[2], _ip[3]);
+            return String(buf);
+        }
+
+    private :
+        uint8_t _ip[4];
+};
+
+// Log goes here, quiet unless MESH_VERBOSE is set
+class MeshSerial
+{
+    public :
+        bool verbose = false;
+
+        template <typename T>
+        void print(const T & v)     { if (verbose) out(v); }
+        template <typename T>
+        void println(const T & v)   { if (verbose) { out(v); putchar('\n'); } }
+        void println()              { if (verbose) putchar('\n'); }
+
+    private :
+        void out(const char * s)            { fputs(s, stdout); }
+        void out(const std::string & s)     { fputs(s.c_str(), stdout); }
+        void out(const String & s)          { fputs(s.c_str(), stdout); }
+        void out(unsigned long v)           { printf("%lu", v); }
+        void out(long v)                    { printf("%ld", v); }
+        void out(unsigned int v)            { printf("%u", v); }
+        void out(int v)                     { printf("%d", v); }
+};
+
+extern MeshSerial Serial;
+
+class Stream
+{
+    public :
+        template <typename T> void print(const T &) {}
+        template <typename T> void println(const T &) {}
+        void println() {}
+};
+
+class MeshESP
+{
+    public :
+        uint32_t getFreeHeap()          { return 1UL << 24; }
+        uint16_t getMaxFreeBlockSize()  { return 32768; }
+};
+
+extern MeshESP ESP;
+
+#define WL_CONNECTED        3
+
+enum WiFiMode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+
+// The nodes reach each other on loopback, the station link has no WiFi
+// to drop
+class MeshWiFi
+{
+    public :
+        uint8_t status()            { return WL_CONNECTED; }
+        bool disconnect(bool = false) { return true; }
+        bool reconnect()            { return true; }
+        bool mode(WiFiMode_t)       { return true; }
+        int begin()                 { return status(); }
+        int begin(const char *, const char * = NULL) { return status(); }
+        bool hostname(const char *) { return true; }
+        bool hostname(const String &) { return true; }
+        bool setHostname(const char *) { return true; }
+        bool setAutoConnect(bool)   { return true; }
+        bool setAutoReconnect(bool) { return true; }
+        MeshIPAddress localIP()         { return MeshIPAddress(127, 0, 0, 1); }
+        String SSID()               { return "mesh"; }
+        String psk()                { return ""; }
+
+        bool beginSmartConfig()     { return false; }
+        bool smartConfigDone()      { return false; }
+        bool stopSmartConfig()      { return true; }
+        bool softAP(const char *, const char * = NULL) { return true; }
+        bool softAPConfig(MeshIPAddress, MeshIPAddress, MeshIPAddress) { return true; }
+        MeshIPAddress softAPIP()        { return MeshIPAddress(192, 168, 4, 1); }
+};
+
+extern MeshWiFi WiFi;
+
+inline char * utoa(unsigned int v, char * buf, int)
+{
+    sprintf(buf, "%u", v);
+    return buf;
+}
+
+inline char * ultoa(unsigned long v, char * buf, int)
+{
+    sprintf(buf, "%lu", v);
+    return buf;
+}
+
+#endif
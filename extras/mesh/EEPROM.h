@@ -0,0 +1,42 @@
+#ifndef BLINKER_MESH_EEPROM_H
+#define BLINKER_MESH_EEPROM_H
+
+// EEPROM of the gateway, the sub-devices don't use theirs
+
+#include <Arduino.h>
+
+#define MESH_EEP_SIZE       4096
+
+class EEPROMClass
+{
+    public :
+        EEPROMClass()                               { memset(_data, 0xFF, sizeof(_data)); }
+
+        void begin(size_t)                          {}
+        bool commit()                               { return true; }
+        void end()                                  {}
+
+        uint8_t read(int addr)                      { return _data[addr]; }
+        void write(int addr, uint8_t v)             { _data[addr] = v; }
+
+        template <typename T>
+        T & get(int addr, T & t)
+        {
+            memcpy(&t, _data + addr, sizeof(T));
+            return t;
+        }
+
+        template <typename T>
+        const T & put(int addr, const T & t)
+        {
+            memcpy(_data + addr, &t, sizeof(T));
+            return t;
+        }
+
+    private :
+        uint8_t _data[MESH_EEP_SIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef BLINKER_MESH_ESP8266HTTPCLIENT_H
+#define BLINKER_MESH_ESP8266HTTPCLIENT_H
+
+// The cloud answers the auth requests of the gateway and of the
+// sub-devices it registers, see mesh_cloud_get() in mesh.cpp
+
+#include <memory>
+
+#include <Arduino.h>
+#include "ESP8266WiFi.h"
+
+#define HTTP_CODE_OK                    200
+#define HTTP_CODE_MOVED_PERMANENTLY     301
+#define HTTP_CODE_NOT_FOUND             404
+
+String mesh_cloud_get(const String & url);
+
+class HTTPClient
+{
+    public :
+        bool begin(WiFiClient &, const String & url) { _url = url; return true; }
+        bool begin(const String & url)              { _url = url; return true; }
+        void addHeader(const String &, const String &) {}
+
+        int GET()
+        {
+            _payload = mesh_cloud_get(_url);
+            return _payload.length() ? HTTP_CODE_OK : HTTP_CODE_NOT_FOUND;
+        }
+
+        int POST(const String &)                    { _payload = "{}"; return HTTP_CODE_OK; }
+
+        String getString()                          { return _payload; }
+        String errorToString(int)                   { return "not found"; }
+        void end()                                  {}
+
+    private :
+        String _url;
+        String _payload;
+};
+
+#endif
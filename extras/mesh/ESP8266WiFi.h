@@ -0,0 +1,50 @@
+#ifndef BLINKER_MESH_ESP8266WIFI_H
+#define BLINKER_MESH_ESP8266WIFI_H
+
+// The clients the gateway adapter holds. The nodes never open one, the
+// cloud of the gateway is the MQTT and HTTP stand-in next to this file.
+
+#include <Arduino.h>
+
+#define WL_DISCONNECTED     6
+
+class Client
+{
+    public :
+        virtual ~Client() {}
+
+        int connect(const char *, uint16_t)     { return 0; }
+        int connected()                         { return 0; }
+        int available()                         { return 0; }
+        int read()                              { return -1; }
+        uint8_t status()                        { return 0; }
+        void flush()                            {}
+        void stop()                             {}
+        String readStringUntil(char)            { return String(); }
+        template <typename T> size_t print(const T &) { return 0; }
+};
+
+class WiFiClient : public Client {};
+
+class WiFiServer
+{
+    public :
+        WiFiServer(uint16_t) {}
+
+        void begin()                {}
+        WiFiClient available()      { return WiFiClient(); }
+};
+
+namespace BearSSL
+{
+    class WiFiClientSecure : public WiFiClient
+    {
+        public :
+            void setInsecure()                                  {}
+            bool setFingerprint(const char *)                   { return true; }
+            bool probeMaxFragmentLength(const String &, uint16_t, uint16_t) { return false; }
+            void setBufferSizes(int, int)                       {}
+    };
+}
+
+#endif
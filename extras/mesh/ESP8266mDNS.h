@@ -0,0 +1,20 @@
+#ifndef BLINKER_MESH_ESP8266MDNS_H
+#define BLINKER_MESH_ESP8266MDNS_H
+
+// Nobody browses for the gateway
+
+#include <Arduino.h>
+
+class MeshMDNS
+{
+    public :
+        bool begin(const char *, MeshIPAddress = MeshIPAddress()) { return true; }
+        bool addService(const char *, const char *, uint16_t) { return true; }
+        bool addServiceTxt(const char *, const char *, const char *, const String &) { return true; }
+        bool update()               { return true; }
+        void end()                  {}
+};
+
+extern MeshMDNS MDNS;
+
+#endif
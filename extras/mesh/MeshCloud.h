@@ -0,0 +1,128 @@
+#ifndef BLINKER_MESH_CLOUD_H
+#define BLINKER_MESH_CLOUD_H
+
+// Stand-ins for the modules BlinkerGateway.h includes by path, the Adafruit
+// MQTT client and the WebSockets server. Include this first, the include
+// guards defined here keep the real ones out.
+//
+// The gateway is the only client: connect() always succeeds, publish()
+// hands the message to mesh_cloud_publish() in mesh.cpp and
+// readSubscription() takes the next message mesh.cpp put in
+// mesh_cloud_inbox.
+
+#define WEBSOCKETSSERVER_H_
+#define _ADAFRUIT_MQTT_H_
+#define _ADAFRUIT_MQTT_CLIENT_H_
+
+#include <deque>
+#include <string>
+
+#include <Arduino.h>
+#include "ESP8266WiFi.h"
+
+#define SUBSCRIPTIONDATALEN 1024
+
+extern std::deque<std::string> mesh_cloud_inbox;
+
+bool mesh_cloud_publish(const char * topic, const char * payload);
+
+class Adafruit_MQTT_Client;
+
+class Adafruit_MQTT_Subscribe
+{
+    public :
+        Adafruit_MQTT_Subscribe(Adafruit_MQTT_Client *, const char * feed, uint8_t q = 0)
+            : topic(feed), qos(q), datalen(0)
+        {
+            lastread[0] = '\0';
+        }
+
+        const char *    topic;
+        uint8_t         qos;
+        uint8_t         lastread[SUBSCRIPTIONDATALEN];
+        uint16_t        datalen;
+};
+
+class Adafruit_MQTT_Publish
+{
+    public :
+        Adafruit_MQTT_Publish(Adafruit_MQTT_Client *, const char *, uint8_t = 0) {}
+};
+
+class Adafruit_MQTT_Client
+{
+    public :
+        Adafruit_MQTT_Client(Client *, const char *, uint16_t,
+                            const char *, const char *, const char *)
+            : _up(false), _sub(NULL)
+        {}
+
+        int8_t connect()            { _up = true; return 0; }
+
+        const char * connectErrorString(int8_t) { return "Connection failed"; }
+
+        bool connected()            { return _up; }
+        bool disconnect()           { _up = false; return true; }
+        bool ping(uint8_t = 1)      { return _up; }
+
+        bool publish(const char * topic, const char * payload, uint8_t = 0)
+        {
+            return _up && mesh_cloud_publish(topic, payload);
+        }
+
+        bool subscribe(Adafruit_MQTT_Subscribe * sub) { _sub = sub; return true; }
+
+        Adafruit_MQTT_Subscribe * readSubscription(int16_t = 0)
+        {
+            if (!_up || _sub == NULL || mesh_cloud_inbox.empty()) return NULL;
+
+            std::string & msg = mesh_cloud_inbox.front();
+
+            _sub->datalen = msg.size() < SUBSCRIPTIONDATALEN - 1 ?
+                            msg.size() : SUBSCRIPTIONDATALEN - 1;
+            memcpy(_sub->lastread, msg.data(), _sub->datalen);
+            _sub->lastread[_sub->datalen] = '\0';
+
+            mesh_cloud_inbox.pop_front();
+
+            return _sub;
+        }
+
+    private :
+        bool                        _up;
+        Adafruit_MQTT_Subscribe *   _sub;
+};
+
+typedef enum
+{
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN
+} WStype_t;
+
+// No LAN client ever connects
+class WebSocketsServer
+{
+    public :
+        typedef void (*WebSocketServerEvent)(uint8_t num, WStype_t type,
+                                            uint8_t * payload, size_t length);
+
+        WebSocketsServer(uint16_t) {}
+
+        void begin()                {}
+        void close()                {}
+        void loop()                 {}
+        void onEvent(WebSocketServerEvent) {}
+        void disconnect()           {}
+
+        bool sendTXT(uint8_t, const char *, size_t = 0)     { return false; }
+        bool sendTXT(uint8_t, const uint8_t *, size_t)      { return false; }
+        bool sendBIN(uint8_t, const uint8_t *, size_t)      { return false; }
+        bool broadcastTXT(const char *, size_t = 0)         { return false; }
+
+        MeshIPAddress remoteIP(uint8_t) { return MeshIPAddress(); }
+};
+
+#endif
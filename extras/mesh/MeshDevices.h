@@ -0,0 +1,28 @@
+#ifndef BLINKER_MESH_DEVICES_H
+#define BLINKER_MESH_DEVICES_H
+
+// What mesh.cpp sees of the gateway in gate.cpp and of the sub-devices in
+// sub.cpp. The adapters run on the node the MeshNode they are given points
+// at, mesh_current is the number of the node being run, its MAC and so the
+// device name follow from it.
+
+#include <stdint.h>
+
+#define MESH_KEY        "blinker"
+#define MESH_TYPE       "OwnApp"
+
+class SimNode;
+class SubDevice;
+
+extern uint32_t mesh_current;
+
+bool gateway_begin(SimNode * node);
+void gateway_run();
+uint32_t gateway_registered();
+
+SubDevice * subdevice_new(SimNode * node, const char * key, const char * type);
+// Runs the adapter, a command it got is answered with a print of reply
+void subdevice_run(SubDevice * sub, const char * (*reply)(const char * command));
+bool subdevice_registered(SubDevice * sub);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef BLINKER_MESH_NODE_H
+#define BLINKER_MESH_NODE_H
+
+// painlessMesh as the gateway and sub-device adapters see it. gate.cpp and
+// sub.cpp define painlessMesh to this class before they include their
+// adapter, so its painlessMesh mesh global is one of these. It forwards to
+// the harness node the mesh member points at, a painlessmesh::Mesh over
+// loopback, and converts the Arduino Strings of the adapter to the
+// std::string painlessMesh keeps on a host. The functions are in mesh.cpp.
+
+#include <Arduino.h>
+#include "painlessMesh.h"
+
+class SimNode;
+
+class MeshNode
+{
+    public :
+        MeshNode() : node(NULL), layoutChangedAt(0) {}
+
+        void setDebugMsgTypes(uint16_t) {}
+
+        // Starts the node, it listens on its port and joins its parent
+        void init(String ssid, String password, uint16_t port = 5555,
+                  WiFiMode_t connectMode = WIFI_AP_STA, uint8_t channel = 1);
+        void stationManual(String, String) {}
+
+        void setRoot(bool on = true);
+        void setContainsRoot(bool on = true);
+        void setWireFormat(painlessmesh::protocol::WireFormat format);
+        void setPriorityWeight(painlessmesh::protocol::Priority priority, uint16_t weight);
+        size_t queueDepth(painlessmesh::protocol::Priority priority);
+
+        void onReceive(void (*callback)(uint32_t from, String & msg));
+        void onNewConnection(void (*callback)(uint32_t nodeId));
+        void onChangedConnections(void (*callback)());
+
+        void update();
+
+        bool sendSingle(uint32_t dest, String msg,
+                        painlessmesh::protocol::Priority priority =
+                            painlessmesh::protocol::PRIORITY_TELEMETRY);
+        bool sendBroadcast(String msg, bool includeSelf = false);
+        bool isConnected(uint32_t nodeId);
+
+        String subConnectionJson(bool pretty = false);
+        painlessmesh::layout::Traffic traffic();
+
+        SimNode *   node;
+        uint32_t    layoutChangedAt;
+};
+
+#endif
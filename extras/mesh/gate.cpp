@@ -0,0 +1,85 @@
+// The gateway of the mesh harness, the library's BlinkerGateway adapter as
+// it is, on node 1. See mesh.cpp for the build line.
+//
+// The adapter and BlinkerSubDevice both define their state as globals with
+// the same names, each is built in its own file inside its own namespace.
+// Everything they include comes first, outside of it.
+
+#define BLINKER_WIFI_GATEWAY
+#define BLINKER_LOG_LEVEL               BLINKER_LOG_LEVEL_NONE
+#define BLINKER_ARDUINOJSON
+
+// Room for every node, and a whois often enough to find the ones which
+// joined after the first
+#define BLINKER_MAX_SUB_DEVICE_NUM      1024
+#define BLINKER_MESH_CHECK_FREQ         5000UL
+
+#include <Arduino.h>
+#include <ESP8266mDNS.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#include <EEPROM.h>
+#include "MeshCloud.h"
+#include "MeshNode.h"
+#include "MeshDevices.h"
+
+#include "Blinker/BlinkerConfig.h"
+#include "Blinker/BlinkerDebug.h"
+#include "Blinker/BlinkerUtility.h"
+#include "Blinker/BlinkerJsonArena.h"
+#include "Blinker/BlinkerSupervisor.h"
+#include "Blinker/BlinkerMetrics.h"
+#include "Functions/BlinkerCredentials.h"
+
+#define painlessMesh    MeshNode
+#define IPAddress       MeshIPAddress
+
+namespace gate
+{
+    #include "Blinker/BlinkerStream.h"
+    #include "Adapters/BlinkerGateway.h"
+
+    BlinkerGateway gateway;
+}
+
+BlinkerDebug    BLINKER_DEBUG;
+MeshMDNS        MDNS;
+EEPROMClass     EEPROM;
+
+void BLINKER_LOG_TIME() {}
+void BLINKER_LOG_T() {}
+void BLINKER_LOG_FreeHeap() {}
+void BLINKER_LOG_FreeHeap_ALL() {}
+
+bool gateway_begin(SimNode * node)
+{
+    gate::mesh.node = node;
+
+    gate::gateway.begin(MESH_KEY, MESH_TYPE);
+
+    return gate::gateway.deviceRegister();
+}
+
+// BlinkerApi::run() for the gateway
+void gateway_run()
+{
+    gate::BlinkerStream & stream = gate::gateway;
+
+    stream.meshCheck();
+
+    gate::gateway.connect();
+
+    if (gate::gateway.available()) gate::gateway.flush();
+}
+
+uint32_t gateway_registered()
+{
+    uint32_t count = 0;
+
+    for (uint16_t num = 0; num < gate::_subCount; num++)
+    {
+        if (gate::_subDevices[num]->isAuth()) count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,500 @@
+// Mesh harness for the gateway and sub-device adapters, painlessMesh nodes
+// in one process talking over loopback.
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++14 -O2 -fno-rtti -DESP8266 -DARDUINO=100 -DARDUINO_ARCH_ESP8266 -DPAINLESSMESH_BOOST -Iextras/mesh -Isrc -Isrc/modules/painlessMesh extras/mesh/mesh.cpp extras/mesh/gate.cpp extras/mesh/sub.cpp src/modules/painlessMesh/painlessMeshConnection.cpp src/modules/painlessMesh/scheduler.cpp src/Blinker/BlinkerUtility.cpp src/Blinker/BlinkerSupervisor.cpp -o mesh -lboost_system -lpthread
+//   ./mesh [nodes]
+//
+// Add -DBLINKER_MESH_MSGPACK for the MessagePack wire format.
+//
+// Every node is the real painlessmesh::Mesh and MeshConnection over the
+// boost asio AsyncTCP stand-in: its own AP server on a loopback port and a
+// station link to its parent, four children a node. Node 1 runs the
+// library's BlinkerGateway (gate.cpp), the others BlinkerSubDevice
+// (sub.cpp), each called the way BlinkerApi::run() calls them. The cloud is
+// in this file: it answers the device auth requests and exchanges MQTT
+// messages with the gateway.
+// - the mesh forms, the time until every node knows every other node is
+//   the convergence time;
+// - the gateway asks whois, registers every sub-device that answers with
+//   the cloud and hands it its credentials;
+// - the app sends each sub-device a few commands through the cloud, the
+//   gateway forwards them on the control lane, each sub-device prints a
+//   reply which the gateway publishes.
+//
+// It prints the latency percentiles of the commands and the bytes the mesh
+// put on the wire per message, then drops a leaf and checks its parent
+// keeps the traffic totals and marks the layout changed. The program fails
+// when a sub-device isn't registered, a command goes unanswered or the
+// checks don't hold.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "painlessMesh.h"
+#include "MeshNode.h"
+#include "MeshDevices.h"
+
+#define SIM_PORT            20000
+#define SIM_FANOUT          4
+#define SIM_COMMANDS        5
+// Sub-devices gate.cpp has room for
+#define SIM_MAX_NODES       1024
+// BlinkerSubDevice prints at most once per BLINKER_PRO_MSG_LIMIT
+#define SIM_COMMAND_GAP     300
+
+painlessmesh::logger::LogClass Log;
+MeshSerial Serial;
+MeshESP ESP;
+MeshWiFi WiFi;
+
+uint32_t mesh_current = 0;
+std::deque<std::string> mesh_cloud_inbox;
+
+static const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+unsigned long millis(void)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long micros(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Node n is 5C:CF:7F plus n, its device name the MAC as macDeviceName()
+// prints it
+extern "C" bool wifi_get_macaddr(uint8_t, uint8_t * mac)
+{
+    mac[0] = 0x5C; mac[1] = 0xCF; mac[2] = 0x7F;
+    mac[3] = mesh_current >> 16; mac[4] = mesh_current >> 8; mac[5] = mesh_current;
+
+    return true;
+}
+
+static std::string macName(uint32_t num)
+{
+    char name[13];
+
+    snprintf(name, sizeof(name), "5CCF7F%06X", (unsigned)(num & 0xFFFFFF));
+
+    return name;
+}
+
+static uint32_t failed = 0;
+
+static void check(bool ok, const char * what)
+{
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failed++;
+}
+
+typedef painlessmesh::Mesh<MeshConnection> SimMesh;
+
+class SimNode : public SimMesh
+{
+    public :
+        SimNode(boost::asio::io_service & io, uint32_t id, uint16_t port, uint16_t parentPort)
+            : server(io, port), station(io)
+            , _id(id), _port(port), _parentPort(parentPort), _started(false)
+        {}
+
+        // stop() needs the station client, it goes before the members do
+        ~SimNode() { if (_started) stop(); }
+
+        // painlessMesh::init(), the root has no parent to join
+        void start()
+        {
+            init(&scheduler, _id, _port);
+            painlessmesh::tcp::initServer<MeshConnection, SimMesh>(server, *this);
+
+            if (_parentPort)
+            {
+                painlessmesh::tcp::connect<MeshConnection, SimMesh>(station,
+                    boost::asio::ip::make_address("127.0.0.1"), _parentPort, *this);
+            }
+
+            _started = true;
+        }
+
+        Scheduler   scheduler;
+        AsyncServer server;
+        AsyncClient station;
+
+    private :
+        uint32_t    _id;
+        uint16_t    _port;
+        uint16_t    _parentPort;
+        bool        _started;
+};
+
+void MeshNode::init(String, String, uint16_t, WiFiMode_t, uint8_t) { node->start(); }
+
+void MeshNode::setRoot(bool on)             { node->setRoot(on); }
+void MeshNode::setContainsRoot(bool on)     { node->setContainsRoot(on); }
+
+void MeshNode::setWireFormat(painlessmesh::protocol::WireFormat format)
+{
+    node->setWireFormat(format);
+}
+
+void MeshNode::setPriorityWeight(painlessmesh::protocol::Priority priority, uint16_t weight)
+{
+    node->setPriorityWeight(priority, weight);
+}
+
+size_t MeshNode::queueDepth(painlessmesh::protocol::Priority priority)
+{
+    return node->queueDepth(priority);
+}
+
+void MeshNode::onReceive(void (*callback)(uint32_t from, String & msg))
+{
+    node->onReceive([callback](uint32_t from, TSTRING & msg) {
+        String data(msg.c_str());
+
+        callback(from, data);
+    });
+}
+
+void MeshNode::onNewConnection(void (*callback)(uint32_t nodeId))
+{
+    node->onNewConnection(callback);
+}
+
+void MeshNode::onChangedConnections(void (*callback)())
+{
+    node->onChangedConnections(callback);
+}
+
+void MeshNode::update()
+{
+    node->update();
+    layoutChangedAt = node->layoutChangedAt;
+}
+
+bool MeshNode::sendSingle(uint32_t dest, String msg, painlessmesh::protocol::Priority priority)
+{
+    return node->sendSingle(dest, msg.c_str(), priority);
+}
+
+bool MeshNode::sendBroadcast(String msg, bool includeSelf)
+{
+    return node->sendBroadcast(msg.c_str(), includeSelf);
+}
+
+bool MeshNode::isConnected(uint32_t nodeId)     { return node->isConnected(nodeId); }
+
+String MeshNode::subConnectionJson(bool pretty)
+{
+    return String(node->subConnectionJson(pretty).c_str());
+}
+
+painlessmesh::layout::Traffic MeshNode::traffic()  { return node->traffic(); }
+
+// The device auth service: /auth/get hands out an authKey for a device
+// name, /auth the credentials for an authKey
+static std::string param(const std::string & url, const char * key)
+{
+    size_t at = url.find(key);
+
+    if (at == std::string::npos) return "";
+
+    at += strlen(key);
+
+    return url.substr(at, url.find('&', at) - at);
+}
+
+String mesh_cloud_get(const String & url)
+{
+    std::string get = url.c_str();
+    std::string reply;
+
+    if (get.find("/api/v1/user/device/auth/get?") != std::string::npos)
+    {
+        std::string name = param(get, "deviceName=");
+
+        if (name.size()) reply = "{\"message\":1000,\"detail\":{\"authKey\":\"key" + name + "\"}}";
+    }
+    else if (get.find("/api/v1/user/device/auth?") != std::string::npos)
+    {
+        std::string key = param(get, "authKey=");
+
+        if (key.compare(0, 3, "key") == 0)
+        {
+            std::string name = key.substr(3);
+
+            reply = "{\"message\":1000,\"detail\":{\"deviceName\":\"DEV" + name +
+                "\",\"iotId\":\"id" + name + "\",\"iotToken\":\"token\"" +
+                ",\"productKey\":\"blinker\",\"broker\":\"aliyun\"" +
+                ",\"uuid\":\"user" + name + "\",\"authKey\":\"" + key + "\"}}";
+        }
+    }
+
+    return String(reply.c_str());
+}
+
+// Sent time of every command on its way, by sequence number
+static std::map<uint32_t, unsigned long> pending;
+static std::vector<uint32_t> latency;
+static uint32_t seq = 0;
+static uint32_t delivered = 0;
+
+static uint32_t seqOf(const char * msg)
+{
+    const char * at = strstr(msg, "\"seq\":");
+
+    return at ? atol(at + 6) : 0;
+}
+
+// A reply the gateway published for a sub-device
+bool mesh_cloud_publish(const char *, const char * payload)
+{
+    if (!strstr(payload, "\"subDevice\"")) return true;
+
+    auto it = pending.find(seqOf(payload));
+
+    if (it != pending.end())
+    {
+        latency.push_back(micros() - it->second);
+        pending.erase(it);
+        delivered++;
+    }
+
+    return true;
+}
+
+// The widget callback of every sub-device
+static const char * reply(const char * command)
+{
+    static char data[64];
+
+    snprintf(data, sizeof(data), "{\"btn-abc\":{\"swi\":\"on\"},\"seq\":%lu}",
+            (unsigned long)seqOf(command));
+
+    return data;
+}
+
+static boost::asio::io_service io;
+// The nodes start listening on the first run of their adapter, poll() must
+// not find the service out of work before that
+static boost::asio::io_service::work busy(io);
+static std::vector<std::unique_ptr<SimNode> > nodes;
+static std::vector<SubDevice *> subs;
+static std::vector<bool> running;
+
+// One loop() of every device
+static void pump(unsigned long ms)
+{
+    unsigned long end = millis() + ms;
+
+    do
+    {
+        io.poll();
+
+        mesh_current = 1;
+        gateway_run();
+
+        for (uint32_t num = 1; num < nodes.size(); num++)
+        {
+            if (!running[num]) continue;
+
+            mesh_current = num + 1;
+            subdevice_run(subs[num], reply);
+        }
+    } while (millis() < end);
+}
+
+// Runs until done() or limit, returns the time taken in ms
+template <typename F>
+static unsigned long settle(F done, unsigned long limit)
+{
+    unsigned long from = millis();
+
+    while (!done() && millis() - from < limit) pump(10);
+
+    return millis() - from;
+}
+
+static uint32_t percentile(std::vector<uint32_t> & v, uint32_t pct)
+{
+    if (v.empty()) return 0;
+
+    size_t num = (v.size() - 1) * pct / 100;
+
+    std::nth_element(v.begin(), v.begin() + num, v.end());
+
+    return v[num];
+}
+
+static uint32_t bytesSent()
+{
+    uint32_t bytes = 0;
+
+    for (auto && node : nodes) bytes += node->traffic().bytesSent;
+
+    return bytes;
+}
+
+int main(int argc, char * argv[])
+{
+    uint32_t count = argc > 1 ? atol(argv[1]) : 50;
+
+    if (count < 2 || count > SIM_MAX_NODES)
+    {
+        printf("usage: %s [nodes], 2 to %u\n", argv[0], SIM_MAX_NODES);
+        return 1;
+    }
+
+    // Three sockets a node
+    struct rlimit files;
+
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = std::min<rlim_t>(files.rlim_max, count * 4 + 64);
+    setrlimit(RLIMIT_NOFILE, &files);
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    Serial.verbose = getenv("MESH_VERBOSE") != NULL;
+    Log.setLogLevel(painlessmesh::logger::ERROR);
+
+    for (uint32_t num = 0; num < count; num++)
+    {
+        nodes.emplace_back(new SimNode(io, num + 1, SIM_PORT + num,
+            num ? SIM_PORT + (num - 1) / SIM_FANOUT : 0));
+        running.push_back(true);
+    }
+
+    subs.push_back(NULL);
+    for (uint32_t num = 1; num < count; num++)
+    {
+        mesh_current = num + 1;
+        subs.push_back(subdevice_new(nodes[num].get(), MESH_KEY, MESH_TYPE));
+    }
+
+    #if defined(BLINKER_MESH_MSGPACK)
+        printf("%lu nodes, msgpack wire format\n\n", (unsigned long)count);
+    #else
+        printf("%lu nodes, json wire format\n\n", (unsigned long)count);
+    #endif
+
+    mesh_current = 1;
+    check(gateway_begin(nodes[0].get()), "gateway registered with the cloud");
+
+    // The mesh forms, the first run of each adapter starts its node
+    unsigned long took = settle([count]() {
+        for (auto && node : nodes)
+        {
+            if (node->getNodeList().size() != count - 1) return false;
+        }
+        return true;
+    }, 120000UL);
+
+    printf("mesh formed\n");
+    printf("  converged in %.2f s\n", took / 1000.0);
+    check(took < 120000UL, "every node knows every node");
+
+    // whois, device info and the cloud registration of each sub-device
+    took = settle([count]() {
+        if (gateway_registered() != count - 1) return false;
+
+        for (uint32_t num = 1; num < count; num++)
+        {
+            if (!subdevice_registered(subs[num])) return false;
+        }
+        return true;
+    }, 120000UL);
+
+    uint32_t registered = 0;
+
+    for (uint32_t num = 1; num < count; num++)
+    {
+        if (subdevice_registered(subs[num])) registered++;
+    }
+
+    printf("sub-devices registered\n");
+    printf("  %lu of %lu in %.2f s, the gateway knows %lu\n",
+            (unsigned long)registered, (unsigned long)(count - 1), took / 1000.0,
+            (unsigned long)gateway_registered());
+    check(registered == count - 1 && gateway_registered() == count - 1,
+            "every sub-device has its credentials");
+
+    // Sync traffic settles down before the counters start
+    pump(500);
+
+    // App commands through the cloud, each sub-device gets one a round
+    uint32_t bytes = bytesSent();
+
+    for (uint32_t round = 0; round < SIM_COMMANDS; round++)
+    {
+        for (uint32_t num = 1; num < count; num++)
+        {
+            std::string name = macName(num + 1);
+            char data[64];
+
+            snprintf(data, sizeof(data), "{\"btn-abc\":\"tap\",\"seq\":%lu}",
+                    (unsigned long)++seq);
+            pending[seq] = micros();
+
+            mesh_cloud_inbox.push_back("{\"fromDevice\":\"user" + name +
+                "\",\"toDevice\":\"DEV" + macName(1) +
+                "\",\"subDevice\":\"DEV" + name +
+                "\",\"deviceType\":\"OwnApp\",\"data\":" + data + "}");
+        }
+
+        pump(SIM_COMMAND_GAP);
+    }
+
+    settle([]() { return pending.empty(); }, 30000UL);
+
+    // Both legs went over the wire
+    printf("commands and replies\n");
+    printf("  %lu of %lu answered, p50 %.2f ms, p99 %.2f ms, %.1f B/msg on the wire\n",
+            (unsigned long)delivered, (unsigned long)((count - 1) * SIM_COMMANDS),
+            percentile(latency, 50) / 1000.0, percentile(latency, 99) / 1000.0,
+            delivered ? (double)(bytesSent() - bytes) / 2 / delivered : 0.0);
+    check(delivered == (count - 1) * SIM_COMMANDS, "every command answered");
+
+    // A leaf leaves, MeshConnection::close() on its parent
+    uint32_t leaf = count - 1;
+    SimNode & parent = *nodes[(leaf - 1) / SIM_FANOUT];
+    SimNode & gate = *nodes[0];
+
+    painlessmesh::layout::Traffic before = parent.traffic();
+    uint32_t changed = parent.layoutChangedAt;
+
+    nodes[leaf]->stop();
+    running[leaf] = false;
+
+    took = settle([&gate, count]() {
+        return gate.getNodeList().size() == count - 2;
+    }, 30000UL);
+
+    painlessmesh::layout::Traffic after = parent.traffic();
+
+    printf("leaf %lu left\n", (unsigned long)(leaf + 1));
+    printf("  gateway saw it in %.2f s\n", took / 1000.0);
+    check(took < 30000UL, "the gateway dropped the leaf");
+    check(parent.layoutChangedAt != changed, "parent marked the layout changed");
+    check(parent.closedTraffic.bytesSent > 0, "parent kept the closed link traffic");
+    check(after.bytesSent >= before.bytesSent &&
+          after.bytesReceived >= before.bytesReceived, "parent totals didn't go back");
+
+    printf("\n%s\n", failed ? "FAILED" : "passed");
+
+    nodes.clear();
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+// The sub-devices of the mesh harness, the library's BlinkerSubDevice
+// adapter as it is, on every node but the first. See mesh.cpp for the build
+// line and gate.cpp for why it sits in a namespace.
+//
+// The adapter keeps its state in globals, SubDevice holds the state of one
+// node and swaps it in around every run like the fleet simulator does.
+// meshDoc is left shared, a message parsed into it is handled before
+// meshCheck() returns. The JSON arena and the metrics the adapter includes
+// are defined in gate.cpp too, the sub-devices get their own copy inside
+// the namespace.
+
+#define BLINKER_WIFI_SUBDEVICE
+#define BLINKER_LOG_LEVEL               BLINKER_LOG_LEVEL_NONE
+#define BLINKER_ARDUINOJSON
+
+#include <algorithm>
+
+#include <Arduino.h>
+#include <ESP8266mDNS.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#include <EEPROM.h>
+#include "MeshNode.h"
+#include "MeshDevices.h"
+
+#include "Blinker/BlinkerConfig.h"
+#include "Blinker/BlinkerDebug.h"
+#include "Blinker/BlinkerUtility.h"
+#include "Blinker/BlinkerSupervisor.h"
+#include "modules/ArduinoJson/ArduinoJson.h"
+
+// The node clock is the wall clock, the time the gateway hands out is not
+// set on the host
+struct sim_timezone
+{
+    int tz_minuteswest;
+    int tz_dsttime;
+};
+
+static inline int sim_settimeofday(const timeval *, const sim_timezone *) { return 0; }
+
+#define painlessMesh    MeshNode
+#define IPAddress       MeshIPAddress
+#define timezone        sim_timezone
+#define settimeofday    sim_settimeofday
+
+namespace sub
+{
+    #include "Blinker/BlinkerStream.h"
+    #include "Adapters/BlinkerSubDevice.h"
+}
+
+#undef timezone
+#undef settimeofday
+
+class SubDevice
+{
+    public :
+        SubDevice(SimNode * node)
+            : msgBuf_mesh(NULL), isFresh_mesh(false), isAvail_mesh(false)
+            , msgBuf_PRO(NULL), isFresh_PRO(false), isAvail_PRO(false)
+            , AUTHKEY_PRO(NULL), UUID_PRO(NULL), MQTT_DEVICEID_PRO(NULL)
+            , isTimeSet(false), mesh_timezone(8.0), isNewConnect(false)
+            , _sharerCount(0), _sharerFrom(BLINKER_MQTT_FROM_AUTHER)
+            , isAlive(false), kaTime(0), _needCheckShare(false), latestTime(0)
+            , aliKaTime(0), isAliAlive(false), isAliAvail(false)
+            , duerKaTime(0), isDuerAlive(false), isDuerAvail(false)
+            , miKaTime(0), isMIOTAlive(false), isMIOTAvail(false)
+        {
+            mesh.node = node;
+            memset(_sharers, 0, sizeof(_sharers));
+        }
+
+        void swap()
+        {
+            std::swap(msgBuf_mesh, sub::msgBuf_mesh);
+            std::swap(isFresh_mesh, sub::isFresh_mesh);
+            std::swap(isAvail_mesh, sub::isAvail_mesh);
+            std::swap(msgBuf_PRO, sub::msgBuf_PRO);
+            std::swap(isFresh_PRO, sub::isFresh_PRO);
+            std::swap(isAvail_PRO, sub::isAvail_PRO);
+            std::swap(AUTHKEY_PRO, sub::AUTHKEY_PRO);
+            std::swap(UUID_PRO, sub::UUID_PRO);
+            std::swap(MQTT_DEVICEID_PRO, sub::MQTT_DEVICEID_PRO);
+            std::swap(mesh, sub::mesh);
+            std::swap(isTimeSet, sub::isTimeSet);
+            std::swap(mesh_timezone, sub::mesh_timezone);
+            std::swap(isNewConnect, sub::isNewConnect);
+            std::swap(_sharers, sub::_sharers);
+            std::swap(_sharerCount, sub::_sharerCount);
+            std::swap(_sharerFrom, sub::_sharerFrom);
+            std::swap(isAlive, sub::isAlive);
+            std::swap(kaTime, sub::kaTime);
+            std::swap(_needCheckShare, sub::_needCheckShare);
+            std::swap(latestTime, sub::latestTime);
+            std::swap(aliKaTime, sub::aliKaTime);
+            std::swap(isAliAlive, sub::isAliAlive);
+            std::swap(isAliAvail, sub::isAliAvail);
+            std::swap(duerKaTime, sub::duerKaTime);
+            std::swap(isDuerAlive, sub::isDuerAlive);
+            std::swap(isDuerAvail, sub::isDuerAvail);
+            std::swap(miKaTime, sub::miKaTime);
+            std::swap(isMIOTAlive, sub::isMIOTAlive);
+            std::swap(isMIOTAvail, sub::isMIOTAvail);
+        }
+
+        sub::BlinkerSubDevice   device;
+
+    private :
+        char *                  msgBuf_mesh;
+        bool                    isFresh_mesh;
+        bool                    isAvail_mesh;
+        char *                  msgBuf_PRO;
+        bool                    isFresh_PRO;
+        bool                    isAvail_PRO;
+        char *                  AUTHKEY_PRO;
+        char *                  UUID_PRO;
+        char *                  MQTT_DEVICEID_PRO;
+        MeshNode                mesh;
+        bool                    isTimeSet;
+        float                   mesh_timezone;
+        bool                    isNewConnect;
+        BlinkerSharer *         _sharers[BLINKER_MQTT_MAX_SHARERS_NUM];
+        uint8_t                 _sharerCount;
+        uint8_t                 _sharerFrom;
+        bool                    isAlive;
+        uint32_t                kaTime;
+        bool                    _needCheckShare;
+        uint32_t                latestTime;
+        uint32_t                aliKaTime;
+        bool                    isAliAlive;
+        bool                    isAliAvail;
+        uint32_t                duerKaTime;
+        bool                    isDuerAlive;
+        bool                    isDuerAvail;
+        uint32_t                miKaTime;
+        bool                    isMIOTAlive;
+        bool                    isMIOTAvail;
+};
+
+SubDevice * subdevice_new(SimNode * node, const char * key, const char * type)
+{
+    SubDevice * sub = new SubDevice(node);
+
+    sub->swap();
+    sub->device.begin(key, type);
+    sub->swap();
+
+    return sub;
+}
+
+// BlinkerApi::run() for a sub-device, with the command answered where a
+// sketch would answer it from its widget callback
+void subdevice_run(SubDevice * sub, const char * (*reply)(const char * command))
+{
+    sub->swap();
+
+    sub::BlinkerStream & stream = sub->device;
+
+    stream.meshCheck();
+
+    if (sub->device.available())
+    {
+        char data[BLINKER_MAX_SEND_SIZE];
+
+        strncpy(data, reply(sub->device.lastRead()), 256);
+        data[256] = '\0';
+
+        sub->device.print(data);
+        sub->device.flush();
+    }
+
+    sub->swap();
+}
+
+bool subdevice_registered(SubDevice * sub)
+{
+    return sub->device.init();
+}
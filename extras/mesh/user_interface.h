@@ -0,0 +1,19 @@
+#ifndef BLINKER_MESH_USER_INTERFACE_H
+#define BLINKER_MESH_USER_INTERFACE_H
+
+// The one SDK call BlinkerUtility.cpp makes, mesh.cpp answers with the MAC
+// of the node being run
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool wifi_get_macaddr(uint8_t if_index, uint8_t * mac);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
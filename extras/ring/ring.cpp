@@ -0,0 +1,208 @@
+// Thread test for BlinkerRing, the queues between the ESP32 network task
+// and Blinker.run().
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++11 -O2 -Isrc extras/ring/ring.cpp -o ring -lpthread
+//   ./ring [messages]
+//
+// Add -fsanitize=thread to have the memory ordering checked as well.
+//
+// Two std::threads stand in for the two cores and use two rings the way
+// BlinkerMQTT does with BLINKER_WITH_NET_TASK:
+// - the "net" thread fills messages in place on the rx ring, like
+//   netPoll(), and reads the replies off the tx ring, like netSend();
+// - the "app" thread reads each message off the rx ring, like run(), and
+//   answers it on the tx ring, like print().
+// Each message carries its sequence number and a payload derived from it.
+// Both sides check they read every message once, in order and whole,
+// while the other side is writing the next slot. A full ring is left to
+// the producer, which spins until a slot frees up.
+//
+// It runs with 2, 4 and 64 slots and prints the round trips a second.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#include "Blinker/BlinkerRing.h"
+
+#define SIM_DATA            64
+
+static uint32_t failed = 0;
+
+static void check(bool ok, const char * what)
+{
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failed++;
+}
+
+struct SimMsg
+{
+    uint32_t    seq;
+    uint8_t     len;
+    char        data[SIM_DATA];
+};
+
+static void fill(SimMsg & msg, uint32_t seq, char salt)
+{
+    msg.seq = seq;
+    msg.len = 1 + seq % (SIM_DATA - 1);
+
+    for (uint8_t num = 0; num < msg.len; num++)
+    {
+        msg.data[num] = (char)(seq * 31 + num + salt);
+    }
+}
+
+static bool whole(const SimMsg & msg, uint32_t seq, char salt)
+{
+    if (msg.seq != seq || msg.len != 1 + seq % (SIM_DATA - 1)) return false;
+
+    for (uint8_t num = 0; num < msg.len; num++)
+    {
+        if (msg.data[num] != (char)(seq * 31 + num + salt)) return false;
+    }
+    return true;
+}
+
+struct SimResult
+{
+    uint32_t    rxBad;      // messages the app thread read wrong
+    uint32_t    txBad;      // replies the net thread read wrong
+    uint32_t    replies;
+    double      wall;       // s
+};
+
+template <uint8_t SLOTS>
+static SimResult run(uint32_t count)
+{
+    BlinkerRing<SimMsg, SLOTS> rx;
+    BlinkerRing<SimMsg, SLOTS> tx;
+    SimResult r = { 0, 0, 0, 0 };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::thread app([&]() {
+        for (uint32_t seq = 0; seq < count; seq++)
+        {
+            SimMsg * in;
+
+            while ((in = rx.front()) == NULL) std::this_thread::yield();
+
+            if (!whole(*in, seq, 'r')) r.rxBad++;
+
+            rx.pop();
+
+            SimMsg * out;
+
+            while ((out = tx.back()) == NULL) std::this_thread::yield();
+
+            fill(*out, seq, 't');
+            tx.push();
+        }
+    });
+
+    uint32_t sent = 0;
+
+    while (r.replies < count)
+    {
+        SimMsg * out = sent < count ? rx.back() : NULL;
+
+        if (out)
+        {
+            fill(*out, sent++, 'r');
+            rx.push();
+        }
+
+        SimMsg * in = tx.front();
+
+        if (in)
+        {
+            if (!whole(*in, r.replies, 't')) r.txBad++;
+
+            r.replies++;
+            tx.pop();
+        }
+
+        if (out == NULL && in == NULL) std::this_thread::yield();
+    }
+
+    app.join();
+
+    r.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return r;
+}
+
+template <uint8_t SLOTS>
+static void row(uint32_t count)
+{
+    SimResult r = run<SLOTS>(count);
+    char what[64];
+
+    printf("%5u %10lu %12.0f\n", (unsigned)SLOTS, (unsigned long)r.replies,
+            r.replies / r.wall);
+
+    snprintf(what, sizeof(what), "%u slots, every message whole and in order", (unsigned)SLOTS);
+    check(r.rxBad == 0 && r.txBad == 0 && r.replies == count, what);
+}
+
+int main(int argc, char * argv[])
+{
+    uint32_t count = argc > 1 ? atol(argv[1]) : 1000000;
+
+    if (count == 0)
+    {
+        printf("usage: %s [messages]\n", argv[0]);
+        return 1;
+    }
+
+    // One thread, the edges
+    BlinkerRing<SimMsg, 4> ring;
+
+    printf("one thread\n");
+    check(ring.front() == NULL && ring.size() == 0, "a new ring is empty");
+
+    for (uint32_t seq = 0; seq < 4; seq++)
+    {
+        fill(*ring.back(), seq, 'r');
+        ring.push();
+    }
+    check(ring.full() && ring.back() == NULL, "a full ring refuses the fifth");
+
+    bool fifo = true;
+
+    for (uint32_t seq = 0; seq < 4; seq++)
+    {
+        fifo = fifo && ring.front() && whole(*ring.front(), seq, 'r');
+        ring.pop();
+    }
+    check(fifo && ring.size() == 0, "it gives them back in order");
+
+    // The slot index wraps every SLOTS elements
+    bool wraps = true;
+
+    for (uint32_t seq = 0; seq < 1000; seq++)
+    {
+        fill(*ring.back(), seq, 'r');
+        ring.push();
+        wraps = wraps && ring.size() == 1 && whole(*ring.front(), seq, 'r');
+        ring.pop();
+    }
+    check(wraps, "slots are reused in turn");
+
+    printf("\ntwo threads, %lu round trips\n\n", (unsigned long)count);
+    printf("%5s %10s %12s\n", "slots", "replies", "trips/s");
+
+    row<2>(count);
+    row<4>(count);
+    row<64>(count);
+
+    printf("\n%s\n", failed ? "FAILED" : "passed");
+
+    return failed ? 1 : 0;
+}
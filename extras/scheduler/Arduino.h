@@ -0,0 +1,18 @@
+#ifndef BLINKER_SCHEDULER_ARDUINO_H
+#define BLINKER_SCHEDULER_ARDUINO_H
+
+// The part of the Arduino core TaskScheduler uses, enough to build it on
+// Linux for the scheduler benchmark. millis() and micros() read the
+// simulated clock, not the wall clock.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+
+unsigned long millis(void);
+unsigned long micros(void);
+
+#endif
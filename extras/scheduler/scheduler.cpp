@@ -0,0 +1,154 @@
+// Pass cost benchmark for the TaskScheduler run queue, the chain walk
+// against _TASK_HEAP_QUEUE.
+//
+// Build and run from the library root, once for each queue:
+//
+//   g++ -std=c++11 -O2 -Iextras/scheduler -Isrc/modules extras/scheduler/scheduler.cpp -o scheduler
+//   g++ -std=c++11 -O2 -D_TASK_HEAP_QUEUE -Iextras/scheduler -Isrc/modules extras/scheduler/scheduler.cpp -o scheduler_heap
+//   ./scheduler [seconds] && ./scheduler_heap [seconds]
+//
+// The scheduler is set up like painlessMesh sets it up. Each run registers
+// 10 to 1000 periodic tasks with the intervals a mesh connection uses:
+// 100 ms, 1 s, 10 s and 60 s, started at staggered times. It then runs them
+// for a minute of simulated time in two ways:
+// - "spinning" calls execute() every millisecond, like Mesh::update() in a
+//   busy loop();
+// - "tickless" jumps the clock by timeUntilNextTask() between passes, like a
+//   loop that sleeps until the next task is due.
+//
+// Each row shows the wall time per pass, the passes a second and the wall
+// time per simulated second. The program fails when the two ways don't run
+// every task the same number of times.
+
+#define _TASK_PRIORITY
+#define _TASK_STD_FUNCTION
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "TaskScheduler/TaskScheduler.h"
+
+#define SIM_COUNTS          { 10, 30, 100, 300, 1000 }
+
+static unsigned long sim_now = 0;
+
+unsigned long millis(void)  { return sim_now; }
+unsigned long micros(void)  { return sim_now * 1000UL; }
+
+static uint32_t failed = 0;
+
+static void check(bool ok, const char * what)
+{
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failed++;
+}
+
+struct SimResult
+{
+    uint64_t    passes;
+    uint64_t    runs;
+    double      wall;       // s
+};
+
+static SimResult run(uint32_t count, uint32_t span, bool tickless)
+{
+    static const unsigned long intervals[] = { 100, 1000, 10000, 60000 };
+
+    Scheduler scheduler;
+    std::vector<Task *> tasks;
+    SimResult r = { 0, 0, 0 };
+
+    sim_now = 0;
+
+    for (uint32_t num = 0; num < count; num++)
+    {
+        Task * task = new Task(intervals[num % 4], TASK_FOREVER,
+                                [&r]() { r.runs++; });
+
+        scheduler.addTask(*task);
+        task->enableDelayed(num * 7 % intervals[num % 4]);
+        tasks.push_back(task);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    while (sim_now < span)
+    {
+        scheduler.execute();
+        r.passes++;
+
+        if (!tickless)
+        {
+            sim_now++;
+            continue;
+        }
+
+        long wait = scheduler.timeUntilNextTask();
+
+        sim_now += wait > 0 ? wait : 1;
+    }
+
+    r.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t num = 0; num < tasks.size(); num++) delete tasks[num];
+
+    return r;
+}
+
+static void row(const char * name, uint32_t count, const SimResult & r, uint32_t span)
+{
+    double s = span / 1000.0;
+
+    printf("%-9s %5lu %10.1f %11.1f %12.1f %10lu\n",
+            name, (unsigned long)count, r.wall * 1e9 / r.passes,
+            r.passes / s, r.wall * 1e6 / s, (unsigned long)r.runs);
+}
+
+int main(int argc, char * argv[])
+{
+    uint32_t seconds = argc > 1 ? atol(argv[1]) : 60;
+    const uint32_t counts[] = SIM_COUNTS;
+
+    if (seconds == 0)
+    {
+        printf("usage: %s [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t span = seconds * 1000;
+
+    #ifdef _TASK_HEAP_QUEUE
+        printf("_TASK_HEAP_QUEUE, %lu s\n\n", (unsigned long)seconds);
+    #else
+        printf("task chain, %lu s\n\n", (unsigned long)seconds);
+    #endif
+    printf("%-9s %5s %10s %11s %12s %10s\n",
+            "loop", "tasks", "ns/pass", "passes/s", "us/sim s", "runs");
+
+    std::vector<bool> same;
+
+    for (size_t num = 0; num < sizeof(counts) / sizeof(counts[0]); num++)
+    {
+        SimResult spin = run(counts[num], span, false);
+        SimResult tick = run(counts[num], span, true);
+
+        row("spinning", counts[num], spin, span);
+        row("tickless", counts[num], tick, span);
+
+        same.push_back(spin.runs == tick.runs);
+    }
+
+    printf("\n");
+
+    bool all = true;
+
+    for (size_t num = 0; num < same.size(); num++) all = all && same[num];
+
+    check(all, "tickless runs every task as often");
+
+    printf("\n%s\n", failed ? "FAILED" : "passed");
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,311 @@
+// Reconnect test for BlinkerSupervisor, a fleet of devices against a broker
+// and auth server stand-in.
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++11 -O2 -Isrc extras/supervisor/supervisor.cpp src/Blinker/BlinkerSupervisor.cpp -o supervisor
+//   ./supervisor [devices]
+//
+// Each device drives its own BlinkerSupervisor the way BlinkerApi::run()
+// drives the WiFi link and BlinkerMQTT::connect() and reRegister() drive the
+// MQTT and auth links. The broker takes a tenth of the fleet a second and
+// refuses the rest as unavailable. It rejects outdated credentials as a bad
+// user name or password, like Adafruit_MQTT does with code 4. The auth
+// server serves a 25th of the fleet a second.
+//
+// Scenarios:
+// - the access point reboots and stays down for a minute;
+// - the broker is down for 30 s;
+// - the broker rotates credentials, every device has to auth again.
+//
+// Each one prints the connect rate at the broker and the time to reconnect.
+// The program fails when a device doesn't come back, or retries in
+// lockstep, or asks for a new auth it doesn't need.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Blinker/BlinkerSupervisor.h"
+
+#define SIM_STEP            100UL
+#define SIM_ASSOCIATE       3000UL      // WiFi.reconnect() to WL_CONNECTED
+
+static uint32_t failed = 0;
+
+static void check(bool ok, const char * what)
+{
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failed++;
+}
+
+class SimBroker
+{
+    public :
+        SimBroker(uint32_t rate)
+            : up(true), credentials(1), _rate(rate), _second(0), _count(0)
+        {}
+
+        bool        up;
+        uint32_t    credentials;
+
+        // Adafruit_MQTT::connect() return codes
+        int8_t connect(uint32_t now, uint32_t key)
+        {
+            hits.push_back(now);
+
+            if (!up) return -1;
+            if (!admit(now)) return 3;
+            if (key != credentials) return 4;
+
+            return 0;
+        }
+
+        std::vector<uint32_t> hits;
+
+    private :
+        uint32_t    _rate;
+        uint32_t    _second;
+        uint32_t    _count;
+
+        bool admit(uint32_t now)
+        {
+            if (now / 1000 != _second)
+            {
+                _second = now / 1000;
+                _count = 0;
+            }
+
+            return _count++ < _rate;
+        }
+};
+
+class SimAuth
+{
+    public :
+        SimAuth(uint32_t rate) : requests(0), _rate(rate), _second(0), _count(0) {}
+
+        uint32_t    requests;
+
+        bool request(uint32_t now)
+        {
+            requests++;
+
+            if (now / 1000 != _second)
+            {
+                _second = now / 1000;
+                _count = 0;
+            }
+
+            return _count++ < _rate;
+        }
+
+    private :
+        uint32_t    _rate;
+        uint32_t    _second;
+        uint32_t    _count;
+};
+
+struct SimDevice
+{
+    BlinkerSupervisor   sup;
+    uint32_t            associated;     // WiFi up from then, 0 while not
+    uint32_t            reconTime;      // BlinkerApi::_reconTime
+    bool                mqtt;
+    uint32_t            key;
+};
+
+static bool apUp = true;
+static uint32_t apUpAt = 0;
+
+static void reRegister(SimDevice & d, SimAuth & auth, SimBroker & broker, uint32_t now)
+{
+    if (!d.sup.ready(BLINKER_LINK_AUTH, now)) return;
+
+    d.sup.attempt(BLINKER_LINK_AUTH, now);
+
+    if (auth.request(now))
+    {
+        d.key = broker.credentials;
+        d.sup.success(BLINKER_LINK_AUTH, now);
+    }
+    else d.sup.failure(BLINKER_LINK_AUTH, now, BLINKER_FAIL_AUTH);
+}
+
+static void step(SimDevice & d, SimBroker & broker, SimAuth & auth, uint32_t now)
+{
+    if (!apUp) d.associated = 0;
+
+    if (!d.associated)
+    {
+        d.mqtt = false;
+
+        if (d.sup.ready(BLINKER_LINK_WIFI, now))
+        {
+            d.reconTime = now;
+            d.sup.attempt(BLINKER_LINK_WIFI, now);
+            d.sup.failure(BLINKER_LINK_WIFI, now, BLINKER_FAIL_WIFI);
+
+            // WiFi.reconnect()
+            if (apUp) d.associated = std::max(now, apUpAt) + SIM_ASSOCIATE;
+        }
+        return;
+    }
+
+    if (now < d.associated) return;
+
+    if (d.reconTime)
+    {
+        d.reconTime = 0;
+        d.sup.success(BLINKER_LINK_WIFI, now);
+    }
+
+    if (d.mqtt) return;
+
+    if (!d.sup.ready(BLINKER_LINK_MQTT, now)) return;
+
+    d.sup.attempt(BLINKER_LINK_MQTT, now);
+
+    int8_t ret = broker.connect(now, d.key);
+
+    if (ret != 0)
+    {
+        d.sup.failure(BLINKER_LINK_MQTT, now,
+            ret == 4 ? BLINKER_FAIL_REJECTED : BLINKER_FAIL_MQTT);
+
+        if (d.sup.needReauth()) reRegister(d, auth, broker, now);
+        return;
+    }
+
+    d.sup.success(BLINKER_LINK_MQTT, now);
+    d.mqtt = true;
+}
+
+// Runs until every device is back or limit passes, returns the time taken
+static uint32_t settle(std::vector<SimDevice> & fleet, SimBroker & broker,
+                        SimAuth & auth, uint32_t & now, uint32_t limit)
+{
+    uint32_t start = now;
+
+    for (; now - start < limit; now += SIM_STEP)
+    {
+        if (!apUp && now >= apUpAt) apUp = true;
+
+        bool all = apUp;
+
+        for (size_t num = 0; num < fleet.size(); num++)
+        {
+            step(fleet[num], broker, auth, now);
+            all = all && fleet[num].mqtt;
+        }
+
+        if (all) break;
+    }
+
+    return now - start;
+}
+
+static uint32_t peakRate(const std::vector<uint32_t> & hits)
+{
+    uint32_t peak = 0;
+    size_t from = 0;
+
+    for (size_t num = 0; num < hits.size(); num++)
+    {
+        while (hits[num] - hits[from] >= 1000) from++;
+        peak = std::max(peak, (uint32_t)(num - from + 1));
+    }
+
+    return peak;
+}
+
+static void report(const char * name, SimBroker & broker, SimAuth & auth,
+                    uint32_t took)
+{
+    printf("%s\n", name);
+    printf("  settled in %.1f s, %lu connects, peak %lu/s, %lu auth requests\n",
+            took / 1000.0, (unsigned long)broker.hits.size(),
+            (unsigned long)peakRate(broker.hits), (unsigned long)auth.requests);
+}
+
+int main(int argc, char * argv[])
+{
+    uint32_t count = argc > 1 ? atol(argv[1]) : 500;
+    uint32_t rate = count / 10 + 1;
+    uint32_t now = 1;
+
+    std::vector<SimDevice> fleet(count);
+    SimBroker broker(rate);
+    SimAuth auth(count / 25 + 1);
+
+    for (uint32_t num = 0; num < count; num++)
+    {
+        SimDevice & d = fleet[num];
+
+        // the adapters seed from the hardware rng
+        d.sup.seed(num * 2654435761UL + 1);
+        d.associated = 1;
+        d.reconTime = 0;
+        d.mqtt = false;
+        d.key = broker.credentials;
+    }
+
+    settle(fleet, broker, auth, now, 600000UL);
+
+    printf("%lu devices, broker takes %lu connects/s\n\n",
+            (unsigned long)count, (unsigned long)rate);
+
+    // The access point reboots
+    broker.hits.clear();
+    apUp = false;
+    apUpAt = now + 60000UL;
+
+    uint32_t took = settle(fleet, broker, auth, now, 900000UL);
+
+    report("access point down for 60 s", broker, auth, took);
+    check(took < 60000UL + BLINKER_RECONNECT_MAX, "every device back");
+    check(peakRate(broker.hits) <= rate * 2, "broker connects spread out");
+    check(auth.requests == 0, "resumed on cached credentials");
+    check(fleet[0].sup.lastReason() == BLINKER_FAIL_WIFI, "last failure is the WiFi link");
+    check(fleet[0].sup.connectTime(BLINKER_LINK_WIFI) >= 60000UL, "WiFi time to connect counted");
+
+    // The broker restarts
+    broker.hits.clear();
+    broker.up = false;
+
+    for (uint32_t num = 0; num < count; num++) fleet[num].mqtt = false;
+
+    for (uint32_t end = now + 30000UL; now < end; now += SIM_STEP)
+    {
+        for (uint32_t num = 0; num < count; num++) step(fleet[num], broker, auth, now);
+    }
+
+    broker.up = true;
+    broker.hits.clear();
+    took = settle(fleet, broker, auth, now, 900000UL);
+
+    report("broker back after 30 s", broker, auth, took);
+    check(took < 2 * BLINKER_RECONNECT_MAX, "every device back");
+    check(peakRate(broker.hits) <= rate * 2, "broker connects spread out");
+    check(auth.requests <= count, "at most one auth each");
+
+    // The broker rotates credentials
+    broker.hits.clear();
+    auth.requests = 0;
+    broker.credentials++;
+
+    for (uint32_t num = 0; num < count; num++) fleet[num].mqtt = false;
+
+    took = settle(fleet, broker, auth, now, 900000UL);
+
+    report("credentials rotated", broker, auth, took);
+    check(took < 2 * BLINKER_RECONNECT_MAX, "every device back");
+    check(auth.requests >= count, "every device authed again");
+
+    printf("\n%s\n", failed ? "FAILED" : "passed");
+
+    return failed ? 1 : 0;
+}
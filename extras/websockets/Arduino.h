@@ -0,0 +1,206 @@
+#ifndef BLINKER_WS_ARDUINO_H
+#define BLINKER_WS_ARDUINO_H
+
+// The part of the ESP8266 Arduino core the WebSockets module uses, enough
+// to build WebSockets.cpp and WebSocketsServer.cpp on Linux for the frame
+// benchmark. millis() is the wall clock.
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+inline unsigned long millis()
+{
+    timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+inline void randomSeed(unsigned long seed)  { srand(seed); }
+inline long random(long howbig)             { return howbig ? rand() % howbig : 0; }
+inline long random(long howsmall, long howbig)
+{
+    return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+#define RANDOM_REG32        ((uint32_t)rand())
+#define bit(b)              (1UL << (b))
+
+#define F(s)                (s)
+#define PROGMEM
+
+class SimESP
+{
+    public :
+        uint32_t getFreeHeap()      { return 1UL << 24; }
+};
+
+extern SimESP ESP;
+
+// Arduino String, a plain heap buffer like the core's, so the module may
+// memset the structs it keeps Strings in
+class String
+{
+    public :
+        String() : _buf(NULL), _len(0), _cap(0) {}
+        String(const char * s) : _buf(NULL), _len(0), _cap(0)  { copy(s, s ? strlen(s) : 0); }
+        String(const String & s) : _buf(NULL), _len(0), _cap(0) { copy(s._buf, s._len); }
+        String(int v) : _buf(NULL), _len(0), _cap(0)            { number("%d", v); }
+        String(unsigned int v) : _buf(NULL), _len(0), _cap(0)   { number("%u", v); }
+        String(long v) : _buf(NULL), _len(0), _cap(0)           { number("%ld", v); }
+        String(unsigned long v) : _buf(NULL), _len(0), _cap(0)  { number("%lu", v); }
+        ~String()                   { free(_buf); }
+
+        String & operator=(const String & s)    { if (this != &s) copy(s._buf, s._len); return *this; }
+        String & operator=(const char * s)      { copy(s, s ? strlen(s) : 0); return *this; }
+
+        const char * c_str() const  { return _buf ? _buf : ""; }
+        unsigned int length() const { return _len; }
+
+        bool reserve(unsigned int n)
+        {
+            if (n <= _cap && _buf) return true;
+
+            char * buf = (char *)realloc(_buf, n + 1);
+            if (!buf) return false;
+
+            if (!_buf) buf[0] = '\0';
+            _buf = buf;
+            _cap = n;
+            return true;
+        }
+
+        bool concat(const char * s, unsigned int n)
+        {
+            if (!reserve(_len + n)) return false;
+
+            memcpy(_buf + _len, s, n);
+            _len += n;
+            _buf[_len] = '\0';
+            return true;
+        }
+        bool concat(const String & s)           { return concat(s.c_str(), s._len); }
+        bool concat(const char * s)             { return s ? concat(s, strlen(s)) : false; }
+        bool concat(char c)                     { return concat(&c, 1); }
+
+        String & operator+=(const String & s)   { concat(s); return *this; }
+        String & operator+=(const char * s)     { concat(s); return *this; }
+        String & operator+=(char c)             { concat(c); return *this; }
+
+        bool operator==(const String & s) const { return strcmp(c_str(), s.c_str()) == 0; }
+        bool operator==(const char * s) const   { return strcmp(c_str(), s) == 0; }
+        bool operator!=(const String & s) const { return !(*this == s); }
+        bool operator!=(const char * s) const   { return !(*this == s); }
+
+        char operator[](unsigned int n) const   { return n < _len ? _buf[n] : 0; }
+
+        bool equalsIgnoreCase(const String & s) const
+        {
+            return _len == s._len && strcasecmp(c_str(), s.c_str()) == 0;
+        }
+
+        bool startsWith(const String & s) const
+        {
+            return _len >= s._len && strncmp(c_str(), s.c_str(), s._len) == 0;
+        }
+
+        int indexOf(char c, unsigned int from = 0) const
+        {
+            if (from >= _len) return -1;
+
+            const char * p = strchr(_buf + from, c);
+            return p ? p - _buf : -1;
+        }
+        int indexOf(const String & s, unsigned int from = 0) const
+        {
+            if (from >= _len) return -1;
+
+            const char * p = strstr(_buf + from, s.c_str());
+            return p ? p - _buf : -1;
+        }
+
+        // Arduino semantics, the bounds are swapped and clamped
+        String substring(unsigned int left) const { return substring(left, _len); }
+        String substring(unsigned int left, unsigned int right) const
+        {
+            String s;
+
+            if (left > right) { unsigned int t = left; left = right; right = t; }
+            if (left >= _len) return s;
+            if (right > _len) right = _len;
+
+            s.concat(_buf + left, right - left);
+            return s;
+        }
+
+        void remove(unsigned int index, unsigned int count)
+        {
+            if (index >= _len) return;
+            if (count > _len - index) count = _len - index;
+
+            memmove(_buf + index, _buf + index + count, _len - index - count + 1);
+            _len -= count;
+        }
+
+        void toLowerCase()
+        {
+            for (unsigned int i = 0; i < _len; i++) _buf[i] = tolower(_buf[i]);
+        }
+
+        void trim()
+        {
+            unsigned int begin = 0;
+
+            while (begin < _len && isspace(_buf[begin])) begin++;
+            while (_len > begin && isspace(_buf[_len - 1])) _len--;
+
+            if (_buf)
+            {
+                memmove(_buf, _buf + begin, _len - begin);
+                _len -= begin;
+                _buf[_len] = '\0';
+            }
+        }
+
+        long toInt() const          { return atol(c_str()); }
+
+    private :
+        char *          _buf;
+        unsigned int    _len;
+        unsigned int    _cap;
+
+        void copy(const char * s, unsigned int n)
+        {
+            _len = 0;
+            if (_buf) _buf[0] = '\0';
+            if (s) concat(s, n);
+        }
+
+        template <typename T>
+        void number(const char * format, T v)
+        {
+            char buf[32];
+
+            snprintf(buf, sizeof(buf), format, v);
+            copy(buf, strlen(buf));
+        }
+};
+
+inline String operator+(const String & a, const String & b)
+{
+    String s(a);
+    s += b;
+    return s;
+}
+
+inline String operator+(const String & a, const char * b)   { return a + String(b); }
+inline String operator+(const char * a, const String & b)   { return String(a) + b; }
+
+#endif
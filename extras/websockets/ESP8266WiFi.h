@@ -0,0 +1,146 @@
+#ifndef BLINKER_WS_ESP8266WIFI_H
+#define BLINKER_WS_ESP8266WIFI_H
+
+// WiFiClient and WiFiServer of the core over Linux TCP sockets. A client
+// is a copyable handle on the socket like on the ESP, stop() closes it.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+class WiFiClient
+{
+    public :
+        WiFiClient(int fd = -1) : _fd(fd) {}
+        virtual ~WiFiClient() {}
+
+        uint8_t connected()
+        {
+            if (_fd < 0) return 0;
+
+            char c;
+            ssize_t n = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+            return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        }
+
+        int available()
+        {
+            int n = 0;
+
+            if (_fd < 0 || ioctl(_fd, FIONREAD, &n) < 0) return 0;
+            return n;
+        }
+
+        int read(uint8_t * buf, size_t size)
+        {
+            ssize_t n = recv(_fd, buf, size, MSG_DONTWAIT);
+
+            return n > 0 ? n : 0;
+        }
+
+        size_t write(const uint8_t * buf, size_t size)
+        {
+            ssize_t n = send(_fd, buf, size, MSG_NOSIGNAL);
+
+            return n > 0 ? n : 0;
+        }
+        size_t write(const char * s)    { return write((const uint8_t *)s, strlen(s)); }
+
+        String readStringUntil(char terminator)
+        {
+            String line;
+            char c;
+
+            while (recv(_fd, &c, 1, 0) == 1 && c != terminator) line += c;
+
+            return line;
+        }
+
+        void setNoDelay(bool on)
+        {
+            int v = on;
+
+            setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+        }
+        void setTimeout(unsigned long) {}
+
+        IPAddress remoteIP()        { return IPAddress(0x0100007f); }
+
+        void flush() {}
+
+        void stop()
+        {
+            if (_fd >= 0) ::close(_fd);
+            _fd = -1;
+        }
+
+    private :
+        int _fd;
+};
+
+class WiFiClientSecure : public WiFiClient
+{
+};
+
+class WiFiServer
+{
+    public :
+        WiFiServer(uint16_t port) : _port(port), _fd(-1), _next(-1) {}
+
+        void begin()
+        {
+            sockaddr_in addr;
+            int one = 1;
+
+            _fd = socket(AF_INET, SOCK_STREAM, 0);
+            setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(_port);
+
+            bind(_fd, (sockaddr *)&addr, sizeof(addr));
+            listen(_fd, 8);
+            fcntl(_fd, F_SETFL, O_NONBLOCK);
+        }
+
+        bool hasClient()
+        {
+            if (_next < 0 && _fd >= 0) _next = accept(_fd, NULL, NULL);
+
+            return _next >= 0;
+        }
+
+        WiFiClient available()
+        {
+            hasClient();
+
+            WiFiClient client(_next);
+
+            _next = -1;
+            return client;
+        }
+
+        void close()
+        {
+            if (_fd >= 0) ::close(_fd);
+            _fd = -1;
+        }
+
+    private :
+        uint16_t    _port;
+        int         _fd;
+        int         _next;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef BLINKER_WS_HASH_H
+#define BLINKER_WS_HASH_H
+
+// sha1() of the ESP8266 core, websockets.cpp defines it with the libsha1
+// the module carries for other boards
+
+#include <Arduino.h>
+
+void sha1(const String & data, uint8_t hash[20]);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef BLINKER_WS_IPADDRESS_H
+#define BLINKER_WS_IPADDRESS_H
+
+#include <Arduino.h>
+
+class IPAddress
+{
+    public :
+        IPAddress(uint32_t ip = 0)  { memcpy(_ip, &ip, 4); }
+
+        uint8_t operator[](int n) const { return _ip[n]; }
+
+    private :
+        uint8_t _ip[4];
+};
+
+#endif
@@ -0,0 +1 @@
+// Empty, WebSockets.cpp includes it on the ESP8266
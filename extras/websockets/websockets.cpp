@@ -0,0 +1,332 @@
+// Frame benchmark for the WebSockets module, the server side of the LAN
+// port of a device.
+//
+// Build and run from the library root:
+//
+//   g++ -std=c++11 -O2 -DESP8266 -Iextras/websockets -Isrc/modules/WebSockets extras/websockets/websockets.cpp src/modules/WebSockets/WebSockets.cpp src/modules/WebSockets/WebSocketsServer.cpp -o websockets -lpthread
+//   ./websockets [MB per size]
+//
+// Add -DWEBSOCKETS_RX_CHUNK_SIZE=1024 to have big frames delivered in
+// fragments, the test puts them together again before it checks them.
+//
+// WebSocketsServer and WebSockets.cpp are built as they are, the headers
+// next to this file stand in for the core and its WiFiClient, over real
+// TCP sockets on 127.0.0.1. A client thread does the upgrade and then, for
+// every frame size:
+// - sends masked text frames the server reads, unmasks and hands to the
+//   event callback, which checks every byte;
+// - reads back as many frames sent with sendTXT() and checks them.
+// The table gives the rate both ways and the RX and TX buffers the server
+// kept for the client, which only grow to the largest frame read whole and
+// the largest sent past the stack stage.
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <Hash.h>
+#include "WebSocketsServer.h"
+
+// libb64 and libsha1 the module carries, the core has its own on the ESP
+#pragma push_macro("ESP8266")
+#undef ESP8266
+extern "C" {
+    #include "libb64/cencode.c"
+    #include "libsha1/libsha1.c"
+}
+#pragma pop_macro("ESP8266")
+
+#define SIM_PORT            18781
+
+SimESP ESP;
+
+void sha1(const String & data, uint8_t hash[20])
+{
+    SHA1_CTX ctx;
+
+    SHA1Init(&ctx);
+    SHA1Update(&ctx, (const unsigned char *)data.c_str(), data.length());
+    SHA1Final(hash, &ctx);
+}
+
+static const size_t sizes[] = { 64, 512, 1024, 4096, 12288 };
+
+static std::atomic<uint32_t> failed(0);
+
+static double now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Frame k of a size, what both sides check
+static void fill(std::string & s, size_t size, uint32_t k)
+{
+    s.resize(size);
+    for (size_t i = 0; i < size; i++) s[i] = 'a' + (k + i) % 26;
+}
+
+static bool same(const uint8_t * data, size_t size, uint32_t k)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] != 'a' + (k + i) % 26) return false;
+    }
+    return true;
+}
+
+class SimServer : public WebSocketsServer
+{
+    public :
+        SimServer() : WebSocketsServer(SIM_PORT) {}
+
+        size_t rxBuffer()           { return _clients[0].cWsRxBufSize; }
+        size_t txBuffer()           { return _clients[0].cWsTxBufSize; }
+};
+
+static SimServer server;
+
+// what the server side got
+static std::atomic<uint32_t> received(0);
+static uint32_t fragments = 0;
+static std::string message;
+static std::atomic<bool> connected(false);
+
+// what the client side got
+static std::atomic<uint32_t> echoed(0);
+
+static void onEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length)
+{
+    switch (type)
+    {
+        case WStype_CONNECTED :
+            connected = true;
+            break;
+        case WStype_TEXT :
+            if (!same(payload, length, received)) failed++;
+            received++;
+            break;
+        case WStype_FRAGMENT_TEXT_START :
+            message.assign((const char *)payload, length);
+            fragments++;
+            break;
+        case WStype_FRAGMENT :
+        case WStype_FRAGMENT_FIN :
+            message.append((const char *)payload, length);
+            fragments++;
+            if (type == WStype_FRAGMENT_FIN)
+            {
+                if (!same((const uint8_t *)message.data(), message.size(), received)) failed++;
+                received++;
+            }
+            break;
+        default :
+            break;
+    }
+}
+
+// Client side, a plain socket speaking RFC 6455
+static int fd = -1;
+
+static bool readAll(uint8_t * out, size_t n)
+{
+    while (n)
+    {
+        ssize_t r = recv(fd, out, n, 0);
+
+        if (r <= 0) return false;
+        out += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool readFrame(std::vector<uint8_t> & payload, uint8_t & opcode)
+{
+    uint8_t head[8];
+
+    if (!readAll(head, 2)) return false;
+
+    opcode = head[0] & 0x0F;
+    size_t len = head[1] & 0x7F;
+
+    if (len == 126)
+    {
+        if (!readAll(head, 2)) return false;
+        len = head[0] << 8 | head[1];
+    }
+    else if (len == 127)
+    {
+        if (!readAll(head, 8)) return false;
+        len = head[4] << 24 | head[5] << 16 | head[6] << 8 | head[7];
+    }
+
+    payload.resize(len);
+    return len == 0 || readAll(payload.data(), len);
+}
+
+static void sendFrame(const std::string & data)
+{
+    std::string frame(1, (char)0x81);
+    uint8_t key[4] = { 0x12, 0x34, 0x56, 0x78 };
+    size_t len = data.size();
+
+    if (len < 126)
+    {
+        frame += (char)(0x80 | len);
+    }
+    else
+    {
+        frame += (char)(0x80 | 126);
+        frame += (char)(len >> 8);
+        frame += (char)(len & 0xFF);
+    }
+    frame.append((const char *)key, 4);
+
+    for (size_t i = 0; i < len; i++) frame += (char)(data[i] ^ key[i & 3]);
+
+    send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+}
+
+static void client(size_t bytes)
+{
+    sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(SIM_PORT);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        printf("connect failed\n");
+        exit(1);
+    }
+
+    const char * upgrade =
+        "GET / HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "\r\n";
+
+    send(fd, upgrade, strlen(upgrade), MSG_NOSIGNAL);
+
+    std::string response;
+    char c;
+
+    while (response.find("\r\n\r\n") == std::string::npos && recv(fd, &c, 1, 0) == 1)
+    {
+        response += c;
+    }
+
+    if (response.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == std::string::npos)
+    {
+        printf("upgrade refused:\n%s", response.c_str());
+        exit(1);
+    }
+
+    uint32_t k = 0;
+    std::string data;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint32_t frames = bytes / sizes[s];
+
+        for (uint32_t n = 0; n < frames; n++, k++)
+        {
+            fill(data, sizes[s], k);
+            sendFrame(data);
+        }
+
+        // the frames the server sends back, after its ping
+        std::vector<uint8_t> payload;
+        uint8_t opcode;
+
+        for (uint32_t n = 0; n < frames; )
+        {
+            if (!readFrame(payload, opcode)) return;
+            if (opcode != WSop_text) continue;
+
+            if (payload.size() != sizes[s] || !same(payload.data(), payload.size(), n)) failed++;
+            n++;
+            echoed++;
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    size_t bytes = (argc > 1 ? atof(argv[1]) : 8) * 1024 * 1024;
+
+    server.onEvent(onEvent);
+    server.begin();
+
+    std::thread peer(client, bytes);
+
+#if defined(WEBSOCKETS_RX_CHUNK_SIZE)
+    printf("frames over %u bytes delivered in fragments\n\n", WEBSOCKETS_RX_CHUNK_SIZE);
+#else
+    printf("frames delivered whole\n\n");
+#endif
+    printf("  %6s %7s %10s %10s %10s %10s %10s\n", "size", "frames", "rx MB/s", "fragments",
+           "rx buffer", "tx MB/s", "tx buffer");
+
+    uint32_t total = 0;
+    std::string data;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint32_t frames = bytes / sizes[s];
+        uint32_t fragmentsBefore = fragments;
+        double start = 0;
+
+        total += frames;
+
+        while (received < total)
+        {
+            server.loop();
+
+            if (!start && connected && received > total - frames) start = now();
+            if (!server.connectedClients())
+            {
+                if (start) break;
+            }
+        }
+
+        double rx = now() - start;
+
+        uint32_t echoedBefore = echoed;
+        double txStart = now();
+
+        for (uint32_t n = 0; n < frames; n++)
+        {
+            fill(data, sizes[s], n);
+            server.sendTXT(0, data.c_str(), data.size());
+        }
+        // not reading meanwhile, the frames of the next size count there
+        while (echoed < echoedBefore + frames) std::this_thread::yield();
+
+        double tx = now() - txStart;
+
+        printf("  %6zu %7u %10.1f %10u %10zu %10.1f %10zu\n", sizes[s], frames,
+               frames * sizes[s] / rx / 1048576, fragments - fragmentsBefore,
+               server.rxBuffer(), frames * sizes[s] / tx / 1048576, server.txBuffer());
+    }
+
+    peer.join();
+
+    if (received != total || echoed != total) failed++;
+
+    printf("\n%u of %u frames in, %u of %u out, %s\n", (uint32_t)received, total,
+           (uint32_t)echoed, total, failed ? "FAILED" : "ok");
+
+    return failed ? 1 : 0;
+}
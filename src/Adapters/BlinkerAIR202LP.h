@@ -11,6 +11,7 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
 #include "../Functions/BlinkerAIR202.h"
 #include "../Functions/BlinkerHTTPAIR202.h"
 #ifndef ARDUINOJSON_VERSION_MAJOR
@@ -113,7 +114,7 @@ int BlinkerAIR202LP::print(char * data, bool needCheck)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& data_rp = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject data_rp = jsonBuffer.as<JsonObject>();
 
@@ -174,7 +175,7 @@ void BlinkerAIR202LP::dataGet()
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& data_rp = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject data_rp = jsonBuffer.as<JsonObject>();
 
@@ -277,7 +278,7 @@ int BlinkerAIR202LP::connectServer()
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(payload);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, payload);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -336,7 +337,7 @@ int BlinkerAIR202LP::connectServer()
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
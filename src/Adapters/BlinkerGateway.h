@@ -28,6 +28,11 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
+#include "../Blinker/BlinkerLan.h"
+#include "../Blinker/BlinkerSupervisor.h"
+#include "../Blinker/BlinkerMetrics.h"
+#include "../Functions/BlinkerCredentials.h"
 
 char*       MQTT_HOST_PRO;
 char*       MQTT_ID_PRO;
@@ -56,19 +61,34 @@ painlessMesh  mesh;
     #define BLINKER_MESH_PORT   5555
 #endif
 
-char*       meshBuf;
+// Keeps the last mesh message parsed, so gate/ctrl payloads that arrive as
+// nested objects are handled without a second parse
+DynamicJsonDocument meshDoc(1024);
+JsonObject  meshData;
 bool        isFresh_mesh = false;
 bool        isAvail_gate = false;
 bool        isAvail_ctrl = false;
 uint32_t    msgFrom;
 
+// Messages received in a mesh update wait here until meshCheck() handles
+// them, each link of the gateway can deliver one in the same update
+struct BlinkerMeshMsg
+{
+    uint32_t    from;
+    char *      msg;
+};
+
+BlinkerMeshMsg  _meshQueue[BLINKER_MESH_RX_QUEUE];
+uint8_t         _meshHead = 0;
+uint8_t         _meshCount = 0;
+
 BlinkerMeshSub  *_subDevices[BLINKER_MAX_SUB_DEVICE_NUM];
-uint8_t         _subCount = 0;
+uint16_t        _subCount = 0;
 bool            _newSub = false;
 
 int16_t _checkIdAlive(uint32_t nodeId)
 {
-    for (uint8_t num = 0; num < _subCount; num++)
+    for (uint16_t num = 0; num < _subCount; num++)
     {
         if (_subDevices[num]->id() == nodeId)
         {
@@ -81,7 +101,7 @@ int16_t _checkIdAlive(uint32_t nodeId)
 
 int16_t _checkIdAlive(const String & name)
 {
-    for (uint8_t num = 0; num < _subCount; num++)
+    for (uint16_t num = 0; num < _subCount; num++)
     {
         if (_subDevices[num]->isAuth())
         {
@@ -95,55 +115,117 @@ int16_t _checkIdAlive(const String & name)
     return -1;
 }
 
+bool _meshUnpack(const char * key)
+{
+    if (meshDoc[key].is<JsonObject>())
+    {
+        meshData = meshDoc[key].as<JsonObject>();
+        return true;
+    }
+
+    // payload sent as a json string by older sub devices
+    String _data = meshDoc[key].as<String>();
+    DeserializationError error = deserializeJson(meshDoc, _data);
+    meshData = meshDoc.as<JsonObject>();
+
+    if (error || meshData.isNull())
+    {
+        BLINKER_ERR_LOG_ALL("msg not Json!");
+        return false;
+    }
+
+    return true;
+}
+
+void _subAlive(uint32_t nodeId)
+{
+    int checkId = _checkIdAlive(nodeId);
+    if (checkId == -1)
+    {
+        if (_subCount >= BLINKER_MAX_SUB_DEVICE_NUM)
+        {
+            BLINKER_ERR_LOG_ALL("sub device full, drop: ", nodeId);
+            return;
+        }
+
+        _subDevices[_subCount] = new BlinkerMeshSub(nodeId);
+        _subCount++;
+    }
+    else
+    {
+        _subDevices[checkId]->state(true);
+        BLINKER_LOG_ALL("fresh new");
+    }
+}
+
 void _receivedCallback(uint32_t from, String &msg)
 {
     BLINKER_LOG_ALL("bridge: Received from: ", from, ", msg: ",msg);
-    msgFrom = from;
 
-    DynamicJsonDocument jsonBuffer(1024);
-    DeserializationError error = deserializeJson(jsonBuffer, msg);
-    JsonObject root = jsonBuffer.as<JsonObject>();
+    if (_meshCount >= BLINKER_MESH_RX_QUEUE)
+    {
+        BLINKER_ERR_LOG_ALL("mesh queue full, drop msg from: ", from);
+    }
+    else
+    {
+        BlinkerMeshMsg & slot = _meshQueue[(_meshHead + _meshCount) % BLINKER_MESH_RX_QUEUE];
+
+        slot.msg = (char*)malloc((msg.length()+1)*sizeof(char));
+
+        if (slot.msg)
+        {
+            strcpy(slot.msg, msg.c_str());
+            slot.from = from;
+            _meshCount++;
+        }
+    }
+
+    _subAlive(from);
+    // _newSub = true;
+}
+
+// Takes the oldest queued message into meshDoc, sets isAvail_gate or
+// isAvail_ctrl for it
+bool _meshNext()
+{
+    if (_meshCount == 0) return false;
+
+    BlinkerMeshMsg & slot = _meshQueue[_meshHead];
+
+    _meshHead = (_meshHead + 1) % BLINKER_MESH_RX_QUEUE;
+    _meshCount--;
+
+    msgFrom = slot.from;
+    isAvail_gate = false;
+    isAvail_ctrl = false;
+
+    // read through a const pointer, ArduinoJson copies the strings then
+    // and the message can go
+    DeserializationError error = deserializeJson(meshDoc, (const char *)slot.msg);
+    JsonObject root = meshDoc.as<JsonObject>();
+
+    free(slot.msg);
 
     if (error) 
     {
         BLINKER_ERR_LOG_ALL("msg not Json!");
-        return;
+        return true;
     }
 
     if (root.containsKey(BLINKER_CMD_GATE))
     {
         BLINKER_LOG_ALL("gate data");
-        
-        String _data = root[BLINKER_CMD_GATE];
-        meshBuf = (char*)malloc((_data.length()+1)*sizeof(char));
-        strcpy(meshBuf, _data.c_str());
 
-        isAvail_gate = true;
+        isAvail_gate = _meshUnpack(BLINKER_CMD_GATE);
     }
     else if (root.containsKey(BLINKER_CMD_CONTROL))
     {
         BLINKER_LOG_ALL("control data");
-        
-        String _data = root[BLINKER_CMD_CONTROL];
-        meshBuf = (char*)malloc((_data.length()+1)*sizeof(char));
-        strcpy(meshBuf, _data.c_str());
 
-        isAvail_ctrl = true;
+        isAvail_ctrl = _meshUnpack(BLINKER_CMD_CONTROL);
     }
-    
 
-    int checkId = _checkIdAlive(from);
-    if (checkId == -1)
-    {
-        _subDevices[_subCount] = new BlinkerMeshSub(from);
-        _subCount++;
-    }
-    else
-    {
-        _subDevices[checkId]->state(true);
-        BLINKER_LOG_ALL("fresh new");
-    }
-    // _newSub = true;
+    return true;
 }
 
 void _newConnectionCallback(uint32_t nodeId)
@@ -151,17 +233,7 @@ void _newConnectionCallback(uint32_t nodeId)
     BLINKER_LOG_ALL("--> startHere: New Connection, nodeId = ", nodeId);
     BLINKER_LOG_ALL("--> startHere: New Connection, ", mesh.subConnectionJson(true));
 
-    int checkId = _checkIdAlive(nodeId);
-    if (checkId == -1)
-    {
-        _subDevices[_subCount] = new BlinkerMeshSub(nodeId);
-        _subCount++;
-    }
-    else
-    {
-        _subDevices[checkId]->state(true);
-        BLINKER_LOG_ALL("fresh new");
-    }
+    _subAlive(nodeId);
     _newSub = true;
 }
 
@@ -216,16 +288,21 @@ class BlinkerGateway : public BlinkerStream
         char * deviceName();
         char * authKey() { return AUTHKEY_PRO; }
         int init() { return isMQTTinit; }
-        int reRegister() { return connectServer(); }
-        int deviceRegister() { return connectServer(); }
+        int reRegister();
+        int deviceRegister() { return connectServer(true); }
         int authCheck();
         void freshAlive() { kaTime = millis(); isAlive = true; }
         void sharers(const String & data);
+        uint8_t replyTo()           { return _sharerFrom; }
+        void replyTo(uint8_t num)   { _sharerFrom = num; }
+        // at most once every BLINKER_SHARERS_CHECK_SPAN
         int  needFreshShare() {
-            if (_needCheckShare)
+            if (_needCheckShare && (_shareCheckTime == 0 ||
+                millis() - _shareCheckTime >= BLINKER_SHARERS_CHECK_SPAN))
             {
                 BLINKER_LOG_ALL(BLINKER_F("needFreshShare"));
                 _needCheckShare = false;
+                _shareCheckTime = millis();
                 return true;
             }
             else
@@ -234,12 +311,15 @@ class BlinkerGateway : public BlinkerStream
             }
         }
         void setTimezone(float tz) { _timezone = tz; }
+        void meshWeight(uint8_t priority, uint16_t weight);
+        uint32_t meshQueueDepth(uint8_t priority);
 
     private :
         bool isMQTTinit = false;
         bool isWSinit = false;
 
-        int connectServer();
+        int connectServer(bool useCache = false);
+        String authRequest();
         void mDNSInit(String name = macDeviceName());
         void checkKA();
         int checkAliKA();
@@ -256,7 +336,8 @@ class BlinkerGateway : public BlinkerStream
         bool meshInit();
         void meshCheck();
         void sendBroadcast(String msg);
-        bool sendSingle(uint32_t toId, String msg);
+        bool sendSingle(uint32_t toId, String msg,
+                        painlessmesh::protocol::Priority priority = painlessmesh::protocol::PRIORITY_TELEMETRY);
         String gateFormat(const String & msg);
         bool subRegister(uint32_t num);
         time_t time();
@@ -275,6 +356,7 @@ class BlinkerGateway : public BlinkerStream
         bool        isAlive = false;
         bool        isBavail = false;
         bool        _needCheckShare = false;
+        uint32_t    _shareCheckTime = 0;
         uint32_t    latestTime;
         uint32_t    printTime = 0;
         uint32_t    bPrintTime = 0;
@@ -305,9 +387,8 @@ class BlinkerGateway : public BlinkerStream
 
         int isJson(const String & data);
 
-        uint8_t     reconnect_time = 0;
-        uint32_t    _reRegister_time = 0;
-        uint8_t     _reRegister_times = 0;
+
+        BlinkerCredentials _credentials;
 
         bool        _isAuthKey = false;
         bool        _isMeshInit = false;
@@ -345,9 +426,30 @@ bool    isFresh_PRO = false;
 bool    isConnect_PRO = false;
 bool    isAvail_PRO = false;
 bool    isApCfg = false;
-uint8_t ws_num_PRO = 0;
 uint8_t dataFrom_PRO = BLINKER_MSG_FROM_MQTT;
 
+BlinkerLan lan_PRO;
+
+bool lanSend_PRO(uint8_t num, const uint8_t * data, size_t len, bool binary)
+{
+    return binary ? webSocket_PRO.sendBIN(num, data, len)
+                  : webSocket_PRO.sendTXT(num, data, len);
+}
+
+void wsData_PRO(const char * data, size_t length)
+{
+    if (length < BLINKER_MAX_READ_SIZE) {
+        if (isFresh_PRO) free(msgBuf_PRO);
+        msgBuf_PRO = (char*)malloc((length+1)*sizeof(char));
+        memcpy(msgBuf_PRO, data, length);
+        msgBuf_PRO[length] = '\0';
+        isAvail_PRO = true;
+        isFresh_PRO = true;
+    }
+
+    if (!isApCfg) dataFrom_PRO = BLINKER_MSG_FROM_WS;
+}
+
 void webSocketEvent_PRO(uint8_t num, WStype_t type, \
                     uint8_t * payload, size_t length)
 {
@@ -357,7 +459,9 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
         case WStype_DISCONNECTED:
             BLINKER_LOG_ALL(BLINKER_F("Disconnected! "), num);
 
-            isConnect_PRO = false;
+            lan_PRO.disconnect(num);
+
+            if (!isApCfg) isConnect_PRO = lan_PRO.clients() > 0;
             break;
         case WStype_CONNECTED:
             {
@@ -370,7 +474,9 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
                 // send message to client
                 webSocket_PRO.sendTXT(num, "{\"state\":\"connected\"}\n");
 
-                ws_num_PRO = num;
+                // "ws://<ip>:81/msgpack" asks for binary frames
+                lan_PRO.connect(num, strstr((char *)payload, "msgpack") != NULL, \
+                                millis());
 
                 if (!isApCfg) isConnect_PRO = true;
             }
@@ -379,37 +485,53 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
             BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
                             BLINKER_F(", get Text: "), (char *)payload, \
                             BLINKER_F(", length: "), length);
-            
-            if (length < BLINKER_MAX_READ_SIZE) {
-                if (isFresh_PRO) free(msgBuf_PRO);
-                msgBuf_PRO = (char*)malloc((length+1)*sizeof(char));
-                strcpy(msgBuf_PRO, (char*)payload);
-                isAvail_PRO = true;
-                isFresh_PRO = true;
-            }
 
-            if (!isApCfg) dataFrom_PRO = BLINKER_MSG_FROM_WS;
+            wsData_PRO((char *)payload, length);
+            break;
+        case WStype_BIN:
+            {
+                BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
+                                BLINKER_F(", get binary length: "), length);
 
-            ws_num_PRO = num;
+                // MessagePack requests are handled as their json text
+                DynamicJsonDocument doc(BLINKER_MAX_READ_SIZE);
 
-            // send message to client
-            // webSocket_PRO.sendTXT(num, "message here");
+                if (deserializeMsgPack(doc, (const char *)payload, length))
+                {
+                    BLINKER_ERR_LOG_ALL(BLINKER_F("msgpack parse failed"));
+                    break;
+                }
 
-            // send data to all connected clients
-            // webSocket_PRO.broadcastTXT("message here");
-            break;
-        case WStype_BIN:
-            // BLINKER_LOG("num: ", num, " get binary length: ", length);
-            // hexdump(payload, length);
+                String data;
+                serializeJson(doc, data);
 
-            // send message to client
-            // webSocket_PRO.sendBIN(num, payload, length);
+                wsData_PRO(data.c_str(), data.length());
+            }
             break;
     }
 }
 
 BlinkerGateway::BlinkerGateway() { isHandle = &isConnect_PRO; }
 
+int BlinkerGateway::reRegister()
+{
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_AUTH, millis())) return false;
+
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_AUTH, millis());
+
+    if (connectServer())
+    {
+        BLINKER_SUPERVISOR.success(BLINKER_LINK_AUTH, millis());
+        BLINKER_TRACE(BLINKER_TRACE_AUTH_OK, 0, 0);
+        return true;
+    }
+
+    BLINKER_SUPERVISOR.failure(BLINKER_LINK_AUTH, millis(), BLINKER_FAIL_AUTH);
+    BLINKER_TRACE(BLINKER_TRACE_AUTH_FAIL,
+        BLINKER_SUPERVISOR.failures(BLINKER_LINK_AUTH), 0);
+    return false;
+}
+
 int BlinkerGateway::connect()
 {
     int8_t ret;
@@ -427,7 +549,7 @@ int BlinkerGateway::connect()
 
     disconnect();
 
-    if ((millis() - latestTime) < BLINKER_MQTT_CONNECT_TIMESLOT && latestTime > 0)
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_MQTT, millis()))
     {
         yield();
         return false;
@@ -435,6 +557,8 @@ int BlinkerGateway::connect()
 
     BLINKER_LOG(BLINKER_F("Connecting to MQTT... "));
 
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_MQTT, millis());
+
     #if defined(ESP8266)
         client_mqtt.setInsecure();
         ::delay(10);
@@ -445,61 +569,26 @@ int BlinkerGateway::connect()
     if ((ret = mqtt_PRO->connect()) != 0)
     {
         BLINKER_LOG(mqtt_PRO->connectErrorString(ret));
-        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
-                    BLINKER_MQTT_CONNECT_TIMESLOT/1000, \
-                    BLINKER_F(" seconds..."));
 
-        if (ret == 4) 
-        {
-            if (_reRegister_times < BLINKER_SERVER_CONNECT_LIMIT)
-            {
-                if (reRegister())
-                {
-                    _reRegister_times = 0;
-                }
-                else
-                {
-                    _reRegister_times++;
-                    _reRegister_time = millis();
-                }
-            }
-            else
-            {
-                if (millis() - _reRegister_time >= 60000 * 5) _reRegister_times = 0;
-            }
+        // Bad user name or password, the credentials we hold are outdated
+        BLINKER_SUPERVISOR.failure(BLINKER_LINK_MQTT, millis(),
+            ret == 4 ? BLINKER_FAIL_REJECTED : BLINKER_FAIL_MQTT);
+        BLINKER_TRACE(BLINKER_TRACE_MQTT_FAIL, ret,
+            BLINKER_SUPERVISOR.failures(BLINKER_LINK_MQTT));
 
-            BLINKER_LOG_ALL(BLINKER_F("_reRegister_times: "), _reRegister_times);
-        }
+        if (BLINKER_SUPERVISOR.needReauth()) reRegister();
 
-        this->latestTime = millis();
-        reconnect_time += 1;
-        if (reconnect_time >= 12)
-        {
-            if (_reRegister_times < BLINKER_SERVER_CONNECT_LIMIT)
-            {
-                if (reRegister())
-                {
-                    _reRegister_times = 0;
-                }
-                else
-                {
-                    _reRegister_times++;
-                    _reRegister_time = millis();
-                }
-            }
-            else
-            {
-                if (millis() - _reRegister_time >= 60000 * 5) _reRegister_times = 0;
-            }
-            
-            reconnect_time = 0;
+        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
+                    BLINKER_SUPERVISOR.retryIn(BLINKER_LINK_MQTT, millis())/1000, \
+                    BLINKER_F(" seconds..."));
 
-            BLINKER_LOG_ALL(BLINKER_F("_reRegister_times: "), _reRegister_times);
-        }
+        this->latestTime = millis();
         return false;
     }
-    
-    reconnect_time = 0;
+
+    BLINKER_SUPERVISOR.success(BLINKER_LINK_MQTT, millis());
+    BLINKER_TRACE(BLINKER_TRACE_MQTT_UP,
+        BLINKER_SUPERVISOR.connectTime(BLINKER_LINK_MQTT), 0);
     
     BLINKER_LOG(BLINKER_F("MQTT Connected!"));
     BLINKER_LOG_FreeHeap();
@@ -569,6 +658,7 @@ int BlinkerGateway::available()
 #endif
 
     webSocket_PRO.loop();
+    lan_PRO.flush(millis());
 
     if (isMQTTinit) {
         checkKA();
@@ -657,7 +747,7 @@ void BlinkerGateway::subscribe()
             
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(String((char *)iotSub_PRO->lastread));
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, String((char *)iotSub_PRO->lastread));
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -668,7 +758,8 @@ void BlinkerGateway::subscribe()
                 int checkId = _checkIdAlive(_sub);
                 if (checkId != -1)
                 {
-                    sendSingle(_subDevices[checkId]->id(), (char *)iotSub_PRO->lastread);
+                    sendSingle(_subDevices[checkId]->id(), (char *)iotSub_PRO->lastread,
+                                painlessmesh::protocol::PRIORITY_CONTROL);
                 }
 
                 this->latestTime = millis();
@@ -802,29 +893,39 @@ int BlinkerGateway::print(char * data, bool needCheck)
     // BLINKER_LOG_FreeHeap();
     if (*isHandle && dataFrom_PRO == BLINKER_MSG_FROM_WS)
     {
-        if (needCheck)
-        {
-            if (!checkPrintSpan())
-            {
-                respTime = millis();
-                return false;
-            }
-        }
-
+        // LAN clients have their own budget, replies reach every client
         respTime = millis();
-        
+
         BLINKER_LOG_ALL(BLINKER_F("WS response: "));
         BLINKER_LOG_ALL(data);
-        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         strcat(data, BLINKER_CMD_NEWLINE);
-        
-        webSocket_PRO.sendTXT(ws_num_PRO, data);
+
+        if (!lan_PRO.broadcast(data, millis())) return false;
+
+        BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+
+        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         return true;
     }
     else
     {
+        // LAN clients see the state the cloud sees, on their own budget
+        if (lan_PRO.clients())
+        {
+            uint16_t len = strlen(data);
+
+            strcat(data, BLINKER_CMD_NEWLINE);
+
+            if (lan_PRO.broadcast(data, millis()))
+            {
+                BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+            }
+
+            data[len] = '\0';
+        }
+
         // // String payload;
         // if (STRING_contains_string(data, BLINKER_CMD_NEWLINE))
         // {
@@ -1470,6 +1571,10 @@ void BlinkerGateway::begin(const char* _key, const char* _type)
     
     BLINKER_LOG_ALL(BLINKER_F("PRO deviceType: "), _type);
 
+    // Hardware rng, devices sharing an outage spread their retries
+    BLINKER_SUPERVISOR.seed(random(1, 0x7FFFFFFF));
+    BLINKER_TRACE(BLINKER_TRACE_BOOT, 0, 0);
+
     mDNSInit();
 }
 
@@ -1628,7 +1733,7 @@ void BlinkerGateway::sharers(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1692,58 +1797,238 @@ int BlinkerGateway::authCheck()
     return false;
 }
 
-int BlinkerGateway::connectServer() {
-    const int httpsPort = 443;
+String BlinkerGateway::authRequest() {
     #if defined(ESP8266)
         String host = BLINKER_F(BLINKER_SERVER_HOST);
-        client_mqtt.stop();
     #elif defined(ESP32)
         String host = BLINKER_F(BLINKER_SERVER_HTTPS);
     #endif
-    if (!_isAuthKey)
-    {
-    #if defined(ESP8266)
-        // String host = BLINKER_F(BLINKER_SERVER_HOST);
-        String fingerprint = BLINKER_F("84 5f a4 8a 70 5e 79 7e f5 b3 b4 20 45 c8 35 55 72 f6 85 5a");
 
-        // WiFiClientSecure client_s;
+#if defined(ESP8266)
+    // client_mqtt.stop();
 
-    //     BearSSL::WiFiClientSecure *client_s;
+    std::unique_ptr<BearSSL::WiFiClientSecure>client_s(new BearSSL::WiFiClientSecure);
 
-    //     client_s = new BearSSL::WiFiClientSecure();
+    // client_s->setFingerprint(fingerprint);
+    client_s->setInsecure();
 
-    //     client_mqtt.stop();
-        
-    //     BLINKER_LOG_ALL(BLINKER_F("connecting to "), host);
+    String url_iot = BLINKER_F("/api/v1/user/device/auth?authKey=");
+    url_iot += AUTHKEY_PRO;
+    // url_iot += _aliType;
+    // url_iot += _duerType;
 
-    //     // BLINKER_LOG_FreeHeap();
-        
-    //     uint8_t connet_times = 0;
-    //     // client_s.stop();
-    //     ::delay(100);
+    #if defined(BLINKER_ALIGENIE_LIGHT)
+        url_iot += BLINKER_F("&aliType=light");
+    #elif defined(BLINKER_ALIGENIE_OUTLET)
+        url_iot += BLINKER_F("&aliType=outlet");
+    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
+        url_iot += BLINKER_F("&aliType=multi_outlet");
+    #elif defined(BLINKER_ALIGENIE_SENSOR)
+        url_iot += BLINKER_F("&aliType=sensor");
+    #elif defined(BLINKER_ALIGENIE_TYPE)
+        url_iot += BLINKER_ALIGENIE_TYPE;
+    #endif
 
-    //     bool mfln = client_s->probeMaxFragmentLength(host, httpsPort, 1024);
-    //     if (mfln) {
-    //         client_s->setBufferSizes(1024, 1024);
-    //     }
-    //     // client_s.setFingerprint(fingerprint.c_str());
-        
-    //     client_s->setInsecure();
+    #if defined(BLINKER_DUEROS_LIGHT)
+        url_iot += BLINKER_F("&duerType=LIGHT");
+    #elif defined(BLINKER_DUEROS_OUTLET)
+        url_iot += BLINKER_F("&duerType=SOCKET");
+    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
+        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
+    #elif defined(BLINKER_DUEROS_SENSOR)
+        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
+    #elif defined(BLINKER_DUEROS_TYPE)
+        url_iot += BLINKER_DUEROS_TYPE;
+    #endif
 
-    //     // while (1) {
-    //         bool cl_connected = false;
-    //         if (!client_s->connect(host, httpsPort)) {
-    //             BLINKER_ERR_LOG(BLINKER_F("server connection failed"));
-    //             // connet_times++;
+    #if defined(BLINKER_MIOT_LIGHT)
+        url_iot += BLINKER_F("&miType=light");
+    #elif defined(BLINKER_MIOT_OUTLET)
+        url_iot += BLINKER_F("&miType=outlet");
+    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
+        url_iot += BLINKER_F("&miType=multi_outlet");
+    #elif defined(BLINKER_MIOT_SENSOR)
+        url_iot += BLINKER_F("&miType=sensor");
+    #elif defined(BLINKER_MIOT_TYPE)
+        url_iot += BLINKER_MIOT_TYPE;
+    #endif
 
-    //             ::delay(1000);
-    //         }
-    //         else {
-    //             BLINKER_LOG_ALL(BLINKER_F("connection succeed"));
-    //             cl_connected = true;
+    url_iot = "https://" + host + url_iot;
 
-    //             // break;
-    //         }
+    HTTPClient http;
+
+    String payload = "";
+
+    BLINKER_LOG_ALL(BLINKER_F("[HTTP] begin: "), url_iot);
+
+    if (http.begin(*client_s, url_iot)) {  // HTTPS
+
+        // Serial.print("[HTTPS] GET...\n");
+        // start connection and send HTTP header
+        int httpCode = http.GET();
+
+        // httpCode will be negative on error
+        if (httpCode > 0) {
+            // HTTP header has been send and Server response header has been handled
+
+            BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
+
+            // file found at server
+            if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
+                payload = http.getString();
+                // Serial.println(payload);
+            }
+        } else {
+            BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
+            payload = http.getString();
+            BLINKER_LOG(payload);
+        }
+
+        http.end();
+    } else {
+        // Serial.printf("[HTTPS] Unable to connect\n");
+    }
+
+#elif defined(ESP32)
+    HTTPClient http;
+
+    String url_iot = host;
+    url_iot += BLINKER_F("/api/v1/user/device/auth?authKey=");
+    url_iot += AUTHKEY_PRO;
+    // url_iot += _aliType;
+    // url_iot += _duerType;
+
+    #if defined(BLINKER_ALIGENIE_LIGHT)
+        url_iot += BLINKER_F("&aliType=light");
+    #elif defined(BLINKER_ALIGENIE_OUTLET)
+        url_iot += BLINKER_F("&aliType=outlet");
+    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
+        url_iot += BLINKER_F("&aliType=multi_outlet");
+    #elif defined(BLINKER_ALIGENIE_SENSOR)
+        url_iot += BLINKER_F("&aliType=sensor");
+    #elif defined(BLINKER_ALIGENIE_TYPE)
+        url_iot += BLINKER_ALIGENIE_TYPE;
+    #endif
+
+    #if defined(BLINKER_DUEROS_LIGHT)
+        url_iot += BLINKER_F("&duerType=LIGHT");
+    #elif defined(BLINKER_DUEROS_OUTLET)
+        url_iot += BLINKER_F("&duerType=SOCKET");
+    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
+        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
+    #elif defined(BLINKER_DUEROS_SENSOR)
+        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
+    #elif defined(BLINKER_DUEROS_TYPE)
+        url_iot += BLINKER_DUEROS_TYPE;
+    #endif
+
+    #if defined(BLINKER_MIOT_LIGHT)
+        url_iot += BLINKER_F("&miType=light");
+    #elif defined(BLINKER_MIOT_OUTLET)
+        url_iot += BLINKER_F("&miType=outlet");
+    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
+        url_iot += BLINKER_F("&miType=multi_outlet");
+    #elif defined(BLINKER_MIOT_SENSOR)
+        url_iot += BLINKER_F("&miType=sensor");
+    #elif defined(BLINKER_MIOT_TYPE)
+        url_iot += BLINKER_MIOT_TYPE;
+    #endif
+
+    BLINKER_LOG_ALL(BLINKER_F("HTTPS begin: "), url_iot);
+
+// #if defined(ESP8266)
+//     http.begin(url_iot, fingerprint); //HTTP
+// #elif defined(ESP32)
+    // http.begin(url_iot, ca); TODO
+    http.begin(url_iot);
+// #endif
+    int httpCode = http.GET();
+
+    String payload = "";
+
+    if (httpCode > 0) {
+      // HTTP header has been send and Server response header has been handled
+
+        BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
+
+        // file found at server
+        if (httpCode == HTTP_CODE_OK) {
+            payload = http.getString();
+            // BLINKER_LOG(payload);
+        }
+    }
+    else {
+        BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
+        payload = http.getString();
+        BLINKER_LOG(payload);
+    }
+
+    http.end();
+#endif
+
+    return payload;
+}
+
+int BlinkerGateway::connectServer(bool useCache) {
+    // Everything the auth requests depend on, a change or a new build asks
+    // the server again
+    String _credentialsId = STRING_format(_deviceType) + _vipKey + macDeviceName() + \
+                            BLINKER_OTA_VERSION_CODE + BLINKER_F(__DATE__ " " __TIME__);
+
+    String payload;
+    bool cached = useCache && _credentials.load(_credentialsId, payload);
+
+    const int httpsPort = 443;
+    #if defined(ESP8266)
+        String host = BLINKER_F(BLINKER_SERVER_HOST);
+        client_mqtt.stop();
+    #elif defined(ESP32)
+        String host = BLINKER_F(BLINKER_SERVER_HTTPS);
+    #endif
+    if (!_isAuthKey && !cached)
+    {
+    #if defined(ESP8266)
+        // String host = BLINKER_F(BLINKER_SERVER_HOST);
+        String fingerprint = BLINKER_F("84 5f a4 8a 70 5e 79 7e f5 b3 b4 20 45 c8 35 55 72 f6 85 5a");
+
+        // WiFiClientSecure client_s;
+
+    //     BearSSL::WiFiClientSecure *client_s;
+
+    //     client_s = new BearSSL::WiFiClientSecure();
+
+    //     client_mqtt.stop();
+        
+    //     BLINKER_LOG_ALL(BLINKER_F("connecting to "), host);
+
+    //     // BLINKER_LOG_FreeHeap();
+        
+    //     uint8_t connet_times = 0;
+    //     // client_s.stop();
+    //     ::delay(100);
+
+    //     bool mfln = client_s->probeMaxFragmentLength(host, httpsPort, 1024);
+    //     if (mfln) {
+    //         client_s->setBufferSizes(1024, 1024);
+    //     }
+    //     // client_s.setFingerprint(fingerprint.c_str());
+        
+    //     client_s->setInsecure();
+
+    //     // while (1) {
+    //         bool cl_connected = false;
+    //         if (!client_s->connect(host, httpsPort)) {
+    //             BLINKER_ERR_LOG(BLINKER_F("server connection failed"));
+    //             // connet_times++;
+
+    //             ::delay(1000);
+    //         }
+    //         else {
+    //             BLINKER_LOG_ALL(BLINKER_F("connection succeed"));
+    //             cl_connected = true;
+
+    //             // break;
+    //         }
 
     //         // if (connet_times >= 4 && !cl_connected)  return BLINKER_CMD_FALSE;
     //     // }
@@ -1981,7 +2266,7 @@ int BlinkerGateway::connectServer() {
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(payload);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, payload);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -2009,167 +2294,7 @@ int BlinkerGateway::connectServer() {
         _isAuthKey = true;
     }
 
-#if defined(ESP8266)
-    // client_mqtt.stop();
-
-    std::unique_ptr<BearSSL::WiFiClientSecure>client_s(new BearSSL::WiFiClientSecure);
-
-    // client_s->setFingerprint(fingerprint);
-    client_s->setInsecure();
-
-    String url_iot = BLINKER_F("/api/v1/user/device/auth?authKey=");
-    url_iot += AUTHKEY_PRO;
-    // url_iot += _aliType;
-    // url_iot += _duerType;
-
-    #if defined(BLINKER_ALIGENIE_LIGHT)
-        url_iot += BLINKER_F("&aliType=light");
-    #elif defined(BLINKER_ALIGENIE_OUTLET)
-        url_iot += BLINKER_F("&aliType=outlet");
-    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
-        url_iot += BLINKER_F("&aliType=multi_outlet");
-    #elif defined(BLINKER_ALIGENIE_SENSOR)
-        url_iot += BLINKER_F("&aliType=sensor");
-    #elif defined(BLINKER_ALIGENIE_TYPE)
-        url_iot += BLINKER_ALIGENIE_TYPE;
-    #endif
-
-    #if defined(BLINKER_DUEROS_LIGHT)
-        url_iot += BLINKER_F("&duerType=LIGHT");
-    #elif defined(BLINKER_DUEROS_OUTLET)
-        url_iot += BLINKER_F("&duerType=SOCKET");
-    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
-        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
-    #elif defined(BLINKER_DUEROS_SENSOR)
-        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
-    #elif defined(BLINKER_DUEROS_TYPE)
-        url_iot += BLINKER_DUEROS_TYPE;
-    #endif
-
-    #if defined(BLINKER_MIOT_LIGHT)
-        url_iot += BLINKER_F("&miType=light");
-    #elif defined(BLINKER_MIOT_OUTLET)
-        url_iot += BLINKER_F("&miType=outlet");
-    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
-        url_iot += BLINKER_F("&miType=multi_outlet");
-    #elif defined(BLINKER_MIOT_SENSOR)
-        url_iot += BLINKER_F("&miType=sensor");
-    #elif defined(BLINKER_MIOT_TYPE)
-        url_iot += BLINKER_MIOT_TYPE;
-    #endif
-
-    url_iot = "https://" + host + url_iot;
-
-    HTTPClient http;
-
-    String payload = "";
-
-    BLINKER_LOG_ALL(BLINKER_F("[HTTP] begin: "), url_iot);
-
-    if (http.begin(*client_s, url_iot)) {  // HTTPS
-
-        // Serial.print("[HTTPS] GET...\n");
-        // start connection and send HTTP header
-        int httpCode = http.GET();
-
-        // httpCode will be negative on error
-        if (httpCode > 0) {
-            // HTTP header has been send and Server response header has been handled
-
-            BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
-
-            // file found at server
-            if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
-                payload = http.getString();
-                // Serial.println(payload);
-            }
-        } else {
-            BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
-            payload = http.getString();
-            BLINKER_LOG(payload);
-        }
-
-        http.end();
-    } else {
-        // Serial.printf("[HTTPS] Unable to connect\n");
-    }
-
-#elif defined(ESP32)
-    HTTPClient http;
-
-    String url_iot = host;
-    url_iot += BLINKER_F("/api/v1/user/device/auth?authKey=");
-    url_iot += AUTHKEY_PRO;
-    // url_iot += _aliType;
-    // url_iot += _duerType;
-
-    #if defined(BLINKER_ALIGENIE_LIGHT)
-        url_iot += BLINKER_F("&aliType=light");
-    #elif defined(BLINKER_ALIGENIE_OUTLET)
-        url_iot += BLINKER_F("&aliType=outlet");
-    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
-        url_iot += BLINKER_F("&aliType=multi_outlet");
-    #elif defined(BLINKER_ALIGENIE_SENSOR)
-        url_iot += BLINKER_F("&aliType=sensor");
-    #elif defined(BLINKER_ALIGENIE_TYPE)
-        url_iot += BLINKER_ALIGENIE_TYPE;
-    #endif
-
-    #if defined(BLINKER_DUEROS_LIGHT)
-        url_iot += BLINKER_F("&duerType=LIGHT");
-    #elif defined(BLINKER_DUEROS_OUTLET)
-        url_iot += BLINKER_F("&duerType=SOCKET");
-    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
-        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
-    #elif defined(BLINKER_DUEROS_SENSOR)
-        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
-    #elif defined(BLINKER_DUEROS_TYPE)
-        url_iot += BLINKER_DUEROS_TYPE;
-    #endif
-
-    #if defined(BLINKER_MIOT_LIGHT)
-        url_iot += BLINKER_F("&miType=light");
-    #elif defined(BLINKER_MIOT_OUTLET)
-        url_iot += BLINKER_F("&miType=outlet");
-    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
-        url_iot += BLINKER_F("&miType=multi_outlet");
-    #elif defined(BLINKER_MIOT_SENSOR)
-        url_iot += BLINKER_F("&miType=sensor");
-    #elif defined(BLINKER_MIOT_TYPE)
-        url_iot += BLINKER_MIOT_TYPE;
-    #endif
-
-    BLINKER_LOG_ALL(BLINKER_F("HTTPS begin: "), url_iot);
-
-// #if defined(ESP8266)
-//     http.begin(url_iot, fingerprint); //HTTP
-// #elif defined(ESP32)
-    // http.begin(url_iot, ca); TODO
-    http.begin(url_iot);
-// #endif
-    int httpCode = http.GET();
-
-    String payload = "";
-
-    if (httpCode > 0) {
-      // HTTP header has been send and Server response header has been handled
-
-        BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
-
-        // file found at server
-        if (httpCode == HTTP_CODE_OK) {
-            payload = http.getString();
-            // BLINKER_LOG(payload);
-        }
-    }
-    else {
-        BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
-        payload = http.getString();
-        BLINKER_LOG(payload);
-    }
-
-    http.end();
-#endif
+    if (!cached) payload = authRequest();
 
     BLINKER_LOG_ALL(BLINKER_F("reply was:"));
     BLINKER_LOG_ALL(BLINKER_F("=============================="));
@@ -2178,20 +2303,37 @@ int BlinkerGateway::connectServer() {
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
     if (STRING_contains_string(payload, BLINKER_CMD_NOTFOUND) || error ||
         !STRING_contains_string(payload, BLINKER_CMD_IOTID)) {
+        if (cached)
+        {
+            _credentials.clear();
+            return connectServer();
+        }
         // while(1) {
             BLINKER_ERR_LOG(("Please make sure you have register this device!"));
             // ::delay(60000);
 
-            return false;
-        // }
+            return false;
+        // }
+    }
+
+    if (cached && !_isAuthKey)
+    {
+        String _getAuthKey = root[BLINKER_CMD_DETAIL][BLINKER_CMD_AUTHKEY];
+
+        AUTHKEY_PRO = (char*)malloc((_getAuthKey.length()+1)*sizeof(char));
+        strcpy(AUTHKEY_PRO, _getAuthKey.c_str());
+
+        _isAuthKey = true;
     }
 
+    if (!cached) _credentials.save(_credentialsId, root[BLINKER_CMD_DETAIL], AUTHKEY_PRO);
+
     // String _userID = STRING_find_string(payload, "deviceName", "\"", 4);
     // String _userName = STRING_find_string(payload, "iotId", "\"", 4);
     // String _key = STRING_find_string(payload, "iotToken", "\"", 4);
@@ -2486,6 +2628,7 @@ void BlinkerGateway::mDNSInit(String name)
     // {
         webSocket_PRO.begin();
         webSocket_PRO.onEvent(webSocketEvent_PRO);
+        lan_PRO.begin(lanSend_PRO);
     // }
     BLINKER_LOG(BLINKER_F("webSocket_PRO server started"));
     BLINKER_LOG(BLINKER_F("ws://"), name, BLINKER_F(".local:"), WS_SERVERPORT);
@@ -2647,7 +2790,7 @@ int BlinkerGateway::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -2710,6 +2853,14 @@ bool BlinkerGateway::meshInit()
     // This and all other mesh should ideally now the mesh contains a root
     mesh.setContainsRoot(true);
 
+    #if defined(BLINKER_MESH_MSGPACK)
+        mesh.setWireFormat(painlessmesh::protocol::WIRE_MSGPACK);
+    #endif
+
+    mesh.setPriorityWeight(painlessmesh::protocol::PRIORITY_CONTROL, BLINKER_MESH_WEIGHT_CONTROL);
+    mesh.setPriorityWeight(painlessmesh::protocol::PRIORITY_SYNC, BLINKER_MESH_WEIGHT_SYNC);
+    mesh.setPriorityWeight(painlessmesh::protocol::PRIORITY_TELEMETRY, BLINKER_MESH_WEIGHT_TELEMETRY);
+
     mesh.onReceive(&_receivedCallback);
     mesh.onNewConnection(&_newConnectionCallback);
     mesh.onChangedConnections(&_changedConnectionCallback);
@@ -2730,499 +2881,486 @@ void BlinkerGateway::meshCheck()
         if (WiFi.status() != WL_CONNECTED) return;
         mesh.update();
 
-        if (isAvail_gate)
+        while (_meshNext())
         {
-            isAvail_gate = false;
+            if (isAvail_gate)
+            {
+                isAvail_gate = false;
             
-            BLINKER_LOG_ALL("new gate data: ", meshBuf);
-
-            DynamicJsonDocument jsonBuffer(1024);
-            DeserializationError error = deserializeJson(jsonBuffer, meshBuf);
-            JsonObject root = jsonBuffer.as<JsonObject>();
+                BLINKER_LOG_ALL("new gate data from: ", msgFrom);
 
-            if (error) 
-            {
-                BLINKER_ERR_LOG_ALL("msg not Json!");
-                free(meshBuf);
-                return;
-            }
+                JsonObject root = meshData;
 
-            if (root.containsKey(BLINKER_CMD_DEVICEINFO))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                if (root.containsKey("hello"))
+                {
+                    // a sub device joined further down the mesh, the new
+                    // connection callback only fires for the gateway's own links
+                    sendSingle(msgFrom, gateFormat(STRING_format(BLINKER_CMD_WHOIS)));
+                }
+                else if (root.containsKey(BLINKER_CMD_DEVICEINFO))
                 {
-                    bool authState = root[BLINKER_CMD_DEVICEINFO]["auth"];
-                    BLINKER_LOG_ALL("auth state: ", authState);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        bool authState = root[BLINKER_CMD_DEVICEINFO]["auth"];
+                        BLINKER_LOG_ALL("auth state: ", authState);
                     
-                    _subDevices[checkId]->auth(root[BLINKER_CMD_DEVICEINFO]["name"],
-                    root[BLINKER_CMD_DEVICEINFO]["key"],
-                    root[BLINKER_CMD_DEVICEINFO]["type"],
-                    root[BLINKER_CMD_DEVICEINFO]["vas"].as<uint16_t>());
+                        _subDevices[checkId]->auth(root[BLINKER_CMD_DEVICEINFO]["name"],
+                        root[BLINKER_CMD_DEVICEINFO]["key"],
+                        root[BLINKER_CMD_DEVICEINFO]["type"],
+                        root[BLINKER_CMD_DEVICEINFO]["vas"].as<uint16_t>());
 
-                    vasDecode(root[BLINKER_CMD_DEVICEINFO]["vas"].as<uint16_t>());
+                        vasDecode(root[BLINKER_CMD_DEVICEINFO]["vas"].as<uint16_t>());
 
 
-                    if (!authState || !_subDevices[checkId]->isAuth())
-                    {
-                        // TODO
-                        if (subRegister(checkId))
+                        if (!authState || !_subDevices[checkId]->isAuth())
                         {
-                            _subDevices[checkId]->freshAuth(true);
+                            // TODO
+                            if (subRegister(checkId))
+                            {
+                                _subDevices[checkId]->freshAuth(true);
+                            }
                         }
                     }
                 }
             }
-
-            free(meshBuf);
-        }
-        else if (isAvail_ctrl)
-        {
-            isAvail_ctrl = false;
+            else if (isAvail_ctrl)
+            {
+                isAvail_ctrl = false;
                 
-            BLINKER_LOG_ALL("new ctrl data: ", meshBuf);
-
-            DynamicJsonDocument jsonBuffer(1024);
-            DeserializationError error = deserializeJson(jsonBuffer, meshBuf);
-            JsonObject root = jsonBuffer.as<JsonObject>();
+                BLINKER_LOG_ALL("new ctrl data from: ", msgFrom);
 
-            if (error) 
-            {
-                BLINKER_ERR_LOG_ALL("msg not Json!");
-                free(meshBuf);
-                return;
-            }
+                JsonObject root = meshData;
 
-            if (root.containsKey("user"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                if (root.containsKey("user"))
                 {
-                    if (_subDevices[checkId]->isAuth())
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        subPrint(root["user"], root["toDevice"], _subDevices[checkId]->deviceName());
+                        if (_subDevices[checkId]->isAuth())
+                        {
+                            subPrint(root["user"], root["toDevice"], _subDevices[checkId]->deviceName());
+                        }
                     }
                 }
-            }
-            else if (root.containsKey("ali"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("ali"))
                 {
-                    if (_subDevices[checkId]->isAuth())
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        subAliPrint(root["ali"], _subDevices[checkId]->deviceName());
+                        if (_subDevices[checkId]->isAuth())
+                        {
+                            subAliPrint(root["ali"], _subDevices[checkId]->deviceName());
+                        }
                     }
                 }
-            }
-            else if (root.containsKey("duer"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("duer"))
                 {
-                    if (_subDevices[checkId]->isAuth())
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        subDuerPrint(root["duer"], _subDevices[checkId]->deviceName());
+                        if (_subDevices[checkId]->isAuth())
+                        {
+                            subDuerPrint(root["duer"], _subDevices[checkId]->deviceName());
+                        }
                     }
                 }
-            }
-            else if (root.containsKey("miot"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("miot"))
                 {
-                    if (_subDevices[checkId]->isAuth())
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        subMiPrint(root["miot"], _subDevices[checkId]->deviceName());
+                        if (_subDevices[checkId]->isAuth())
+                        {
+                            subMiPrint(root["miot"], _subDevices[checkId]->deviceName());
+                        }
                     }
                 }
-            }
-            else if (root.containsKey("sms"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("sms"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"msg\":\"");
-                    data += root["sms"].as<String>();
-
-                    if (root.containsKey("cel"))
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        data += BLINKER_F("\",\"cel\":\"");
-                        data += root["cel"].as<String>();
-                    }
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"msg\":\"");
+                        data += root["sms"].as<String>();
+
+                        if (root.containsKey("cel"))
+                        {
+                            data += BLINKER_F("\",\"cel\":\"");
+                            data += root["cel"].as<String>();
+                        }
 
-                    data += BLINKER_F("\"}");
+                        data += BLINKER_F("\"}");
 
-                    blinkerServer(BLINKER_CMD_SMS_NUMBER, data);
+                        blinkerServer(BLINKER_CMD_SMS_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("push"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("push"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"msg\":\"");
-                    data += root["push"].as<String>();
-                    data += BLINKER_F("\"}");
-
-                    blinkerServer(BLINKER_CMD_PUSH_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"msg\":\"");
+                        data += root["push"].as<String>();
+                        data += BLINKER_F("\"}");
+
+                        blinkerServer(BLINKER_CMD_PUSH_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("wechat"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("wechat"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"msg\":\"");
-                    data += root["wechat"].as<String>();
-
-                    if (root.containsKey("title"))
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        data += BLINKER_F("\",\"title\":\"");
-                        data += root["title"].as<String>();
-                    }
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"msg\":\"");
+                        data += root["wechat"].as<String>();
+
+                        if (root.containsKey("title"))
+                        {
+                            data += BLINKER_F("\",\"title\":\"");
+                            data += root["title"].as<String>();
+                        }
                     
-                    if (root.containsKey("state"))
-                    {
-                        data += BLINKER_F("\",\"state\":\"");
-                        data += root["state"].as<String>();
-                    }
+                        if (root.containsKey("state"))
+                        {
+                            data += BLINKER_F("\",\"state\":\"");
+                            data += root["state"].as<String>();
+                        }
 
-                    data += BLINKER_F("\"}");
+                        data += BLINKER_F("\"}");
 
-                    blinkerServer(BLINKER_CMD_WECHAT_NUMBER, data);
+                        blinkerServer(BLINKER_CMD_WECHAT_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("weather"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("weather"))
                 {
-                    String data = BLINKER_F("/weather/now?");
-                    data += BLINKER_F("deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("&location=");
-                    data += root["weather"].as<String>();
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/weather/now?");
+                        data += BLINKER_F("deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("&location=");
+                        data += root["weather"].as<String>();
 
-                    // String dataBack = "{\"ctrl\":{\"weather\":" + \
-                    //     blinkerServer(BLINKER_CMD_WEATHER_NUMBER, data) + \
-                    //     "}}";
-                    String dataBack = blinkerServer(BLINKER_CMD_WEATHER_NUMBER, data);
+                        // String dataBack = "{\"ctrl\":{\"weather\":" + \
+                        //     blinkerServer(BLINKER_CMD_WEATHER_NUMBER, data) + \
+                        //     "}}";
+                        String dataBack = blinkerServer(BLINKER_CMD_WEATHER_NUMBER, data);
 
-                    if (dataBack == "null") dataBack = "\"null\"";
+                        if (dataBack == "null") dataBack = "\"null\"";
 
-                    dataBack = "{\"ctrl\":{\"weather\":" + dataBack + "}}";
+                        dataBack = "{\"ctrl\":{\"weather\":" + dataBack + "}}";
 
-                    sendSingle(_subDevices[checkId]->id(), dataBack);
+                        sendSingle(_subDevices[checkId]->id(), dataBack);
+                    }
                 }
-            }
-            else if (root.containsKey("aqi"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("aqi"))
                 {
-                    String data = BLINKER_F("/weather/aqi?");
-                    data += BLINKER_F("deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("&location=");
-                    data += root["aqi"].as<String>();
-
-                    // String dataBack = "{\"ctrl\":{\"aqi\":" + \
-                    //     blinkerServer(BLINKER_CMD_AQI_NUMBER, data) + \
-                    //     "}}";
-                    String dataBack = blinkerServer(BLINKER_CMD_AQI_NUMBER, data);
-
-                    if (dataBack == "null") dataBack = "\"null\"";
-
-                    dataBack = "{\"meshData\":{\"aqi\":" + dataBack + "}}";
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/weather/aqi?");
+                        data += BLINKER_F("deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("&location=");
+                        data += root["aqi"].as<String>();
+
+                        // String dataBack = "{\"ctrl\":{\"aqi\":" + \
+                        //     blinkerServer(BLINKER_CMD_AQI_NUMBER, data) + \
+                        //     "}}";
+                        String dataBack = blinkerServer(BLINKER_CMD_AQI_NUMBER, data);
+
+                        if (dataBack == "null") dataBack = "\"null\"";
+
+                        dataBack = "{\"meshData\":{\"aqi\":" + dataBack + "}}";
                     
-                    sendSingle(_subDevices[checkId]->id(), dataBack);
+                        sendSingle(_subDevices[checkId]->id(), dataBack);
+                    }
                 }
-            }
-            else if (root.containsKey("freshSharers"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("freshSharers"))
                 {
-                    String data = BLINKER_F("/share/device?");
-                    data += BLINKER_F("deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/share/device?");
+                        data += BLINKER_F("deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
                     
-                    String dataBack = blinkerServer(BLINKER_CMD_FRESH_SHARERS_NUMBER, data);
+                        String dataBack = blinkerServer(BLINKER_CMD_FRESH_SHARERS_NUMBER, data);
 
-                    if (dataBack == "null") dataBack = "\"null\"";
+                        if (dataBack == "null") dataBack = "\"null\"";
 
-                    dataBack = "{\"meshData\":{\"freshSharers\":" + dataBack + "}}";
+                        dataBack = "{\"meshData\":{\"freshSharers\":" + dataBack + "}}";
                     
-                    sendSingle(_subDevices[checkId]->id(), dataBack);
+                        sendSingle(_subDevices[checkId]->id(), dataBack);
+                    }
                 }
-            }
-            else if (root.containsKey("configUpdate"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("configUpdate"))
                 {
-                    String _msg = root["configUpdate"].as<String>();
-
-                    if (_msg.length() <= 256) 
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        String data = BLINKER_F("{\"deviceName\":\"");
-                        data += _subDevices[checkId]->deviceName();
-                        data += BLINKER_F("\",\"key\":\"");
-                        data += _subDevices[checkId]->authKey();
-                        data += BLINKER_F("\",\"config\":\"");
-                        data += _msg;
-                        data += BLINKER_F("\"}");
+                        String _msg = root["configUpdate"].as<String>();
 
-                        blinkerServer(BLINKER_CMD_CONFIG_UPDATE_NUMBER, data);
+                        if (_msg.length() <= 256) 
+                        {
+                            String data = BLINKER_F("{\"deviceName\":\"");
+                            data += _subDevices[checkId]->deviceName();
+                            data += BLINKER_F("\",\"key\":\"");
+                            data += _subDevices[checkId]->authKey();
+                            data += BLINKER_F("\",\"config\":\"");
+                            data += _msg;
+                            data += BLINKER_F("\"}");
+
+                            blinkerServer(BLINKER_CMD_CONFIG_UPDATE_NUMBER, data);
+                        }
                     }
                 }
-            }
-            else if (root.containsKey("configGet"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("configGet"))
                 {
-                    String data = BLINKER_F("/pull_userconfig?deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/pull_userconfig?deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
 
-                    String dataBack = blinkerServer(BLINKER_CMD_CONFIG_GET_NUMBER, data);
+                        String dataBack = blinkerServer(BLINKER_CMD_CONFIG_GET_NUMBER, data);
 
-                    if (dataBack == "null") dataBack = "\"null\"";
+                        if (dataBack == "null") dataBack = "\"null\"";
 
-                    dataBack = "{\"meshData\":{\"configGet\":" + dataBack + "}}";
+                        dataBack = "{\"meshData\":{\"configGet\":" + dataBack + "}}";
                     
-                    sendSingle(_subDevices[checkId]->id(), dataBack);
+                        sendSingle(_subDevices[checkId]->id(), dataBack);
+                    }
                 }
-            }
-            else if (root.containsKey("configDel"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("configDel"))
                 {
-                    String data = BLINKER_F("/delete_userconfig?deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/delete_userconfig?deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
 
-                    blinkerServer(BLINKER_CMD_CONFIG_DELETE_NUMBER, data);
-                }
-            }
-            else if (root.containsKey("dataUpdate"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
-                {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"data\":");
-                    data += root["dataUpdate"].as<String>();
-                    data += BLINKER_F("}");
-
-                    blinkerServer(BLINKER_CMD_DATA_STORAGE_NUMBER, data);
+                        blinkerServer(BLINKER_CMD_CONFIG_DELETE_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("dataGet"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("dataUpdate"))
                 {
-                    String data = BLINKER_F("/pull_cloudStorage?deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
-
-                    String _type = root["dataGet"].as<String>();
-                    if (_type != "")
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        data += BLINKER_F("&dataType=");
-                        data += _type;
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"data\":");
+                        data += root["dataUpdate"].as<String>();
+                        data += BLINKER_F("}");
+
+                        blinkerServer(BLINKER_CMD_DATA_STORAGE_NUMBER, data);
                     }
-                    if (root.containsKey("date"))
+                }
+                else if (root.containsKey("dataGet"))
+                {
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        data += BLINKER_F("&date=");
-                        data += root["date"].as<String>();
-                    }
+                        String data = BLINKER_F("/pull_cloudStorage?deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
 
-                    String dataBack = blinkerServer(BLINKER_CMD_DATA_GET_NUMBER, data);
+                        String _type = root["dataGet"].as<String>();
+                        if (_type != "")
+                        {
+                            data += BLINKER_F("&dataType=");
+                            data += _type;
+                        }
+                        if (root.containsKey("date"))
+                        {
+                            data += BLINKER_F("&date=");
+                            data += root["date"].as<String>();
+                        }
 
-                    if (dataBack == "null") dataBack = "\"null\"";
+                        String dataBack = blinkerServer(BLINKER_CMD_DATA_GET_NUMBER, data);
 
-                    dataBack = "{\"meshData\":{\"dataGet\":" + dataBack + "}}";
+                        if (dataBack == "null") dataBack = "\"null\"";
+
+                        dataBack = "{\"meshData\":{\"dataGet\":" + dataBack + "}}";
                     
-                    sendSingle(_subDevices[checkId]->id(), dataBack);
+                        sendSingle(_subDevices[checkId]->id(), dataBack);
+                    }
                 }
-            }
-            else if (root.containsKey("dataDel"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("dataDel"))
                 {
-                    String data = BLINKER_F("/delete_cloudStorage?deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
-
-                    String _type = root["dataDel"].as<String>();
-                    if (_type != "")
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
                     {
-                        data += BLINKER_F("&dataType=");
-                        data += _type;
-                    }
+                        String data = BLINKER_F("/delete_cloudStorage?deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
+
+                        String _type = root["dataDel"].as<String>();
+                        if (_type != "")
+                        {
+                            data += BLINKER_F("&dataType=");
+                            data += _type;
+                        }
 
-                    blinkerServer(BLINKER_CMD_DATA_DELETE_NUMBER, data);
+                        blinkerServer(BLINKER_CMD_DATA_DELETE_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("eKey"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("eKey"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"eKey\":\"");
-                    data += root["eKey"].as<String>();
-                    data += BLINKER_F("\",\"date\":\"");
-                    data += root["date"].as<String>();
-                    data += BLINKER_F("\",\"value\":\"");
-                    data += root["value"].as<String>();
-                    data += BLINKER_F("\"}");
-
-                    blinkerServer(BLINKER_CMD_EVENT_DATA_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"eKey\":\"");
+                        data += root["eKey"].as<String>();
+                        data += BLINKER_F("\",\"date\":\"");
+                        data += root["date"].as<String>();
+                        data += BLINKER_F("\",\"value\":\"");
+                        data += root["value"].as<String>();
+                        data += BLINKER_F("\"}");
+
+                        blinkerServer(BLINKER_CMD_EVENT_DATA_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("gpsUpdate"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("gpsUpdate"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"data\":[");
-                    data += root["gpsUpdate"][0].as<String>();
-                    data += BLINKER_F(",");
-                    data += root["gpsUpdate"][1].as<String>();
-                    data += BLINKER_F(",");
-                    data += root["gpsUpdate"][2].as<String>();
-                    data += BLINKER_F("]}");
-
-                    blinkerServer(BLINKER_CMD_GPS_DATA_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"data\":[");
+                        data += root["gpsUpdate"][0].as<String>();
+                        data += BLINKER_F(",");
+                        data += root["gpsUpdate"][1].as<String>();
+                        data += BLINKER_F(",");
+                        data += root["gpsUpdate"][2].as<String>();
+                        data += BLINKER_F("]}");
+
+                        blinkerServer(BLINKER_CMD_GPS_DATA_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("autoPull"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("autoPull"))
                 {
-                    String data = BLINKER_F("/auto/pull?deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/auto/pull?deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
 
-                    String dataBack = blinkerServer(BLINKER_CMD_AUTO_PULL_NUMBER, data);
+                        String dataBack = blinkerServer(BLINKER_CMD_AUTO_PULL_NUMBER, data);
 
-                    if (dataBack == "null") dataBack = "\"null\"";
+                        if (dataBack == "null") dataBack = "\"null\"";
 
-                    dataBack = "{\"meshData\":{\"autoPull\":" + dataBack + "}}";
+                        dataBack = "{\"meshData\":{\"autoPull\":" + dataBack + "}}";
                     
-                    sendSingle(_subDevices[checkId]->id(), dataBack);
+                        sendSingle(_subDevices[checkId]->id(), dataBack);
+                    }
                 }
-            }
-            else if (root.containsKey("deviceHeartbeat"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("deviceHeartbeat"))
                 {
-                    String data = BLINKER_F("/heartbeat?");
-                    data += BLINKER_F("deviceName=");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("&key=");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("&heartbeat=");
-                    data += root["deviceHeartbeat"].as<String>();
-
-                    blinkerServer(BLINKER_CMD_DEVICE_HEARTBEAT_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("/heartbeat?");
+                        data += BLINKER_F("deviceName=");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("&key=");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("&heartbeat=");
+                        data += root["deviceHeartbeat"].as<String>();
+
+                        blinkerServer(BLINKER_CMD_DEVICE_HEARTBEAT_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("eventWarn"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("eventWarn"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"msgType\":\"warning");
-                    data += BLINKER_F("\",\"msg\":\"");
-                    data += root["eventWarn"].as<String>();
-                    data += BLINKER_F("\"}");
-
-                    blinkerServer(BLINKER_CMD_EVENT_WARNING_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"msgType\":\"warning");
+                        data += BLINKER_F("\",\"msg\":\"");
+                        data += root["eventWarn"].as<String>();
+                        data += BLINKER_F("\"}");
+
+                        blinkerServer(BLINKER_CMD_EVENT_WARNING_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("eventError"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("eventError"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"msgType\":\"error");
-                    data += BLINKER_F("\",\"msg\":\"");
-                    data += root["eventError"].as<String>();
-                    data += BLINKER_F("\"}");
-
-                    blinkerServer(BLINKER_CMD_EVENT_ERROR_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"msgType\":\"error");
+                        data += BLINKER_F("\",\"msg\":\"");
+                        data += root["eventError"].as<String>();
+                        data += BLINKER_F("\"}");
+
+                        blinkerServer(BLINKER_CMD_EVENT_ERROR_NUMBER, data);
+                    }
                 }
-            }
-            else if (root.containsKey("eventMsg"))
-            {
-                int checkId = _checkIdAlive(msgFrom);
-                if (checkId != -1)
+                else if (root.containsKey("eventMsg"))
                 {
-                    String data = BLINKER_F("{\"deviceName\":\"");
-                    data += _subDevices[checkId]->deviceName();
-                    data += BLINKER_F("\",\"key\":\"");
-                    data += _subDevices[checkId]->authKey();
-                    data += BLINKER_F("\",\"msgType\":\"error");
-                    data += BLINKER_F("\",\"msg\":\"");
-                    data += root["eventMsg"].as<String>();
-                    data += BLINKER_F("\"}");
-
-                    blinkerServer(BLINKER_CMD_EVENT_MSG_NUMBER, data);
+                    int checkId = _checkIdAlive(msgFrom);
+                    if (checkId != -1)
+                    {
+                        String data = BLINKER_F("{\"deviceName\":\"");
+                        data += _subDevices[checkId]->deviceName();
+                        data += BLINKER_F("\",\"key\":\"");
+                        data += _subDevices[checkId]->authKey();
+                        data += BLINKER_F("\",\"msgType\":\"error");
+                        data += BLINKER_F("\",\"msg\":\"");
+                        data += root["eventMsg"].as<String>();
+                        data += BLINKER_F("\"}");
+
+                        blinkerServer(BLINKER_CMD_EVENT_MSG_NUMBER, data);
+                    }
                 }
             }
-
-            free(meshBuf);
         }
 
         if (_newSub)
@@ -3237,22 +3375,48 @@ void BlinkerGateway::meshCheck()
         {
             sendBroadcast(gateFormat(STRING_format(BLINKER_CMD_WHOIS)));
 
+            painlessmesh::layout::Traffic traffic = mesh.traffic();
+            BLINKER_LOG_ALL("mesh sent: ", traffic.packagesSent, "/", traffic.bytesSent,
+                            "B, received: ", traffic.packagesReceived, "/", traffic.bytesReceived,
+                            "B, layout changed at: ", mesh.layoutChangedAt);
+            BLINKER_METRIC_HIGH(BLINKER_GAUGE_MESH_QUEUE,
+                meshQueueDepth(painlessmesh::protocol::PRIORITY_CONTROL) +
+                meshQueueDepth(painlessmesh::protocol::PRIORITY_SYNC) +
+                meshQueueDepth(painlessmesh::protocol::PRIORITY_TELEMETRY));
+            BLINKER_LOG_ALL("mesh queued control: ", meshQueueDepth(painlessmesh::protocol::PRIORITY_CONTROL),
+                            ", sync: ", meshQueueDepth(painlessmesh::protocol::PRIORITY_SYNC),
+                            ", telemetry: ", meshQueueDepth(painlessmesh::protocol::PRIORITY_TELEMETRY));
+
             _meshCheckTime = millis();
         }
     }
 }
 
+void BlinkerGateway::meshWeight(uint8_t priority, uint16_t weight)
+{
+    if (priority >= PAINLESSMESH_PRIORITIES) return;
+
+    mesh.setPriorityWeight((painlessmesh::protocol::Priority)priority, weight);
+}
+
+uint32_t BlinkerGateway::meshQueueDepth(uint8_t priority)
+{
+    if (priority >= PAINLESSMESH_PRIORITIES) return 0;
+
+    return mesh.queueDepth((painlessmesh::protocol::Priority)priority);
+}
+
 void BlinkerGateway::sendBroadcast(String msg)
 {
     mesh.sendBroadcast(msg);
 }
 
-bool BlinkerGateway::sendSingle(uint32_t toId, String msg)
+bool BlinkerGateway::sendSingle(uint32_t toId, String msg, painlessmesh::protocol::Priority priority)
 {
-    BLINKER_LOG_ALL("to id: ", toId, ", msg: ", msg);
+    BLINKER_LOG_ALL("to id: ", toId, ", msg: ", msg, ", priority: ", priority);
     if (mesh.isConnected(toId))
     {
-        return mesh.sendSingle(toId, msg);
+        return mesh.sendSingle(toId, msg, priority);
     }
     else
     {
@@ -3372,7 +3536,7 @@ bool BlinkerGateway::subRegister(uint32_t num)
     BLINKER_LOG_ALL(payload);
     BLINKER_LOG_ALL(BLINKER_F("=============================="));
 
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -3475,7 +3639,7 @@ bool BlinkerGateway::subRegister(uint32_t num)
     BLINKER_LOG_ALL(payload);
     BLINKER_LOG_ALL(BLINKER_F("=============================="));
 
-    DynamicJsonDocument _jsonBuffer(1024);
+    BLINKER_JSON_DOC(_jsonBuffer);
     DeserializationError _error = deserializeJson(_jsonBuffer, payload);
     JsonObject _root = _jsonBuffer.as<JsonObject>();
 
@@ -3495,7 +3659,8 @@ bool BlinkerGateway::subRegister(uint32_t num)
     _detail["authKey"] = _getAuthKey;
     String _data;
     serializeJson(_detail, _data);
-    sendSingle(_subDevices[num]->id(), "{\"gate\":{\"auth\":" + _data + "}}");
+    sendSingle(_subDevices[num]->id(), "{\"gate\":{\"auth\":" + _data + "}}",
+                painlessmesh::protocol::PRIORITY_CONTROL);
 
     return true;
 }
@@ -3961,7 +4126,7 @@ String BlinkerGateway::blinkerServer(uint8_t _type, const String & msg)
 
             BLINKER_LOG_ALL(payload);
             
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, payload);
             JsonObject data_rp = jsonBuffer.as<JsonObject>();
             
@@ -4470,6 +4635,7 @@ void BlinkerWlan::softAPinit() {
 
     webSocket_PRO.begin();
     webSocket_PRO.onEvent(webSocketEvent_PRO);
+    lan_PRO.begin(lanSend_PRO);
 
     _status = BWL_APCONFIG_BEGIN;
 
@@ -4547,7 +4713,7 @@ void BlinkerWlan::parseUrl(String data)
     BLINKER_LOG(BLINKER_F("APCONFIG data: "), data);
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& wifi_data = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject wifi_data = jsonBuffer.as<JsonObject>();
 
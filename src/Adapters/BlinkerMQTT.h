@@ -28,6 +28,28 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
+#include "../Blinker/BlinkerSupervisor.h"
+#include "../Blinker/BlinkerLan.h"
+#include "../Blinker/BlinkerEventLoop.h"
+#include "../Blinker/BlinkerMetrics.h"
+#include "../Blinker/BlinkerSharers.h"
+#include "../Functions/BlinkerCredentials.h"
+
+#if defined(BLINKER_WITH_BRIDGE_LAN)
+    #include <WiFiUdp.h>
+    #include <MD5Builder.h>
+
+    #include "../Blinker/BlinkerBridgeLan.h"
+#endif
+
+#if defined(BLINKER_WITH_NET_TASK)
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    #include <freertos/semphr.h>
+
+    #include "../Blinker/BlinkerRing.h"
+#endif
 
 enum b_config_t {
     COMM,
@@ -44,6 +66,34 @@ enum b_configStatus_t {
     APCFG_TIMEOUT
 };
 
+#if defined(BLINKER_WITH_NET_TASK)
+// With BLINKER_WITH_NET_TASK the broker client, the LAN WebSocket server
+// and their keepalives run in a task of their own, pinned to
+// BLINKER_NET_TASK_CORE, from the first successful connect() on. Received
+// messages and prints cross between that task and the one running
+// Blinker.run() through two BlinkerRing queues. The few calls that use
+// the broker client straight from the app, bridge and auto prints and
+// sharer updates, wait for the network task between two of its passes.
+enum blinker_net_kind_t
+{
+    BLINKER_NET_APP,
+    BLINKER_NET_ALI,
+    BLINKER_NET_DUER,
+    BLINKER_NET_MI,
+    BLINKER_NET_NONE
+};
+
+template <size_t SIZE>
+struct blinker_net_msg_t
+{
+    uint8_t     kind;
+    uint8_t     from;       // dataFrom_MQTT
+    uint8_t     sharer;     // _sharerFrom
+    bool        check;      // needCheck of print(), report of duerPrint()
+    char        data[SIZE];
+};
+#endif
+
 
 // static WiFiServer *_apServer;
 // static WiFiClient _apClient;
@@ -83,9 +133,15 @@ class BlinkerMQTT : public BlinkerStream
         void flush();
         int print(char * data, bool needCheck = true);
         int bPrint(char * name, const String & data);
-        int aliPrint(const String & data);
-        int duerPrint(const String & data, bool report = false);
-        int miPrint(const String & data);
+        #if defined(BLINKER_WITH_BRIDGE_LAN)
+        void bridgePeer(const char * name, const char * key);
+        #endif
+        int aliPrint(const char * data);
+        int duerPrint(const char * data, bool report = false);
+        int miPrint(const char * data);
+        int aliPrint(const String & data)   { return aliPrint(data.c_str()); }
+        int duerPrint(const String & data, bool report = false) { return duerPrint(data.c_str(), report); }
+        int miPrint(const String & data)    { return miPrint(data.c_str()); }
         void aliType(const String & type);
         void duerType(const String & type);
         void miType(const String & type);
@@ -98,14 +154,19 @@ class BlinkerMQTT : public BlinkerStream
         char * deviceName();
         char * authKey() { return _authKey; }
         int init() { if (!isMQTTinit) checkInit(); return isMQTTinit; }
-        int reRegister() { return connectServer(); }
+        int reRegister();
         void freshAlive() { kaTime = millis(); isAlive = true; }
         void sharers(const String & data);
+        uint8_t replyTo()           { return _sharerFrom; }
+        void replyTo(uint8_t num)   { _sharerFrom = num; }
+        // at most once every BLINKER_SHARERS_CHECK_SPAN
         int  needFreshShare() {
-            if (_needCheckShare)
+            if (_needCheckShare && (_shareCheckTime == 0 ||
+                millis() - _shareCheckTime >= BLINKER_SHARERS_CHECK_SPAN))
             {
                 BLINKER_LOG_ALL(BLINKER_F("needFreshShare"));
                 _needCheckShare = false;
+                _shareCheckTime = millis();
                 return true;
             }
             else
@@ -128,10 +189,35 @@ class BlinkerMQTT : public BlinkerStream
         void connectWiFi(String _ssid, String _pswd);
         void connectWiFi(const char* _ssid, const char* _pswd);
 
+        #if defined(BLINKER_WITH_NET_TASK)
+        void netRun();
+        bool netJob(void (*job)(void *), void * arg);
+        #endif
+
     private :
         bool isMQTTinit = false;
 
-        int connectServer();
+        #if defined(BLINKER_WITH_NET_TASK)
+        uint8_t     _netKind = BLINKER_NET_NONE;
+        uint8_t     _netFrom = BLINKER_MSG_FROM_MQTT;
+        uint8_t     _netSharer = BLINKER_MQTT_FROM_AUTHER;
+        bool        _netHeld = false;
+
+        bool onApp() const;
+        void netBegin();
+        void netPoll();
+        void netSend();
+        int netAvailable();
+        int netAvail(uint8_t kind);
+        int netQueue(uint8_t kind, const char * data, bool check);
+        #endif
+
+        int connectServer(bool useCache = false);
+        int bPublish(const String & data);
+        #if defined(BLINKER_WITH_BRIDGE_LAN)
+        void bridgePoll();
+        #endif
+        String authRequest();
         void mDNSInit();
         void checkKA();
         int checkAliKA();
@@ -146,15 +232,13 @@ class BlinkerMQTT : public BlinkerStream
         int checkPrintLimit();
 
     protected :
-        BlinkerSharer * _sharers[BLINKER_MQTT_MAX_SHARERS_NUM];
-        uint8_t     _sharerCount = 0;
+        BlinkerSharers _sharers;
         uint8_t     _sharerFrom = BLINKER_MQTT_FROM_AUTHER;
         bool        _isWiFiInit = false;
         bool        _isBegin = false;
         b_config_t  _configType = COMM;
         b_configStatus_t _configStatus = SMART_BEGIN;
         uint32_t    _connectTime = 0;
-        uint8_t     _connectTimes = 0;
         // const char* _authKey;
         char*       _authKey;
         char*       _aliType;
@@ -165,6 +249,7 @@ class BlinkerMQTT : public BlinkerStream
         bool        isAlive = false;
         // bool        isBavail = false;
         bool        _needCheckShare = false;
+        uint32_t    _shareCheckTime = 0;
         uint32_t    latestTime;
         uint32_t    printTime = 0;
         uint32_t    bPrintTime = 0;
@@ -190,19 +275,20 @@ class BlinkerMQTT : public BlinkerStream
         bool        isMIOTAvail = false;
         char*       mqtt_broker;
 
-        int isJson(const String & data);
+        int isJson(const char * data);
+        int isJson(const String & data)     { return isJson(data.c_str()); }
+        bool vaWrap(char * buf, const char * data, const char * to, bool report);
 
         #if defined(BLINKER_APCONFIG)
         // WiFiServer *_apServer;
         // WiFiClient _apClient;
         #endif
 
-        uint8_t     reconnect_time = 0;
-        uint32_t    _reRegister_time = 0;
-        uint8_t     _reRegister_times = 0;
 
         uint32_t    _print_time = 0;
         uint8_t     _print_times = 0;
+
+        BlinkerCredentials _credentials;
 };
 
 char*       MQTT_HOST_MQTT;
@@ -236,9 +322,120 @@ bool     isFresh_MQTT = false;
 bool     isConnect_MQTT = false;
 bool     isAvail_MQTT = false;
 bool     isApCfg = false;
-uint8_t  ws_num_MQTT = 0;
 uint8_t  dataFrom_MQTT = BLINKER_MSG_FROM_MQTT;
 
+BlinkerLan lan_MQTT;
+
+bool lanSend_MQTT(uint8_t num, const uint8_t * data, size_t len, bool binary)
+{
+    return binary ? webSocket_MQTT.sendBIN(num, data, len)
+                  : webSocket_MQTT.sendTXT(num, data, len);
+}
+
+#if defined(BLINKER_WITH_BRIDGE_LAN)
+WiFiUDP          bridgeUdp_MQTT;
+BlinkerBridgeLan bridgeLan_MQTT;
+char             bridgeBuf_MQTT[BLINKER_MAX_READ_SIZE];
+
+bool bridgeSend_MQTT(uint32_t ip, const char * data, size_t len)
+{
+    IPAddress to = ip ? IPAddress(ip) : IPAddress(255, 255, 255, 255);
+
+    if (!bridgeUdp_MQTT.beginPacket(to, BLINKER_BRIDGE_LAN_PORT)) return false;
+
+    bridgeUdp_MQTT.write((const uint8_t *)data, len);
+
+    return bridgeUdp_MQTT.endPacket();
+}
+
+// HMAC-MD5 of data, as hex
+void bridgeSign_MQTT(const char * key, const char * data, size_t len, char sign[33])
+{
+    uint8_t pad[64];
+    uint8_t digest[16];
+    size_t  keyLen = strlen(key);
+
+    memset(pad, 0, sizeof(pad));
+    memcpy(pad, key, keyLen < sizeof(pad) ? keyLen : sizeof(pad));
+
+    for (uint8_t i = 0; i < sizeof(pad); i++) pad[i] ^= 0x36;
+
+    MD5Builder inner;
+    inner.begin();
+    inner.add(pad, sizeof(pad));
+    inner.add((const uint8_t *)data, len);
+    inner.calculate();
+    inner.getBytes(digest);
+
+    for (uint8_t i = 0; i < sizeof(pad); i++) pad[i] ^= 0x36 ^ 0x5c;
+
+    MD5Builder outer;
+    outer.begin();
+    outer.add(pad, sizeof(pad));
+    outer.add(digest, sizeof(digest));
+    outer.calculate();
+    outer.getChars(sign);
+}
+#endif
+
+#if defined(BLINKER_WITH_NET_TASK)
+BlinkerRing<blinker_net_msg_t<BLINKER_MAX_READ_SIZE>, BLINKER_NET_RX_SLOTS> netRx_MQTT;
+BlinkerRing<blinker_net_msg_t<BLINKER_MAX_SEND_SIZE>, BLINKER_NET_TX_SLOTS> netTx_MQTT;
+TaskHandle_t        netTask_MQTT = NULL;
+SemaphoreHandle_t   netLock_MQTT = NULL;
+volatile bool       netUp_MQTT = false;
+void (* volatile    netJob_MQTT)(void *) = NULL;
+void *              netJobArg_MQTT = NULL;
+
+class BlinkerNetLock
+{
+    public :
+        BlinkerNetLock() : _lock(netLock_MQTT)
+        {
+            if (_lock) xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+        }
+
+        ~BlinkerNetLock()
+        {
+            if (_lock) xSemaphoreGiveRecursive(_lock);
+        }
+
+    private :
+        SemaphoreHandle_t _lock;
+};
+
+#define BLINKER_NET_LOCK()  BlinkerNetLock _netLock
+
+void netLoop_MQTT(void * mqtt)
+{
+    for(;;) {
+        ((BlinkerMQTT *)mqtt)->netRun();
+        // outside the lock, a job may take a while
+        if (netJob_MQTT) netJob_MQTT(netJobArg_MQTT);
+        vTaskDelay(1);
+    }
+}
+#else
+#define BLINKER_NET_LOCK()  do {} while(0)
+#endif
+
+void wsData_MQTT(const char * data, size_t length)
+{
+    if (length < BLINKER_MAX_READ_SIZE) {
+        if (isFresh_MQTT) free(msgBuf_MQTT);
+        msgBuf_MQTT = (char*)malloc((length+1)*sizeof(char));
+        memcpy(msgBuf_MQTT, data, length);
+        msgBuf_MQTT[length] = '\0';
+        isAvail_MQTT = true;
+        isFresh_MQTT = true;
+    }
+
+    if (!isApCfg) dataFrom_MQTT = BLINKER_MSG_FROM_WS;
+
+    BLINKER_METRIC_COUNT(BLINKER_CNT_WS_IN);
+    BLINKER_LOOP.signal(BLINKER_EVENT_LAN);
+}
+
 void webSocketEvent_MQTT(uint8_t num, WStype_t type, \
                     uint8_t * payload, size_t length)
 {
@@ -248,7 +445,9 @@ void webSocketEvent_MQTT(uint8_t num, WStype_t type, \
         case WStype_DISCONNECTED:
             BLINKER_LOG_ALL(BLINKER_F("Disconnected! "), num);
 
-            if (!isApCfg) isConnect_MQTT = false;
+            lan_MQTT.disconnect(num);
+
+            if (!isApCfg) isConnect_MQTT = lan_MQTT.clients() > 0;
             break;
         case WStype_CONNECTED:
             {
@@ -261,7 +460,9 @@ void webSocketEvent_MQTT(uint8_t num, WStype_t type, \
                 // send message to client
                 webSocket_MQTT.sendTXT(num, "{\"state\":\"connected\"}\n");
 
-                ws_num_MQTT = num;
+                // "ws://<ip>:81/msgpack" asks for binary frames
+                lan_MQTT.connect(num, strstr((char *)payload, "msgpack") != NULL, \
+                                millis());
 
                 if (!isApCfg) isConnect_MQTT = true;
             }
@@ -271,30 +472,27 @@ void webSocketEvent_MQTT(uint8_t num, WStype_t type, \
                             BLINKER_F(", get Text: "), (char *)payload, \
                             BLINKER_F(", length: "), length);
 
-            if (length < BLINKER_MAX_READ_SIZE) {
-                if (isFresh_MQTT) free(msgBuf_MQTT);
-                msgBuf_MQTT = (char*)malloc((length+1)*sizeof(char));
-                strcpy(msgBuf_MQTT, (char*)payload);
-                isAvail_MQTT = true;
-                isFresh_MQTT = true;
-            }
+            wsData_MQTT((char *)payload, length);
+            break;
+        case WStype_BIN:
+            {
+                BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
+                                BLINKER_F(", get binary length: "), length);
 
-            if (!isApCfg) dataFrom_MQTT = BLINKER_MSG_FROM_WS;
+                // MessagePack requests are handled as their json text
+                DynamicJsonDocument doc(BLINKER_MAX_READ_SIZE);
 
-            ws_num_MQTT = num;
+                if (deserializeMsgPack(doc, (const char *)payload, length))
+                {
+                    BLINKER_ERR_LOG_ALL(BLINKER_F("msgpack parse failed"));
+                    break;
+                }
 
-            // send message to client
-            // webSocket_MQTT.sendTXT(num, "message here");
+                String data;
+                serializeJson(doc, data);
 
-            // send data to all connected clients
-            // webSocket_MQTT.broadcastTXT("message here");
-            break;
-        case WStype_BIN:
-            // BLINKER_LOG("num: ", num, " get binary length: ", length);
-            // hexdump(payload, length);
-
-            // send message to client
-            // webSocket_MQTT.sendBIN(num, payload, length);
+                wsData_MQTT(data.c_str(), data.length());
+            }
             break;
         default :
             break;
@@ -303,10 +501,33 @@ void webSocketEvent_MQTT(uint8_t num, WStype_t type, \
 
 BlinkerMQTT::BlinkerMQTT() { isHandle = &isConnect_MQTT; }
 
+int BlinkerMQTT::reRegister()
+{
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_AUTH, millis())) return false;
+
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_AUTH, millis());
+
+    if (connectServer())
+    {
+        BLINKER_SUPERVISOR.success(BLINKER_LINK_AUTH, millis());
+        BLINKER_TRACE(BLINKER_TRACE_AUTH_OK, 0, 0);
+        return true;
+    }
+
+    BLINKER_SUPERVISOR.failure(BLINKER_LINK_AUTH, millis(), BLINKER_FAIL_AUTH);
+    BLINKER_TRACE(BLINKER_TRACE_AUTH_FAIL,
+        BLINKER_SUPERVISOR.failures(BLINKER_LINK_AUTH), 0);
+    return false;
+}
+
 int BlinkerMQTT::connect()
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netUp_MQTT;
+    #endif
+
     int8_t ret;
 
     webSocket_MQTT.loop();
@@ -318,7 +539,7 @@ int BlinkerMQTT::connect()
 
     disconnect();
 
-    if ((millis() - latestTime) < BLINKER_MQTT_CONNECT_TIMESLOT && latestTime > 0)
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_MQTT, millis()))
     {
         yield();
         return false;
@@ -326,6 +547,8 @@ int BlinkerMQTT::connect()
 
     BLINKER_LOG(BLINKER_F("Connecting to MQTT... "));
 
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_MQTT, millis());
+
     // BLINKER_LOG_ALL(BLINKER_F("MQTT_ID_MQTT: "), MQTT_ID_MQTT);
     // BLINKER_LOG_ALL(BLINKER_F("MQTT_NAME_MQTT: "), MQTT_NAME_MQTT);
     // BLINKER_LOG_ALL(BLINKER_F("MQTT_KEY_MQTT: "), MQTT_KEY_MQTT);
@@ -338,61 +561,26 @@ int BlinkerMQTT::connect()
     if ((ret = mqtt_MQTT->connect()) != 0)
     {
         BLINKER_LOG(mqtt_MQTT->connectErrorString(ret));
-        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
-                    BLINKER_MQTT_CONNECT_TIMESLOT/1000, \
-                    BLINKER_F(" seconds..."));
 
-        if (ret == 4) 
-        {
-            if (_reRegister_times < BLINKER_SERVER_CONNECT_LIMIT)
-            {
-                if (reRegister())
-                {
-                    _reRegister_times = 0;
-                }
-                else
-                {
-                    _reRegister_times++;
-                    _reRegister_time = millis();
-                }
-            }
-            else
-            {
-                if (millis() - _reRegister_time >= 60000 * 5) _reRegister_times = 0;
-            }
+        // Bad user name or password, the credentials we hold are outdated
+        BLINKER_SUPERVISOR.failure(BLINKER_LINK_MQTT, millis(),
+            ret == 4 ? BLINKER_FAIL_REJECTED : BLINKER_FAIL_MQTT);
+        BLINKER_TRACE(BLINKER_TRACE_MQTT_FAIL, ret,
+            BLINKER_SUPERVISOR.failures(BLINKER_LINK_MQTT));
 
-            BLINKER_LOG_ALL(BLINKER_F("_reRegister_times: "), _reRegister_times);
-        }
+        if (BLINKER_SUPERVISOR.needReauth()) reRegister();
 
-        this->latestTime = millis();
-        reconnect_time += 1;
-        if (reconnect_time >= 12)
-        {
-            if (_reRegister_times < BLINKER_SERVER_CONNECT_LIMIT)
-            {
-                if (reRegister())
-                {
-                    _reRegister_times = 0;
-                }
-                else
-                {
-                    _reRegister_times++;
-                    _reRegister_time = millis();
-                }
-            }
-            else
-            {
-                if (millis() - _reRegister_time >= 60000 * 5) _reRegister_times = 0;
-            }
-            
-            reconnect_time = 0;
+        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
+                    BLINKER_SUPERVISOR.retryIn(BLINKER_LINK_MQTT, millis())/1000, \
+                    BLINKER_F(" seconds..."));
 
-            BLINKER_LOG_ALL(BLINKER_F("_reRegister_times: "), _reRegister_times);
-        }
+        this->latestTime = millis();
         return false;
     }
-    
-    reconnect_time = 0;
+
+    BLINKER_SUPERVISOR.success(BLINKER_LINK_MQTT, millis());
+    BLINKER_TRACE(BLINKER_TRACE_MQTT_UP,
+        BLINKER_SUPERVISOR.connectTime(BLINKER_LINK_MQTT), 0);
 
     BLINKER_LOG(BLINKER_F("MQTT Connected!"));
     BLINKER_LOG_FreeHeap();
@@ -407,6 +595,10 @@ int BlinkerMQTT::connect()
 
     this->latestTime = millis();
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (netTask_MQTT == NULL) netBegin();
+    #endif
+
     return true;
 }
 
@@ -414,6 +606,10 @@ int BlinkerMQTT::connected()
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netUp_MQTT || *isHandle;
+    #endif
+
     if (!isMQTTinit)
     {
         return *isHandle;
@@ -427,13 +623,23 @@ int BlinkerMQTT::mConnected()
     if (!checkInit()) return false;
 
     if (!isMQTTinit) return false;
-    else return mqtt_MQTT->connected();
+
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netUp_MQTT;
+    #endif
+
+    return mqtt_MQTT->connected();
 }
 
 void BlinkerMQTT::disconnect()
 {
     if (!checkInit()) return;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        // the network task reconnects by itself
+        if (onApp()) return;
+    #endif
+
     mqtt_MQTT->disconnect();
 
     if (*isHandle) webSocket_MQTT.disconnect();
@@ -464,7 +670,16 @@ int BlinkerMQTT::available()
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netAvailable();
+    #endif
+
     webSocket_MQTT.loop();
+    lan_MQTT.flush(millis());
+
+    #if defined(BLINKER_WITH_BRIDGE_LAN)
+        bridgePoll();
+    #endif
 
     checkKA();
 #if defined(ESP8266)
@@ -481,6 +696,8 @@ int BlinkerMQTT::available()
         subscribe();
     }
 
+    BLINKER_LOOP.at(BLINKER_DUE_KEEPALIVE, this->latestTime + BLINKER_MQTT_PING_TIMEOUT);
+
     if (isAvail_MQTT)
     {
         isAvail_MQTT = false;
@@ -495,6 +712,10 @@ int BlinkerMQTT::aligenieAvail()
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netAvail(BLINKER_NET_ALI);
+    #endif
+
     if (isAliAvail)
     {
         isAliAvail = false;
@@ -509,6 +730,10 @@ int BlinkerMQTT::duerAvail()
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netAvail(BLINKER_NET_DUER);
+    #endif
+
     if (isDuerAvail)
     {
         isDuerAvail = false;
@@ -523,6 +748,10 @@ int BlinkerMQTT::miAvail()
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netAvail(BLINKER_NET_MI);
+    #endif
+
     if (isMIOTAvail)
     {
         isMIOTAvail = false;
@@ -552,16 +781,22 @@ void BlinkerMQTT::subscribe()
 
     if (!isMQTTinit) return;
 
+    // readSubscription() would wait 10ms on an idle socket
+    if (!mqtt_MQTT->available()) return;
+
+    BLINKER_LOOP.signal(BLINKER_EVENT_NET);
+
     Adafruit_MQTT_Subscribe *subscription;
     while ((subscription = mqtt_MQTT->readSubscription(10)))
     {
         if (subscription == iotSub_MQTT)
         {
+            BLINKER_METRIC_COUNT(BLINKER_CNT_MQTT_IN);
             BLINKER_LOG_ALL(BLINKER_F("Got: "), (char *)iotSub_MQTT->lastread);
 
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(String((char *)iotSub_MQTT->lastread));
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             deserializeJson(jsonBuffer, String((char *)iotSub_MQTT->lastread));
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -616,29 +851,29 @@ void BlinkerMQTT::subscribe()
             }
             else
             {
-                if (_sharerCount)
+                uint8_t num = _sharers.find(_uuid.c_str());
+
+                if (num < BLINKER_MQTT_MAX_SHARERS_NUM)
                 {
-                    for (uint8_t num = 0; num < _sharerCount; num++)
-                    {
-                        if (strcmp(_uuid.c_str(), _sharers[num]->uuid()) == 0)
-                        {
-                            _sharerFrom = num;
+                    _sharerFrom = num;
 
-                            kaTime = millis();
+                    kaTime = millis();
 
-                            BLINKER_LOG_ALL(BLINKER_F("From sharer: "), _uuid);
-                            BLINKER_LOG_ALL(BLINKER_F("sharer num: "), num);
-                            
-                            _needCheckShare = false;
+                    BLINKER_LOG_ALL(BLINKER_F("From sharer: "), _uuid);
+                    BLINKER_LOG_ALL(BLINKER_F("sharer num: "), num);
+                }
+                else
+                {
+                    _sharerFrom = BLINKER_MQTT_FROM_AUTHER;
 
-                            break;
-                        }
-                        else
-                        {
-                            BLINKER_ERR_LOG_ALL(BLINKER_F("No authority uuid, check is from bridge/share device, data: "), dataGet);
+                    // bridge messages come from devices, not from sharers
+                    const char * type = root["deviceType"];
 
-                            _needCheckShare = true;
-                        }
+                    if (type == NULL || strcmp(type, "DiyBridge") != 0)
+                    {
+                        BLINKER_ERR_LOG_ALL(BLINKER_F("No authority uuid, check is from share device, data: "), dataGet);
+
+                        _needCheckShare = true;
                     }
                 }
                 // else
@@ -679,12 +914,26 @@ void BlinkerMQTT::subscribe()
 
 char * BlinkerMQTT::lastRead()
 {
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return _netHeld ? netRx_MQTT.front()->data : "";
+    #endif
+
     if (isFresh_MQTT) return msgBuf_MQTT;
     else return "";
 }
 
 void BlinkerMQTT::flush()
 {
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp())
+        {
+            if (_netHeld) netRx_MQTT.pop();
+            _netHeld = false;
+            _netKind = BLINKER_NET_NONE;
+            return;
+        }
+    #endif
+
     if (isFresh_MQTT)
     {
         free(msgBuf_MQTT); isFresh_MQTT = false; isAvail_MQTT = false;
@@ -696,32 +945,44 @@ int BlinkerMQTT::print(char * data, bool needCheck)
 {
     if (!checkInit()) return false;
 
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netQueue(BLINKER_NET_APP, data, needCheck);
+    #endif
+
     // BLINKER_LOG_FreeHeap();
     if (*isHandle && dataFrom_MQTT == BLINKER_MSG_FROM_WS)
     {
-        if (needCheck)
-        {
-            if (!checkPrintSpan())
-            {
-                respTime = millis();
-                return false;
-            }
-        }
-
-        respTime = millis();
-
+        // LAN clients have their own budget, replies reach every client
         BLINKER_LOG_ALL(BLINKER_F("WS response: "));
         BLINKER_LOG_ALL(data);
-        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         strcat(data, BLINKER_CMD_NEWLINE);
 
-        webSocket_MQTT.sendTXT(ws_num_MQTT, data);
+        if (!lan_MQTT.broadcast(data, millis())) return false;
+
+        BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+
+        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         return true;
     }
     else
     {
+        // LAN clients see the state the cloud sees, on their own budget
+        if (lan_MQTT.clients())
+        {
+            uint16_t len = strlen(data);
+
+            strcat(data, BLINKER_CMD_NEWLINE);
+
+            if (lan_MQTT.broadcast(data, millis()))
+            {
+                BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+            }
+
+            data[len] = '\0';
+        }
+
         // // String payload;
         // if (STRING_contains_string(data, BLINKER_CMD_NEWLINE))
         // {
@@ -777,9 +1038,10 @@ int BlinkerMQTT::print(char * data, bool needCheck)
         // strcat(data, data_add.c_str());
         strcat(data, "\",\"toDevice\":\"");
         
-        if (_sharerFrom < BLINKER_MQTT_MAX_SHARERS_NUM)
+        // a reply to a sharer removed meanwhile goes to the owner
+        if (_sharers.uuid(_sharerFrom))
         {
-            strcat(data, _sharers[_sharerFrom]->uuid());
+            strcat(data, _sharers.uuid(_sharerFrom));
         }
         else
         {
@@ -824,6 +1086,7 @@ int BlinkerMQTT::print(char * data, bool needCheck)
         {
             if (!checkPrintSpan())
             {
+                BLINKER_METRIC_COUNT(BLINKER_CNT_DROP_SPAN);
                 return false;
             }
             respTime = millis();
@@ -835,6 +1098,8 @@ int BlinkerMQTT::print(char * data, bool needCheck)
             {
                 if (!checkCanPrint())
                 {
+                    BLINKER_METRIC_COUNT(BLINKER_CNT_DROP_CAN_PRINT);
+
                     if (!_alive)
                     {
                         isAlive = false;
@@ -871,6 +1136,8 @@ int BlinkerMQTT::print(char * data, bool needCheck)
                 BLINKER_LOG_ALL(BLINKER_F("...OK!"));
                 BLINKER_LOG_FreeHeap_ALL();
 
+                BLINKER_METRIC_COUNT(BLINKER_CNT_MQTT_OUT);
+
                 if (needCheck) printTime = millis();
 
                 if (!_alive)
@@ -896,6 +1163,8 @@ int BlinkerMQTT::bPrint(char * name, const String & data)
 {
     if (!checkInit()) return false;
 
+    BLINKER_NET_LOCK();
+
     // String payload;
     // if (STRING_contains_string(data, BLINKER_CMD_NEWLINE))
     // {
@@ -948,6 +1217,19 @@ int BlinkerMQTT::bPrint(char * name, const String & data)
 
     if (!isJson(data_add)) return false;
 
+    #if defined(BLINKER_WITH_BRIDGE_LAN)
+        if (bridgeLan_MQTT.print(name, data_add, millis(), ::time(nullptr)))
+        {
+            return true;
+        }
+    #endif
+
+    return bPublish(data_add);
+}
+
+// Publishes a bridge message through the broker
+int BlinkerMQTT::bPublish(const String & data_add)
+{
     BLINKER_LOG_ALL(BLINKER_F("MQTT Bridge Publish..."));
 
     // bool _alive = isAlive;
@@ -1021,19 +1303,87 @@ int BlinkerMQTT::bPrint(char * name, const String & data)
     // }
 }
 
-int BlinkerMQTT::aliPrint(const String & data)
+#if defined(BLINKER_WITH_BRIDGE_LAN)
+void BlinkerMQTT::bridgePeer(const char * name, const char * key)
+{
+    BLINKER_NET_LOCK();
+
+    bridgeLan_MQTT.peer(name, key);
+}
+
+// Bridge datagrams of the LAN, a message stops the loop until it is read.
+// Messages the LAN didn't ack go to the broker.
+void BlinkerMQTT::bridgePoll()
+{
+    int len;
+
+    while (!isAvail_MQTT && (len = bridgeUdp_MQTT.parsePacket()) > 0)
+    {
+        if (len >= BLINKER_MAX_READ_SIZE) continue;
+
+        bridgeUdp_MQTT.read(bridgeBuf_MQTT, len);
+        bridgeBuf_MQTT[len] = '\0';
+
+        String message;
+        if (!bridgeLan_MQTT.receive(bridgeUdp_MQTT.remoteIP(), bridgeBuf_MQTT, len,
+                                    millis(), ::time(nullptr), message))
+        {
+            continue;
+        }
+
+        BLINKER_LOG_ALL(BLINKER_F("bridge lan got: "), message);
+
+        if (isFresh_MQTT) free(msgBuf_MQTT);
+        msgBuf_MQTT = (char*)malloc((message.length()+1)*sizeof(char));
+        strcpy(msgBuf_MQTT, message.c_str());
+        isFresh_MQTT = true;
+        isAvail_MQTT = true;
+        isAlive = true;
+
+        dataFrom_MQTT = BLINKER_MSG_FROM_MQTT;
+
+        BLINKER_LOOP.signal(BLINKER_EVENT_LAN);
+    }
+
+    String data;
+    while (bridgeLan_MQTT.expired(millis(), data)) bPublish(data);
+}
+#endif
+
+// Wraps a voice assistant reply for the broker into buf, which holds
+// BLINKER_MAX_SEND_SIZE bytes
+bool BlinkerMQTT::vaWrap(char * buf, const char * data, const char * to, bool report)
+{
+    if (strlen(data) + strlen(MQTT_ID_MQTT) + strlen(to) + 80 > BLINKER_MAX_SEND_SIZE)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("SEND DATA BYTES MAX THAN LIMIT!"));
+        return false;
+    }
+
+    strcpy(buf, "{\"data\":");
+    if (report) strcat(buf, "{\"report\":");
+    strcat(buf, data);
+    if (report) strcat(buf, "}");
+    strcat(buf, ",\"fromDevice\":\"");
+    strcat(buf, MQTT_ID_MQTT);
+    strcat(buf, "\",\"toDevice\":\"");
+    strcat(buf, to);
+    strcat(buf, "\",\"deviceType\":\"vAssistant\"}");
+
+    return isJson(buf);
+}
+
+int BlinkerMQTT::aliPrint(const char * data)
 {
     if (!checkInit()) return false;
 
-    String data_add = BLINKER_F("{\"data\":");
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netQueue(BLINKER_NET_ALI, data, false);
+    #endif
 
-    data_add += data;
-    data_add += BLINKER_F(",\"fromDevice\":\"");
-    data_add += MQTT_ID_MQTT;
-    data_add += BLINKER_F("\",\"toDevice\":\"AliGenie_r\"");
-    data_add += BLINKER_F(",\"deviceType\":\"vAssistant\"}");
+    char data_add[BLINKER_MAX_SEND_SIZE];
 
-    if (!isJson(data_add)) return false;
+    if (!vaWrap(data_add, data, "AliGenie_r", false)) return false;
 
     BLINKER_LOG_ALL(BLINKER_F("MQTT AliGenie Publish..."));
     BLINKER_LOG_FreeHeap_ALL();
@@ -1052,7 +1402,7 @@ int BlinkerMQTT::aliPrint(const String & data)
         }
         respAliTime = millis();
 
-        if (! mqtt_MQTT->publish(BLINKER_PUB_TOPIC_MQTT, data_add.c_str()))
+        if (! mqtt_MQTT->publish(BLINKER_PUB_TOPIC_MQTT, data_add))
         {
             BLINKER_LOG_ALL(data_add);
             BLINKER_LOG_ALL(BLINKER_F("...Failed"));
@@ -1081,29 +1431,17 @@ int BlinkerMQTT::aliPrint(const String & data)
     }
 }
 
-int BlinkerMQTT::duerPrint(const String & data, bool report)
+int BlinkerMQTT::duerPrint(const char * data, bool report)
 {
     if (!checkInit()) return false;
 
-    String data_add = BLINKER_F("{\"data\":");
-
-    if (report)
-    {
-        data_add += BLINKER_F("{\"report\":");
-        data_add += data;
-        data_add += BLINKER_F("}");
-    }
-    else
-    {
-        data_add += data;
-    }
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netQueue(BLINKER_NET_DUER, data, report);
+    #endif
 
-    data_add += BLINKER_F(",\"fromDevice\":\"");
-    data_add += MQTT_ID_MQTT;
-    data_add += BLINKER_F("\",\"toDevice\":\"DuerOS_r\"");
-    data_add += BLINKER_F(",\"deviceType\":\"vAssistant\"}");
+    char data_add[BLINKER_MAX_SEND_SIZE];
 
-    if (!isJson(data_add)) return false;
+    if (!vaWrap(data_add, data, "DuerOS_r", report)) return false;
 
     BLINKER_LOG_ALL(BLINKER_F("MQTT DuerOS Publish..."));
     BLINKER_LOG_FreeHeap_ALL();
@@ -1122,7 +1460,7 @@ int BlinkerMQTT::duerPrint(const String & data, bool report)
         }
         respDuerTime = millis();
 
-        if (! mqtt_MQTT->publish(BLINKER_PUB_TOPIC_MQTT, data_add.c_str()))
+        if (! mqtt_MQTT->publish(BLINKER_PUB_TOPIC_MQTT, data_add))
         {
             BLINKER_LOG_ALL(data_add);
             BLINKER_LOG_ALL(BLINKER_F("...Failed"));
@@ -1151,19 +1489,17 @@ int BlinkerMQTT::duerPrint(const String & data, bool report)
     }
 }
 
-int BlinkerMQTT::miPrint(const String & data)
+int BlinkerMQTT::miPrint(const char * data)
 {
     if (!checkInit()) return false;
 
-    String data_add = BLINKER_F("{\"data\":");
+    #if defined(BLINKER_WITH_NET_TASK)
+        if (onApp()) return netQueue(BLINKER_NET_MI, data, false);
+    #endif
 
-    data_add += data;
-    data_add += BLINKER_F(",\"fromDevice\":\"");
-    data_add += MQTT_ID_MQTT;
-    data_add += BLINKER_F("\",\"toDevice\":\"MIOT_r\"");
-    data_add += BLINKER_F(",\"deviceType\":\"vAssistant\"}");
+    char data_add[BLINKER_MAX_SEND_SIZE];
 
-    if (!isJson(data_add)) return false;
+    if (!vaWrap(data_add, data, "MIOT_r", false)) return false;
 
     BLINKER_LOG_ALL(BLINKER_F("MQTT MIOT Publish..."));
     BLINKER_LOG_FreeHeap_ALL();
@@ -1182,7 +1518,7 @@ int BlinkerMQTT::miPrint(const String & data)
         }
         respMIOTTime = millis();
 
-        if (! mqtt_MQTT->publish(BLINKER_PUB_TOPIC_MQTT, data_add.c_str()))
+        if (! mqtt_MQTT->publish(BLINKER_PUB_TOPIC_MQTT, data_add))
         {
             BLINKER_LOG_ALL(data_add);
             BLINKER_LOG_ALL(BLINKER_F("...Failed"));
@@ -1238,6 +1574,15 @@ void BlinkerMQTT::begin(const char* auth) {
     _authKey = (char*)malloc((strlen(auth)+1)*sizeof(char));
     strcpy(_authKey, auth);
 
+    // Hardware rng, devices sharing an outage spread their retries
+    BLINKER_SUPERVISOR.seed(random(1, 0x7FFFFFFF));
+    BLINKER_TRACE(BLINKER_TRACE_BOOT, 0, 0);
+
+    #if defined(BLINKER_IDLE_SLEEP) && defined(ESP8266)
+        // lets the idle delay() of run() enter light sleep
+        WiFi.setSleepMode(WIFI_LIGHT_SLEEP);
+    #endif
+
     BLINKER_LOG_ALL(BLINKER_F("_authKey: "), auth);
 }
 
@@ -1258,34 +1603,25 @@ bool BlinkerMQTT::begin() {
         // BLINKER_ERR_LOG("Maybe you have put in the wrong AuthKey!");
         // BLINKER_ERR_LOG("Or maybe your request is too frequently!");
         // BLINKER_ERR_LOG("Or maybe your network is disconnected!");
-    if (_connectTimes < BLINKER_SERVER_CONNECT_LIMIT)
+    if (BLINKER_SUPERVISOR.ready(BLINKER_LINK_AUTH, millis()))
     {
-        if (_connectTime == 0 || (millis() - _connectTime) >= 10000)
-        {
-            _connectTime = millis();
-            if (connectServer()) {
-                _connectTimes = 0;
-                mDNSInit();
-                isMQTTinit = true;
-                return true;
-            }
-            else {
-                _connectTimes++;
-                isMQTTinit = false;
-                // ::delay(10000);
-                // BLINKER_ERR_LOG("init error, ", _connectTime);
-                // BLINKER_ERR_LOG("Maybe you have put in the wrong AuthKey!");
-                // BLINKER_ERR_LOG("Or maybe your request is too frequently!");
-                // BLINKER_ERR_LOG("Or maybe your network is disconnected!");
-                return false;
-            }
+        BLINKER_SUPERVISOR.attempt(BLINKER_LINK_AUTH, millis());
+
+        if (connectServer(true)) {
+            BLINKER_SUPERVISOR.success(BLINKER_LINK_AUTH, millis());
+            mDNSInit();
+            isMQTTinit = true;
+            return true;
+        }
+        else {
+            BLINKER_SUPERVISOR.failure(BLINKER_LINK_AUTH, millis(), BLINKER_FAIL_AUTH);
+            isMQTTinit = false;
+            // BLINKER_ERR_LOG("Maybe you have put in the wrong AuthKey!");
+            // BLINKER_ERR_LOG("Or maybe your request is too frequently!");
+            // BLINKER_ERR_LOG("Or maybe your network is disconnected!");
+            return false;
         }
     }
-    else
-    {
-        if (millis() - _connectTime > 60000 * 5) _connectTimes = 0;
-    }
-    
 
     // BLINKER_ERR_LOG("init error1, ", _connectTime);
     // ::delay(1000);
@@ -1313,6 +1649,8 @@ bool BlinkerMQTT::begin() {
 
 int BlinkerMQTT::autoPrint(unsigned long id)
 {
+    BLINKER_NET_LOCK();
+
     String payload = BLINKER_F("{\"data\":{\"set\":{");
     payload += BLINKER_F("\"auto\":{\"trig\":true,");
     payload += BLINKER_F("\"id\":");
@@ -1463,49 +1801,25 @@ char * BlinkerMQTT::deviceName() { return DEVICE_NAME_MQTT;/*MQTT_ID_MQTT;*/ }
 
 void BlinkerMQTT::sharers(const String & data)
 {
+    BLINKER_NET_LOCK();
+
     BLINKER_LOG_ALL(BLINKER_F("sharers data: "), data);
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
     // if (!root.success()) return;
     if (error) return;
 
-    String user_name = "";
-
-    if (_sharerCount)
-    {
-        for (uint8_t num = _sharerCount; num > 0; num--)
-        {
-            delete _sharers[num - 1];
-        }
-    }
-
-    _sharerCount = 0;
-
-    for (uint8_t num = 0; num < BLINKER_MQTT_MAX_SHARERS_NUM; num++)
-    {
-        user_name = root["users"][num].as<String>();
-
-        if (user_name.length() == BLINKER_MQTT_USER_UUID_SIZE)
-        {
-            BLINKER_LOG_ALL(BLINKER_F("sharer uuid: "), user_name, BLINKER_F(", length: "), user_name.length());
+    _sharers.update(root["users"].as<JsonArray>());
 
-            _sharerCount++;
-
-            _sharers[num] = new BlinkerSharer(user_name);
-        }
-        else
-        {
-            break;
-        }
-    }
+    BLINKER_LOG_ALL(BLINKER_F("sharers: "), _sharers.count());
 }
 
-int BlinkerMQTT::connectServer() {
+String BlinkerMQTT::authRequest() {
     const int httpsPort = 443;
 #if defined(ESP8266)
     String host = BLINKER_F(BLINKER_SERVER_HOST);
@@ -1764,6 +2078,20 @@ int BlinkerMQTT::connectServer() {
     http.end();
 #endif
 
+    return payload;
+}
+
+int BlinkerMQTT::connectServer(bool useCache) {
+    // Everything the auth request depends on, a change or a new build asks
+    // the server again
+    String _credentialsId = STRING_format(_authKey) + _aliType + _duerType + _miType + \
+                            BLINKER_OTA_VERSION_CODE + BLINKER_F(__DATE__ " " __TIME__);
+
+    String payload;
+    bool cached = useCache && _credentials.load(_credentialsId, payload);
+
+    if (!cached) payload = authRequest();
+
     // payload = "";
 
     BLINKER_LOG_ALL(BLINKER_F("reply was:"));
@@ -1773,12 +2101,17 @@ int BlinkerMQTT::connectServer() {
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
     if (STRING_contains_string(payload, BLINKER_CMD_NOTFOUND) || error ||
         !STRING_contains_string(payload, BLINKER_CMD_IOTID)) {
+        if (cached)
+        {
+            _credentials.clear();
+            return connectServer();
+        }
         // while(1) {
             BLINKER_ERR_LOG(BLINKER_F("Maybe you have put in the wrong AuthKey!"));
             BLINKER_ERR_LOG(BLINKER_F("Or maybe your request is too frequently!"));
@@ -1789,6 +2122,8 @@ int BlinkerMQTT::connectServer() {
         // }
     }
 
+    if (!cached) _credentials.save(_credentialsId, root[BLINKER_CMD_DETAIL]);
+
     // String _userID = STRING_find_string(payload, "deviceName", "\"", 4);
     // String _userName = STRING_find_string(payload, "iotId", "\"", 4);
     // String _key = STRING_find_string(payload, "iotToken", "\"", 4);
@@ -2057,9 +2392,18 @@ void BlinkerMQTT::mDNSInit()
 
     webSocket_MQTT.begin();
     webSocket_MQTT.onEvent(webSocketEvent_MQTT);
+    lan_MQTT.begin(lanSend_MQTT);
     BLINKER_LOG(BLINKER_F("webSocket_MQTT server started"));
     BLINKER_LOG(BLINKER_F("ws://"), DEVICE_NAME_MQTT, BLINKER_F(".local:"), WS_SERVERPORT);
 
+    #if defined(BLINKER_WITH_BRIDGE_LAN)
+        MDNS.addServiceTxt(BLINKER_MDNS_SERVICE_BLINKER, "tcp", "bridgePort", String(BLINKER_BRIDGE_LAN_PORT));
+
+        bridgeUdp_MQTT.begin(BLINKER_BRIDGE_LAN_PORT);
+        bridgeLan_MQTT.begin(bridgeSend_MQTT, bridgeSign_MQTT, MQTT_ID_MQTT, _authKey);
+        BLINKER_LOG(BLINKER_F("bridge lan port: "), BLINKER_BRIDGE_LAN_PORT);
+    #endif
+
     isApCfg = false;
 }
 
@@ -2219,14 +2563,14 @@ int BlinkerMQTT::checkPrintLimit()
     }
 }
 
-int BlinkerMQTT::isJson(const String & data)
+int BlinkerMQTT::isJson(const char * data)
 {
     BLINKER_LOG_ALL(BLINKER_F("isJson: "), data);
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
-    DeserializationError error = deserializeJson(jsonBuffer, STRING_format(data));
+    BLINKER_JSON_DOC(jsonBuffer);
+    DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
     // if (!root.success())
@@ -2540,6 +2884,7 @@ void BlinkerMQTT::softAPinit()
 
     webSocket_MQTT.begin();
     webSocket_MQTT.onEvent(webSocketEvent_MQTT);
+    lan_MQTT.begin(lanSend_MQTT);
 
     _configStatus = APCFG_BEGIN;
     isApCfg = true;
@@ -2715,7 +3060,7 @@ bool BlinkerMQTT::parseUrl(String data)
     BLINKER_LOG(BLINKER_F("APCONFIG data: "), data);
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& wifi_data = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject wifi_data = jsonBuffer.as<JsonObject>();
 
@@ -2787,6 +3132,170 @@ void BlinkerMQTT::connectWiFi(const char* _ssid, const char* _pswd)
     // _isWiFiInit = true;
 }
 
+#if defined(BLINKER_WITH_NET_TASK)
+// Called from the app task while the network task runs
+bool BlinkerMQTT::onApp() const
+{
+    return netTask_MQTT && xTaskGetCurrentTaskHandle() != netTask_MQTT;
+}
+
+void BlinkerMQTT::netBegin()
+{
+    netLock_MQTT = xSemaphoreCreateRecursiveMutex();
+    netUp_MQTT = true;
+
+    BLINKER_LOG_ALL(BLINKER_F("network task on core "), BLINKER_NET_TASK_CORE);
+
+    xTaskCreatePinnedToCore(netLoop_MQTT,
+                            "blinkerNetTask",
+                            BLINKER_NET_TASK_STACK,
+                            this,
+                            BLINKER_NET_TASK_PRIORITY,
+                            &netTask_MQTT,
+                            BLINKER_NET_TASK_CORE);
+}
+
+// Keeps the first job given, BlinkerApi hands its server queries over
+bool BlinkerMQTT::netJob(void (*job)(void *), void * arg)
+{
+    if (netTask_MQTT == NULL) return false;
+
+    if (netJob_MQTT == NULL)
+    {
+        netJobArg_MQTT = arg;
+        netJob_MQTT = job;
+    }
+
+    return true;
+}
+
+// One pass of the network task, what Blinker.run() did for the link
+void BlinkerMQTT::netRun()
+{
+    BLINKER_NET_LOCK();
+
+    if (!connected()) connect();
+    else netPoll();
+
+    netSend();
+
+    netUp_MQTT = mqtt_MQTT->connected();
+}
+
+// Hands what arrived to the app task. With its queue full new data waits
+// in the sockets, only the keepalive goes on.
+void BlinkerMQTT::netPoll()
+{
+    blinker_net_msg_t<BLINKER_MAX_READ_SIZE> * msg = netRx_MQTT.back();
+
+    if (msg == NULL)
+    {
+        if ((millis() - this->latestTime) > BLINKER_MQTT_PING_TIMEOUT) ping();
+        return;
+    }
+
+    if (available()) msg->kind = BLINKER_NET_APP;
+    else if (isAliAvail) msg->kind = BLINKER_NET_ALI;
+    else if (isDuerAvail) msg->kind = BLINKER_NET_DUER;
+    else if (isMIOTAvail) msg->kind = BLINKER_NET_MI;
+    else return;
+
+    msg->from = dataFrom_MQTT;
+    msg->sharer = _sharerFrom;
+    strncpy(msg->data, msgBuf_MQTT, BLINKER_MAX_READ_SIZE - 1);
+    msg->data[BLINKER_MAX_READ_SIZE - 1] = '\0';
+
+    netRx_MQTT.push();
+    flush();
+}
+
+// Publishes what the app task printed, in order
+void BlinkerMQTT::netSend()
+{
+    blinker_net_msg_t<BLINKER_MAX_SEND_SIZE> * msg;
+
+    while ((msg = netTx_MQTT.front()) != NULL)
+    {
+        dataFrom_MQTT = msg->from;
+        _sharerFrom = msg->sharer;
+
+        switch (msg->kind)
+        {
+            case BLINKER_NET_ALI :
+                aliPrint(msg->data);
+                break;
+            case BLINKER_NET_DUER :
+                duerPrint(msg->data, msg->check);
+                break;
+            case BLINKER_NET_MI :
+                miPrint(msg->data);
+                break;
+            default :
+                print(msg->data, msg->check);
+                break;
+        }
+
+        netTx_MQTT.pop();
+    }
+}
+
+// The oldest received message stays in its slot until flush()
+int BlinkerMQTT::netAvailable()
+{
+    if (_netHeld) return false;
+
+    blinker_net_msg_t<BLINKER_MAX_READ_SIZE> * msg = netRx_MQTT.front();
+
+    if (msg == NULL) return false;
+
+    _netHeld = true;
+    _netKind = msg->kind;
+    _netFrom = msg->from;
+    _netSharer = msg->sharer;
+
+    return netAvail(BLINKER_NET_APP);
+}
+
+int BlinkerMQTT::netAvail(uint8_t kind)
+{
+    if (!_netHeld || _netKind != kind) return false;
+
+    _netKind = BLINKER_NET_NONE;
+    return true;
+}
+
+// Replies go back to where the message being handled came from
+int BlinkerMQTT::netQueue(uint8_t kind, const char * data, bool check)
+{
+    // print() wraps the data in place
+    if (strlen(data) > BLINKER_MAX_SEND_BUFFER_SIZE)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("SEND DATA BYTES MAX THAN LIMIT!"));
+        return false;
+    }
+
+    blinker_net_msg_t<BLINKER_MAX_SEND_SIZE> * msg = netTx_MQTT.back();
+
+    if (msg == NULL)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("network task busy, print dropped"));
+        return false;
+    }
+
+    msg->kind = kind;
+    msg->from = _netFrom;
+    msg->sharer = _netSharer;
+    msg->check = check;
+    strcpy(msg->data, data);
+
+    netTx_MQTT.push();
+
+    if (kind == BLINKER_NET_APP) _netSharer = BLINKER_MQTT_FROM_AUTHER;
+
+    return true;
+}
+#endif
+
 #endif
 
 #endif
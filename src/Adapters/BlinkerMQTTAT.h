@@ -29,6 +29,9 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
+#include "../Blinker/BlinkerSupervisor.h"
+#include "../Functions/BlinkerCredentials.h"
 #include "../Blinker/BlinkerMQTTATBase.h"
 
 class BlinkerMQTTAT : public BlinkerStream
@@ -84,16 +87,21 @@ class BlinkerMQTTAT : public BlinkerStream
         void connectWiFi(String _ssid, String _pswd);
         void connectWiFi(const char* _ssid, const char* _pswd);
         int init() { return isMQTTinit; }
-        int reRegister() { return connectServer(); }
+        int reRegister();
         void aligenieType(int _type) { _aliType = _type; }
         void duerType(int _type) { _duerType = _type; }
         void freshAlive() { kaTime = millis(); isAlive = true; }
         void sharers(const String & data);
+        uint8_t replyTo()           { return _sharerFrom; }
+        void replyTo(uint8_t num)   { _sharerFrom = num; }
+        // at most once every BLINKER_SHARERS_CHECK_SPAN
         int  needFreshShare() {
-            if (_needCheckShare)
+            if (_needCheckShare && (_shareCheckTime == 0 ||
+                millis() - _shareCheckTime >= BLINKER_SHARERS_CHECK_SPAN))
             {
                 BLINKER_LOG_ALL(BLINKER_F("needFreshShare"));
                 _needCheckShare = false;
+                _shareCheckTime = millis();
                 return true;
             }
             else
@@ -105,7 +113,8 @@ class BlinkerMQTTAT : public BlinkerStream
     private :
         bool isMQTTinit = false;
 
-        int connectServer();
+        int connectServer(bool useCache = false);
+        String authRequest();
         void mDNSInit();
         void checkKA();
         int checkAliKA();
@@ -146,6 +155,7 @@ class BlinkerMQTTAT : public BlinkerStream
         bool        isAlive = false;
         // bool        isBavail = false;
         bool        _needCheckShare = false;
+        uint32_t    _shareCheckTime = 0;
         uint32_t    latestTime;
         uint32_t    printTime = 0;
         uint32_t    bPrintTime = 0;
@@ -179,10 +189,11 @@ class BlinkerMQTTAT : public BlinkerStream
 
         int isJson(const String & data);
 
-        uint8_t     reconnect_time = 0;
 
         uint32_t    _print_time = 0;
         uint8_t     _print_times = 0;
+
+        BlinkerCredentials _credentials;
 };
 
 // #if defined(ESP8266)
@@ -429,6 +440,25 @@ int BlinkerMQTTAT::serialConnected() { return isSerialConnect; }
 
 void BlinkerMQTTAT::serialDisconnect() { isSerialConnect = false; }
 
+int BlinkerMQTTAT::reRegister()
+{
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_AUTH, millis())) return false;
+
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_AUTH, millis());
+
+    if (connectServer())
+    {
+        BLINKER_SUPERVISOR.success(BLINKER_LINK_AUTH, millis());
+        BLINKER_TRACE(BLINKER_TRACE_AUTH_OK, 0, 0);
+        return true;
+    }
+
+    BLINKER_SUPERVISOR.failure(BLINKER_LINK_AUTH, millis(), BLINKER_FAIL_AUTH);
+    BLINKER_TRACE(BLINKER_TRACE_AUTH_FAIL,
+        BLINKER_SUPERVISOR.failures(BLINKER_LINK_AUTH), 0);
+    return false;
+}
+
 int BlinkerMQTTAT::connect()
 {
     if (!_isBegin)
@@ -449,13 +479,15 @@ int BlinkerMQTTAT::connect()
 
     disconnect();
 
-    if ((millis() - latestTime) < 5000)
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_MQTT, millis()))
     {
         return false;
     }
 
     BLINKER_LOG(BLINKER_F("Connecting to MQTT... "));
 
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_MQTT, millis());
+
     #if defined(ESP8266)
         client_mqtt.setInsecure();
     #endif
@@ -463,19 +495,26 @@ int BlinkerMQTTAT::connect()
     if ((ret = mqtt_MQTT_AT->connect()) != 0)
     {
         BLINKER_LOG(mqtt_MQTT_AT->connectErrorString(ret));
-        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in 5 seconds..."));
+
+        // Bad user name or password, the credentials we hold are outdated
+        BLINKER_SUPERVISOR.failure(BLINKER_LINK_MQTT, millis(),
+            ret == 4 ? BLINKER_FAIL_REJECTED : BLINKER_FAIL_MQTT);
+        BLINKER_TRACE(BLINKER_TRACE_MQTT_FAIL, ret,
+            BLINKER_SUPERVISOR.failures(BLINKER_LINK_MQTT));
+
+        if (BLINKER_SUPERVISOR.needReauth()) reRegister();
+
+        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
+                    BLINKER_SUPERVISOR.retryIn(BLINKER_LINK_MQTT, millis())/1000, \
+                    BLINKER_F(" seconds..."));
 
         this->latestTime = millis();
-        reconnect_time += 1;
-        if (reconnect_time >= 12)
-        {
-            reRegister();
-            reconnect_time = 0;
-        }
         return false;
     }
-    
-    reconnect_time = 0;
+
+    BLINKER_SUPERVISOR.success(BLINKER_LINK_MQTT, millis());
+    BLINKER_TRACE(BLINKER_TRACE_MQTT_UP,
+        BLINKER_SUPERVISOR.connectTime(BLINKER_LINK_MQTT), 0);
     
     BLINKER_LOG(BLINKER_F("MQTT Connected!"));
     BLINKER_LOG_FreeHeap();
@@ -678,7 +717,7 @@ void BlinkerMQTTAT::subscribe()
             
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(String((char *)iotSub_MQTT_AT->lastread));
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, (char *)iotSub_MQTT_AT->lastread);
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1055,7 +1094,7 @@ int BlinkerMQTTAT::mqttPrint(const String & data) {
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& print_data = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject print_data = jsonBuffer.as<JsonObject>();
 
@@ -1417,6 +1456,10 @@ void BlinkerMQTTAT::begin(const char* auth) {
     // _authKey = auth;
     _authKey = (char*)malloc((strlen(auth)+1)*sizeof(char));
     strcpy(_authKey, auth);
+
+    // Hardware rng, devices sharing an outage spread their retries
+    BLINKER_SUPERVISOR.seed(random(1, 0x7FFFFFFF));
+    BLINKER_TRACE(BLINKER_TRACE_BOOT, 0, 0);
     
     BLINKER_LOG_ALL(BLINKER_F("_authKey: "), auth);
 
@@ -1442,13 +1485,19 @@ bool BlinkerMQTTAT::begin()
         // BLINKER_ERR_LOG("Maybe you have put in the wrong AuthKey!");
         // BLINKER_ERR_LOG("Or maybe your request is too frequently!");
         // BLINKER_ERR_LOG("Or maybe your network is disconnected!");
+        if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_AUTH, millis())) return false;
+
+        BLINKER_SUPERVISOR.attempt(BLINKER_LINK_AUTH, millis());
+
         BLINKER_LOG_ALL("connectServer");
-        if (connectServer()) {
+        if (connectServer(true)) {
+            BLINKER_SUPERVISOR.success(BLINKER_LINK_AUTH, millis());
             mDNSInit();
             isMQTTinit = true;
             return true;
         }
         else {
+            BLINKER_SUPERVISOR.failure(BLINKER_LINK_AUTH, millis(), BLINKER_FAIL_AUTH);
             isMQTTinit = false;
 
             return false;
@@ -1632,7 +1681,7 @@ void BlinkerMQTTAT::sharers(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1753,7 +1802,7 @@ int BlinkerMQTTAT::parseUrl(String data)
     BLINKER_LOG(BLINKER_F("APCONFIG data: "), data);
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& wifi_data = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject wifi_data = jsonBuffer.as<JsonObject>();
 
@@ -1899,7 +1948,7 @@ void BlinkerMQTTAT::smartconfig()
     #endif
 }
 
-int BlinkerMQTTAT::connectServer() {
+String BlinkerMQTTAT::authRequest() {
     const int httpsPort = 443;
 #if defined(ESP8266)
     String host = BLINKER_F(BLINKER_SERVER_HOST);
@@ -2204,6 +2253,20 @@ int BlinkerMQTTAT::connectServer() {
     http.end();
 #endif
 
+    return payload;
+}
+
+int BlinkerMQTTAT::connectServer(bool useCache) {
+    // Everything the auth request depends on, a change or a new build asks
+    // the server again
+    String _credentialsId = STRING_format(_authKey) + BLINKER_OTA_VERSION_CODE + \
+                            BLINKER_F(__DATE__ " " __TIME__);
+
+    String payload;
+    bool cached = useCache && _credentials.load(_credentialsId, payload);
+
+    if (!cached) payload = authRequest();
+
     BLINKER_LOG_ALL(BLINKER_F("reply was:"));
     BLINKER_LOG_ALL(BLINKER_F("=============================="));
     BLINKER_LOG_ALL(payload);
@@ -2211,12 +2274,17 @@ int BlinkerMQTTAT::connectServer() {
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
     if (STRING_contains_string(payload, BLINKER_CMD_NOTFOUND) || error ||
         !STRING_contains_string(payload, BLINKER_CMD_IOTID)) {
+        if (cached)
+        {
+            _credentials.clear();
+            return connectServer();
+        }
         // while(1) {
             BLINKER_ERR_LOG(BLINKER_F("Maybe you have put in the wrong AuthKey!"));
             BLINKER_ERR_LOG(BLINKER_F("Or maybe your request is too frequently!"));
@@ -2227,6 +2295,8 @@ int BlinkerMQTTAT::connectServer() {
         // }
     }
 
+    if (!cached) _credentials.save(_credentialsId, root[BLINKER_CMD_DETAIL]);
+
     // String _userID = STRING_find_string(payload, "deviceName", "\"", 4);
     // String _userName = STRING_find_string(payload, "iotId", "\"", 4);
     // String _key = STRING_find_string(payload, "iotToken", "\"", 4);
@@ -2629,7 +2699,7 @@ int BlinkerMQTTAT::isJson(const String & data)
 {
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
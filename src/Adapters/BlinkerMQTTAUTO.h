@@ -26,6 +26,7 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
 
 char*       MQTT_HOST_AUTO;
 char*       MQTT_ID_AUTO;
@@ -77,11 +78,16 @@ class BlinkerMQTTAUTO : public BlinkerStream
         int authCheck();
         void freshAlive() { kaTime = millis(); isAlive = true; }
         void sharers(const String & data);
+        uint8_t replyTo()           { return _sharerFrom; }
+        void replyTo(uint8_t num)   { _sharerFrom = num; }
+        // at most once every BLINKER_SHARERS_CHECK_SPAN
         int  needFreshShare() {
-            if (_needCheckShare)
+            if (_needCheckShare && (_shareCheckTime == 0 ||
+                millis() - _shareCheckTime >= BLINKER_SHARERS_CHECK_SPAN))
             {
                 BLINKER_LOG_ALL(BLINKER_F("needFreshShare"));
                 _needCheckShare = false;
+                _shareCheckTime = millis();
                 return true;
             }
             else
@@ -121,6 +127,7 @@ class BlinkerMQTTAUTO : public BlinkerStream
         bool        isAlive = false;
         bool        isBavail = false;
         bool        _needCheckShare = false;
+        uint32_t    _shareCheckTime = 0;
         uint32_t    latestTime;
         uint32_t    printTime = 0;
         uint32_t    bPrintTime = 0;
@@ -437,7 +444,7 @@ void BlinkerMQTTAUTO::subscribe()
 
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(String((char *)iotSub_AUTO->lastread));
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, String((char *)iotSub_AUTO->lastread));
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1155,7 +1162,7 @@ void BlinkerMQTTAUTO::sharers(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1495,7 +1502,7 @@ int BlinkerMQTTAUTO::connectServer()
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(payload);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, payload);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1630,7 +1637,7 @@ int BlinkerMQTTAUTO::connectServer()
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -2059,7 +2066,7 @@ int BlinkerMQTTAUTO::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -27,6 +27,8 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
+#include "../Blinker/BlinkerLan.h"
 
 char*       MQTT_HOST_PRO;
 char*       MQTT_ID_PRO;
@@ -76,11 +78,16 @@ class BlinkerPRO : public BlinkerStream
         int authCheck();
         void freshAlive() { kaTime = millis(); isAlive = true; }
         void sharers(const String & data);
+        uint8_t replyTo()           { return _sharerFrom; }
+        void replyTo(uint8_t num)   { _sharerFrom = num; }
+        // at most once every BLINKER_SHARERS_CHECK_SPAN
         int  needFreshShare() {
-            if (_needCheckShare)
+            if (_needCheckShare && (_shareCheckTime == 0 ||
+                millis() - _shareCheckTime >= BLINKER_SHARERS_CHECK_SPAN))
             {
                 BLINKER_LOG_ALL(BLINKER_F("needFreshShare"));
                 _needCheckShare = false;
+                _shareCheckTime = millis();
                 return true;
             }
             else
@@ -117,6 +124,7 @@ class BlinkerPRO : public BlinkerStream
         bool        isAlive = false;
         bool        isBavail = false;
         bool        _needCheckShare = false;
+        uint32_t    _shareCheckTime = 0;
         uint32_t    latestTime;
         uint32_t    printTime = 0;
         uint32_t    bPrintTime = 0;
@@ -174,9 +182,30 @@ char*   msgBuf_PRO;
 bool    isFresh_PRO = false;
 bool    isConnect_PRO = false;
 bool    isAvail_PRO = false;
-uint8_t ws_num_PRO = 0;
 uint8_t dataFrom_PRO = BLINKER_MSG_FROM_MQTT;
 
+BlinkerLan lan_PRO;
+
+bool lanSend_PRO(uint8_t num, const uint8_t * data, size_t len, bool binary)
+{
+    return binary ? webSocket_PRO.sendBIN(num, data, len)
+                  : webSocket_PRO.sendTXT(num, data, len);
+}
+
+void wsData_PRO(const char * data, size_t length)
+{
+    if (length < BLINKER_MAX_READ_SIZE) {
+        if (isFresh_PRO) free(msgBuf_PRO);
+        msgBuf_PRO = (char*)malloc((length+1)*sizeof(char));
+        memcpy(msgBuf_PRO, data, length);
+        msgBuf_PRO[length] = '\0';
+        isAvail_PRO = true;
+        isFresh_PRO = true;
+    }
+
+    dataFrom_PRO = BLINKER_MSG_FROM_WS;
+}
+
 void webSocketEvent_PRO(uint8_t num, WStype_t type, \
                     uint8_t * payload, size_t length)
 {
@@ -186,7 +215,9 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
         case WStype_DISCONNECTED:
             BLINKER_LOG_ALL(BLINKER_F("Disconnected! "), num);
 
-            isConnect_PRO = false;
+            lan_PRO.disconnect(num);
+
+            isConnect_PRO = lan_PRO.clients() > 0;
             break;
         case WStype_CONNECTED:
             {
@@ -199,7 +230,9 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
                 // send message to client
                 webSocket_PRO.sendTXT(num, "{\"state\":\"connected\"}\n");
 
-                ws_num_PRO = num;
+                // "ws://<ip>:81/msgpack" asks for binary frames
+                lan_PRO.connect(num, strstr((char *)payload, "msgpack") != NULL, \
+                                millis());
 
                 isConnect_PRO = true;
             }
@@ -208,31 +241,28 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
             BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
                             BLINKER_F(", get Text: "), (char *)payload, \
                             BLINKER_F(", length: "), length);
-            
-            if (length < BLINKER_MAX_READ_SIZE) {
-                if (isFresh_PRO) free(msgBuf_PRO);
-                msgBuf_PRO = (char*)malloc((length+1)*sizeof(char));
-                strcpy(msgBuf_PRO, (char*)payload);
-                isAvail_PRO = true;
-                isFresh_PRO = true;
-            }
 
-            dataFrom_PRO = BLINKER_MSG_FROM_WS;
+            wsData_PRO((char *)payload, length);
+            break;
+        case WStype_BIN:
+            {
+                BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
+                                BLINKER_F(", get binary length: "), length);
 
-            ws_num_PRO = num;
+                // MessagePack requests are handled as their json text
+                DynamicJsonDocument doc(BLINKER_MAX_READ_SIZE);
 
-            // send message to client
-            // webSocket_PRO.sendTXT(num, "message here");
+                if (deserializeMsgPack(doc, (const char *)payload, length))
+                {
+                    BLINKER_ERR_LOG_ALL(BLINKER_F("msgpack parse failed"));
+                    break;
+                }
 
-            // send data to all connected clients
-            // webSocket_PRO.broadcastTXT("message here");
-            break;
-        case WStype_BIN:
-            // BLINKER_LOG("num: ", num, " get binary length: ", length);
-            // hexdump(payload, length);
+                String data;
+                serializeJson(doc, data);
 
-            // send message to client
-            // webSocket_PRO.sendBIN(num, payload, length);
+                wsData_PRO(data.c_str(), data.length());
+            }
             break;
     }
 }
@@ -354,6 +384,7 @@ void BlinkerPRO::ping()
 int BlinkerPRO::available()
 {
     webSocket_PRO.loop();
+    lan_PRO.flush(millis());
 
     if (isMQTTinit) {
         checkKA();
@@ -430,7 +461,7 @@ void BlinkerPRO::subscribe()
             
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(String((char *)iotSub_PRO->lastread));
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, String((char *)iotSub_PRO->lastread));
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -560,29 +591,39 @@ int BlinkerPRO::print(char * data, bool needCheck)
     // BLINKER_LOG_FreeHeap();
     if (*isHandle && dataFrom_PRO == BLINKER_MSG_FROM_WS)
     {
-        if (needCheck)
-        {
-            if (!checkPrintSpan())
-            {
-                respTime = millis();
-                return false;
-            }
-        }
-
+        // LAN clients have their own budget, replies reach every client
         respTime = millis();
-        
+
         BLINKER_LOG_ALL(BLINKER_F("WS response: "));
         BLINKER_LOG_ALL(data);
-        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         strcat(data, BLINKER_CMD_NEWLINE);
-        
-        webSocket_PRO.sendTXT(ws_num_PRO, data);
+
+        if (!lan_PRO.broadcast(data, millis())) return false;
+
+        BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+
+        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         return true;
     }
     else
     {
+        // LAN clients see the state the cloud sees, on their own budget
+        if (lan_PRO.clients())
+        {
+            uint16_t len = strlen(data);
+
+            strcat(data, BLINKER_CMD_NEWLINE);
+
+            if (lan_PRO.broadcast(data, millis()))
+            {
+                BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+            }
+
+            data[len] = '\0';
+        }
+
         // // String payload;
         // if (STRING_contains_string(data, BLINKER_CMD_NEWLINE))
         // {
@@ -1183,7 +1224,7 @@ void BlinkerPRO::sharers(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1573,7 +1614,7 @@ int BlinkerPRO::connectServer() {
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1873,6 +1914,7 @@ void BlinkerPRO::mDNSInit()
 
     webSocket_PRO.begin();
     webSocket_PRO.onEvent(webSocketEvent_PRO);
+    lan_PRO.begin(lanSend_PRO);
     BLINKER_LOG(BLINKER_F("webSocket_PRO server started"));
     BLINKER_LOG(BLINKER_F("ws://"), macDeviceName(), BLINKER_F(".local:"), WS_SERVERPORT);
 }
@@ -1999,7 +2041,7 @@ int BlinkerPRO::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -11,6 +11,7 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
 #include "../Functions/BlinkerHTTPAIR202.h"
 #ifndef ARDUINOJSON_VERSION_MAJOR
 #include "../modules/ArduinoJson/ArduinoJson.h"
@@ -299,7 +300,7 @@ void BlinkerProAIR202::subscribe()
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(String(mqtt_GPRS->lastRead));
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, String(mqtt_GPRS->lastRead));
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -899,7 +900,7 @@ void BlinkerProAIR202::sharers(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1023,7 +1024,7 @@ int BlinkerProAIR202::connectServer()
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1383,7 +1384,7 @@ int BlinkerProAIR202::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -26,6 +26,10 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
+#include "../Blinker/BlinkerLan.h"
+#include "../Blinker/BlinkerSupervisor.h"
+#include "../Functions/BlinkerCredentials.h"
 
 char*       MQTT_HOST_PRO;
 char*       MQTT_ID_PRO;
@@ -91,16 +95,21 @@ class BlinkerPROESP : public BlinkerStream
 
             return isMQTTinit;
         }
-        int reRegister() { return connectServer(); }
-        int deviceRegister() { return connectServer(); }
+        int reRegister();
+        int deviceRegister() { return connectServer(true); }
         int authCheck();
         void freshAlive() { kaTime = millis(); isAlive = true; }
         void sharers(const String & data);
+        uint8_t replyTo()           { return _sharerFrom; }
+        void replyTo(uint8_t num)   { _sharerFrom = num; }
+        // at most once every BLINKER_SHARERS_CHECK_SPAN
         int  needFreshShare() {
-            if (_needCheckShare)
+            if (_needCheckShare && (_shareCheckTime == 0 ||
+                millis() - _shareCheckTime >= BLINKER_SHARERS_CHECK_SPAN))
             {
                 BLINKER_LOG_ALL(BLINKER_F("needFreshShare"));
                 _needCheckShare = false;
+                _shareCheckTime = millis();
                 return true;
             }
             else
@@ -114,7 +123,8 @@ class BlinkerPROESP : public BlinkerStream
         bool isMQTTinit = false;
         bool isWSinit = false;
 
-        int connectServer();
+        int connectServer(bool useCache = false);
+        String authRequest();
         void mDNSInit(String name = macDeviceName());
         void checkKA();
         int checkAliKA();
@@ -141,6 +151,7 @@ class BlinkerPROESP : public BlinkerStream
         bool        isAlive = false;
         bool        isBavail = false;
         bool        _needCheckShare = false;
+        uint32_t    _shareCheckTime = 0;
         uint32_t    latestTime;
         uint32_t    printTime = 0;
         uint32_t    bPrintTime = 0;
@@ -171,9 +182,8 @@ class BlinkerPROESP : public BlinkerStream
 
         int isJson(const String & data);
 
-        uint8_t     reconnect_time = 0;
-        uint32_t    _reRegister_time = 0;
-        uint8_t     _reRegister_times = 0;
+
+        BlinkerCredentials _credentials;
 
         bool        _isAuthKey = false;
 };
@@ -208,9 +218,30 @@ bool    isFresh_PRO = false;
 bool    isConnect_PRO = false;
 bool    isAvail_PRO = false;
 bool    isApCfg = false;
-uint8_t ws_num_PRO = 0;
 uint8_t dataFrom_PRO = BLINKER_MSG_FROM_MQTT;
 
+BlinkerLan lan_PRO;
+
+bool lanSend_PRO(uint8_t num, const uint8_t * data, size_t len, bool binary)
+{
+    return binary ? webSocket_PRO.sendBIN(num, data, len)
+                  : webSocket_PRO.sendTXT(num, data, len);
+}
+
+void wsData_PRO(const char * data, size_t length)
+{
+    if (length < BLINKER_MAX_READ_SIZE) {
+        if (isFresh_PRO) free(msgBuf_PRO);
+        msgBuf_PRO = (char*)malloc((length+1)*sizeof(char));
+        memcpy(msgBuf_PRO, data, length);
+        msgBuf_PRO[length] = '\0';
+        isAvail_PRO = true;
+        isFresh_PRO = true;
+    }
+
+    if (!isApCfg) dataFrom_PRO = BLINKER_MSG_FROM_WS;
+}
+
 void webSocketEvent_PRO(uint8_t num, WStype_t type, \
                     uint8_t * payload, size_t length)
 {
@@ -220,7 +251,9 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
         case WStype_DISCONNECTED:
             BLINKER_LOG_ALL(BLINKER_F("Disconnected! "), num);
 
-            isConnect_PRO = false;
+            lan_PRO.disconnect(num);
+
+            if (!isApCfg) isConnect_PRO = lan_PRO.clients() > 0;
             break;
         case WStype_CONNECTED:
             {
@@ -233,7 +266,9 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
                 // send message to client
                 webSocket_PRO.sendTXT(num, "{\"state\":\"connected\"}\n");
 
-                ws_num_PRO = num;
+                // "ws://<ip>:81/msgpack" asks for binary frames
+                lan_PRO.connect(num, strstr((char *)payload, "msgpack") != NULL, \
+                                millis());
 
                 if (!isApCfg) isConnect_PRO = true;
             }
@@ -242,41 +277,55 @@ void webSocketEvent_PRO(uint8_t num, WStype_t type, \
             BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
                             BLINKER_F(", get Text: "), (char *)payload, \
                             BLINKER_F(", length: "), length);
-            
-            if (length < BLINKER_MAX_READ_SIZE) {
-                if (isFresh_PRO) free(msgBuf_PRO);
-                msgBuf_PRO = (char*)malloc((length+1)*sizeof(char));
-                strcpy(msgBuf_PRO, (char*)payload);
-                isAvail_PRO = true;
-                isFresh_PRO = true;
-            }
 
-            if (!isApCfg) isConnect_PRO = true;
+            wsData_PRO((char *)payload, length);
 
-            if (!isApCfg) dataFrom_PRO = BLINKER_MSG_FROM_WS;
-
-            ws_num_PRO = num;
+            if (!isApCfg) isConnect_PRO = true;
+            break;
+        case WStype_BIN:
+            {
+                BLINKER_LOG_ALL(BLINKER_F("num: "), num, \
+                                BLINKER_F(", get binary length: "), length);
 
-            // BLINKER_LOG_ALL(BLINKER_F("isConnect_PRO: "), isConnect_PRO);
+                // MessagePack requests are handled as their json text
+                DynamicJsonDocument doc(BLINKER_MAX_READ_SIZE);
 
-            // send message to client
-            // webSocket_PRO.sendTXT(num, "message here");
+                if (deserializeMsgPack(doc, (const char *)payload, length))
+                {
+                    BLINKER_ERR_LOG_ALL(BLINKER_F("msgpack parse failed"));
+                    break;
+                }
 
-            // send data to all connected clients
-            // webSocket_PRO.broadcastTXT("message here");
-            break;
-        case WStype_BIN:
-            // BLINKER_LOG("num: ", num, " get binary length: ", length);
-            // hexdump(payload, length);
+                String data;
+                serializeJson(doc, data);
 
-            // send message to client
-            // webSocket_PRO.sendBIN(num, payload, length);
+                wsData_PRO(data.c_str(), data.length());
+            }
             break;
     }
 }
 
 BlinkerPROESP::BlinkerPROESP() { isHandle = &isConnect_PRO; }
 
+int BlinkerPROESP::reRegister()
+{
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_AUTH, millis())) return false;
+
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_AUTH, millis());
+
+    if (connectServer())
+    {
+        BLINKER_SUPERVISOR.success(BLINKER_LINK_AUTH, millis());
+        BLINKER_TRACE(BLINKER_TRACE_AUTH_OK, 0, 0);
+        return true;
+    }
+
+    BLINKER_SUPERVISOR.failure(BLINKER_LINK_AUTH, millis(), BLINKER_FAIL_AUTH);
+    BLINKER_TRACE(BLINKER_TRACE_AUTH_FAIL,
+        BLINKER_SUPERVISOR.failures(BLINKER_LINK_AUTH), 0);
+    return false;
+}
+
 int BlinkerPROESP::connect()
 {
     int8_t ret;
@@ -298,7 +347,7 @@ int BlinkerPROESP::connect()
 
     disconnect();
 
-    if ((millis() - latestTime) < BLINKER_MQTT_CONNECT_TIMESLOT && latestTime > 0)
+    if (!BLINKER_SUPERVISOR.ready(BLINKER_LINK_MQTT, millis()))
     {
         yield();
         return false;
@@ -306,6 +355,8 @@ int BlinkerPROESP::connect()
 
     BLINKER_LOG(BLINKER_F("Connecting to MQTT... "));
 
+    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_MQTT, millis());
+
     #if defined(ESP8266)
         client_mqtt.setInsecure();
         ::delay(10);
@@ -316,61 +367,26 @@ int BlinkerPROESP::connect()
     if ((ret = mqtt_PRO->connect()) != 0)
     {
         BLINKER_LOG(mqtt_PRO->connectErrorString(ret));
-        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
-                    BLINKER_MQTT_CONNECT_TIMESLOT/1000, \
-                    BLINKER_F(" seconds..."));
 
-        if (ret == 4) 
-        {
-            if (_reRegister_times < BLINKER_SERVER_CONNECT_LIMIT)
-            {
-                if (reRegister())
-                {
-                    _reRegister_times = 0;
-                }
-                else
-                {
-                    _reRegister_times++;
-                    _reRegister_time = millis();
-                }
-            }
-            else
-            {
-                if (millis() - _reRegister_time >= 60000 * 5) _reRegister_times = 0;
-            }
+        // Bad user name or password, the credentials we hold are outdated
+        BLINKER_SUPERVISOR.failure(BLINKER_LINK_MQTT, millis(),
+            ret == 4 ? BLINKER_FAIL_REJECTED : BLINKER_FAIL_MQTT);
+        BLINKER_TRACE(BLINKER_TRACE_MQTT_FAIL, ret,
+            BLINKER_SUPERVISOR.failures(BLINKER_LINK_MQTT));
 
-            BLINKER_LOG_ALL(BLINKER_F("_reRegister_times: "), _reRegister_times);
-        }
+        if (BLINKER_SUPERVISOR.needReauth()) reRegister();
 
-        this->latestTime = millis();
-        reconnect_time += 1;
-        if (reconnect_time >= 12)
-        {
-            if (_reRegister_times < BLINKER_SERVER_CONNECT_LIMIT)
-            {
-                if (reRegister())
-                {
-                    _reRegister_times = 0;
-                }
-                else
-                {
-                    _reRegister_times++;
-                    _reRegister_time = millis();
-                }
-            }
-            else
-            {
-                if (millis() - _reRegister_time >= 60000 * 5) _reRegister_times = 0;
-            }
-            
-            reconnect_time = 0;
+        BLINKER_LOG(BLINKER_F("Retrying MQTT connection in "), \
+                    BLINKER_SUPERVISOR.retryIn(BLINKER_LINK_MQTT, millis())/1000, \
+                    BLINKER_F(" seconds..."));
 
-            BLINKER_LOG_ALL(BLINKER_F("_reRegister_times: "), _reRegister_times);
-        }
+        this->latestTime = millis();
         return false;
     }
-    
-    reconnect_time = 0;
+
+    BLINKER_SUPERVISOR.success(BLINKER_LINK_MQTT, millis());
+    BLINKER_TRACE(BLINKER_TRACE_MQTT_UP,
+        BLINKER_SUPERVISOR.connectTime(BLINKER_LINK_MQTT), 0);
     
     BLINKER_LOG(BLINKER_F("MQTT Connected!"));
     BLINKER_LOG_FreeHeap();
@@ -442,6 +458,7 @@ int BlinkerPROESP::available()
     delay(1);
 
     webSocket_PRO.loop();
+    lan_PRO.flush(millis());
 
     if (isMQTTinit) {
         checkKA();
@@ -530,7 +547,7 @@ void BlinkerPROESP::subscribe()
             
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(String((char *)iotSub_PRO->lastread));
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, String((char *)iotSub_PRO->lastread));
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -669,29 +686,39 @@ int BlinkerPROESP::print(char * data, bool needCheck)
     // BLINKER_LOG_FreeHeap();
     if (*isHandle && dataFrom_PRO == BLINKER_MSG_FROM_WS)
     {
-        if (needCheck)
-        {
-            if (!checkPrintSpan())
-            {
-                respTime = millis();
-                return false;
-            }
-        }
-
+        // LAN clients have their own budget, replies reach every client
         respTime = millis();
-        
+
         BLINKER_LOG_ALL(BLINKER_F("WS response: "));
         BLINKER_LOG_ALL(data);
-        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         strcat(data, BLINKER_CMD_NEWLINE);
-        
-        webSocket_PRO.sendTXT(ws_num_PRO, data);
+
+        if (!lan_PRO.broadcast(data, millis())) return false;
+
+        BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+
+        BLINKER_LOG_ALL(BLINKER_F("Success..."));
 
         return true;
     }
     else
     {
+        // LAN clients see the state the cloud sees, on their own budget
+        if (lan_PRO.clients())
+        {
+            uint16_t len = strlen(data);
+
+            strcat(data, BLINKER_CMD_NEWLINE);
+
+            if (lan_PRO.broadcast(data, millis()))
+            {
+                BLINKER_METRIC_COUNT(BLINKER_CNT_WS_OUT);
+            }
+
+            data[len] = '\0';
+        }
+
         // // String payload;
         // if (STRING_contains_string(data, BLINKER_CMD_NEWLINE))
         // {
@@ -1193,6 +1220,10 @@ void BlinkerPROESP::begin(const char* _key, const char* _type)
     
     BLINKER_LOG_ALL(BLINKER_F("PRO deviceType: "), _type);
 
+    // Hardware rng, devices sharing an outage spread their retries
+    BLINKER_SUPERVISOR.seed(random(1, 0x7FFFFFFF));
+    BLINKER_TRACE(BLINKER_TRACE_BOOT, 0, 0);
+
     mDNSInit();
 }
 
@@ -1352,7 +1383,7 @@ void BlinkerPROESP::sharers(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1416,7 +1447,193 @@ int BlinkerPROESP::authCheck()
     return false;
 }
 
-int BlinkerPROESP::connectServer() {
+String BlinkerPROESP::authRequest() {
+    #if defined(ESP8266)
+        String host = BLINKER_F(BLINKER_SERVER_HOST);
+    #elif defined(ESP32)
+        String host = BLINKER_F(BLINKER_SERVER_HTTPS);
+    #endif
+
+#if defined(ESP8266)
+    // client_mqtt.stop();
+
+    std::unique_ptr<BearSSL::WiFiClientSecure>client_s(new BearSSL::WiFiClientSecure);
+
+    // client_s->setFingerprint(fingerprint);
+    client_s->setInsecure();
+
+    String url_iot = BLINKER_F("/api/v1/user/device/auth?authKey=");
+    url_iot += AUTHKEY_PRO;
+    // url_iot += _aliType;
+    // url_iot += _duerType;
+
+    #if defined(BLINKER_ALIGENIE_LIGHT)
+        url_iot += BLINKER_F("&aliType=light");
+    #elif defined(BLINKER_ALIGENIE_OUTLET)
+        url_iot += BLINKER_F("&aliType=outlet");
+    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
+        url_iot += BLINKER_F("&aliType=multi_outlet");
+    #elif defined(BLINKER_ALIGENIE_SENSOR)
+        url_iot += BLINKER_F("&aliType=sensor");
+    #elif defined(BLINKER_ALIGENIE_TYPE)
+        url_iot += BLINKER_ALIGENIE_TYPE;
+    #endif
+
+    #if defined(BLINKER_DUEROS_LIGHT)
+        url_iot += BLINKER_F("&duerType=LIGHT");
+    #elif defined(BLINKER_DUEROS_OUTLET)
+        url_iot += BLINKER_F("&duerType=SOCKET");
+    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
+        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
+    #elif defined(BLINKER_DUEROS_SENSOR)
+        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
+    #elif defined(BLINKER_DUEROS_TYPE)
+        url_iot += BLINKER_DUEROS_TYPE;
+    #endif
+
+    #if defined(BLINKER_MIOT_LIGHT)
+        url_iot += BLINKER_F("&miType=light");
+    #elif defined(BLINKER_MIOT_OUTLET)
+        url_iot += BLINKER_F("&miType=outlet");
+    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
+        url_iot += BLINKER_F("&miType=multi_outlet");
+    #elif defined(BLINKER_MIOT_SENSOR)
+        url_iot += BLINKER_F("&miType=sensor");
+    #elif defined(BLINKER_MIOT_TYPE)
+        url_iot += BLINKER_MIOT_TYPE;
+    #endif
+    
+    url_iot += BLINKER_F("&version=");
+    url_iot += BLINKER_OTA_VERSION_CODE;
+
+    url_iot = "https://" + host + url_iot;
+
+    HTTPClient http;
+
+    String payload = "";
+
+    BLINKER_LOG_ALL(BLINKER_F("[HTTP] begin: "), url_iot);
+
+    if (http.begin(*client_s, url_iot)) {  // HTTPS
+
+        // Serial.print("[HTTPS] GET...\n");
+        // start connection and send HTTP header
+        int httpCode = http.GET();
+
+        // httpCode will be negative on error
+        if (httpCode > 0) {
+            // HTTP header has been send and Server response header has been handled
+
+            BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
+
+            // file found at server
+            if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
+                payload = http.getString();
+                // Serial.println(payload);
+            }
+        } else {
+            BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
+            payload = http.getString();
+            BLINKER_LOG(payload);
+        }
+
+        http.end();
+    } else {
+        // Serial.printf("[HTTPS] Unable to connect\n");
+    }
+
+#elif defined(ESP32)
+    HTTPClient http;
+
+    String url_iot = host;
+    url_iot += BLINKER_F("/api/v1/user/device/auth?authKey=");
+    url_iot += AUTHKEY_PRO;
+    // url_iot += _aliType;
+    // url_iot += _duerType;
+
+    #if defined(BLINKER_ALIGENIE_LIGHT)
+        url_iot += BLINKER_F("&aliType=light");
+    #elif defined(BLINKER_ALIGENIE_OUTLET)
+        url_iot += BLINKER_F("&aliType=outlet");
+    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
+        url_iot += BLINKER_F("&aliType=multi_outlet");
+    #elif defined(BLINKER_ALIGENIE_SENSOR)
+        url_iot += BLINKER_F("&aliType=sensor");
+    #elif defined(BLINKER_ALIGENIE_TYPE)
+        url_iot += BLINKER_ALIGENIE_TYPE;
+    #endif
+
+    #if defined(BLINKER_DUEROS_LIGHT)
+        url_iot += BLINKER_F("&duerType=LIGHT");
+    #elif defined(BLINKER_DUEROS_OUTLET)
+        url_iot += BLINKER_F("&duerType=SOCKET");
+    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
+        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
+    #elif defined(BLINKER_DUEROS_SENSOR)
+        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
+    #elif defined(BLINKER_DUEROS_TYPE)
+        url_iot += BLINKER_DUEROS_TYPE;
+    #endif
+
+    #if defined(BLINKER_MIOT_LIGHT)
+        url_iot += BLINKER_F("&miType=light");
+    #elif defined(BLINKER_MIOT_OUTLET)
+        url_iot += BLINKER_F("&miType=outlet");
+    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
+        url_iot += BLINKER_F("&miType=multi_outlet");
+    #elif defined(BLINKER_MIOT_SENSOR)
+        url_iot += BLINKER_F("&miType=sensor");
+    #elif defined(BLINKER_MIOT_TYPE)
+        url_iot += BLINKER_MIOT_TYPE;
+    #endif
+    
+    url_iot += BLINKER_F("&version=");
+    url_iot += BLINKER_OTA_VERSION_CODE;
+
+    BLINKER_LOG_ALL(BLINKER_F("HTTPS begin: "), url_iot);
+
+// #if defined(ESP8266)
+//     http.begin(url_iot, fingerprint); //HTTP
+// #elif defined(ESP32)
+    // http.begin(url_iot, ca); TODO
+    http.begin(url_iot);
+// #endif
+    int httpCode = http.GET();
+
+    String payload = "";
+
+    if (httpCode > 0) {
+      // HTTP header has been send and Server response header has been handled
+
+        BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
+
+        // file found at server
+        if (httpCode == HTTP_CODE_OK) {
+            payload = http.getString();
+            // BLINKER_LOG(payload);
+        }
+    }
+    else {
+        BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
+        payload = http.getString();
+        BLINKER_LOG(payload);
+    }
+
+    http.end();
+#endif
+
+    return payload;
+}
+
+int BlinkerPROESP::connectServer(bool useCache) {
+    // Everything the auth requests depend on, a change or a new build asks
+    // the server again
+    String _credentialsId = STRING_format(_deviceType) + _vipKey + macDeviceName() + \
+                            BLINKER_OTA_VERSION_CODE + BLINKER_F(__DATE__ " " __TIME__);
+
+    String payload;
+    bool cached = useCache && _credentials.load(_credentialsId, payload);
+
     const int httpsPort = 443;
     #if defined(ESP8266)
         String host = BLINKER_F(BLINKER_SERVER_HOST);
@@ -1424,7 +1641,7 @@ int BlinkerPROESP::connectServer() {
     #elif defined(ESP32)
         String host = BLINKER_F(BLINKER_SERVER_HTTPS);
     #endif
-    if (!_isAuthKey)
+    if (!_isAuthKey && !cached)
     {
     #if defined(ESP8266)
         // String host = BLINKER_F(BLINKER_SERVER_HOST);
@@ -1778,7 +1995,7 @@ int BlinkerPROESP::connectServer() {
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(payload);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, payload);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -1806,173 +2023,7 @@ int BlinkerPROESP::connectServer() {
         _isAuthKey = true;
     }
 
-#if defined(ESP8266)
-    // client_mqtt.stop();
-
-    std::unique_ptr<BearSSL::WiFiClientSecure>client_s(new BearSSL::WiFiClientSecure);
-
-    // client_s->setFingerprint(fingerprint);
-    client_s->setInsecure();
-
-    String url_iot = BLINKER_F("/api/v1/user/device/auth?authKey=");
-    url_iot += AUTHKEY_PRO;
-    // url_iot += _aliType;
-    // url_iot += _duerType;
-
-    #if defined(BLINKER_ALIGENIE_LIGHT)
-        url_iot += BLINKER_F("&aliType=light");
-    #elif defined(BLINKER_ALIGENIE_OUTLET)
-        url_iot += BLINKER_F("&aliType=outlet");
-    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
-        url_iot += BLINKER_F("&aliType=multi_outlet");
-    #elif defined(BLINKER_ALIGENIE_SENSOR)
-        url_iot += BLINKER_F("&aliType=sensor");
-    #elif defined(BLINKER_ALIGENIE_TYPE)
-        url_iot += BLINKER_ALIGENIE_TYPE;
-    #endif
-
-    #if defined(BLINKER_DUEROS_LIGHT)
-        url_iot += BLINKER_F("&duerType=LIGHT");
-    #elif defined(BLINKER_DUEROS_OUTLET)
-        url_iot += BLINKER_F("&duerType=SOCKET");
-    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
-        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
-    #elif defined(BLINKER_DUEROS_SENSOR)
-        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
-    #elif defined(BLINKER_DUEROS_TYPE)
-        url_iot += BLINKER_DUEROS_TYPE;
-    #endif
-
-    #if defined(BLINKER_MIOT_LIGHT)
-        url_iot += BLINKER_F("&miType=light");
-    #elif defined(BLINKER_MIOT_OUTLET)
-        url_iot += BLINKER_F("&miType=outlet");
-    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
-        url_iot += BLINKER_F("&miType=multi_outlet");
-    #elif defined(BLINKER_MIOT_SENSOR)
-        url_iot += BLINKER_F("&miType=sensor");
-    #elif defined(BLINKER_MIOT_TYPE)
-        url_iot += BLINKER_MIOT_TYPE;
-    #endif
-    
-    url_iot += BLINKER_F("&version=");
-    url_iot += BLINKER_OTA_VERSION_CODE;
-
-    url_iot = "https://" + host + url_iot;
-
-    HTTPClient http;
-
-    String payload = "";
-
-    BLINKER_LOG_ALL(BLINKER_F("[HTTP] begin: "), url_iot);
-
-    if (http.begin(*client_s, url_iot)) {  // HTTPS
-
-        // Serial.print("[HTTPS] GET...\n");
-        // start connection and send HTTP header
-        int httpCode = http.GET();
-
-        // httpCode will be negative on error
-        if (httpCode > 0) {
-            // HTTP header has been send and Server response header has been handled
-
-            BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
-
-            // file found at server
-            if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
-                payload = http.getString();
-                // Serial.println(payload);
-            }
-        } else {
-            BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
-            payload = http.getString();
-            BLINKER_LOG(payload);
-        }
-
-        http.end();
-    } else {
-        // Serial.printf("[HTTPS] Unable to connect\n");
-    }
-
-#elif defined(ESP32)
-    HTTPClient http;
-
-    String url_iot = host;
-    url_iot += BLINKER_F("/api/v1/user/device/auth?authKey=");
-    url_iot += AUTHKEY_PRO;
-    // url_iot += _aliType;
-    // url_iot += _duerType;
-
-    #if defined(BLINKER_ALIGENIE_LIGHT)
-        url_iot += BLINKER_F("&aliType=light");
-    #elif defined(BLINKER_ALIGENIE_OUTLET)
-        url_iot += BLINKER_F("&aliType=outlet");
-    #elif defined(BLINKER_ALIGENIE_MULTI_OUTLET)
-        url_iot += BLINKER_F("&aliType=multi_outlet");
-    #elif defined(BLINKER_ALIGENIE_SENSOR)
-        url_iot += BLINKER_F("&aliType=sensor");
-    #elif defined(BLINKER_ALIGENIE_TYPE)
-        url_iot += BLINKER_ALIGENIE_TYPE;
-    #endif
-
-    #if defined(BLINKER_DUEROS_LIGHT)
-        url_iot += BLINKER_F("&duerType=LIGHT");
-    #elif defined(BLINKER_DUEROS_OUTLET)
-        url_iot += BLINKER_F("&duerType=SOCKET");
-    #elif defined(BLINKER_DUEROS_MULTI_OUTLET)
-        url_iot += BLINKER_F("&duerType=MULTI_SOCKET");
-    #elif defined(BLINKER_DUEROS_SENSOR)
-        url_iot += BLINKER_F("&duerType=AIR_MONITOR");
-    #elif defined(BLINKER_DUEROS_TYPE)
-        url_iot += BLINKER_DUEROS_TYPE;
-    #endif
-
-    #if defined(BLINKER_MIOT_LIGHT)
-        url_iot += BLINKER_F("&miType=light");
-    #elif defined(BLINKER_MIOT_OUTLET)
-        url_iot += BLINKER_F("&miType=outlet");
-    #elif defined(BLINKER_MIOT_MULTI_OUTLET)
-        url_iot += BLINKER_F("&miType=multi_outlet");
-    #elif defined(BLINKER_MIOT_SENSOR)
-        url_iot += BLINKER_F("&miType=sensor");
-    #elif defined(BLINKER_MIOT_TYPE)
-        url_iot += BLINKER_MIOT_TYPE;
-    #endif
-    
-    url_iot += BLINKER_F("&version=");
-    url_iot += BLINKER_OTA_VERSION_CODE;
-
-    BLINKER_LOG_ALL(BLINKER_F("HTTPS begin: "), url_iot);
-
-// #if defined(ESP8266)
-//     http.begin(url_iot, fingerprint); //HTTP
-// #elif defined(ESP32)
-    // http.begin(url_iot, ca); TODO
-    http.begin(url_iot);
-// #endif
-    int httpCode = http.GET();
-
-    String payload = "";
-
-    if (httpCode > 0) {
-      // HTTP header has been send and Server response header has been handled
-
-        BLINKER_LOG_ALL(BLINKER_F("[HTTP] GET... code: "), httpCode);
-
-        // file found at server
-        if (httpCode == HTTP_CODE_OK) {
-            payload = http.getString();
-            // BLINKER_LOG(payload);
-        }
-    }
-    else {
-        BLINKER_LOG(BLINKER_F("[HTTP] GET... failed, error: "), http.errorToString(httpCode).c_str());
-        payload = http.getString();
-        BLINKER_LOG(payload);
-    }
-
-    http.end();
-#endif
+    if (!cached) payload = authRequest();
 
     BLINKER_LOG_ALL(BLINKER_F("reply was:"));
     BLINKER_LOG_ALL(BLINKER_F("=============================="));
@@ -1981,12 +2032,17 @@ int BlinkerPROESP::connectServer() {
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
     if (STRING_contains_string(payload, BLINKER_CMD_NOTFOUND) || error ||
         !STRING_contains_string(payload, BLINKER_CMD_IOTID)) {
+        if (cached)
+        {
+            _credentials.clear();
+            return connectServer();
+        }
         // while(1) {
             BLINKER_ERR_LOG(BLINKER_F("Please make sure you have register this device!"));
             // ::delay(60000);
@@ -1995,6 +2051,18 @@ int BlinkerPROESP::connectServer() {
         // }
     }
 
+    if (cached && !_isAuthKey)
+    {
+        String _getAuthKey = root[BLINKER_CMD_DETAIL][BLINKER_CMD_AUTHKEY];
+
+        AUTHKEY_PRO = (char*)malloc((_getAuthKey.length()+1)*sizeof(char));
+        strcpy(AUTHKEY_PRO, _getAuthKey.c_str());
+
+        _isAuthKey = true;
+    }
+
+    if (!cached) _credentials.save(_credentialsId, root[BLINKER_CMD_DETAIL], AUTHKEY_PRO);
+
     // String _userID = STRING_find_string(payload, "deviceName", "\"", 4);
     // String _userName = STRING_find_string(payload, "iotId", "\"", 4);
     // String _key = STRING_find_string(payload, "iotToken", "\"", 4);
@@ -2291,6 +2359,7 @@ void BlinkerPROESP::mDNSInit(String name)
     // {
         webSocket_PRO.begin();
         webSocket_PRO.onEvent(webSocketEvent_PRO);
+        lan_PRO.begin(lanSend_PRO);
     // }
     BLINKER_LOG(BLINKER_F("webSocket_PRO server started"));
     BLINKER_LOG(BLINKER_F("ws://"), name, BLINKER_F(".local:"), WS_SERVERPORT);
@@ -2452,7 +2521,7 @@ int BlinkerPROESP::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -2885,6 +2954,7 @@ void BlinkerWlan::softAPinit() {
 
     webSocket_PRO.begin();
     webSocket_PRO.onEvent(webSocketEvent_PRO);
+    lan_PRO.begin(lanSend_PRO);
 
     _status = BWL_APCONFIG_BEGIN;
 
@@ -2962,7 +3032,7 @@ void BlinkerWlan::parseUrl(String data)
     BLINKER_LOG(BLINKER_F("APCONFIG data: "), data);
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& wifi_data = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject wifi_data = jsonBuffer.as<JsonObject>();
 
@@ -12,6 +12,9 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#if !defined(BLINKER_ARDUINOJSON)
+    #include "../Blinker/BlinkerJsonScanner.h"
+#endif
 
 #if defined(ESP32)
     #include <HardwareSerial.h>
@@ -30,6 +33,10 @@ class BlinkerSerial : public BlinkerStream
             : stream(NULL), isConnect(false)
         {}
 
+        #if !defined(BLINKER_ARDUINOJSON)
+            bool attachScanner(BlinkerJsonScanner * scan) { scanner = scan; return true; }
+        #endif
+
         int available();
         void begin(Stream& s, bool state);
         int timedRead();
@@ -48,6 +55,9 @@ class BlinkerSerial : public BlinkerStream
         bool    isHWS = false;
         uint8_t respTimes = 0;
         uint32_t    respTime = 0;
+        #if !defined(BLINKER_ARDUINOJSON)
+            BlinkerJsonScanner * scanner = NULL;
+        #endif
 
         int checkPrintSpan();
 };
@@ -72,6 +82,11 @@ int BlinkerSerial::available()
         
         int16_t dNum = 0;
         int c_d = timedRead();
+
+        #if !defined(BLINKER_ARDUINOJSON)
+            if (scanner) scanner->reset();
+        #endif
+
         while (dNum < BLINKER_MAX_READ_SIZE && 
             c_d >=0 && c_d != '\n')
         {
@@ -80,6 +95,11 @@ int BlinkerSerial::available()
                 streamData[dNum] = (char)c_d;
                 dNum++;
                 streamData = (char*)realloc(streamData, (dNum+1)*sizeof(char));
+
+                #if !defined(BLINKER_ARDUINOJSON)
+                    // members are handled as they arrive
+                    if (scanner) scanner->feed((char)c_d);
+                #endif
             }
 
             c_d = timedRead();
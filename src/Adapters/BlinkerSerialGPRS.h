@@ -11,6 +11,7 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
 #include "../Functions/BlinkerHTTPAIR202.h"
 #ifndef ARDUINOJSON_VERSION_MAJOR
 #include "../modules/ArduinoJson/ArduinoJson.h"
@@ -231,7 +232,7 @@ void BlinkerSerialGPRS::subscribe()
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(String(mqtt_GPRS->lastRead));
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, String(mqtt_GPRS->lastRead));
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -612,7 +613,7 @@ int BlinkerSerialGPRS::connectServer()
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(payload);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, payload);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -856,7 +857,7 @@ int BlinkerSerialGPRS::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(data);
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
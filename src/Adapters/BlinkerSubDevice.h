@@ -28,6 +28,7 @@
 #include "../Blinker/BlinkerDebug.h"
 #include "../Blinker/BlinkerStream.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "../Blinker/BlinkerJsonArena.h"
 
 char*   msgBuf_mesh;
 bool    isFresh_mesh = false;
@@ -54,7 +55,10 @@ painlessMesh  mesh;
     #define BLINKER_MESH_PORT   5555
 #endif
 
-char*       meshBuf;
+// Keeps the last mesh message parsed, so gate payloads that arrive as
+// nested objects are handled without a second parse
+DynamicJsonDocument meshDoc(1024);
+JsonObject  meshData;
 bool        isFresh_gate = false;
 bool        isAvail_gate = false;
 uint32_t    msgFrom;
@@ -79,14 +83,38 @@ uint32_t    miKaTime = 0;
 bool        isMIOTAlive = false;
 bool        isMIOTAvail = false;
 
+bool _meshUnpack(const char * key)
+{
+    if (meshDoc[key].is<JsonObject>())
+    {
+        meshData = meshDoc[key].as<JsonObject>();
+        return true;
+    }
+
+    // payload sent as a json string by older gateways
+    String _data = meshDoc[key].as<String>();
+    DeserializationError error = deserializeJson(meshDoc, _data);
+    meshData = meshDoc.as<JsonObject>();
+
+    if (error || meshData.isNull())
+    {
+        BLINKER_ERR_LOG_ALL("msg not Json!");
+        return false;
+    }
+
+    return true;
+}
+
 void _receivedCallback(uint32_t from, String &msg)
 {
     BLINKER_LOG_ALL("bridge: Received from: ", from, ", msg: ",msg);
     msgFrom = from;
 
-    DynamicJsonDocument jsonBuffer(1024);
-    DeserializationError error = deserializeJson(jsonBuffer, msg);
-    JsonObject root = jsonBuffer.as<JsonObject>();
+    // meshDoc is reused, a gate payload not handled yet is dropped
+    isAvail_gate = false;
+
+    DeserializationError error = deserializeJson(meshDoc, msg);
+    JsonObject root = meshDoc.as<JsonObject>();
 
     if (error) 
     {
@@ -113,11 +141,7 @@ void _receivedCallback(uint32_t from, String &msg)
         time_t now = time(nullptr);
         BLINKER_LOG_ALL("now: ", now, ", ", ctime(&now));        
         
-        String _data = root[BLINKER_CMD_GATE];
-        meshBuf = (char*)malloc((_data.length()+1)*sizeof(char));
-        strcpy(meshBuf, _data.c_str());
-
-        isAvail_gate = true;
+        isAvail_gate = _meshUnpack(BLINKER_CMD_GATE);
     }
     else if (root.containsKey("meshData"))
     {
@@ -350,7 +374,14 @@ void BlinkerSubDevice::disconnect()
 
 int BlinkerSubDevice::available()
 {
-    return false;
+    if (isAvail_PRO)
+    {
+        isAvail_PRO = false;
+        return true;
+    }
+    else {
+        return false;
+    }
 }
 
 int BlinkerSubDevice::meshAvail()
@@ -464,7 +495,7 @@ int BlinkerSubDevice::print(char * data, bool needCheck)
     // data_add = BLINKER_F(",\"fromDevice\":\"");
     // strcat(data, data_add.c_str());
     // strcat(data, MQTT_DEVICEID_PRO);
-    data_add = BLINKER_F("\",\"toDevice\":\"");
+    data_add = BLINKER_F(",\"toDevice\":\"");
     strcat(data, data_add.c_str());
     if (_sharerFrom < BLINKER_MQTT_MAX_SHARERS_NUM)
     {
@@ -475,7 +506,7 @@ int BlinkerSubDevice::print(char * data, bool needCheck)
         strcat(data, UUID_PRO);
     }
     // data_add = BLINKER_F("\",\"deviceType\":\"OwnApp\"}}");
-    data_add = BLINKER_F("}}");
+    data_add = BLINKER_F("\"}}");
     strcat(data, data_add.c_str());
 
     _sharerFrom = BLINKER_MQTT_FROM_AUTHER;
@@ -732,7 +763,7 @@ void BlinkerSubDevice::sharers(const String & data)
 {
     BLINKER_LOG_ALL(BLINKER_F("sharers data: "), data);
 
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -916,7 +947,7 @@ int BlinkerSubDevice::isJson(const String & data)
 
     // DynamicJsonBuffer jsonBuffer;
     // JsonObject& root = jsonBuffer.parseObject(STRING_format(data));
-    DynamicJsonDocument jsonBuffer(1024);
+    BLINKER_JSON_DOC(jsonBuffer);
     DeserializationError error = deserializeJson(jsonBuffer, data);
     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -990,6 +1021,10 @@ bool BlinkerSubDevice::meshInit()
     // This and all other mesh should ideally now the mesh contains a root
     // mesh.setContainsRoot(true);
 
+    #if defined(BLINKER_MESH_MSGPACK)
+        mesh.setWireFormat(painlessmesh::protocol::WIRE_MSGPACK);
+    #endif
+
     mesh.onReceive(&_receivedCallback);
     mesh.onNewConnection(&_newConnectionCallback);
 
@@ -1011,21 +1046,13 @@ void BlinkerSubDevice::meshCheck()
 
         if (isAvail_gate)
         {
-            BLINKER_LOG_ALL("new mesh data: ", meshBuf);
+            BLINKER_LOG_ALL("new mesh data from: ", msgFrom);
 
-            DynamicJsonDocument jsonBuffer(1024);
-            DeserializationError error = deserializeJson(jsonBuffer, meshBuf);
-            JsonObject root = jsonBuffer.as<JsonObject>();
-
-            if (error) 
-            {
-                BLINKER_ERR_LOG_ALL("msg not Json!");
-                isAvail_gate = false;
-                free(meshBuf);
-                return;
-            }
+            JsonObject root = meshData;
 
-            if (root.containsKey("hello"))
+            // other sub devices broadcast hello new when they join, only
+            // the gateway asks whois
+            if (root["hello"] == "whois")
             {
                 if (gateId != msgFrom)
                 {
@@ -1067,7 +1094,6 @@ void BlinkerSubDevice::meshCheck()
             }
 
             isAvail_gate = false;
-            free(meshBuf);
         }
 
         if (isNewConnect && !_isHello)
@@ -2,11 +2,17 @@
 #define BLINKER_API_H
 
 #include <time.h>
+#if defined(ESP8266) || defined(ESP32)
+    #include <sys/time.h>
+#endif
 
 #if defined(ESP8266) || defined(ESP32)
     #include <Ticker.h>
     #include <EEPROM.h>
 
+    #include "../Functions/BlinkerBridgeCache.h"
+    #include "../Functions/BlinkerQuery.h"
+
     #if defined(BLINKER_WIFI) || defined(BLINKER_MQTT) || \
         defined(BLINKER_PRO) || defined(BLINKER_AT_MQTT) || \
         defined(BLINKER_WIFI_GATEWAY) || defined(BLINKER_MQTT_AUTO) || \
@@ -81,6 +87,20 @@
 
 #include "BlinkerApiBase.h"
 #include "BlinkerProtocol.h"
+#include "BlinkerSupervisor.h"
+#include "BlinkerEventLoop.h"
+#include "BlinkerWheel.h"
+#include "../Functions/BlinkerVoice.h"
+#include "../Functions/BlinkerWidgetWriter.h"
+#include "BlinkerTrace.h"
+#include "BlinkerMetrics.h"
+#include "BlinkerJsonScanner.h"
+#if defined(BLINKER_ARDUINOJSON)
+    #include "BlinkerJsonArena.h"
+#endif
+#if defined(BLINKER_WITH_SNAPSHOT)
+    #include "BlinkerSnapshot.h"
+#endif
 
 typedef BlinkerProtocol BProto;
 
@@ -208,6 +228,16 @@ class BlinkerApi : public BlinkerProtocol
     public :
         void run();
 
+        #if !defined(BLINKER_ARDUINOJSON)
+            // a stream adapter hands each message to the scanner byte by byte
+            void transport(BlinkerStream & bStream)
+            {
+                BProto::transport(bStream);
+                _scan.attach(scanned, this);
+                _streamed = bStream.attachScanner(&_scan);
+            }
+        #endif
+
         template <typename T>
         void print(T n);
         void print();
@@ -228,6 +258,17 @@ class BlinkerApi : public BlinkerProtocol
         // template <typename T1>
         void printNumArray(char * _name, const String & data);
 
+        // widget state, also kept for the heartbeat snapshot, the delta of
+        // the widget learns whether it went out
+        template <typename T1>
+        void printWidget(T1 n1, const String &s2, BlinkerWidgetDelta * delta = NULL);
+
+        // the same written by the widget in place, between the two calls,
+        // keep false takes it back out
+        BlinkerWidgetWriter widgetBegin(const BlinkerWidgetName & name);
+        void widgetEnd(const BlinkerWidgetName & name, BlinkerWidgetWriter & w,
+                        BlinkerWidgetDelta * delta = NULL, bool keep = true);
+
         template <typename T1>
         void printObject(T1 n1, const String &s2);
 
@@ -391,6 +432,7 @@ class BlinkerApi : public BlinkerProtocol
             bool configDelete();
             template<typename T>
             void dataStorage(char _name[], const T& msg);
+            bool dataAggregate(char _name[], uint32_t _window = 60);
             bool dataUpdate();
             void dataGet();
             void dataGet(const String & _type);
@@ -416,6 +458,7 @@ class BlinkerApi : public BlinkerProtocol
                 char * bridgeKey(uint8_t num);
                 char * bridgeName(uint8_t num);
                 void bridgeInit();
+                void bridgeRefresh();
 
                 void bridgePrint(char * bName, const String & data);
                 #endif
@@ -448,9 +491,12 @@ class BlinkerApi : public BlinkerProtocol
             #endif
 
             #if !defined(BLINKER_LOWPOWER_AIR202)
-            void aligeniePrint(String & _msg);
-            void duerPrint(String & _msg, bool report = false);
-            void miotPrint(String & _msg);
+            void aligeniePrint(const char * _msg);
+            void duerPrint(const char * _msg, bool report = false);
+            void miotPrint(const char * _msg);
+            void aligeniePrint(String & _msg)   { aligeniePrint(_msg.c_str()); }
+            void duerPrint(String & _msg, bool report = false) { duerPrint(_msg.c_str(), report); }
+            void miotPrint(String & _msg)       { miotPrint(_msg.c_str()); }
             #endif
 
         #endif
@@ -599,11 +645,14 @@ class BlinkerApi : public BlinkerProtocol
             bool sms(const T& msg);
             void reset();
 
-            void aligeniePrint(String & _msg);
-            void duerPrint(String & _msg, bool report = false);
+            void aligeniePrint(const char * _msg);
+            void duerPrint(const char * _msg, bool report = false);
+            void aligeniePrint(String & _msg)   { aligeniePrint(_msg.c_str()); }
+            void duerPrint(String & _msg, bool report = false) { duerPrint(_msg.c_str(), report); }
             #if !defined(BLINKER_GPRS_AIR202) && !defined(BLINKER_NBIOT_SIM7020) && \
                 !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202)
-            void miotPrint(String & _msg);
+            void miotPrint(const char * _msg);
+            void miotPrint(String & _msg)       { miotPrint(_msg.c_str()); }
             #endif
         #endif
 
@@ -647,6 +696,8 @@ class BlinkerApi : public BlinkerProtocol
         { BProto::_availableFunc = newFunction; }
         void attachHeartbeat(blinker_callback_t newFunction)
         { _heartbeatFunc = newFunction; }
+        // widgets print their whole state while the callback runs
+        bool heartbeating()                 { return _heartbeating; }
         void attachSummary(blinker_callback_return_string_t newFunction)
         { _summaryFunc = newFunction; }
         void attachAQI(blinker_callback_with_string_arg_t newFunction)
@@ -754,6 +805,11 @@ class BlinkerApi : public BlinkerProtocol
             uint32_t gps_air202_time = 0;
         #endif
         bool        _fresh = false;
+        #if !defined(BLINKER_ARDUINOJSON)
+            BlinkerJsonScanner  _scan;
+            float       _scanArray[BLINKER_JSON_ARRAY_SIZE];
+            bool        _streamed = false;
+        #endif
         int16_t     ahrsValue[3];
         float       gpsValue[2];
         uint32_t    gps_get_time;
@@ -802,6 +858,7 @@ class BlinkerApi : public BlinkerProtocol
             time_t      _deviceStartTime = 0;
             float       _timezone = 8.0;
             uint32_t    _ntpStart;
+            uint32_t    _wheelSyncTime = 0;
 
             uint32_t    _smsTime = 0;
             uint32_t    _pushTime = 0;
@@ -833,6 +890,16 @@ class BlinkerApi : public BlinkerProtocol
 
             uint32_t    _dHeartTime = 0;
 
+            #if defined(BLINKER_MQTT)
+                void idle();
+            #endif
+
+            #if defined(BLINKER_WITH_METRICS)
+                uint32_t    _metricsTime = 0;
+
+                void metricsReport();
+            #endif
+
             #if (!defined(BLINKER_NBIOT_SIM7020) && !defined(BLINKER_GPRS_AIR202) && \
                 !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202) && \
                 !defined(BLINKER_LOWPOWER_AIR202) && !defined(BLINKER_LOWPOWER_AIR202))
@@ -841,6 +908,15 @@ class BlinkerApi : public BlinkerProtocol
                 char                            _lpAction2[BLINKER_TIMER_LOOP_ACTION2_SIZE];
                 class BlinkerTimingTimer *      timingTask[BLINKER_TIMING_TIMER_SIZE];
                 class BlinkerBridge_key *       _Bridge[BLINKER_MAX_BRIDGE_SIZE];
+                uint32_t                        _bridgeRefreshTime = 0;
+
+                bool bridgeResolve(uint8_t num);
+                bool bridgeReply(uint8_t num, const String & name);
+                void freshBridgeName(uint8_t num, const String & name, uint32_t resolved);
+
+                #if defined(ESP8266) || defined(ESP32)
+                BlinkerBridgeCache              _bridgeCache;
+                #endif
             #endif
 
             class BlinkerData *             _Data[BLINKER_MAX_BLINKER_DATA_SIZE];
@@ -1000,6 +1076,13 @@ class BlinkerApi : public BlinkerProtocol
         #endif
 
         blinker_callback_t                  _heartbeatFunc = NULL;
+        bool                                _heartbeating = false;
+        #if defined(BLINKER_WITH_SNAPSHOT)
+            BlinkerSnapshot                 _snapshot;
+
+            void heartbeatWidgets();
+            void printSnapshot(uint8_t replyTo);
+        #endif
         blinker_callback_return_string_t    _summaryFunc = NULL;
         blinker_callback_with_string_arg_t  _aqiFunc = NULL;
         blinker_callback_with_string_arg_t  _weatherFunc = NULL;
@@ -1037,22 +1120,25 @@ class BlinkerApi : public BlinkerProtocol
 
             void json_parse(const JsonObject& data);
         #else
-            int16_t ahrs(b_ahrsattitude_t attitude, char data[]);
-            float gps(b_gps_t axis, char data[]);
+            void ahrs(BlinkerJsonScanner & scan, const float * array);
+            void gps(BlinkerJsonScanner & scan, const float * array);
 
-            void heartBeat(char data[]);
-            void getVersion(char data[]);
-            void setSwitch(char data[]);
+            void heartBeat(BlinkerJsonScanner & scan);
+            void getVersion(BlinkerJsonScanner & scan);
+            void setSwitch(BlinkerJsonScanner & scan);
 
-            void strWidgetsParse(char _wName[], char _data[]);
+            void strWidgetsParse(BlinkerJsonScanner & scan);
             #if defined(BLINKER_BLE)
-                void joyWidgetsParse(char _wName[], char _data[]);
+                void joyWidgetsParse(BlinkerJsonScanner & scan, const float * array);
             #endif
-            void rgbWidgetsParse(char _wName[], char _data[]);
-            void intWidgetsParse(char _wName[], char _data[]);
-            void tabWidgetsParse(char _wName[], char _data[]);
-
-            void json_parse(char _data[]);
+            void rgbWidgetsParse(BlinkerJsonScanner & scan, const float * array);
+            void intWidgetsParse(BlinkerJsonScanner & scan);
+            void tabWidgetsParse(BlinkerJsonScanner & scan);
+
+            void json_parse(char _data[], bool builtin = false);
+            void json_member(BlinkerJsonScanner & scan, uint8_t event,
+                            float * array, bool builtin);
+            static void scanned(void * arg, BlinkerJsonScanner & scan, uint8_t event);
         #endif
 
         #if defined(BLINKER_GPRS_AIR202) || defined(BLINKER_PRO_AIR202) || \
@@ -1458,7 +1544,7 @@ class BlinkerApi : public BlinkerProtocol
 
                     // DynamicJsonBuffer jsonBuffer;
                     // JsonObject& data_rp = jsonBuffer.parseObject(payload);
-                    DynamicJsonDocument jsonBuffer(1024);
+                    BLINKER_JSON_DOC(jsonBuffer);
                     DeserializationError error = deserializeJson(jsonBuffer, payload);
                     JsonObject data_rp = jsonBuffer.as<JsonObject>();
 
@@ -1932,7 +2018,7 @@ class BlinkerApi : public BlinkerProtocol
 
                     // DynamicJsonBuffer jsonBuffer;
                     // JsonObject& data_rp = jsonBuffer.parseObject(payload);
-                    DynamicJsonDocument jsonBuffer(1024);
+                    BLINKER_JSON_DOC(jsonBuffer);
                     DeserializationError error = deserializeJson(jsonBuffer, payload);
                     JsonObject data_rp = jsonBuffer.as<JsonObject>();
 
@@ -2133,6 +2219,7 @@ class BlinkerApi : public BlinkerProtocol
             #endif
 
             #if !defined(BLINKER_LOWPOWER_AIR202)
+            String bridgePath(char * key);
             String bridgeQuery(char * key);
             #endif
 
@@ -2146,6 +2233,28 @@ class BlinkerApi : public BlinkerProtocol
 
             #endif
 
+            #if defined(BLINKER_WIFI) || defined(BLINKER_MQTT) || \
+                defined(BLINKER_PRO) || defined(BLINKER_AT_MQTT) || \
+                defined(BLINKER_WIFI_GATEWAY) || defined(BLINKER_MQTT_AUTO) || \
+                defined(BLINKER_PRO_ESP)
+                // the one query run() has in flight
+                BlinkerQuery    _query;
+
+                void queryRun();
+                static void queryStep(void * api);
+                bool queryBegin(uint8_t type, uint8_t tag, const String & path);
+            #endif
+
+            #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
+                defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+                defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP)
+                bool            _shareWanted = false;
+                uint8_t         _shareRetry = 0;
+
+                void shareQuery();
+                void shareReply(bool ok, const String & detail);
+            #endif
+
             uint32_t ntpFreshTime = 0;
             time_t ntpGetTime = 0;
 
@@ -2600,6 +2709,10 @@ void BlinkerApi::needInit()
 
 void BlinkerApi::run()
 {
+    #if defined(ESP8266) || defined(ESP32)
+        BLINKER_WHEEL.advance(millis());
+    #endif
+
     // #if defined(BLINKER_LOWPOWER_AIR202)
     //     ::delay(10);
     // #else
@@ -2817,7 +2930,7 @@ void BlinkerApi::run()
                                 {
                                     // DynamicJsonBuffer jsonBuffer;
                                     // JsonObject& otaJson = jsonBuffer.parseObject(otaData);
-                                    DynamicJsonDocument jsonBuffer(1024);
+                                    BLINKER_JSON_DOC(jsonBuffer);
                                     DeserializationError error = deserializeJson(jsonBuffer, otaData);
                                     JsonObject otaJson = jsonBuffer.as<JsonObject>();
 
@@ -3160,16 +3273,40 @@ void BlinkerApi::run()
 
             if (WiFi.status() != WL_CONNECTED)
             {
-                if ((millis() - _reconTime) >= 10000 || \
-                    _reconTime == 0 )
+                if (BLINKER_SUPERVISOR.ready(BLINKER_LINK_WIFI, millis()))
                 {
                     _reconTime = millis();
+                    BLINKER_SUPERVISOR.attempt(BLINKER_LINK_WIFI, millis());
+                    // Counts as failed unless the link is back inside the window
+                    BLINKER_SUPERVISOR.failure(BLINKER_LINK_WIFI, millis(), BLINKER_FAIL_WIFI);
+                    BLINKER_TRACE(BLINKER_TRACE_WIFI_DOWN,
+                        BLINKER_SUPERVISOR.failures(BLINKER_LINK_WIFI), 0);
+
                     BLINKER_LOG(BLINKER_F("WiFi disconnected! reconnecting!"));
                     WiFi.reconnect();
                 }
 
                 return;
             }
+            else if (_reconTime)
+            {
+                _reconTime = 0;
+                BLINKER_SUPERVISOR.success(BLINKER_LINK_WIFI, millis());
+                BLINKER_TRACE(BLINKER_TRACE_WIFI_UP,
+                    BLINKER_SUPERVISOR.connectTime(BLINKER_LINK_WIFI), 0);
+
+                BLINKER_LOG_ALL(BLINKER_F("WiFi back in "),
+                    BLINKER_SUPERVISOR.connectTime(BLINKER_LINK_WIFI));
+            }
+
+            bridgeRefresh();
+        #endif
+
+        #if defined(BLINKER_WIFI) || defined(BLINKER_MQTT) || \
+            defined(BLINKER_PRO) || defined(BLINKER_AT_MQTT) || \
+            defined(BLINKER_WIFI_GATEWAY) || defined(BLINKER_MQTT_AUTO) || \
+            defined(BLINKER_PRO_ESP)
+            queryRun();
         #endif
 
         #if defined(BLINKER_NB73_NBIOT)
@@ -3699,7 +3836,7 @@ void BlinkerApi::run()
                 {
                     BLINKER_LOG_ALL("meshAvail");
 
-                    DynamicJsonDocument jsonBuffer(1024);
+                    BLINKER_JSON_DOC(jsonBuffer);
                     DeserializationError error = deserializeJson(jsonBuffer, BProto::meshLastRead());
                     JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -3746,7 +3883,7 @@ void BlinkerApi::run()
                         {
                             // DynamicJsonBuffer jsonBuffer;
                             // JsonObject& autoJson = jsonBuffer.parseObject(payload);
-                            DynamicJsonDocument jsonBuffer(1024);
+                            BLINKER_JSON_DOC(jsonBuffer);
                             deserializeJson(jsonBuffer, payload);
                             JsonObject autoJson = jsonBuffer.as<JsonObject>();
 
@@ -3777,6 +3914,18 @@ void BlinkerApi::run()
             }
         #endif
 
+        #if defined(BLINKER_WITH_METRICS) && \
+            (defined(BLINKER_MQTT) || defined(BLINKER_WIFI_GATEWAY))
+            // every loop, the low water marks are the lowest seen
+            BLINKER_METRICS.sampleHeap();
+
+            if ((millis() - _metricsTime) >= BLINKER_METRICS_REPORT_TIME && _isInit)
+            {
+                metricsReport();
+                _metricsTime = millis();
+            }
+        #endif
+
         switch (BProto::state)
         {
             case CONNECTING :
@@ -3939,17 +4088,11 @@ void BlinkerApi::run()
                     #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
                         defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
                         defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP)
+                        // the reply comes in on later passes, see queryRun()
                         if (BProto::needFreshShare())
                         {
-                            String _shareData = freshSharers();
-                            if (STRING_contains_string(_shareData, "users") == false)
-                            {
-                                _shareData = freshSharers();
-                            }
-                            if (STRING_contains_string(_shareData, "users") == true)
-                            {
-                                BProto::sharers(_shareData);
-                            }
+                            _shareRetry = 0;
+                            shareQuery();
                         }
                     #endif
                 }
@@ -4075,25 +4218,97 @@ void BlinkerApi::run()
         #endif
 
         BProto::checkAutoFormat();
+
+        #if defined(BLINKER_MQTT)
+            idle();
+        #endif
     // #endif
 }
 
+#if defined(BLINKER_WITH_METRICS)
+    void BlinkerApi::metricsReport()
+    {
+        String metrics;
+
+        BLINKER_METRICS.sampleHeap();
+        BLINKER_METRICS.json(metrics);
+
+        printArray(BLINKER_CMD_METRICS, metrics);
+        BProto::checkState(false);
+        BProto::printNow();
+    }
+#endif
+
+#if defined(BLINKER_MQTT)
+    // End of a run() that went through: counts it and, with
+    // BLINKER_IDLE_SLEEP, sleeps until the closest deadline when nothing
+    // was signalled.
+    void BlinkerApi::idle()
+    {
+        uint8_t events = BLINKER_LOOP.take();
+
+        BLINKER_LOOP.ran(events != 0);
+
+        #if defined(BLINKER_IDLE_SLEEP)
+            if (events) return;
+
+            if (_isInit)
+            {
+                BLINKER_LOOP.at(BLINKER_DUE_HEARTBEAT,
+                    _dHeartTime + BLINKER_DEVICE_HEARTBEAT_TIME * 1000);
+            }
+
+            if (_dataStorageFunc)
+            {
+                BLINKER_LOOP.at(BLINKER_DUE_STORAGE,
+                    _autoDataTime + _autoStorageTime * 1000);
+            }
+            else BLINKER_LOOP.cancel(BLINKER_DUE_STORAGE);
+
+            if (data_dataCount && _isInit)
+            {
+                BLINKER_LOOP.at(BLINKER_DUE_UPDATE,
+                    _autoUpdateTime + _autoStorageTime * _dataTimes * 1000);
+            }
+            else BLINKER_LOOP.cancel(BLINKER_DUE_UPDATE);
+
+            if (BLINKER_WHEEL.count())
+            {
+                BLINKER_LOOP.at(BLINKER_DUE_WHEEL, millis() +
+                    BLINKER_WHEEL.idleFor(millis(), BLINKER_IDLE_SLEEP_MAX));
+            }
+            else BLINKER_LOOP.cancel(BLINKER_DUE_WHEEL);
+
+            uint32_t wait = BLINKER_LOOP.idleFor(millis(), BLINKER_IDLE_SLEEP_MAX);
+
+            if (wait)
+            {
+                // light sleep on the ESP cores when WiFi allows it
+                ::delay(wait);
+                BLINKER_LOOP.slept(wait);
+            }
+        #endif
+    }
+#endif
+
 void BlinkerApi::parse(char _data[], bool ex_data)
 {
+    BLINKER_METRIC_TIME_US(BLINKER_HIST_PARSE_US);
+
     BLINKER_LOG_ALL(BLINKER_F("parse data: "), _data);
     
     if (!ex_data)
     {
         if (BProto::parseState())
         {
-            _fresh = false;
-
             #if defined(BLINKER_ARDUINOJSON)
+                _fresh = false;
+
                 BLINKER_LOG_ALL(BLINKER_F("defined BLINKER_ARDUINOJSON"));
 
                 // DynamicJsonBuffer jsonBuffer;
                 // JsonObject& root = jsonBuffer.parseObject(STRING_format(_data));
-                DynamicJsonDocument jsonBuffer(1024);
+                BLINKER_JSON_DOC(jsonBuffer);
                 DeserializationError error = deserializeJson(jsonBuffer, STRING_format(_data));
                 JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -4164,13 +4379,12 @@ void BlinkerApi::parse(char _data[], bool ex_data)
                         return;
                 #endif
 
-                heartBeat(_data);
-                getVersion(_data);
-
-                json_parse(_data);
-
-                ahrs(Yaw, _data);
-                gps(LONG, _data);
+                // a message read from a stream was handled as it came in
+                if (!_streamed)
+                {
+                    _fresh = false;
+                    json_parse(_data, true);
+                }
             #endif
 
             if (_fresh)
@@ -4202,7 +4416,7 @@ void BlinkerApi::parse(char _data[], bool ex_data)
             arrayData += BLINKER_F("}");
             // DynamicJsonBuffer jsonBuffer;
             // JsonObject& root = jsonBuffer.parseObject(arrayData);
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, arrayData);
             JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -4220,7 +4434,7 @@ void BlinkerApi::parse(char _data[], bool ex_data)
                     if(arrayData != "null") {
                         // DynamicJsonBuffer _jsonBuffer;
                         // JsonObject& _array = _jsonBuffer.parseObject(arrayData);
-                        DynamicJsonDocument jsonBuffer(1024);
+                        BLINKER_JSON_DOC(jsonBuffer);
                         deserializeJson(jsonBuffer, arrayData);
                         JsonObject _array = jsonBuffer.as<JsonObject>();
 
@@ -4364,6 +4578,84 @@ void BlinkerApi::printNumArray(char * _name, const String & data)
     }
 }
 
+template <typename T1>
+void BlinkerApi::printWidget(T1 n1, const String &s2, BlinkerWidgetDelta * delta)
+{
+    #if defined(BLINKER_WITH_SNAPSHOT)
+        _snapshot.update(STRING_format(n1).c_str(), s2.c_str());
+
+        // the snapshot goes out whole at the end of the heartbeat
+        if (_heartbeating)
+        {
+            if (delta) delta->sent(true);
+            return;
+        }
+    #endif
+
+    String _msg = BLINKER_F("\"");
+    _msg += STRING_format(n1);
+    _msg += BLINKER_F("\":");
+    _msg += s2;
+
+    if (!BProto::print(STRING_format(n1), _msg))
+    {
+        if (delta) delta->sent(false);
+    }
+    else if (delta)
+    {
+        BProto::pendDelta(delta);
+    }
+}
+
+BlinkerWidgetWriter BlinkerApi::widgetBegin(const BlinkerWidgetName & name)
+{
+    size_t room;
+    bool replace = true;
+
+    #if defined(BLINKER_WITH_SNAPSHOT)
+        // only kept for the snapshot, it leaves the message as it was
+        if (_heartbeating) replace = false;
+    #endif
+
+    char * value = BProto::beginMember(name.c_str(), name.length(), room, replace);
+
+    return BlinkerWidgetWriter(value, room);
+}
+
+void BlinkerApi::widgetEnd(const BlinkerWidgetName & name, BlinkerWidgetWriter & w,
+                            BlinkerWidgetDelta * delta, bool keep)
+{
+    if (w.full())
+    {
+        BLINKER_ERR_LOG(BLINKER_F("widget data too long: "), name.c_str());
+
+        BProto::endMember(false);
+        if (delta) delta->sent(false);
+        return;
+    }
+
+    if (!keep)
+    {
+        BProto::endMember(false);
+        return;
+    }
+
+    #if defined(BLINKER_WITH_SNAPSHOT)
+        _snapshot.update(name.c_str(), w.c_str());
+
+        // the snapshot goes out whole at the end of the heartbeat
+        if (_heartbeating)
+        {
+            BProto::endMember(false);
+            if (delta) delta->sent(true);
+            return;
+        }
+    #endif
+
+    BProto::endMember(true);
+    if (delta) BProto::pendDelta(delta);
+}
+
 template <typename T1>
 void BlinkerApi::printObject(T1 n1, const String &s2)
 {
@@ -5910,10 +6202,16 @@ float BlinkerApi::gps(b_gps_t axis)
     template<typename T>
     void BlinkerApi::dataStorage(char _name[], const T& msg)
     {
-        String _msg = STRING_format(msg);
-
         int8_t num = checkNum(_name, _Data, data_dataCount);
 
+        if (num != BLINKER_OBJECT_NOT_AVAIL && _Data[num]->aggregated())
+        {
+            _Data[num]->foldData(msg, time());
+            return;
+        }
+
+        String _msg = STRING_format(msg);
+
         uint32_t now_time = time() - second();
 
         BLINKER_LOG_ALL(BLINKER_F("time: "), time(), BLINKER_F(",second: "), second());
@@ -5963,6 +6261,33 @@ float BlinkerApi::gps(b_gps_t axis)
 
     }
 
+    // Folds every numeric sample dataStorage() gets for _name into
+    // windows of _window seconds, aligned to the clock. Each window is
+    // uploaded as one record [time, mean, min, max, count, last] in place
+    // of the samples, none are dropped for arriving too often. Call it
+    // next to attachDataStorage(), the window should be at most a quarter
+    // of the upload period or the oldest windows make room for new ones.
+    bool BlinkerApi::dataAggregate(char _name[], uint32_t _window)
+    {
+        int8_t num = checkNum(_name, _Data, data_dataCount);
+
+        if (num == BLINKER_OBJECT_NOT_AVAIL)
+        {
+            if (data_dataCount == BLINKER_MAX_BLINKER_DATA_SIZE)
+            {
+                return false;
+            }
+            _Data[data_dataCount] = new BlinkerData();
+            _Data[data_dataCount]->name(_name);
+            num = data_dataCount;
+            data_dataCount++;
+        }
+
+        BLINKER_LOG_ALL(_name, BLINKER_F(" aggregate window: "), _window);
+
+        return _Data[num]->aggregate(_window);
+    }
+
 
     bool BlinkerApi::dataUpdate()
     {
@@ -6021,8 +6346,11 @@ float BlinkerApi::gps(b_gps_t axis)
             BLINKER_LOG_FreeHeap_ALL();
 
             // uint32_t now_time = time() - second();
+            time_t now_time = time();
 
             for (uint8_t _num = 0; _num < data_dataCount; _num++) {
+                _Data[_num]->closeWindow(now_time);
+
                 data += BLINKER_F("\"");
                 data += _Data[_num]->getName();
                 data += BLINKER_F("\":");
@@ -6265,7 +6593,7 @@ float BlinkerApi::gps(b_gps_t axis)
             {
                 // DynamicJsonBuffer jsonBuffer;
                 // JsonObject& autoJson = jsonBuffer.parseObject(payload);
-                DynamicJsonDocument jsonBuffer(1024);
+                BLINKER_JSON_DOC(jsonBuffer);
                 deserializeJson(jsonBuffer, payload);
                 JsonObject autoJson = jsonBuffer.as<JsonObject>();
 
@@ -6388,18 +6716,94 @@ float BlinkerApi::gps(b_gps_t axis)
     }
 
 
+    // Cached names are used as they are, expired ones get refreshed by
+    // bridgeRefresh() once connected
     void BlinkerApi::bridgeInit()
     {
-        String register_r;
         for (uint8_t num = 0; num < _bridgeCount; num++)
         {
-            register_r = bridgeQuery(_Bridge[num]->getKey());
-            BLINKER_LOG_ALL(BLINKER_F("bridgeQuery name: "), register_r);
-            if (strcmp(register_r.c_str(), BLINKER_CMD_FALSE) != 0)
+            #if defined(ESP8266) || defined(ESP32)
+                String name;
+                uint32_t resolved;
+
+                if (_bridgeCache.load(_Bridge[num]->getKey(), name, resolved))
+                {
+                    BLINKER_LOG_ALL(BLINKER_F("bridge cached name: "), name);
+                    freshBridgeName(num, name, resolved);
+                    continue;
+                }
+            #endif
+
+            bridgeResolve(num);
+        }
+    }
+
+    // Starts a query for one bridge name older than BLINKER_BRIDGE_CACHE_TTL,
+    // or not resolved yet, every BLINKER_BRIDGE_REFRESH_SPAN. Keys that
+    // failed wait out their backoff, the reply comes in through queryRun().
+    void BlinkerApi::bridgeRefresh()
+    {
+        if (_bridgeCount == 0) return;
+        if (millis() - _bridgeRefreshTime < BLINKER_BRIDGE_REFRESH_SPAN) return;
+        if (_query.busy()) return;
+
+        _bridgeRefreshTime = millis();
+
+        uint32_t now = time();
+
+        for (uint8_t num = 0; num < _bridgeCount; num++)
+        {
+            if (_Bridge[num]->registered() &&
+                now - _Bridge[num]->resolved() < BLINKER_BRIDGE_CACHE_TTL)
             {
-                _Bridge[num]->name(register_r);
+                continue;
             }
+
+            if (!_Bridge[num]->due(millis())) continue;
+
+            queryBegin(BLINKER_CMD_BRIDGE_NUMBER, num, bridgePath(_Bridge[num]->getKey()));
+            return;
+        }
+    }
+
+    bool BlinkerApi::bridgeResolve(uint8_t num)
+    {
+        return bridgeReply(num, bridgeQuery(_Bridge[num]->getKey()));
+    }
+
+    // A failed query keeps the name the bridge had and backs the key off
+    bool BlinkerApi::bridgeReply(uint8_t num, const String & name)
+    {
+        BLINKER_LOG_ALL(BLINKER_F("bridgeQuery name: "), name);
+
+        // an error reply comes back as its json
+        if (strcmp(name.c_str(), BLINKER_CMD_FALSE) == 0 ||
+            name.length() == 0 || name.indexOf('{') >= 0)
+        {
+            _Bridge[num]->failed(millis());
+
+            BLINKER_LOG_ALL(BLINKER_F("bridge "), _Bridge[num]->getKey(),
+                            BLINKER_F(" failed "), _Bridge[num]->fails(),
+                            BLINKER_F(" times"));
+            return false;
         }
+
+        freshBridgeName(num, name, time());
+
+        #if defined(ESP8266) || defined(ESP32)
+            _bridgeCache.save(_Bridge[num]->getKey(), name, _Bridge[num]->resolved());
+        #endif
+
+        return true;
+    }
+
+    void BlinkerApi::freshBridgeName(uint8_t num, const String & name, uint32_t resolved)
+    {
+        _Bridge[num]->name(name, resolved);
+
+        #if defined(BLINKER_WITH_BRIDGE_LAN)
+            BProto::bridgePeer(_Bridge[num]->getName(), _Bridge[num]->getKey());
+        #endif
     }
 
     void BlinkerApi::bridgePrint(char * bName, const String & data)
@@ -6430,55 +6834,180 @@ float BlinkerApi::gps(b_gps_t axis)
     }
     #endif
 
-    #if !defined(BLINKER_WIFI_SUBDEVICE)
+    #if defined(BLINKER_WIFI) || defined(BLINKER_MQTT) || \
+        defined(BLINKER_PRO) || defined(BLINKER_AT_MQTT) || \
+        defined(BLINKER_WIFI_GATEWAY) || defined(BLINKER_MQTT_AUTO) || \
+        defined(BLINKER_PRO_ESP)
+    // Starts a query on the blinker server, false while one is in flight
+    bool BlinkerApi::queryBegin(uint8_t type, uint8_t tag, const String & path)
+    {
+        if (_query.busy()) return false;
 
-    #if (!defined(BLINKER_NBIOT_SIM7020) && !defined(BLINKER_GPRS_AIR202) && \
-        !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202) && \
-        !defined(BLINKER_LOWPOWER_AIR202))
+        #if defined(ESP8266) && !defined(BLINKER_WIFI)
+            // no room for two TLS sessions, as in blinkerServer()
+            extern BearSSL::WiFiClientSecure client_mqtt;
+            client_mqtt.stop();
+        #endif
 
-    void BlinkerApi::loadOTA()
+        return _query.begin(type, tag, path);
+    }
+
+    void BlinkerApi::queryStep(void * api)
     {
-        // if (_OTA.loadOTACheck())
-        // {
-        //     if (!_OTA.loadVersion())
-        //     {
-        //         _OTA.saveVersion();
-        //     }
-        // }
+        ((BlinkerApi *)api)->_query.run();
+    }
 
-        ::delay(1000);
+    // Takes a step of the query in flight, with the network task that task
+    // does, and hands a finished one on
+    void BlinkerApi::queryRun()
+    {
+        #if defined(BLINKER_WITH_NET_TASK)
+            if (!BProto::netJob(queryStep, this)) queryStep(this);
+        #else
+            queryStep(this);
+        #endif
 
-        BLINKER_LOG_ALL(BLINKER_F("OTA load: "), BLINKER_OTA_VERSION_CODE);
+        if (!_query.finished())
+        {
+            #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
+                defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+                defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP)
+                if (_shareWanted && !_query.busy()) shareQuery();
+            #endif
 
-        uint8_t ota_check = _OTA.loadOTACheck();
+            return;
+        }
 
-        if (ota_check == BLINKER_OTA_RUN)
-        {
-            _OTA.saveOTACheck();
-            updateOTAStatus(10, "download firmware");
+        bool ok = false;
+        String detail;
 
-            String otaData = checkOTA();
+        if (_query.state() == BLINKER_QUERY_DONE)
+        {
+            BLINKER_JSON_DOC(jsonBuffer);
+            DeserializationError error = deserializeJson(jsonBuffer, _query.reply());
+            JsonObject data_rp = jsonBuffer.as<JsonObject>();
 
-            if (otaData != BLINKER_CMD_FALSE)
+            if (!error)
             {
-                // DynamicJsonBuffer jsonBuffer;
-                // JsonObject& otaJson = jsonBuffer.parseObject(otaData);
-                DynamicJsonDocument jsonBuffer(1024);
-                DeserializationError error = deserializeJson(jsonBuffer, otaData);
-                JsonObject otaJson = jsonBuffer.as<JsonObject>();
-
-                // if (!otaJson.success())
-                if (error)
+                uint16_t msg_code = data_rp[BLINKER_CMD_MESSAGE];
+                if (msg_code != 1000)
                 {
-                    BLINKER_ERR_LOG_ALL(BLINKER_F("check ota data error"));
-                    return;
+                    String _detail = data_rp[BLINKER_CMD_DETAIL];
+                    BLINKER_ERR_LOG(_detail);
                 }
+                else if (_query.type() == BLINKER_CMD_BRIDGE_NUMBER)
+                {
+                    detail = data_rp[BLINKER_CMD_DETAIL][BLINKER_CMD_DEVICENAME].as<String>();
+                    ok = true;
+                }
+                else
+                {
+                    detail = data_rp[BLINKER_CMD_DETAIL].as<String>();
+                    ok = true;
+                }
+            }
+        }
+
+        uint8_t type = _query.type();
+        uint8_t tag = _query.tag();
+
+        _query.end();
+
+        switch (type)
+        {
+            #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
+                defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+                defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP)
+                case BLINKER_CMD_FRESH_SHARERS_NUMBER :
+                    shareReply(ok, detail);
+                    break;
+            #endif
+            case BLINKER_CMD_BRIDGE_NUMBER :
+                bridgeReply(tag, ok ? detail : String(BLINKER_CMD_FALSE));
+                break;
+            default :
+                break;
+        }
+    }
+    #endif
+
+    #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
+        defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+        defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP)
+    // freshSharers() without the wait, a busy query slot defers it
+    void BlinkerApi::shareQuery()
+    {
+        String data = BLINKER_F("/share/device?");
+        data += BLINKER_F("deviceName=");
+        data += BProto::deviceName();
+        data += BLINKER_F("&key=");
+        data += BProto::authKey();
+
+        _shareWanted = !queryBegin(BLINKER_CMD_FRESH_SHARERS_NUMBER, 0, data);
+    }
+
+    // A failed query is tried once more, as freshSharers() callers do
+    void BlinkerApi::shareReply(bool ok, const String & detail)
+    {
+        if (ok && STRING_contains_string(detail, "users") == true)
+        {
+            BProto::sharers(detail);
+            return;
+        }
+
+        if (_shareRetry++ == 0) shareQuery();
+    }
+    #endif
+
+    #if !defined(BLINKER_WIFI_SUBDEVICE)
+
+    #if (!defined(BLINKER_NBIOT_SIM7020) && !defined(BLINKER_GPRS_AIR202) && \
+        !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202) && \
+        !defined(BLINKER_LOWPOWER_AIR202))
+
+    void BlinkerApi::loadOTA()
+    {
+        // if (_OTA.loadOTACheck())
+        // {
+        //     if (!_OTA.loadVersion())
+        //     {
+        //         _OTA.saveVersion();
+        //     }
+        // }
+
+        ::delay(1000);
+
+        BLINKER_LOG_ALL(BLINKER_F("OTA load: "), BLINKER_OTA_VERSION_CODE);
+
+        uint8_t ota_check = _OTA.loadOTACheck();
+
+        if (ota_check == BLINKER_OTA_RUN)
+        {
+            _OTA.saveOTACheck();
+            updateOTAStatus(10, "download firmware");
+
+            String otaData = checkOTA();
+
+            if (otaData != BLINKER_CMD_FALSE)
+            {
+                // DynamicJsonBuffer jsonBuffer;
+                // JsonObject& otaJson = jsonBuffer.parseObject(otaData);
+                BLINKER_JSON_DOC(jsonBuffer);
+                DeserializationError error = deserializeJson(jsonBuffer, otaData);
+                JsonObject otaJson = jsonBuffer.as<JsonObject>();
+
+                // if (!otaJson.success())
+                if (error)
+                {
+                    BLINKER_ERR_LOG_ALL(BLINKER_F("check ota data error"));
+                    return;
+                }
+
+                // String otaHost = otaJson["host"];
+                // String otaUrl = otaJson["url"];
+                // String otaFp = otaJson["fingerprint"];
+                // String otaMD5 = otaJson["hash"];
 
-                // String otaHost = otaJson["host"];
-                // String otaUrl = otaJson["url"];
-                // String otaFp = otaJson["fingerprint"];
-                // String otaMD5 = otaJson["hash"];
-
                 // _OTA.config(otaHost, otaUrl, otaFp, otaMD5);
                 _OTA.config(otaJson["host"].as<String>(), otaJson["url"].as<String>(), otaJson["fingerprint"].as<String>(), otaJson["hash"].as<String>());
 
@@ -6687,13 +7216,13 @@ float BlinkerApi::gps(b_gps_t axis)
     #endif
 
     #if !defined(BLINKER_LOWPOWER_AIR202)
-    void BlinkerApi::aligeniePrint(String & _msg)
+    void BlinkerApi::aligeniePrint(const char * _msg)
     {
         BLINKER_LOG_ALL(BLINKER_F("response to AliGenie: "), _msg);
 
         // BProto::aliPrint(_msg);
 
-        if (_msg.length() <= BLINKER_MAX_SEND_SIZE)
+        if (strlen(_msg) <= BLINKER_MAX_SEND_SIZE)
         {
             // char* aliData = (char*)malloc((_msg.length()+1+128)*sizeof(char));
             // memcpy(aliData, '\0', _msg.length()+128);
@@ -6707,13 +7236,13 @@ float BlinkerApi::gps(b_gps_t axis)
         }
     }
 
-    void BlinkerApi::duerPrint(String & _msg, bool report)
+    void BlinkerApi::duerPrint(const char * _msg, bool report)
     {
         BLINKER_LOG_ALL(BLINKER_F("response to DuerOS: "), _msg);
 
         // BProto::aliPrint(_msg);
 
-        if (_msg.length() <= BLINKER_MAX_SEND_SIZE)
+        if (strlen(_msg) <= BLINKER_MAX_SEND_SIZE)
         {
             // char* aliData = (char*)malloc((_msg.length()+1+128)*sizeof(char));
             // memcpy(aliData, '\0', _msg.length()+128);
@@ -6729,13 +7258,13 @@ float BlinkerApi::gps(b_gps_t axis)
 
     #if !defined(BLINKER_GPRS_AIR202) && !defined(BLINKER_NBIOT_SIM7020) && \
         !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202)
-    void BlinkerApi::miotPrint(String & _msg)
+    void BlinkerApi::miotPrint(const char * _msg)
     {
         BLINKER_LOG_ALL(BLINKER_F("response to MIOT: "), _msg);
 
         // BProto::aliPrint(_msg);
 
-        if (_msg.length() <= BLINKER_MAX_SEND_SIZE)
+        if (strlen(_msg) <= BLINKER_MAX_SEND_SIZE)
         {
             // char* aliData = (char*)malloc((_msg.length()+1+128)*sizeof(char));
             // memcpy(aliData, '\0', _msg.length()+128);
@@ -7086,6 +7615,48 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         }
     }
 
+    #if defined(BLINKER_WITH_SNAPSHOT)
+    // The widgets printed by the heartbeat callback only go to the snapshot.
+    // Once widgets were printed from the loop since the callback last ran,
+    // they are in it already and the callback is skipped for a while, see
+    // BlinkerSnapshot::stale().
+    void BlinkerApi::heartbeatWidgets()
+    {
+        if (!_heartbeatFunc) return;
+
+        if (!_snapshot.stale(millis()))
+        {
+            BLINKER_LOG_ALL(BLINKER_F("heartbeat served from snapshot"));
+            return;
+        }
+
+        _heartbeating = true;
+        _heartbeatFunc();
+        _heartbeating = false;
+
+        _snapshot.collected(millis());
+    }
+
+    // The adapter sends each print to the owner unless told otherwise, every
+    // packet goes back to whoever asked for the state.
+    void BlinkerApi::printSnapshot(uint8_t replyTo)
+    {
+        uint8_t packets = _snapshot.pack();
+
+        for (uint8_t num = 0; num < packets; num++)
+        {
+            #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
+                defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+                defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP) || \
+                defined(BLINKER_WIFI_SUBDEVICE)
+                BProto::replyTo(replyTo);
+            #endif
+            BProto::checkState(false);
+            BProto::print(STRING_format(_snapshot.packet(num)));
+        }
+    }
+    #endif
+
     void BlinkerApi::heartBeat(const JsonObject& data)
     {
         String state = data[BLINKER_CMD_GET];
@@ -7095,6 +7666,18 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         {
             if (state == BLINKER_CMD_STATE)
             {
+                #if defined(BLINKER_WITH_SNAPSHOT)
+                    // the sharer asking, unused on local links
+                    uint8_t replyTo = 0;
+
+                    #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
+                        defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+                        defined(BLINKER_MQTT_AUTO) || defined(BLINKER_PRO_ESP) || \
+                        defined(BLINKER_WIFI_SUBDEVICE)
+                        replyTo = BProto::replyTo();
+                    #endif
+                #endif
+
                 #if defined(BLINKER_BLE) || defined(BLINKER_WIFI)
                     print(BLINKER_CMD_STATE, BLINKER_CMD_CONNECTED);
                 #else
@@ -7121,9 +7704,15 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                     #endif
                 #endif
 
-                if (_heartbeatFunc) {
-                    _heartbeatFunc();
-                }
+                #if defined(BLINKER_WITH_SNAPSHOT)
+                    heartbeatWidgets();
+                #else
+                    if (_heartbeatFunc) {
+                        _heartbeating = true;
+                        _heartbeatFunc();
+                        _heartbeating = false;
+                    }
+                #endif
 
                 if (_summaryFunc) {
                     String summary_data = _summaryFunc();
@@ -7161,6 +7750,10 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                     BProto::checkState(false);
                     BProto::printNow();
                 }
+
+                #if defined(BLINKER_WITH_SNAPSHOT)
+                    printSnapshot(replyTo);
+                #endif
                 BLINKER_LOG_ALL(BLINKER_F("heartBeat isParsed"));
                 _fresh = true;
 
@@ -7168,6 +7761,27 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                     atHeartbeat();
                 #endif
             }
+            #if defined(BLINKER_WITH_TRACE)
+            else if (state == BLINKER_CMD_TRACE)
+            {
+                String trace;
+                BLINKER_TRACE_RING.json(trace, BLINKER_MAX_SEND_SIZE / 2);
+
+                printArray(BLINKER_CMD_TRACE, trace);
+                BProto::checkState(false);
+                BProto::printNow();
+
+                _fresh = true;
+            }
+            #endif
+            #if defined(BLINKER_WITH_METRICS)
+            else if (state == BLINKER_CMD_METRICS)
+            {
+                metricsReport();
+
+                _fresh = true;
+            }
+            #endif
         }
     }
 
@@ -7422,59 +8036,33 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
 #else
 
-    int16_t BlinkerApi::ahrs(b_ahrsattitude_t attitude, char data[])
+    void BlinkerApi::ahrs(BlinkerJsonScanner & scan, const float * array)
     {
-        int16_t aAttiValue = STRING_find_array_numberic_value(data, BLINKER_CMD_AHRS, attitude);
-
-        if (aAttiValue != FIND_KEY_VALUE_FAILED)
-        {
-            ahrsValue[Yaw] = STRING_find_array_numberic_value(data, BLINKER_CMD_AHRS, Yaw);
-            ahrsValue[Roll] = STRING_find_array_numberic_value(data, BLINKER_CMD_AHRS, Roll);
-            ahrsValue[Pitch] = STRING_find_array_numberic_value(data, BLINKER_CMD_AHRS, Pitch);
-            BLINKER_LOG_ALL(BLINKER_F("ahrs isParsed"));
-            _fresh = true;
+        if (strcmp(scan.key(), BLINKER_CMD_AHRS) || scan.count() < 3) return;
 
-            return aAttiValue;
-        }
-        else {
-            return ahrsValue[attitude];
-        }
+        ahrsValue[Yaw] = array[Yaw];
+        ahrsValue[Roll] = array[Roll];
+        ahrsValue[Pitch] = array[Pitch];
+        BLINKER_LOG_ALL(BLINKER_F("ahrs isParsed"));
+        _fresh = true;
     }
 
-    float BlinkerApi::gps(b_gps_t axis, char data[])
+    void BlinkerApi::gps(BlinkerJsonScanner & scan, const float * array)
     {
-        // if (((millis() - gps_get_time) >= BLINKER_GPS_MSG_LIMIT ||
-        //     gps_get_time == 0) && !newData)
-        // {
-        //     static_cast<Proto*>(this)->print(BLINKER_CMD_GET, BLINKER_CMD_GPS);
-        //     static_cast<Proto*>(this)->printNow();
-        //     delay(100);
-        // }
-
-        String axisValue = STRING_find_array_string_value(data, BLINKER_CMD_GPS, axis);
+        if (strcmp(scan.key(), BLINKER_CMD_GPS) || scan.count() < 2) return;
 
-        if (axisValue != "") {
-            gpsValue[LONG] = STRING_find_array_string_value(data, BLINKER_CMD_GPS, LONG).toFloat();
-            gpsValue[LAT] = STRING_find_array_string_value(data, BLINKER_CMD_GPS, LAT).toFloat();
-            BLINKER_LOG_ALL(BLINKER_F("gps isParsed"));
-            _fresh = true;
-
-            if (_fresh) {
-                BProto::isParsed();
-                gps_get_time = millis();
-            }
+        gpsValue[LONG] = array[LONG];
+        gpsValue[LAT] = array[LAT];
+        BLINKER_LOG_ALL(BLINKER_F("gps isParsed"));
+        _fresh = true;
 
-            return gpsValue[axis]*1000000;
-        }
-        else {
-            return gpsValue[axis]*1000000;
-        }
+        gps_get_time = millis();
     }
 
-    void BlinkerApi::heartBeat(char data[])
+    void BlinkerApi::heartBeat(BlinkerJsonScanner & scan)
     {
-        if (strstr(data, BLINKER_CMD_GET) && \
-            strstr(data, BLINKER_CMD_STATE))
+        if (strcmp(scan.key(), BLINKER_CMD_GET) == 0 && \
+            strcmp(scan.value(), BLINKER_CMD_STATE) == 0)
         {
             #if defined(BLINKER_BLE)
                 print(BLINKER_CMD_STATE, BLINKER_CMD_CONNECTED);
@@ -7483,7 +8071,9 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
             #endif
 
             if (_heartbeatFunc) {
+                _heartbeating = true;
                 _heartbeatFunc();
+                _heartbeating = false;
             }
 
             if (_summaryFunc)
@@ -7526,17 +8116,13 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
             }
             BLINKER_LOG_ALL(BLINKER_F("heartBeat isParsed"));
             _fresh = true;
-
-            // #if defined(BLINKER_AT_MQTT)
-            //     static_cast<Proto*>(this)->atHeartbeat();
-            // #endif
         }
     }
 
-    void BlinkerApi::getVersion(char data[])
+    void BlinkerApi::getVersion(BlinkerJsonScanner & scan)
     {
-        if (strstr(data, BLINKER_CMD_GET) && \
-            strstr(data, BLINKER_CMD_VERSION))
+        if (strcmp(scan.key(), BLINKER_CMD_GET) == 0 && \
+            strcmp(scan.value(), BLINKER_CMD_VERSION) == 0)
         {
             print(BLINKER_CMD_VERSION, BLINKER_VERSION);
             BLINKER_LOG_ALL(BLINKER_F("getVersion isParsed"));
@@ -7544,214 +8130,197 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         }
     }
 
-    void BlinkerApi::setSwitch(char data[])
+    void BlinkerApi::setSwitch(BlinkerJsonScanner & scan)
     {
-        String state;
-
-        if (STRING_find_string_value(data, state, BLINKER_CMD_BUILTIN_SWITCH))
+        if (strcmp(scan.key(), BLINKER_CMD_BUILTIN_SWITCH) == 0)
         {
-            // if (_BUILTIN_SWITCH)
-            // {
-            //     blinker_callback_with_string_arg_t sFunc = _BUILTIN_SWITCH->getFunc();
-
-            //     if (sFunc) sFunc(state);
-            // }
             blinker_callback_with_string_arg_t sFunc = _BUILTIN_SWITCH.getFunc();
 
-            if (sFunc) sFunc(state);
+            if (sFunc) sFunc(scan.value());
             BLINKER_LOG_ALL(BLINKER_F("setSwitch isParsed"));
             _fresh = true;
         }
     }
 
-    void BlinkerApi::strWidgetsParse(char _wName[], char _data[])
+    void BlinkerApi::strWidgetsParse(BlinkerJsonScanner & scan)
     {
-        int8_t num = checkNum(_wName, _Widgets_str, _wCount_str);
-
-        // BLINKER_LOG_ALL("====checkNum: ", num, " ====");
-        // BLINKER_LOG_ALL("====_data: ", _data, " ====");
+        int8_t num = checkNum(scan.key(), _Widgets_str, _wCount_str);
 
         if (num == BLINKER_OBJECT_NOT_AVAIL) return;
 
-        String state;
+        BLINKER_LOG_ALL(BLINKER_F("state: "), scan.value());
+        BLINKER_LOG_ALL(BLINKER_F("strWidgetsParse isParsed"));
+        _fresh = true;
 
-        if (STRING_find_string_value(_data, state, _wName))
-        {
-            BLINKER_LOG_ALL(BLINKER_F("state: "), state);
-            BLINKER_LOG_ALL(BLINKER_F("strWidgetsParse isParsed"));
-            _fresh = true;
-
-            blinker_callback_with_string_arg_t nbFunc = _Widgets_str[num]->getFunc();
-            if (nbFunc) nbFunc(state);
-        }
+        blinker_callback_with_string_arg_t nbFunc = _Widgets_str[num]->getFunc();
+        if (nbFunc) nbFunc(scan.value());
     }
 
     #if defined(BLINKER_BLE)
-        void BlinkerApi::joyWidgetsParse(char _wName[], char _data[])
+        void BlinkerApi::joyWidgetsParse(BlinkerJsonScanner & scan, const float * array)
         {
-            int8_t num = checkNum(_wName, _Widgets_joy, _wCount_joy);
-
-            if (num == BLINKER_OBJECT_NOT_AVAIL) return;
+            int8_t num = checkNum(scan.key(), _Widgets_joy, _wCount_joy);
 
-            int16_t jxAxisValue = STRING_find_array_numberic_value(_data, \
-                                                _wName, BLINKER_J_Xaxis);
+            if (num == BLINKER_OBJECT_NOT_AVAIL || scan.count() < 2) return;
 
-            if (jxAxisValue != FIND_KEY_VALUE_FAILED)
-            {
-                uint8_t jyAxisValue = STRING_find_array_numberic_value(_data, \
-                                                    _wName, BLINKER_J_Yaxis);
-                BLINKER_LOG_ALL(BLINKER_F("joyWidgetsParse isParsed"));
-                _fresh = true;
+            BLINKER_LOG_ALL(BLINKER_F("joyWidgetsParse isParsed"));
+            _fresh = true;
 
-                blinker_callback_with_joy_arg_t wFunc = _Widgets_joy[num]->getFunc();
+            blinker_callback_with_joy_arg_t wFunc = _Widgets_joy[num]->getFunc();
 
-                if (wFunc) wFunc(jxAxisValue, jyAxisValue);
-            }
+            if (wFunc) wFunc(array[BLINKER_J_Xaxis], array[BLINKER_J_Yaxis]);
         }
     #endif
 
-    void BlinkerApi::rgbWidgetsParse(char _wName[], char _data[])
+    void BlinkerApi::rgbWidgetsParse(BlinkerJsonScanner & scan, const float * array)
     {
-        int8_t num = checkNum(_wName, _Widgets_rgb, _wCount_rgb);
-
-        if (num == BLINKER_OBJECT_NOT_AVAIL) return;
+        int8_t num = checkNum(scan.key(), _Widgets_rgb, _wCount_rgb);
 
-        int16_t _rValue = STRING_find_array_numberic_value(_data, \
-                                                _wName, BLINKER_R);
+        if (num == BLINKER_OBJECT_NOT_AVAIL || scan.count() < 4) return;
 
-        if (_rValue != FIND_KEY_VALUE_FAILED)
-        {
-            uint8_t _gValue = STRING_find_array_numberic_value(_data, _wName, BLINKER_G);
-            uint8_t _bValue = STRING_find_array_numberic_value(_data, _wName, BLINKER_B);
-            uint8_t _brightValue = STRING_find_array_numberic_value(_data, _wName, BLINKER_BRIGHT);
-            BLINKER_LOG_ALL(BLINKER_F("rgbWidgetsParse isParsed"));
-            _fresh = true;
+        BLINKER_LOG_ALL(BLINKER_F("rgbWidgetsParse isParsed"));
+        _fresh = true;
 
-            blinker_callback_with_rgb_arg_t wFunc = _Widgets_rgb[num]->getFunc();
+        blinker_callback_with_rgb_arg_t wFunc = _Widgets_rgb[num]->getFunc();
 
-            if (wFunc) wFunc(_rValue, _gValue, _bValue, _brightValue);
-        }
+        if (wFunc) wFunc(array[BLINKER_R], array[BLINKER_G], \
+                        array[BLINKER_B], array[BLINKER_BRIGHT]);
     }
 
-    void BlinkerApi::intWidgetsParse(char _wName[], char _data[])
+    void BlinkerApi::intWidgetsParse(BlinkerJsonScanner & scan)
     {
-        int8_t num = checkNum(_wName, _Widgets_int, _wCount_int);
+        int8_t num = checkNum(scan.key(), _Widgets_int, _wCount_int);
 
         if (num == BLINKER_OBJECT_NOT_AVAIL) return;
 
-        int _number = STRING_find_numberic_value(_data, _wName);
-
-        if (_number != FIND_KEY_VALUE_FAILED)
-        {
-            BLINKER_LOG_ALL(BLINKER_F("intWidgetsParse isParsed"));
-            _fresh = true;
+        BLINKER_LOG_ALL(BLINKER_F("intWidgetsParse isParsed"));
+        _fresh = true;
 
-            blinker_callback_with_int32_arg_t wFunc = _Widgets_int[num]->getFunc();
+        blinker_callback_with_int32_arg_t wFunc = _Widgets_int[num]->getFunc();
 
-            if (wFunc) wFunc(_number);
-        }
+        if (wFunc) wFunc(atol(scan.value()));
     }
 
-    void BlinkerApi::tabWidgetsParse(char _wName[], char _data[])
+    void BlinkerApi::tabWidgetsParse(BlinkerJsonScanner & scan)
     {
-        int8_t num = checkNum(_wName, _Widgets_tab, _wCount_tab);
+        int8_t num = checkNum(scan.key(), _Widgets_tab, _wCount_tab);
 
         if (num == BLINKER_OBJECT_NOT_AVAIL) return;
 
-        String _setData;
+        const char * _setData = scan.value();
 
-        if (STRING_find_string_value(_data, _setData, _wName))
-        {
-            BLINKER_LOG_ALL(BLINKER_F("_setData: "), _setData);
-            BLINKER_LOG_ALL(BLINKER_F("tabWidgetsParse isParsed"));
-            _fresh = true;
+        BLINKER_LOG_ALL(BLINKER_F("_setData: "), _setData);
+        BLINKER_LOG_ALL(BLINKER_F("tabWidgetsParse isParsed"));
+        _fresh = true;
 
-            // uint8_t _number = 0;
+        blinker_callback_with_table_arg_t wFunc = _Widgets_tab[num]->getFunc();
 
-            // if (_setData == "10000") _number = BLINKER_CMD_TAB_0;
-            // else if (_setData == "01000") _number = BLINKER_CMD_TAB_1;
-            // else if (_setData == "00100") _number = BLINKER_CMD_TAB_2;
-            // else if (_setData == "00010") _number = BLINKER_CMD_TAB_3;
-            // else if (_setData == "00001") _number = BLINKER_CMD_TAB_4;
-
-            // blinker_callback_with_table_arg_t wFunc = _Widgets_tab[num]->getFunc();
-            // if (wFunc) {
-            //     wFunc(_number);
-            // }
-
-            blinker_callback_with_table_arg_t wFunc = _Widgets_tab[num]->getFunc();
-                    
-            for (uint8_t num = 0; num < 5; num++)
+        for (uint8_t num = 0; num < 5 && _setData[num]; num++)
+        {
+            if (_setData[num] == '1')
             {
-                // BLINKER_LOG_ALL(BLINKER_F("num: "), _setData.substring(num, num + 1));
-
-                if (strcmp(_setData.substring(num, num + 1).c_str(), "1") == 0)
-                {
-                    if (wFunc) {
-                        switch (num)
-                        {
-                            case 0:
-                                wFunc(BLINKER_CMD_TAB_0);
-                                break;
-                            case 1:
-                                wFunc(BLINKER_CMD_TAB_1);
-                                break;
-                            case 2:
-                                wFunc(BLINKER_CMD_TAB_2);
-                                break;
-                            case 3:
-                                wFunc(BLINKER_CMD_TAB_3);
-                                break;
-                            case 4:
-                                wFunc(BLINKER_CMD_TAB_4);
-                                break;
-                            default:
-                                break;
-                        }
+                if (wFunc) {
+                    switch (num)
+                    {
+                        case 0:
+                            wFunc(BLINKER_CMD_TAB_0);
+                            break;
+                        case 1:
+                            wFunc(BLINKER_CMD_TAB_1);
+                            break;
+                        case 2:
+                            wFunc(BLINKER_CMD_TAB_2);
+                            break;
+                        case 3:
+                            wFunc(BLINKER_CMD_TAB_3);
+                            break;
+                        case 4:
+                            wFunc(BLINKER_CMD_TAB_4);
+                            break;
+                        default:
+                            break;
                     }
                 }
             }
-
-            blinker_callback_t wFunc2 = _Widgets_tab[num]->getFunc2();
-            if (wFunc2) {
-                wFunc2();
-            }
         }
 
-        // int _number = STRING_find_numberic_value(_data, _wName);
+        blinker_callback_t wFunc2 = _Widgets_tab[num]->getFunc2();
+        if (wFunc2) {
+            wFunc2();
+        }
+    }
 
-        // if (_number != FIND_KEY_VALUE_FAILED)
-        // {
-        //     _fresh = true;
+    // One pass over the message, members are dispatched as they complete.
+    // builtin also answers the app queries and sensor reports, only the
+    // widgets are parsed otherwise.
+    void BlinkerApi::json_parse(char _data[], bool builtin)
+    {
+        BlinkerJsonScanner scan;
+        float array[BLINKER_JSON_ARRAY_SIZE];
 
-        //     blinker_callback_with_table_arg_t wFunc = _Widgets_tab[num]->getFunc();
+        for (char * c = _data; *c; c++)
+        {
+            uint8_t event = scan.feed(*c);
 
-        //     if (wFunc) wFunc(_number);
-        // }
+            if (event) json_member(scan, event, array, builtin);
+        }
     }
 
-    void BlinkerApi::json_parse(char _data[])
+    // A message fed from the stream by the adapter, as json_parse() of a
+    // line read by run()
+    void BlinkerApi::scanned(void * arg, BlinkerJsonScanner & scan, uint8_t event)
     {
-        setSwitch(_data);
+        BlinkerApi * api = (BlinkerApi *)arg;
 
-        BLINKER_LOG_ALL(BLINKER_F("====_wCount_str: "), _wCount_str, BLINKER_F(" ===="));
+        api->json_member(scan, event, api->_scanArray, true);
+    }
 
-        for (uint8_t wNum = 0; wNum < _wCount_str; wNum++) {
-            strWidgetsParse(_Widgets_str[wNum]->getName(), _data);
-        }
-        for (uint8_t wNum_int = 0; wNum_int < _wCount_int; wNum_int++) {
-            intWidgetsParse(_Widgets_int[wNum_int]->getName(), _data);
+    void BlinkerApi::json_member(BlinkerJsonScanner & scan, uint8_t event,
+                                float * array, bool builtin)
+    {
+        if (event & BLINKER_JSON_BEGIN) _fresh = false;
+
+        // A cut key could match a shorter widget name, drop the member
+        if (scan.truncated())
+        {
+            BLINKER_ERR_LOG_ALL(BLINKER_F("member too long: "), scan.key());
+            return;
         }
-        for (uint8_t wNum_rgb = 0; wNum_rgb < _wCount_rgb; wNum_rgb++) {
-            rgbWidgetsParse(_Widgets_rgb[wNum_rgb]->getName(), _data);
+
+        if (event & BLINKER_JSON_VALUE)
+        {
+            if (scan.index() >= 0)
+            {
+                if (scan.index() < BLINKER_JSON_ARRAY_SIZE)
+                {
+                    array[scan.index()] = atof(scan.value());
+                }
+            }
+            else
+            {
+                if (builtin)
+                {
+                    heartBeat(scan);
+                    getVersion(scan);
+                }
+                setSwitch(scan);
+                strWidgetsParse(scan);
+                intWidgetsParse(scan);
+                tabWidgetsParse(scan);
+            }
         }
-        #if defined(BLINKER_BLE)
-            for (uint8_t wNum_joy = 0; wNum_joy < _wCount_joy; wNum_joy++) {
-                joyWidgetsParse(_Widgets_joy[wNum_joy]->getName(), _data);
+
+        if (event & BLINKER_JSON_ARRAY_END)
+        {
+            if (builtin)
+            {
+                ahrs(scan, array);
+                gps(scan, array);
             }
-        #endif
-        for (uint8_t wNum_tab = 0; wNum_tab < _wCount_tab; wNum_tab++) {
-            tabWidgetsParse(_Widgets_tab[wNum_tab]->getName(), _data);
+            rgbWidgetsParse(scan, array);
+            #if defined(BLINKER_BLE)
+                joyWidgetsParse(scan, array);
+            #endif
         }
     }
 #endif
@@ -7960,12 +8529,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         if (_cdState && _cdRunState)
         {
-            uint32_t _cdTime1_;
-
-            if (_cdTime1 * 60 > BLINKER_ONE_HOUR_TIME) _cdTime1_ = BLINKER_ONE_HOUR_TIME;
-            else _cdTime1_ = _cdTime1 * 60;
-
-            cdTicker.once(_cdTime1_, _cd_callback);
+            cdTicker.once(_cdTime1 * 60, _cd_callback);
 
             _cdStart = millis();
 
@@ -8005,13 +8569,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
             _lpRun1 = true;
             _lpStop = false;
 
-            uint32_t _lpTime1_;
-
-            if (_lpTime1 * 60 > BLINKER_ONE_HOUR_TIME) _lpTime1_ = BLINKER_ONE_HOUR_TIME;
-            else _lpTime1_ = _lpTime1 * 60;
-
-            _lpTime1_start = millis();
-            lpTicker.once(_lpTime1_, _lp_callback);
+            lpTicker.once(_lpTime1 * 60, _lp_callback);
 
             BLINKER_LOG_ALL(BLINKER_F("loop start!"));
         }
@@ -8648,12 +9206,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                         // _cdTime1 = _cdTime1 - _cdTime2;
                         // _cdTime2 = 0;
 
-                        uint32_t _cdTime1_ = _cdTime1 - _cdTime2;
-
-                        if (_cdTime1_ * 60 > BLINKER_ONE_HOUR_TIME) _cdTime1_ = BLINKER_ONE_HOUR_TIME;
-                        else _cdTime1_ = _cdTime1_ * 60;
-
-                        cdTicker.once(_cdTime1_, _cd_callback);
+                        cdTicker.once((_cdTime1 - _cdTime2) * 60, _cd_callback);
 
                         _cdStart = millis();
 
@@ -8834,13 +9387,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                         // _lpTrigged_times = 0;
                         _lpStop = false;
 
-                        uint32_t _lpTime1_;
-
-                        if (_lpTime1 * 60 > BLINKER_ONE_HOUR_TIME) _lpTime1_ = BLINKER_ONE_HOUR_TIME;
-                        else _lpTime1_ = _lpTime1 * 60;
-
-                        _lpTime1_start = millis();
-                        lpTicker.once(_lpTime1_, _lp_callback);
+                        lpTicker.once(_lpTime1 * 60, _lp_callback);
 
                         BLINKER_LOG_ALL(BLINKER_F("loop start!"));
                     }
@@ -9202,8 +9749,19 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
     }
 
 
-    bool BlinkerApi::checkTimer()
-    {
+    bool BlinkerApi::checkTimer()
+    {
+        if (_isNTPInit && (millis() - _wheelSyncTime >= BLINKER_WHEEL_SYNC_TIME ||
+            _wheelSyncTime == 0))
+        {
+            struct timeval tv;
+
+            gettimeofday(&tv, NULL);
+            BLINKER_WHEEL.sync(millis(), (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+
+            _wheelSyncTime = millis() | 1;
+        }
+
         if (_cdTrigged)
         {
             _cdTrigged = false;
@@ -9710,7 +10268,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                         _fresh = false;
                         // DynamicJsonBuffer _jsonBuffer;
                         // JsonObject& _array = _jsonBuffer.parseObject(_autoData_array);
-                        DynamicJsonDocument jsonBuffer(1024);
+                        BLINKER_JSON_DOC(jsonBuffer);
                         deserializeJson(jsonBuffer, _autoData_array);
                         JsonObject _array = jsonBuffer.as<JsonObject>();
 
@@ -9828,7 +10386,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
             // DynamicJsonBuffer jsonBufferSet;
             // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, value);
             JsonObject rootSet = jsonBuffer.as<JsonObject>();
 
@@ -9872,7 +10430,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
             // DynamicJsonBuffer jsonBufferSet;
             // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, value);
             JsonObject rootSet = jsonBuffer.as<JsonObject>();
 
@@ -9901,7 +10459,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
             // DynamicJsonBuffer jsonBufferSet;
             // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, value);
             JsonObject rootSet = jsonBuffer.as<JsonObject>();
 
@@ -9969,7 +10527,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
             // DynamicJsonBuffer jsonBufferSet;
             // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
             DeserializationError error = deserializeJson(jsonBuffer, value);
             JsonObject rootSet = jsonBuffer.as<JsonObject>();
 
@@ -10004,7 +10562,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
     #if !defined(BLINKER_WIFI_SUBDEVICE)
 
     #if !defined(BLINKER_LOWPOWER_AIR202)
-    String BlinkerApi::bridgeQuery(char * key)
+    String BlinkerApi::bridgePath(char * key)
     {
         String data = BLINKER_F("/query?");
         data += BLINKER_F("deviceName=");
@@ -10012,7 +10570,12 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         data += BLINKER_F("&bridgeKey=");
         data += STRING_format(key);
 
-        return blinkerServer(BLINKER_CMD_BRIDGE_NUMBER, data);
+        return data;
+    }
+
+    String BlinkerApi::bridgeQuery(char * key)
+    {
+        return blinkerServer(BLINKER_CMD_BRIDGE_NUMBER, bridgePath(key));
     }
     #endif
 
@@ -10185,6 +10748,8 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         BLINKER_LOG_ALL(BLINKER_F("message: "), msg);
 
+        BLINKER_METRIC_TIME_MS(BLINKER_HIST_SERVER_MS);
+
         #ifndef BLINKER_LAN_DEBUG
             const int httpsPort = 443;
         #elif defined(BLINKER_LAN_DEBUG)
@@ -10917,7 +11482,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
                     // DynamicJsonBuffer jsonBuffer;
                     // JsonObject& data_rp = jsonBuffer.parseObject(payload);
-                    DynamicJsonDocument jsonBuffer(1024);
+                    BLINKER_JSON_DOC(jsonBuffer);
                     DeserializationError error = deserializeJson(jsonBuffer, payload);
                     JsonObject data_rp = jsonBuffer.as<JsonObject>();
 
@@ -11068,7 +11633,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(_data);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, _data);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -11077,8 +11642,6 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         if (root.containsKey(BLINKER_CMD_GET))
         {
-            String value = root[BLINKER_CMD_GET];
-
             bool query_set = false;
 
             if(_AliGenieQueryFunc) query_set = true;
@@ -11089,115 +11652,129 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                 BLINKER_ERR_LOG("None query function set!");
             }
 
-            if (value == BLINKER_CMD_STATE){
-                uint8_t setNum = root[BLINKER_CMD_NUM];
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_ALL_NUMBER);
-                if (_AliGenieQueryFunc_m) _AliGenieQueryFunc_m(BLINKER_CMD_QUERY_ALL_NUMBER, setNum);
-            }
-            else if (value == BLINKER_CMD_POWERSTATE) {
-                uint8_t setNum = root[BLINKER_CMD_NUM];
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_POWERSTATE_NUMBER);
-                if (_AliGenieQueryFunc_m) _AliGenieQueryFunc_m(BLINKER_CMD_QUERY_POWERSTATE_NUMBER, setNum);
-            }
-            else if (value == BLINKER_CMD_COLOR) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_COLOR_NUMBER);
-            }
-            else if (value == BLINKER_CMD_COLOR_) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_COLOR_NUMBER);
-            }
-            else if (value == BLINKER_CMD_COLORTEMP) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_COLORTEMP_NUMBER);
-            }
-            else if (value == BLINKER_CMD_BRIGHTNESS) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_BRIGHTNESS_NUMBER);
-            }
-            else if (value == BLINKER_CMD_TEMP) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_TEMP_NUMBER);
-            }
-            else if (value == BLINKER_CMD_HUMI) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_HUMI_NUMBER);
-            }
-            else if (value == BLINKER_CMD_PM25) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_PM25_NUMBER);
-            }
-            else if (value == BLINKER_CMD_MODE) {
-                if (_AliGenieQueryFunc) _AliGenieQueryFunc(BLINKER_CMD_QUERY_MODE_NUMBER);
-            }
-        }
-        else if (root.containsKey(BLINKER_CMD_SET)) {
-            String value = root[BLINKER_CMD_SET];
-
-            // DynamicJsonBuffer jsonBufferSet;
-            // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
-            DeserializationError error = deserializeJson(jsonBuffer, value);
-            JsonObject rootSet = jsonBuffer.as<JsonObject>();
+            uint8_t setNum = root[BLINKER_CMD_NUM];
+            int32_t query;
+            bool    multi = false;
 
-            // if (!rootSet.success())
-            if (error)
+            switch (blinkerVoiceKey(root[BLINKER_CMD_GET].as<const char *>()))
             {
-                // BLINKER_ERR_LOG_ALL("Json error");
-                return;
-            }
-
-            // BLINKER_LOG_ALL("Json parse success");
-
-            if (rootSet.containsKey(BLINKER_CMD_POWERSTATE)) {
-                String setValue = rootSet[BLINKER_CMD_POWERSTATE];
-                uint8_t setNum = rootSet[BLINKER_CMD_NUM];
-
-                if (_AliGeniePowerStateFunc) _AliGeniePowerStateFunc(setValue);
-                if (_AliGeniePowerStateFunc_m) _AliGeniePowerStateFunc_m(setValue, setNum);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_COLOR)) {
-                String setValue = rootSet[BLINKER_CMD_COLOR];
-
-                if (_AliGenieSetColorFunc) _AliGenieSetColorFunc(setValue);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_COLOR_)) {
-                String setValue = rootSet[BLINKER_CMD_COLOR_];
-
-                if (_AliGenieSetColorFunc) _AliGenieSetColorFunc(setValue);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_BRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_BRIGHTNESS];
-
-                if (_AliGenieSetBrightnessFunc) _AliGenieSetBrightnessFunc(setValue);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_UPBRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_UPBRIGHTNESS];
-
-                if (_AliGenieSetRelativeBrightnessFunc) _AliGenieSetRelativeBrightnessFunc(setValue.toInt());
+                case BLINKER_VOICE_STATE :
+                    query = BLINKER_CMD_QUERY_ALL_NUMBER;
+                    multi = true;
+                    break;
+                case BLINKER_VOICE_POWERSTATE :
+                    query = BLINKER_CMD_QUERY_POWERSTATE_NUMBER;
+                    multi = true;
+                    break;
+                case BLINKER_VOICE_COLOR :
+                case BLINKER_VOICE_COLOR_ :
+                    query = BLINKER_CMD_QUERY_COLOR_NUMBER;
+                    break;
+                case BLINKER_VOICE_COLORTEMP :
+                    query = BLINKER_CMD_QUERY_COLORTEMP_NUMBER;
+                    break;
+                case BLINKER_VOICE_BRIGHTNESS :
+                    query = BLINKER_CMD_QUERY_BRIGHTNESS_NUMBER;
+                    break;
+                case BLINKER_VOICE_TEMP :
+                    query = BLINKER_CMD_QUERY_TEMP_NUMBER;
+                    break;
+                case BLINKER_VOICE_HUMI :
+                    query = BLINKER_CMD_QUERY_HUMI_NUMBER;
+                    break;
+                case BLINKER_VOICE_PM25 :
+                    query = BLINKER_CMD_QUERY_PM25_NUMBER;
+                    break;
+                case BLINKER_VOICE_MODE :
+                    query = BLINKER_CMD_QUERY_MODE_NUMBER;
+                    break;
+                default :
+                    return;
             }
-            else if (rootSet.containsKey(BLINKER_CMD_DOWNBRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_DOWNBRIGHTNESS];
 
-                if (_AliGenieSetRelativeBrightnessFunc) _AliGenieSetRelativeBrightnessFunc(- setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_COLORTEMP)) {
-                String setValue = rootSet[BLINKER_CMD_COLORTEMP];
+            if (_AliGenieQueryFunc) _AliGenieQueryFunc(query);
+            if (_AliGenieQueryFunc_m && multi) _AliGenieQueryFunc_m(query, setNum);
+        }
+        else if (root.containsKey(BLINKER_CMD_SET)) {
+            // Parsed along with the message, unless it came as a string
+            JsonObject rootSet = root[BLINKER_CMD_SET];
+            DynamicJsonDocument jsonBufferSet(rootSet.isNull() ? 1024 : 0);
 
-                if (_AliGenieSetColorTemperature) _AliGenieSetColorTemperature(setValue.toInt());
+            if (rootSet.isNull())
+            {
+                if (deserializeJson(jsonBufferSet, root[BLINKER_CMD_SET].as<const char *>()))
+                {
+                    // BLINKER_ERR_LOG_ALL("Json error");
+                    return;
+                }
+                rootSet = jsonBufferSet.as<JsonObject>();
             }
-            else if (rootSet.containsKey(BLINKER_CMD_UPCOLORTEMP)) {
-                String setValue = rootSet[BLINKER_CMD_UPCOLORTEMP];
 
-                if (_AliGenieSetRelativeColorTemperature) _AliGenieSetRelativeColorTemperature(setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_DOWNCOLORTEMP)) {
-                String setValue = rootSet[BLINKER_CMD_DOWNCOLORTEMP];
+            uint8_t setNum = rootSet[BLINKER_CMD_NUM];
 
-                if (_AliGenieSetRelativeColorTemperature) _AliGenieSetRelativeColorTemperature(- setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_MODE)) {
-                String setMode = rootSet[BLINKER_CMD_MODE];
+            for (JsonPair kv : rootSet)
+            {
+                JsonVariant setValue = kv.value();
 
-                if (_AliGenieSetModeFunc) _AliGenieSetModeFunc(setMode);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_CANCELMODE)) {
-                String setcMode = rootSet[BLINKER_CMD_CANCELMODE];
+                switch (blinkerVoiceKey(kv.key().c_str()))
+                {
+                    case BLINKER_VOICE_POWERSTATE :
+                    {
+                        String state = setValue.as<String>();
 
-                if (_AliGenieSetcModeFunc) _AliGenieSetcModeFunc(setcMode);
+                        if (_AliGeniePowerStateFunc) _AliGeniePowerStateFunc(state);
+                        if (_AliGeniePowerStateFunc_m) _AliGeniePowerStateFunc_m(state, setNum);
+                        return;
+                    }
+                    case BLINKER_VOICE_COLOR :
+                    case BLINKER_VOICE_COLOR_ :
+                    {
+                        if (_AliGenieSetColorFunc) _AliGenieSetColorFunc(setValue.as<String>());
+                        return;
+                    }
+                    case BLINKER_VOICE_BRIGHTNESS :
+                    {
+                        if (_AliGenieSetBrightnessFunc) _AliGenieSetBrightnessFunc(setValue.as<String>());
+                        return;
+                    }
+                    case BLINKER_VOICE_UPBRIGHTNESS :
+                    {
+                        if (_AliGenieSetRelativeBrightnessFunc) _AliGenieSetRelativeBrightnessFunc(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_DOWNBRIGHTNESS :
+                    {
+                        if (_AliGenieSetRelativeBrightnessFunc) _AliGenieSetRelativeBrightnessFunc(- blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_COLORTEMP :
+                    {
+                        if (_AliGenieSetColorTemperature) _AliGenieSetColorTemperature(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_UPCOLORTEMP :
+                    {
+                        if (_AliGenieSetRelativeColorTemperature) _AliGenieSetRelativeColorTemperature(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_DOWNCOLORTEMP :
+                    {
+                        if (_AliGenieSetRelativeColorTemperature) _AliGenieSetRelativeColorTemperature(- blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_MODE :
+                    {
+                        if (_AliGenieSetModeFunc) _AliGenieSetModeFunc(setValue.as<String>());
+                        return;
+                    }
+                    case BLINKER_VOICE_CANCELMODE :
+                    {
+                        if (_AliGenieSetcModeFunc) _AliGenieSetcModeFunc(setValue.as<String>());
+                        return;
+                    }
+                    default :
+                        break;
+                }
             }
         }
     }
@@ -11209,7 +11786,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(_data);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, _data);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -11218,8 +11795,6 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         if (root.containsKey(BLINKER_CMD_GET))
         {
-            String value = root[BLINKER_CMD_GET];
-
             bool query_set = false;
 
             if(_DuerOSQueryFunc) query_set = true;
@@ -11230,110 +11805,112 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                 BLINKER_ERR_LOG("None query function set!");
             }
 
-            if (value == BLINKER_CMD_POWERSTATE) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_POWERSTATE_NUMBER);
-            }
-            else if (value == BLINKER_CMD_AQI) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_AQI_NUMBER);
-            }
-            else if (value == BLINKER_CMD_PM25) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_PM25_NUMBER);
-            }
-            else if (value == BLINKER_CMD_PM10) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_PM10_NUMBER);
-            }
-            else if (value == BLINKER_CMD_CO2) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_CO2_NUMBER);
-            }
-            else if (value == BLINKER_CMD_TEMP) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_TEMP_NUMBER);
-            }
-            else if (value == BLINKER_CMD_HUMI) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_HUMI_NUMBER);
-            }
-            else if (value == BLINKER_CMD_MODE) {
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_MODE_NUMBER);
-            }
-            else if (value == BLINKER_CMD_TIME_ALL) {
-                uint8_t setNum = root[BLINKER_CMD_NUM];
-                if (_DuerOSQueryFunc) _DuerOSQueryFunc(BLINKER_CMD_QUERY_TIME_NUMBER);
-                if (_DuerOSQueryFunc_m) _DuerOSQueryFunc_m(BLINKER_CMD_QUERY_TIME_NUMBER, setNum);
-            }
-        }
-        else if (root.containsKey(BLINKER_CMD_SET)) {
-            String value = root[BLINKER_CMD_SET];
-
-            // DynamicJsonBuffer jsonBufferSet;
-            // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
-            DeserializationError error = deserializeJson(jsonBuffer, value);
-            JsonObject rootSet = jsonBuffer.as<JsonObject>();
+            uint8_t setNum = root[BLINKER_CMD_NUM];
+            int32_t query;
+            bool    multi = false;
 
-            // if (!rootSet.success())
-            if (error)
+            switch (blinkerVoiceKey(root[BLINKER_CMD_GET].as<const char *>()))
             {
-                // BLINKER_ERR_LOG_ALL("Json error");
-                return;
-            }
-
-            // BLINKER_LOG_ALL("Json parse success");
-
-            if (rootSet.containsKey(BLINKER_CMD_POWERSTATE)) {
-                String setValue = rootSet[BLINKER_CMD_POWERSTATE];
-                uint8_t setNum = rootSet[BLINKER_CMD_NUM];
-
-                if (_DuerOSPowerStateFunc) _DuerOSPowerStateFunc(setValue);
-                if (_DuerOSPowerStateFunc_m) _DuerOSPowerStateFunc_m(setValue, setNum);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_COLOR)) {
-                String setValue = rootSet[BLINKER_CMD_COLOR];
-
-                if (_DuerOSSetColorFunc) _DuerOSSetColorFunc(setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_COLOR_)) {
-                String setValue = rootSet[BLINKER_CMD_COLOR_];
-
-                if (_DuerOSSetColorFunc) _DuerOSSetColorFunc(setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_BRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_BRIGHTNESS];
-
-                if (_DuerOSSetBrightnessFunc) _DuerOSSetBrightnessFunc(setValue);
+                case BLINKER_VOICE_POWERSTATE :
+                    query = BLINKER_CMD_QUERY_POWERSTATE_NUMBER;
+                    break;
+                case BLINKER_VOICE_AQI :
+                    query = BLINKER_CMD_QUERY_AQI_NUMBER;
+                    break;
+                case BLINKER_VOICE_PM25 :
+                    query = BLINKER_CMD_QUERY_PM25_NUMBER;
+                    break;
+                case BLINKER_VOICE_PM10 :
+                    query = BLINKER_CMD_QUERY_PM10_NUMBER;
+                    break;
+                case BLINKER_VOICE_CO2 :
+                    query = BLINKER_CMD_QUERY_CO2_NUMBER;
+                    break;
+                case BLINKER_VOICE_TEMP :
+                    query = BLINKER_CMD_QUERY_TEMP_NUMBER;
+                    break;
+                case BLINKER_VOICE_HUMI :
+                    query = BLINKER_CMD_QUERY_HUMI_NUMBER;
+                    break;
+                case BLINKER_VOICE_MODE :
+                    query = BLINKER_CMD_QUERY_MODE_NUMBER;
+                    break;
+                case BLINKER_VOICE_TIME :
+                    query = BLINKER_CMD_QUERY_TIME_NUMBER;
+                    multi = true;
+                    break;
+                default :
+                    return;
             }
-            else if (rootSet.containsKey(BLINKER_CMD_UPBRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_UPBRIGHTNESS];
 
-                if (_DuerOSSetRelativeBrightnessFunc) _DuerOSSetRelativeBrightnessFunc(setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_DOWNBRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_DOWNBRIGHTNESS];
+            if (_DuerOSQueryFunc) _DuerOSQueryFunc(query);
+            if (_DuerOSQueryFunc_m && multi) _DuerOSQueryFunc_m(query, setNum);
+        }
+        else if (root.containsKey(BLINKER_CMD_SET)) {
+            // Parsed along with the message, unless it came as a string
+            JsonObject rootSet = root[BLINKER_CMD_SET];
+            DynamicJsonDocument jsonBufferSet(rootSet.isNull() ? 1024 : 0);
 
-                if (_DuerOSSetRelativeBrightnessFunc) _DuerOSSetRelativeBrightnessFunc(- setValue.toInt());
+            if (rootSet.isNull())
+            {
+                if (deserializeJson(jsonBufferSet, root[BLINKER_CMD_SET].as<const char *>()))
+                {
+                    // BLINKER_ERR_LOG_ALL("Json error");
+                    return;
+                }
+                rootSet = jsonBufferSet.as<JsonObject>();
             }
-            // else if (rootSet.containsKey(BLINKER_CMD_COLORTEMP)) {
-            //     String setValue = rootSet[BLINKER_CMD_COLORTEMP];
-
-            //     if (_DuerOSSetColorTemperature) _DuerOSSetColorTemperature(setValue.toInt());
-            // }
-            // else if (rootSet.containsKey(BLINKER_CMD_UPCOLORTEMP)) {
-            //     String setValue = rootSet[BLINKER_CMD_UPCOLORTEMP];
 
-            //     if (_DuerOSSetRelativeColorTemperature) _DuerOSSetRelativeColorTemperature(setValue.toInt());
-            // }
-            // else if (rootSet.containsKey(BLINKER_CMD_DOWNCOLORTEMP)) {
-            //     String setValue = rootSet[BLINKER_CMD_DOWNCOLORTEMP];
+            uint8_t setNum = rootSet[BLINKER_CMD_NUM];
 
-            //     if (_DuerOSSetRelativeColorTemperature) _DuerOSSetRelativeColorTemperature(- setValue.toInt());
-            // }
-            else if (rootSet.containsKey(BLINKER_CMD_MODE)) {
-                String setMode = rootSet[BLINKER_CMD_MODE];
+            for (JsonPair kv : rootSet)
+            {
+                JsonVariant setValue = kv.value();
 
-                if (_DuerOSSetModeFunc) _DuerOSSetModeFunc(setMode);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_CANCELMODE)) {
-                String setcMode = rootSet[BLINKER_CMD_CANCELMODE];
+                switch (blinkerVoiceKey(kv.key().c_str()))
+                {
+                    case BLINKER_VOICE_POWERSTATE :
+                    {
+                        String state = setValue.as<String>();
 
-                if (_DuerOSSetcModeFunc) _DuerOSSetcModeFunc(setcMode);
+                        if (_DuerOSPowerStateFunc) _DuerOSPowerStateFunc(state);
+                        if (_DuerOSPowerStateFunc_m) _DuerOSPowerStateFunc_m(state, setNum);
+                        return;
+                    }
+                    case BLINKER_VOICE_COLOR :
+                    case BLINKER_VOICE_COLOR_ :
+                    {
+                        if (_DuerOSSetColorFunc) _DuerOSSetColorFunc(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_BRIGHTNESS :
+                    {
+                        if (_DuerOSSetBrightnessFunc) _DuerOSSetBrightnessFunc(setValue.as<String>());
+                        return;
+                    }
+                    case BLINKER_VOICE_UPBRIGHTNESS :
+                    {
+                        if (_DuerOSSetRelativeBrightnessFunc) _DuerOSSetRelativeBrightnessFunc(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_DOWNBRIGHTNESS :
+                    {
+                        if (_DuerOSSetRelativeBrightnessFunc) _DuerOSSetRelativeBrightnessFunc(- blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_MODE :
+                    {
+                        if (_DuerOSSetModeFunc) _DuerOSSetModeFunc(setValue.as<String>());
+                        return;
+                    }
+                    case BLINKER_VOICE_CANCELMODE :
+                    {
+                        if (_DuerOSSetcModeFunc) _DuerOSSetcModeFunc(setValue.as<String>());
+                        return;
+                    }
+                    default :
+                        break;
+                }
             }
         }
     }
@@ -11345,7 +11922,7 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         // DynamicJsonBuffer jsonBuffer;
         // JsonObject& root = jsonBuffer.parseObject(_data);
-        DynamicJsonDocument jsonBuffer(1024);
+        BLINKER_JSON_DOC(jsonBuffer);
         DeserializationError error = deserializeJson(jsonBuffer, _data);
         JsonObject root = jsonBuffer.as<JsonObject>();
 
@@ -11354,8 +11931,6 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
 
         if (root.containsKey(BLINKER_CMD_GET))
         {
-            String value = root[BLINKER_CMD_GET];
-
             bool query_set = false;
 
             if(_MIOTQueryFunc) query_set = true;
@@ -11366,119 +11941,105 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
                 BLINKER_ERR_LOG("None query function set!");
             }
 
-            if (value == BLINKER_CMD_STATE){
-                uint8_t setNum = root[BLINKER_CMD_NUM];
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_ALL_NUMBER);
-                if (_MIOTQueryFunc_m) _MIOTQueryFunc_m(BLINKER_CMD_QUERY_ALL_NUMBER, setNum);
-            }
-            else if (value == BLINKER_CMD_POWERSTATE) {
-                uint8_t setNum = root[BLINKER_CMD_NUM];
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_POWERSTATE_NUMBER);
-                if (_MIOTQueryFunc_m) _MIOTQueryFunc_m(BLINKER_CMD_QUERY_POWERSTATE_NUMBER, setNum);
-            }
-            else if (value == BLINKER_CMD_COLOR) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_COLOR_NUMBER);
-            }
-            else if (value == BLINKER_CMD_COLOR_) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_COLOR_NUMBER);
-            }
-            else if (value == BLINKER_CMD_COLORTEMP) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_COLORTEMP_NUMBER);
-            }
-            else if (value == BLINKER_CMD_BRIGHTNESS) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_BRIGHTNESS_NUMBER);
-            }
-            else if (value == BLINKER_CMD_TEMP) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_TEMP_NUMBER);
-            }
-            else if (value == BLINKER_CMD_HUMI) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_HUMI_NUMBER);
-            }
-            else if (value == BLINKER_CMD_PM25) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_PM25_NUMBER);
-            }
-            else if (value == BLINKER_CMD_MODE) {
-                if (_MIOTQueryFunc) _MIOTQueryFunc(BLINKER_CMD_QUERY_MODE_NUMBER);
-            }
-        }
-        else if (root.containsKey(BLINKER_CMD_SET)) {
-            String value = root[BLINKER_CMD_SET];
-
-            // DynamicJsonBuffer jsonBufferSet;
-            // JsonObject& rootSet = jsonBufferSet.parseObject(value);
-            DynamicJsonDocument jsonBuffer(1024);
-            DeserializationError error = deserializeJson(jsonBuffer, value);
-            JsonObject rootSet = jsonBuffer.as<JsonObject>();
+            uint8_t setNum = root[BLINKER_CMD_NUM];
+            int32_t query;
+            bool    multi = false;
 
-            // if (!rootSet.success())
-            if (error)
+            switch (blinkerVoiceKey(root[BLINKER_CMD_GET].as<const char *>()))
             {
-                // BLINKER_ERR_LOG_ALL("Json error");
-                return;
-            }
-
-            // BLINKER_LOG_ALL("Json parse success");
-
-            if (rootSet.containsKey(BLINKER_CMD_POWERSTATE)) {
-                String setValue = rootSet[BLINKER_CMD_POWERSTATE];
-                uint8_t setNum = rootSet[BLINKER_CMD_NUM];
-
-                if (setValue == "true") setValue = "on";
-                else setValue = "off";                
-
-                if (_MIOTPowerStateFunc) _MIOTPowerStateFunc(setValue);
-                if (_MIOTPowerStateFunc_m) _MIOTPowerStateFunc_m(setValue, setNum);
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_COLOR)) {
-                String setValue = rootSet[BLINKER_CMD_COLOR];
-
-                if (_MIOTSetColorFunc) _MIOTSetColorFunc(setValue.toInt());
+                case BLINKER_VOICE_STATE :
+                    query = BLINKER_CMD_QUERY_ALL_NUMBER;
+                    multi = true;
+                    break;
+                case BLINKER_VOICE_POWERSTATE :
+                    query = BLINKER_CMD_QUERY_POWERSTATE_NUMBER;
+                    multi = true;
+                    break;
+                case BLINKER_VOICE_COLOR :
+                case BLINKER_VOICE_COLOR_ :
+                    query = BLINKER_CMD_QUERY_COLOR_NUMBER;
+                    break;
+                case BLINKER_VOICE_COLORTEMP :
+                    query = BLINKER_CMD_QUERY_COLORTEMP_NUMBER;
+                    break;
+                case BLINKER_VOICE_BRIGHTNESS :
+                    query = BLINKER_CMD_QUERY_BRIGHTNESS_NUMBER;
+                    break;
+                case BLINKER_VOICE_TEMP :
+                    query = BLINKER_CMD_QUERY_TEMP_NUMBER;
+                    break;
+                case BLINKER_VOICE_HUMI :
+                    query = BLINKER_CMD_QUERY_HUMI_NUMBER;
+                    break;
+                case BLINKER_VOICE_PM25 :
+                    query = BLINKER_CMD_QUERY_PM25_NUMBER;
+                    break;
+                case BLINKER_VOICE_MODE :
+                    query = BLINKER_CMD_QUERY_MODE_NUMBER;
+                    break;
+                default :
+                    return;
             }
-            else if (rootSet.containsKey(BLINKER_CMD_COLOR_)) {
-                String setValue = rootSet[BLINKER_CMD_COLOR_];
 
-                if (_MIOTSetColorFunc) _MIOTSetColorFunc(setValue.toInt());
-            }
-            else if (rootSet.containsKey(BLINKER_CMD_BRIGHTNESS)) {
-                String setValue = rootSet[BLINKER_CMD_BRIGHTNESS];
+            if (_MIOTQueryFunc) _MIOTQueryFunc(query);
+            if (_MIOTQueryFunc_m && multi) _MIOTQueryFunc_m(query, setNum);
+        }
+        else if (root.containsKey(BLINKER_CMD_SET)) {
+            // Parsed along with the message, unless it came as a string
+            JsonObject rootSet = root[BLINKER_CMD_SET];
+            DynamicJsonDocument jsonBufferSet(rootSet.isNull() ? 1024 : 0);
 
-                if (_MIOTSetBrightnessFunc) _MIOTSetBrightnessFunc(setValue);
+            if (rootSet.isNull())
+            {
+                if (deserializeJson(jsonBufferSet, root[BLINKER_CMD_SET].as<const char *>()))
+                {
+                    // BLINKER_ERR_LOG_ALL("Json error");
+                    return;
+                }
+                rootSet = jsonBufferSet.as<JsonObject>();
             }
-            // else if (rootSet.containsKey(BLINKER_CMD_UPBRIGHTNESS)) {
-            //     String setValue = rootSet[BLINKER_CMD_UPBRIGHTNESS];
-
-            //     if (_MIOTSetRelativeBrightnessFunc) _MIOTSetRelativeBrightnessFunc(setValue.toInt());
-            // }
-            // else if (rootSet.containsKey(BLINKER_CMD_DOWNBRIGHTNESS)) {
-            //     String setValue = rootSet[BLINKER_CMD_DOWNBRIGHTNESS];
-
-            //     if (_MIOTSetRelativeBrightnessFunc) _MIOTSetRelativeBrightnessFunc(- setValue.toInt());
-            // }
-            else if (rootSet.containsKey(BLINKER_CMD_COLORTEMP)) {
-                String setValue = rootSet[BLINKER_CMD_COLORTEMP];
 
-                if (_MIOTSetColorTemperature) _MIOTSetColorTemperature(setValue.toInt());
-            }
-            // else if (rootSet.containsKey(BLINKER_CMD_UPCOLORTEMP)) {
-            //     String setValue = rootSet[BLINKER_CMD_UPCOLORTEMP];
+            uint8_t setNum = rootSet[BLINKER_CMD_NUM];
 
-            //     if (_MIOTSetRelativeColorTemperature) _MIOTSetRelativeColorTemperature(setValue.toInt());
-            // }
-            // else if (rootSet.containsKey(BLINKER_CMD_DOWNCOLORTEMP)) {
-            //     String setValue = rootSet[BLINKER_CMD_DOWNCOLORTEMP];
+            for (JsonPair kv : rootSet)
+            {
+                JsonVariant setValue = kv.value();
 
-            //     if (_MIOTSetRelativeColorTemperature) _MIOTSetRelativeColorTemperature(- setValue.toInt());
-            // }
-            else if (rootSet.containsKey(BLINKER_CMD_MODE)) {
-                String setMode = rootSet[BLINKER_CMD_MODE];
+                switch (blinkerVoiceKey(kv.key().c_str()))
+                {
+                    case BLINKER_VOICE_POWERSTATE :
+                    {
+                        String state = setValue.as<String>() == BLINKER_CMD_TRUE ? BLINKER_CMD_ON : BLINKER_CMD_OFF;
 
-                if (_MIOTSetModeFunc) _MIOTSetModeFunc(setMode.toInt());
+                        if (_MIOTPowerStateFunc) _MIOTPowerStateFunc(state);
+                        if (_MIOTPowerStateFunc_m) _MIOTPowerStateFunc_m(state, setNum);
+                        return;
+                    }
+                    case BLINKER_VOICE_COLOR :
+                    case BLINKER_VOICE_COLOR_ :
+                    {
+                        if (_MIOTSetColorFunc) _MIOTSetColorFunc(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_BRIGHTNESS :
+                    {
+                        if (_MIOTSetBrightnessFunc) _MIOTSetBrightnessFunc(setValue.as<String>());
+                        return;
+                    }
+                    case BLINKER_VOICE_COLORTEMP :
+                    {
+                        if (_MIOTSetColorTemperature) _MIOTSetColorTemperature(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    case BLINKER_VOICE_MODE :
+                    {
+                        if (_MIOTSetModeFunc) _MIOTSetModeFunc(blinkerVoiceInt(setValue));
+                        return;
+                    }
+                    default :
+                        break;
+                }
             }
-            // else if (rootSet.containsKey(BLINKER_CMD_CANCELMODE)) {
-            //     String setcMode = rootSet[BLINKER_CMD_CANCELMODE];
-
-            //     if (_MIOTSetcModeFunc) _MIOTSetcModeFunc(setcMode);
-            // }
         }
     }
 #endif
@@ -13008,13 +13569,13 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         BProto::printNow();
     }
 
-    void BlinkerApi::aligeniePrint(String & _msg)
+    void BlinkerApi::aligeniePrint(const char * _msg)
     {
         BLINKER_LOG_ALL(BLINKER_F("response to AliGenie: "), _msg);
 
         // BProto::aliPrint(_msg);
 
-        if (_msg.length() <= BLINKER_MAX_SEND_SIZE)
+        if (strlen(_msg) <= BLINKER_MAX_SEND_SIZE)
         {
             // char* aliData = (char*)malloc((_msg.length()+1+128)*sizeof(char));
             // memcpy(aliData, '\0', _msg.length()+128);
@@ -13028,13 +13589,13 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         }
     }
 
-    void BlinkerApi::duerPrint(String & _msg, bool report)
+    void BlinkerApi::duerPrint(const char * _msg, bool report)
     {
         BLINKER_LOG_ALL(BLINKER_F("response to DuerOS: "), _msg);
 
         // BProto::aliPrint(_msg);
 
-        if (_msg.length() <= BLINKER_MAX_SEND_SIZE)
+        if (strlen(_msg) <= BLINKER_MAX_SEND_SIZE)
         {
             // char* aliData = (char*)malloc((_msg.length()+1+128)*sizeof(char));
             // memcpy(aliData, '\0', _msg.length()+128);
@@ -13048,13 +13609,13 @@ char * BlinkerApi::widgetName_tab(uint8_t num)
         }
     }
 
-    void BlinkerApi::miotPrint(String & _msg)
+    void BlinkerApi::miotPrint(const char * _msg)
     {
         BLINKER_LOG_ALL(BLINKER_F("response to MIOT: "), _msg);
 
         // BProto::aliPrint(_msg);
 
-        if (_msg.length() <= BLINKER_MAX_SEND_SIZE)
+        if (strlen(_msg) <= BLINKER_MAX_SEND_SIZE)
         {
             // char* aliData = (char*)malloc((_msg.length()+1+128)*sizeof(char));
             // memcpy(aliData, '\0', _msg.length()+128);
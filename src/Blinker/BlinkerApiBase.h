@@ -193,17 +193,43 @@ class BlinkerWidgets_table
                 if (_register) return bName;
                 else return "false";
             }
-            void name(const String & name)
+            void name(const String & name, uint32_t resolved = 0)
             {
+                if (_register) free(bName);
+
                 _register = true;
                 bName = (char*)malloc((name.length()+1)*sizeof(char));
                 strcpy(bName, name.c_str());
+                _resolved = resolved;
+                _fails = 0;
+            }
+            uint32_t resolved() { return _resolved; }
+            bool registered() { return _register; }
+            // a failed query waits BLINKER_BRIDGE_REFRESH_SPAN, doubled
+            // with each failure up to BLINKER_BRIDGE_RETRY_MAX
+            void failed(uint32_t now)
+            {
+                uint32_t wait = BLINKER_BRIDGE_REFRESH_SPAN;
+
+                if (_fails < 255) _fails++;
+
+                for (uint8_t num = 1; num < _fails && wait < BLINKER_BRIDGE_RETRY_MAX; num++)
+                {
+                    wait *= 2;
+                }
+
+                _retryAt = now + (wait < BLINKER_BRIDGE_RETRY_MAX ? wait : BLINKER_BRIDGE_RETRY_MAX);
             }
+            bool due(uint32_t now) { return _fails == 0 || (int32_t)(now - _retryAt) >= 0; }
+            uint8_t fails() { return _fails; }
 
         private :
             char *bKey;
             char *bName;
             bool _register = false;
+            uint32_t _resolved = 0;
+            uint8_t _fails = 0;
+            uint32_t _retryAt = 0;
             blinker_callback_with_string_arg_t wfunc;
         // public :
         //     BlinkerBridge() {}
@@ -227,6 +253,17 @@ class BlinkerWidgets_table
         //     char *bridgeName;
     };
 
+    // One aggregation window of a data storage key
+    typedef struct
+    {
+        time_t      start;
+        uint32_t    count;
+        double      sum;
+        float       min;
+        float       max;
+        float       last;
+    } blinker_window_t;
+
     class BlinkerData
     {
         public :
@@ -242,10 +279,91 @@ class BlinkerWidgets_table
                 }
             }
 
+            ~BlinkerData() { delete [] _win; }
+
             void name(const String & name) { _dname = name; }
 
             String getName() { return _dname; }
 
+            // Keeps windows of _window seconds instead of samples, see
+            // BlinkerApi::dataAggregate()
+            bool aggregate(uint32_t _window)
+            {
+                if (_window == 0) return false;
+
+                if (_win == NULL)
+                {
+                    _win = new blinker_window_t[BLINKER_MAX_DATA_COUNT];
+                    if (_win == NULL) return false;
+
+                    flush();
+                    _open.count = 0;
+                }
+
+                _winTime = _window;
+
+                return true;
+            }
+
+            bool aggregated() { return _win != NULL; }
+
+            // Folds one sample into the open window, a sample of a later
+            // window stores the open one first
+            void foldData(double _value, time_t now_time)
+            {
+                time_t start = now_time - now_time % _winTime;
+
+                if (_open.count && start != _open.start) closeWindow(now_time);
+
+                float value = _value;
+
+                if (_open.count == 0)
+                {
+                    _open.start = start;
+                    _open.sum = 0;
+                    _open.min = value;
+                    _open.max = value;
+                }
+
+                if (value < _open.min) _open.min = value;
+                if (value > _open.max) _open.max = value;
+                _open.sum += _value;
+                _open.last = value;
+                _open.count++;
+            }
+
+            void foldData(const String & _value, time_t now_time)
+            {
+                foldData(_value.toFloat(), now_time);
+            }
+
+            // Stores the open window once its time is over, the oldest
+            // stored window makes room when all are taken
+            void closeWindow(time_t now_time)
+            {
+                if (_win == NULL || _open.count == 0) return;
+                if (now_time - _open.start < (time_t)_winTime) return;
+
+                if (dataCount >= BLINKER_MAX_DATA_COUNT)
+                {
+                    dataCount = BLINKER_MAX_DATA_COUNT - 1;
+
+                    for (uint8_t num = 0; num < dataCount; num++) {
+                        time_data[num] = time_data[num + 1];
+                        _win[num] = _win[num + 1];
+                    }
+                }
+
+                time_data[dataCount] = _open.start;
+                _win[dataCount] = _open;
+                dataCount++;
+
+                BLINKER_LOG_ALL(BLINKER_F("closeWindow: "), _dname, \
+                                BLINKER_F(" count: "), _open.count);
+
+                _open.count = 0;
+            }
+
             bool saveData(const String & _data, time_t now_time, uint32_t _limit) {
                 if (dataCount > 0)
                 {
@@ -342,7 +460,23 @@ class BlinkerWidgets_table
                     _data_ += "[";
                     _data_ += String(time_data[num]);
                     _data_ += ",";
-                    _data_ += data[num];
+                    if (_win)
+                    {
+                        // [time, mean, min, max, count, last]
+                        _data_ += String(_win[num].sum / _win[num].count);
+                        _data_ += ",";
+                        _data_ += String(_win[num].min);
+                        _data_ += ",";
+                        _data_ += String(_win[num].max);
+                        _data_ += ",";
+                        _data_ += String(_win[num].count);
+                        _data_ += ",";
+                        _data_ += String(_win[num].last);
+                    }
+                    else
+                    {
+                        _data_ += data[num];
+                    }
                     _data_ += "]";
                     if (num + 1 < dataCount)
                     {
@@ -397,6 +531,9 @@ class BlinkerWidgets_table
             // char * data;
             time_t  time_data[BLINKER_MAX_DATA_COUNT];
             char    data[BLINKER_MAX_DATA_COUNT][10];
+            blinker_window_t *  _win = NULL;
+            blinker_window_t    _open;
+            uint32_t            _winTime = 0;
     };
 #endif
 
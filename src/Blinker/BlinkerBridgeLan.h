@@ -0,0 +1,475 @@
+#ifndef BLINKER_BRIDGE_LAN_H
+#define BLINKER_BRIDGE_LAN_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+#include "BlinkerMetrics.h"
+#include "BlinkerUtility.h"
+
+// Bridge messages between devices of one LAN, without the cloud broker.
+//
+// A device only learns the name and key of its bridge targets. The first
+// message to a target goes through the cloud while a probe asks the LAN
+// for that name. The target answers with the probe nonce signed by its
+// own key, the answer gives the address the next messages are sent to.
+// Every message carries a unix time, a sequence number and the sender
+// name, signed with the target key. The target drops messages off by more
+// than BLINKER_BRIDGE_LAN_SKEW seconds or not newer than the last one of
+// that sender, and acks the others. A message without ack inside
+// BLINKER_BRIDGE_LAN_ACK_TIME is handed back by expired() for the cloud
+// and its target is probed again. Only the newest message to a target
+// waits for its ack, bridge messages carry states.
+//
+//   ?<nonce>:<name>                        who is name
+//   !<sign><nonce>:<name>                  name is here
+//   #<sign><time>:<seq>:<from>:<message>   message from from
+//   +<seq>:<name>                          name got message seq
+//
+// Datagrams go out through the function given to begin(), 0 addresses the
+// whole LAN. The signing function writes the 32 hex chars of an HMAC.
+// Time is passed in, nothing here touches the network.
+
+typedef bool (*blinker_bridge_send_t)(uint32_t ip, const char * data, size_t len);
+typedef void (*blinker_bridge_sign_t)(const char * key, const char * data, size_t len, char sign[33]);
+
+#define BLINKER_BRIDGE_LAN_SIGN_SIZE    32
+
+class BlinkerBridgeLan
+{
+    public :
+        BlinkerBridgeLan()
+            : _send(NULL)
+            , _sign(NULL)
+            , _seq(0)
+        {
+            memset(_peer, 0, sizeof(_peer));
+            memset(_sender, 0, sizeof(_sender));
+            _id[0] = '\0';
+            _key[0] = '\0';
+        }
+
+        void begin(blinker_bridge_send_t send, blinker_bridge_sign_t sign,
+                    const char * id, const char * key);
+        void peer(const char * name, const char * key);
+
+        bool print(const char * name, const String & data, uint32_t now, uint32_t ts);
+        bool receive(uint32_t ip, const char * data, size_t len,
+                    uint32_t now, uint32_t ts, String & message);
+        bool expired(uint32_t now, String & data);
+
+    private :
+        struct blinker_bridge_peer_t
+        {
+            char        name[BLINKER_BRIDGE_NAME_SIZE];
+            char        key[BLINKER_AUTHKEY_SIZE];
+            uint32_t    ip;
+            uint32_t    seen;
+            uint32_t    probeTime;
+            uint32_t    nonce;
+            uint32_t    sentTime;
+            uint32_t    seq;
+            String *    pending;
+        };
+
+        struct blinker_bridge_sender_t
+        {
+            uint32_t    id;
+            uint32_t    ts;
+            uint32_t    seq;
+            uint32_t    seen;
+        };
+
+        blinker_bridge_peer_t   _peer[BLINKER_MAX_BRIDGE_SIZE];
+        blinker_bridge_sender_t _sender[BLINKER_BRIDGE_LAN_SENDERS];
+        blinker_bridge_send_t   _send;
+        blinker_bridge_sign_t   _sign;
+        char                    _id[BLINKER_BRIDGE_NAME_SIZE];
+        char                    _key[BLINKER_AUTHKEY_SIZE];
+        uint32_t                _seq;
+
+        blinker_bridge_peer_t * find(const char * name, size_t len);
+        void probe(blinker_bridge_peer_t & p, uint32_t now);
+        bool verify(const char * key, const char * sign, const char * data, size_t len);
+        bool fresh(const char * from, size_t len, uint32_t ts, uint32_t seq, uint32_t now);
+
+        void answer(uint32_t ip, const char * data, size_t len);
+        void answered(uint32_t ip, const char * data, size_t len, uint32_t now);
+        bool message(uint32_t ip, const char * data, size_t len,
+                    uint32_t now, uint32_t ts, String & out);
+        void acked(uint32_t ip, const char * data, size_t len, uint32_t now);
+};
+
+void BlinkerBridgeLan::begin(blinker_bridge_send_t send, blinker_bridge_sign_t sign,
+                            const char * id, const char * key)
+{
+    _send = send;
+    _sign = sign;
+
+    strncpy(_id, id, BLINKER_BRIDGE_NAME_SIZE - 1);
+    _id[BLINKER_BRIDGE_NAME_SIZE - 1] = '\0';
+    strncpy(_key, key, BLINKER_AUTHKEY_SIZE - 1);
+    _key[BLINKER_AUTHKEY_SIZE - 1] = '\0';
+}
+
+// A bridge target, the address is kept when the name doesn't change
+void BlinkerBridgeLan::peer(const char * name, const char * key)
+{
+    if (strlen(name) >= BLINKER_BRIDGE_NAME_SIZE) return;
+
+    blinker_bridge_peer_t * p = find(name, strlen(name));
+
+    if (p == NULL)
+    {
+        for (uint8_t num = 0; num < BLINKER_MAX_BRIDGE_SIZE; num++)
+        {
+            if (_peer[num].name[0] == '\0')
+            {
+                p = &_peer[num];
+                break;
+            }
+        }
+
+        if (p == NULL) return;
+
+        strcpy(p->name, name);
+    }
+
+    strncpy(p->key, key, BLINKER_AUTHKEY_SIZE - 1);
+    p->key[BLINKER_AUTHKEY_SIZE - 1] = '\0';
+
+    BLINKER_LOG_ALL(BLINKER_F("bridge lan peer: "), name);
+}
+
+BlinkerBridgeLan::blinker_bridge_peer_t * BlinkerBridgeLan::find(const char * name, size_t len)
+{
+    if (len == 0 || len >= BLINKER_BRIDGE_NAME_SIZE) return NULL;
+
+    for (uint8_t num = 0; num < BLINKER_MAX_BRIDGE_SIZE; num++)
+    {
+        if (strncmp(_peer[num].name, name, len) == 0 &&
+            _peer[num].name[len] == '\0')
+        {
+            return &_peer[num];
+        }
+    }
+
+    return NULL;
+}
+
+void BlinkerBridgeLan::probe(blinker_bridge_peer_t & p, uint32_t now)
+{
+    if (p.probeTime && now - p.probeTime < BLINKER_BRIDGE_LAN_PROBE_SPAN) return;
+
+    char buf[BLINKER_BRIDGE_NAME_SIZE + 16];
+
+    p.probeTime = now | 1;
+    p.nonce = (now * 2654435761UL) ^ (++_seq * 40503UL) ^ p.nonce;
+
+    size_t len = snprintf(buf, sizeof(buf), "?%08lx:%s",
+                        (unsigned long)p.nonce, p.name);
+
+    BLINKER_LOG_ALL(BLINKER_F("bridge lan probe: "), p.name);
+
+    _send(0, buf, len);
+}
+
+// Sends the message over the LAN, false when it has to go to the cloud
+bool BlinkerBridgeLan::print(const char * name, const String & data, uint32_t now, uint32_t ts)
+{
+    if (_send == NULL) return false;
+
+    blinker_bridge_peer_t * p = find(name, strlen(name));
+
+    if (p == NULL) return false;
+
+    if (p->ip && now - p->seen >= BLINKER_BRIDGE_LAN_TTL)
+    {
+        BLINKER_LOG_ALL(BLINKER_F("bridge lan peer silent: "), p->name);
+        p->ip = 0;
+    }
+
+    if (p->ip == 0)
+    {
+        probe(*p, now);
+        return false;
+    }
+
+    char head[64];
+    size_t headLen = snprintf(head, sizeof(head), "%lu:%lu:%s:",
+                        (unsigned long)ts, (unsigned long)(_seq + 1), _id);
+
+    if (headLen >= sizeof(head)) return false;
+
+    String frame;
+    if (!frame.reserve(1 + BLINKER_BRIDGE_LAN_SIGN_SIZE + headLen + data.length()))
+    {
+        return false;
+    }
+
+    char sign[BLINKER_BRIDGE_LAN_SIGN_SIZE + 1];
+
+    frame = BLINKER_F("#");
+    for (uint8_t i = 0; i < BLINKER_BRIDGE_LAN_SIGN_SIZE; i++) frame += '0';
+    frame += head;
+    frame += data;
+
+    _sign(p->key, frame.c_str() + 1 + BLINKER_BRIDGE_LAN_SIGN_SIZE,
+            frame.length() - 1 - BLINKER_BRIDGE_LAN_SIGN_SIZE, sign);
+    for (uint8_t i = 0; i < BLINKER_BRIDGE_LAN_SIGN_SIZE; i++)
+    {
+        frame.setCharAt(1 + i, sign[i]);
+    }
+
+    if (!_send(p->ip, frame.c_str(), frame.length()))
+    {
+        p->ip = 0;
+        return false;
+    }
+
+    _seq++;
+
+    // an earlier message still waiting is superseded by this one
+    if (p->pending == NULL) p->pending = new String();
+    *p->pending = data;
+    p->seq = _seq;
+    p->sentTime = now | 1;
+
+    BLINKER_LOG_ALL(BLINKER_F("bridge lan send: "), p->name, BLINKER_F(", seq: "), _seq);
+
+    return true;
+}
+
+// A message the LAN didn't ack in time, for the cloud
+bool BlinkerBridgeLan::expired(uint32_t now, String & data)
+{
+    for (uint8_t num = 0; num < BLINKER_MAX_BRIDGE_SIZE; num++)
+    {
+        blinker_bridge_peer_t & p = _peer[num];
+
+        if (p.sentTime == 0 || now - p.sentTime < BLINKER_BRIDGE_LAN_ACK_TIME) continue;
+
+        BLINKER_ERR_LOG(BLINKER_F("bridge lan no ack: "), p.name);
+        BLINKER_METRIC_COUNT(BLINKER_CNT_BRIDGE_CLOUD);
+
+        data = *p.pending;
+        delete p.pending;
+        p.pending = NULL;
+        p.sentTime = 0;
+        p.ip = 0;
+        p.probeTime = 0;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool BlinkerBridgeLan::verify(const char * key, const char * sign, const char * data, size_t len)
+{
+    char expect[BLINKER_BRIDGE_LAN_SIGN_SIZE + 1];
+    uint8_t diff = 0;
+
+    _sign(key, data, len, expect);
+
+    for (uint8_t i = 0; i < BLINKER_BRIDGE_LAN_SIGN_SIZE; i++)
+    {
+        diff |= expect[i] ^ sign[i];
+    }
+
+    return diff == 0;
+}
+
+// Nul terminated datagram from ip, true when it carried a message for
+// this device
+bool BlinkerBridgeLan::receive(uint32_t ip, const char * data, size_t len,
+                            uint32_t now, uint32_t ts, String & out)
+{
+    if (_send == NULL || len < 2) return false;
+
+    switch (data[0])
+    {
+        case '?' :
+            answer(ip, data + 1, len - 1);
+            return false;
+        case '+' :
+            acked(ip, data + 1, len - 1, now);
+            return false;
+        default :
+            break;
+    }
+
+    if (len <= 1 + BLINKER_BRIDGE_LAN_SIGN_SIZE) return false;
+
+    switch (data[0])
+    {
+        case '!' :
+            answered(ip, data + 1, len - 1, now);
+            return false;
+        case '#' :
+            return message(ip, data + 1, len - 1, now, ts, out);
+        default :
+            return false;
+    }
+}
+
+// <nonce>:<name>
+void BlinkerBridgeLan::answer(uint32_t ip, const char * data, size_t len)
+{
+    if (_id[0] == '\0' || len != 9 + strlen(_id) || data[8] != ':' ||
+        strncmp(data + 9, _id, len - 9) != 0)
+    {
+        return;
+    }
+
+    char buf[1 + BLINKER_BRIDGE_LAN_SIGN_SIZE + BLINKER_BRIDGE_NAME_SIZE + 16];
+
+    buf[0] = '!';
+    _sign(_key, data, len, buf + 1);
+    memcpy(buf + 1 + BLINKER_BRIDGE_LAN_SIGN_SIZE, data, len);
+
+    _send(ip, buf, 1 + BLINKER_BRIDGE_LAN_SIGN_SIZE + len);
+}
+
+// <sign><nonce>:<name>
+void BlinkerBridgeLan::answered(uint32_t ip, const char * data, size_t len, uint32_t now)
+{
+    const char * sign = data;
+    data += BLINKER_BRIDGE_LAN_SIGN_SIZE;
+    len -= BLINKER_BRIDGE_LAN_SIGN_SIZE;
+
+    if (len < 10 || data[8] != ':') return;
+
+    blinker_bridge_peer_t * p = find(data + 9, len - 9);
+
+    if (p == NULL || p->probeTime == 0) return;
+
+    char nonce[9];
+    snprintf(nonce, sizeof(nonce), "%08lx", (unsigned long)p->nonce);
+
+    if (strncmp(nonce, data, 8) != 0 || !verify(p->key, sign, data, len))
+    {
+        BLINKER_ERR_LOG(BLINKER_F("bridge lan bad answer for: "), p->name);
+        return;
+    }
+
+    p->ip = ip;
+    p->seen = now;
+    p->probeTime = 0;
+
+    BLINKER_LOG_ALL(BLINKER_F("bridge lan found: "), p->name);
+}
+
+// <sign><time>:<seq>:<from>:<message>
+bool BlinkerBridgeLan::message(uint32_t ip, const char * data, size_t len,
+                            uint32_t now, uint32_t ts, String & out)
+{
+    const char * sign = data;
+    const char * end = data + len;
+    data += BLINKER_BRIDGE_LAN_SIGN_SIZE;
+    len -= BLINKER_BRIDGE_LAN_SIGN_SIZE;
+
+    if (!verify(_key, sign, data, len))
+    {
+        BLINKER_ERR_LOG_ALL(BLINKER_F("bridge lan bad sign"));
+        return false;
+    }
+
+    char * next;
+    uint32_t sent = strtoul(data, &next, 10);
+    if (*next != ':') return false;
+    uint32_t seq = strtoul(next + 1, &next, 10);
+    if (*next != ':') return false;
+
+    const char * from = next + 1;
+    const char * msg = (const char *)memchr(from, ':', end - from);
+    if (msg == NULL) return false;
+
+    if ((sent > ts ? sent - ts : ts - sent) > BLINKER_BRIDGE_LAN_SKEW)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("bridge lan time off: "), sent);
+        return false;
+    }
+
+    if (!fresh(from, msg - from, sent, seq, now))
+    {
+        BLINKER_ERR_LOG(BLINKER_F("bridge lan replay: "), seq);
+        return false;
+    }
+
+    char buf[BLINKER_BRIDGE_NAME_SIZE + 16];
+    size_t ackLen = snprintf(buf, sizeof(buf), "+%lu:%s", (unsigned long)seq, _id);
+    _send(ip, buf, ackLen);
+
+    // a sender that is a bridge target too has its address now
+    blinker_bridge_peer_t * p = find(from, msg - from);
+    if (p)
+    {
+        p->ip = ip;
+        p->seen = now;
+    }
+
+    out = "";
+    out.reserve(end - msg - 1);
+    for (const char * c = msg + 1; c < end; c++) out += *c;
+
+    BLINKER_METRIC_COUNT(BLINKER_CNT_BRIDGE_LAN);
+
+    return true;
+}
+
+// Newer than the last message of from, an unknown sender takes the
+// longest silent slot
+bool BlinkerBridgeLan::fresh(const char * from, size_t len, uint32_t ts, uint32_t seq, uint32_t now)
+{
+    uint32_t id = BlinkerCRC32(from, len);
+    uint8_t slot = 0;
+
+    for (uint8_t num = 0; num < BLINKER_BRIDGE_LAN_SENDERS; num++)
+    {
+        blinker_bridge_sender_t & s = _sender[num];
+
+        if (s.seen && s.id == id)
+        {
+            if (ts < s.ts || (ts == s.ts && seq <= s.seq)) return false;
+
+            slot = num;
+            break;
+        }
+
+        if (s.seen == 0 || now - s.seen > now - _sender[slot].seen) slot = num;
+    }
+
+    _sender[slot].id = id;
+    _sender[slot].ts = ts;
+    _sender[slot].seq = seq;
+    _sender[slot].seen = now | 1;
+
+    return true;
+}
+
+// <seq>:<name>
+void BlinkerBridgeLan::acked(uint32_t ip, const char * data, size_t len, uint32_t now)
+{
+    char * next;
+    uint32_t seq = strtoul(data, &next, 10);
+    if (*next != ':') return;
+
+    blinker_bridge_peer_t * p = find(next + 1, data + len - next - 1);
+
+    if (p == NULL || p->ip != ip) return;
+
+    p->seen = now;
+
+    if (p->sentTime == 0 || p->seq != seq) return;
+
+    delete p->pending;
+    p->pending = NULL;
+    p->sentTime = 0;
+}
+
+#endif
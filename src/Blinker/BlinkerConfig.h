@@ -49,6 +49,139 @@
 
 #define BLINKER_SERVER_CONNECT_LIMIT    12
 
+#define BLINKER_RECONNECT_BASE          2000UL
+
+#define BLINKER_RECONNECT_WIFI_BASE     10000UL
+
+#define BLINKER_RECONNECT_MAX           300000UL
+
+#define BLINKER_RECONNECT_REAUTH        6
+
+// numbers, "-999999999.00" is the longest a slot is set to
+#define BLINKER_VOICE_VALUE_SIZE        16
+
+// power state, color and mode names: the assistants' own names are ASCII
+// and under 32 bytes, this leaves room for 21 characters of a UTF-8 name
+#define BLINKER_VOICE_TEXT_SIZE         64
+
+#define BLINKER_VOICE_PAYLOAD_SIZE      512
+
+#define BLINKER_JSON_KEY_SIZE           24
+
+#define BLINKER_JSON_VALUE_SIZE         24
+
+#define BLINKER_JSON_ARRAY_SIZE         4
+
+#ifndef BLINKER_TRACE_SIZE
+    #define BLINKER_TRACE_SIZE          32
+#endif
+
+// same as WEBSOCKETS_SERVER_CLIENT_MAX
+#define BLINKER_LAN_MAX_CLIENTS         5
+
+#ifndef BLINKER_LAN_QUEUE_SIZE
+    #define BLINKER_LAN_QUEUE_SIZE      4
+#endif
+
+#ifndef BLINKER_LAN_MSG_LIMIT
+    #define BLINKER_LAN_MSG_LIMIT       50
+#endif
+
+#define BLINKER_LAN_MSG_SPAN            1000UL
+
+#define BLINKER_METRICS_BUCKETS         16
+
+#ifndef BLINKER_METRICS_REPORT_TIME
+    #define BLINKER_METRICS_REPORT_TIME 600000UL
+#endif
+
+#ifndef BLINKER_IDLE_SLEEP_MAX
+    #define BLINKER_IDLE_SLEEP_MAX      50UL
+#endif
+
+#if defined(ESP32)
+    #ifndef BLINKER_JSON_ARENA_SIZE
+        #define BLINKER_JSON_ARENA_SIZE 2048
+    #endif
+#else
+    #ifndef BLINKER_JSON_ARENA_SIZE
+        #define BLINKER_JSON_ARENA_SIZE 1024
+    #endif
+#endif
+
+#ifndef BLINKER_JSON_ARENA_NUM
+    #if defined(BLINKER_WITH_NET_TASK)
+        #define BLINKER_JSON_ARENA_NUM  3
+    #else
+        #define BLINKER_JSON_ARENA_NUM  2
+    #endif
+#endif
+
+#if defined(BLINKER_WITH_NET_TASK) && !defined(ESP32)
+    #error BLINKER_WITH_NET_TASK is only supported on ESP32!
+#endif
+
+#ifndef BLINKER_NET_TASK_CORE
+    #define BLINKER_NET_TASK_CORE       0
+#endif
+
+#ifndef BLINKER_NET_TASK_STACK
+    #define BLINKER_NET_TASK_STACK      8192
+#endif
+
+#define BLINKER_NET_TASK_PRIORITY       3
+
+#define BLINKER_NET_RX_SLOTS            4
+
+#define BLINKER_NET_TX_SLOTS            4
+
+#define BLINKER_WHEEL_BITS              6
+
+#define BLINKER_WHEEL_SLOTS             (1 << BLINKER_WHEEL_BITS)
+
+#define BLINKER_WHEEL_LEVELS            5
+
+#define BLINKER_WHEEL_MAX_DELAY         0x7FFFFFFFUL
+
+#define BLINKER_WHEEL_SYNC_TIME         600000UL
+
+#define BLINKER_WHEEL_MAX_PPM           2000
+
+#define BLINKER_SHARERS_CHECK_SPAN      60000UL
+
+#define BLINKER_QUERY_TIMEOUT           5000UL
+
+#define BLINKER_BRIDGE_NAME_SIZE        40
+
+#ifndef BLINKER_BRIDGE_CACHE_TTL
+    #define BLINKER_BRIDGE_CACHE_TTL    86400UL
+#endif
+
+#define BLINKER_BRIDGE_REFRESH_SPAN     60000UL
+
+#ifndef BLINKER_BRIDGE_RETRY_MAX
+    #define BLINKER_BRIDGE_RETRY_MAX    3600000UL
+#endif
+
+#if defined(BLINKER_WITH_BRIDGE_LAN) && \
+    !(defined(BLINKER_MQTT) && (defined(ESP8266) || defined(ESP32)))
+    #error BLINKER_WITH_BRIDGE_LAN is only supported with BLINKER_MQTT on ESP8266 and ESP32!
+#endif
+
+#ifndef BLINKER_BRIDGE_LAN_PORT
+    #define BLINKER_BRIDGE_LAN_PORT     18120
+#endif
+
+#define BLINKER_BRIDGE_LAN_TTL          300000UL
+
+#define BLINKER_BRIDGE_LAN_PROBE_SPAN   30000UL
+
+#define BLINKER_BRIDGE_LAN_ACK_TIME     500UL
+
+#define BLINKER_BRIDGE_LAN_SKEW         60
+
+#define BLINKER_BRIDGE_LAN_SENDERS      4
+
 #if defined(BLINKER_DATA_HOUR_UPDATE)
     #define BLINKER_DATA_FREQ_TIME          3600UL
 #else
@@ -81,12 +214,14 @@
     #define BLINKER_PRESSTIME_RESET         10000UL
 #endif
 
-#if defined(BLINKER_WIFI) || defined(BLINKER_MQTT) || \
-    defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
-    defined(BLINKER_MQTT_AUTO) || defined(BLINKER_WIFI_SUBDEVICE)
-    #define BLINKER_MAX_WIDGET_SIZE         16
-#else
-    #define BLINKER_MAX_WIDGET_SIZE         6
+#ifndef BLINKER_MAX_WIDGET_SIZE
+    #if defined(BLINKER_WIFI) || defined(BLINKER_MQTT) || \
+        defined(BLINKER_AT_MQTT) || defined(BLINKER_WIFI_GATEWAY) || \
+        defined(BLINKER_MQTT_AUTO) || defined(BLINKER_WIFI_SUBDEVICE)
+        #define BLINKER_MAX_WIDGET_SIZE         16
+    #else
+        #define BLINKER_MAX_WIDGET_SIZE         6
+    #endif
 #endif
 
 #define BLINKER_OBJECT_NOT_AVAIL        -1
@@ -145,6 +280,38 @@
     #endif
 #endif
 
+// define BLINKER_WITHOUT_SNAPSHOT to run the heartbeat callback on every
+// heartbeat and send the widgets through the message buffer
+#if (defined(ESP8266) || defined(ESP32)) && defined(BLINKER_ARDUINOJSON) && \
+    !defined(BLINKER_WITHOUT_SNAPSHOT)
+    #define BLINKER_WITH_SNAPSHOT
+#endif
+
+#ifndef BLINKER_SNAPSHOT_NUM
+    #define BLINKER_SNAPSHOT_NUM        32
+#endif
+
+// the state of all widgets together, keys included
+#ifndef BLINKER_SNAPSHOT_SIZE
+    #define BLINKER_SNAPSHOT_SIZE       1024
+#endif
+
+#ifndef BLINKER_SNAPSHOT_TTL
+    #define BLINKER_SNAPSHOT_TTL        10000UL
+#endif
+
+#define BLINKER_SNAPSHOT_PACKET_SIZE    (BLINKER_MAX_SEND_BUFFER_SIZE)
+
+// define BLINKER_WITHOUT_WIDGET_DELTA to send every widget print
+
+#ifndef BLINKER_WIDGET_MIN_INTERVAL
+    #define BLINKER_WIDGET_MIN_INTERVAL 0UL
+#endif
+
+#ifndef BLINKER_WIDGET_REFRESH_TIME
+    #define BLINKER_WIDGET_REFRESH_TIME 60000UL
+#endif
+
 #define BLINKER_AUTHKEY_SIZE            14
 
 #if defined(ESP8266) || defined(ESP32)
@@ -279,6 +446,10 @@
 
 #define BLINKER_CMD_TIMER               "timer"
 
+#define BLINKER_CMD_TRACE               "trace"
+
+#define BLINKER_CMD_METRICS             "metrics"
+
 #define BLINKER_CMD_RUN                 "run"
 
 #define BLINKER_CMD_ENABLE              "ena"
@@ -519,7 +690,33 @@
 
 #define BLINKER_CMD_WHOIS               "{\"hello\":\"whois\"}"
 
+#ifndef BLINKER_MESH_CHECK_FREQ
 #define BLINKER_MESH_CHECK_FREQ         60000UL
+#endif
+
+// mesh messages the gateway holds between two checks, a node gets up to one
+// from each of its links in a single mesh update
+#ifndef BLINKER_MESH_RX_QUEUE
+#define BLINKER_MESH_RX_QUEUE           8
+#endif
+
+// define BLINKER_MESH_MSGPACK to exchange MessagePack packages with mesh
+// nodes that support it, other nodes keep using json
+// #define BLINKER_MESH_MSGPACK
+
+// share of each mesh link per traffic class, control commands forwarded
+// to sub devices > node/time sync > telemetry
+#ifndef BLINKER_MESH_WEIGHT_CONTROL
+#define BLINKER_MESH_WEIGHT_CONTROL     16
+#endif
+
+#ifndef BLINKER_MESH_WEIGHT_SYNC
+#define BLINKER_MESH_WEIGHT_SYNC        4
+#endif
+
+#ifndef BLINKER_MESH_WEIGHT_TELEMETRY
+#define BLINKER_MESH_WEIGHT_TELEMETRY   1
+#endif
 
 #define BLINKER_CMD_MODE_READING_NUMBER         0
 
@@ -575,7 +772,9 @@
 
 #define BLINKER_CMD_TAB_4                       1  // 0x00001
 
+#ifndef BLINKER_MAX_SUB_DEVICE_NUM
 #define BLINKER_MAX_SUB_DEVICE_NUM              36
+#endif
 
 // #define BLINKER_NTP_SERVER_1                    "ntp1.aliyun.com"
 
@@ -1806,6 +2005,30 @@ Success--[AT+MIPLDISCOVERRSP=0,22903,1,24,"5850;5851;5852;5853;5750"]
 
     #define BLINKER_SERIALCFG_SIZE              4
 
+    // 3584-4095, define BLINKER_WITHOUT_CREDENTIALS_CACHE to leave it free
+    // and request the MQTT credentials over https on every boot
+
+    #define BLINKER_EEP_ADDR_CREDENTIALS        3584
+
+    #define BLINKER_CREDENTIALS_SIZE            512
+
+    #define BLINKER_CREDENTIALS_HEAD_SIZE       11
+
+    #define BLINKER_CREDENTIALS_CHECK           0x5A
+
+    // 3072-3583, define BLINKER_WITHOUT_BRIDGE_CACHE to leave it free and
+    // query the bridge names over https on every boot
+
+    #define BLINKER_EEP_ADDR_BRIDGE             3072
+
+    #define BLINKER_BRIDGE_CACHE_SIZE           512
+
+    #define BLINKER_BRIDGE_CACHE_HEAD_SIZE      6
+
+    #define BLINKER_BRIDGE_CACHE_NUM            8
+
+    #define BLINKER_BRIDGE_CACHE_CHECK          0x5B
+
 #endif
 
 #if defined(BLINKER_GPRS_AIR202) || defined(BLINKER_PRO_AIR202) || \
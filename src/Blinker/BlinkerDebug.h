@@ -65,9 +65,22 @@ void BLINKER_LOG_FreeHeap();
 void BLINKER_LOG_FreeHeap_ALL();
 extern void BLINKER_LOG_T();
 
+// Compile time log levels, a sketch defining a lower BLINKER_LOG_LEVEL
+// before including Blinker.h drops the calls above it together with their
+// arguments. Calls left in only evaluate their arguments when the runtime
+// level set on BLINKER_DEBUG asks for them.
+#define BLINKER_LOG_LEVEL_NONE      0
+#define BLINKER_LOG_LEVEL_ERROR     1
+#define BLINKER_LOG_LEVEL_INFO      2
+#define BLINKER_LOG_LEVEL_ALL       3
+
+#ifndef BLINKER_LOG_LEVEL
+    #define BLINKER_LOG_LEVEL       BLINKER_LOG_LEVEL_ALL
+#endif
+
 /* BLINKER_LOG_T递归模板 */
-template <typename T,typename... Ts>
-void BLINKER_LOG_T(T arg,Ts... args)
+template <typename T, typename... Ts>
+void BLINKER_LOG_T(const T & arg, const Ts &... args)
 {
     if (BLINKER_DEBUG.isDebug())
     {
@@ -76,43 +89,67 @@ void BLINKER_LOG_T(T arg,Ts... args)
     }
     return;
 }
-/* BLINKER_LOG可变参数模板 */
+
 template <typename... Ts>
-void BLINKER_LOG(Ts... args)
+void blinker_log(const Ts &... args)
 {
     BLINKER_LOG_TIME();
     BLINKER_LOG_T(args...);
     return;
 }
-/* BLINKER_ERR_LOG可变参数模板 */
+
 template <typename... Ts>
-void BLINKER_ERR_LOG(Ts... args)
+void blinker_err_log(const Ts &... args)
 {
-    if (BLINKER_DEBUG.isDebug())
-    {
-        BLINKER_LOG_TIME();
-        BLINKER_DEBUG.print(BLINKER_DEBUG_F("ERROR: "));
-        BLINKER_LOG_T(args...);
-    }
+    BLINKER_LOG_TIME();
+    BLINKER_DEBUG.print(BLINKER_DEBUG_F("ERROR: "));
+    BLINKER_LOG_T(args...);
     return;
 }
 
-template <typename... Ts>
-void BLINKER_LOG_ALL(Ts... args)
-{
-    if (BLINKER_DEBUG.isDebugAll())
+#define BLINKER_LOG_IF(cond, func, ...) \
+    do { if (cond) func(__VA_ARGS__); } while (0)
+
+#if BLINKER_LOG_LEVEL >= BLINKER_LOG_LEVEL_INFO
+    #define BLINKER_LOG(...)            BLINKER_LOG_IF(BLINKER_DEBUG.isDebug(), blinker_log, __VA_ARGS__)
+#else
+    #define BLINKER_LOG(...)            BLINKER_LOG_IF(false, blinker_log, __VA_ARGS__)
+#endif
+
+#if BLINKER_LOG_LEVEL >= BLINKER_LOG_LEVEL_ERROR
+    #define BLINKER_ERR_LOG(...)        BLINKER_LOG_IF(BLINKER_DEBUG.isDebug(), blinker_err_log, __VA_ARGS__)
+#else
+    #define BLINKER_ERR_LOG(...)        BLINKER_LOG_IF(false, blinker_err_log, __VA_ARGS__)
+#endif
+
+#if BLINKER_LOG_LEVEL >= BLINKER_LOG_LEVEL_ALL
+    #define BLINKER_LOG_ALL(...)        BLINKER_LOG_IF(BLINKER_DEBUG.isDebugAll(), blinker_log, __VA_ARGS__)
+    #define BLINKER_ERR_LOG_ALL(...)    BLINKER_LOG_IF(BLINKER_DEBUG.isDebugAll(), blinker_err_log, __VA_ARGS__)
+#else
+    #define BLINKER_LOG_ALL(...)        BLINKER_LOG_IF(false, blinker_log, __VA_ARGS__)
+    #define BLINKER_ERR_LOG_ALL(...)    BLINKER_LOG_IF(false, blinker_err_log, __VA_ARGS__)
+#endif
+
+// Binary post-mortem trace, see BlinkerTrace.h. Compiled out unless the
+// sketch defines BLINKER_WITH_TRACE.
+#if defined(BLINKER_WITH_TRACE)
+    enum blinker_trace_event_t
     {
-        BLINKER_LOG_TIME();
-        BLINKER_LOG_T(args...);
-    }
-    return;
-}
+        BLINKER_TRACE_BOOT = 1,
+        BLINKER_TRACE_WIFI_DOWN,    // a: failures
+        BLINKER_TRACE_WIFI_UP,      // a: ms to reconnect
+        BLINKER_TRACE_AUTH_OK,
+        BLINKER_TRACE_AUTH_FAIL,    // a: failures
+        BLINKER_TRACE_MQTT_UP,      // a: ms to reconnect
+        BLINKER_TRACE_MQTT_FAIL,    // a: connect error, b: failures
+        BLINKER_TRACE_USER = 0x100  // first id free for sketches
+    };
 
-template <typename... Ts>
-void BLINKER_ERR_LOG_ALL(Ts... args)
-{
-    if (BLINKER_DEBUG.isDebugAll()) { BLINKER_ERR_LOG(args...); }
-    return;
-}
+    void blinker_trace(uint16_t id, int32_t a, int32_t b);
+
+    #define BLINKER_TRACE(id, a, b)     blinker_trace(id, a, b)
+#else
+    #define BLINKER_TRACE(id, a, b)     do {} while (0)
+#endif
 
 #endif
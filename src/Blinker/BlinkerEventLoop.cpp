@@ -0,0 +1,68 @@
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+
+#include <string.h>
+
+#include "BlinkerEventLoop.h"
+
+BlinkerEventLoop BLINKER_LOOP;
+
+BlinkerEventLoop::BlinkerEventLoop()
+    : _iterations(0)
+    , _wakeups(0)
+    , _sleeps(0)
+    , _sleptTime(0)
+    , _events(0)
+    , _armed(0)
+{
+    memset(_due, 0, sizeof(_due));
+}
+
+uint8_t BlinkerEventLoop::take()
+{
+    uint8_t events = _events;
+
+    _events = 0;
+    return events;
+}
+
+void BlinkerEventLoop::at(uint8_t slot, uint32_t when)
+{
+    if (slot >= BLINKER_DUE_NUM) return;
+
+    _due[slot] = when;
+    _armed |= 1 << slot;
+}
+
+// 0 when something is pending or due, limit when no deadline is closer
+uint32_t BlinkerEventLoop::idleFor(uint32_t now, uint32_t limit) const
+{
+    if (_events) return 0;
+
+    uint32_t wait = limit;
+
+    for (uint8_t slot = 0; slot < BLINKER_DUE_NUM; slot++)
+    {
+        if (!(_armed & (1 << slot))) continue;
+
+        int32_t left = (int32_t)(_due[slot] - now);
+
+        if (left <= 0) return 0;
+        if ((uint32_t)left < wait) wait = left;
+    }
+
+    return wait;
+}
+
+void BlinkerEventLoop::ran(bool woken)
+{
+    _iterations++;
+    if (woken) _wakeups++;
+}
+
+void BlinkerEventLoop::slept(uint32_t ms)
+{
+    _sleeps++;
+    _sleptTime += ms;
+}
+
+#endif
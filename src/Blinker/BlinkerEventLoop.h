@@ -0,0 +1,78 @@
+#ifndef BLINKER_EVENT_LOOP_H
+#define BLINKER_EVENT_LOOP_H
+
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include <Arduino.h>
+    #else
+        #include <WProgram.h>
+    #endif
+#else
+    #include <stdint.h>
+#endif
+
+#include "BlinkerConfig.h"
+
+// Tells the main loop when there is work.
+//
+// Adapters and timer callbacks signal() what became ready: bytes on the
+// broker socket, a LAN message, a fired ticker. Periodic work registers its
+// next deadline with at(). When nothing was signalled, idleFor() gives how
+// long run() may sleep before the closest deadline. The counters show how
+// often the loop ran, how often it had work and how long it slept.
+//
+// Time is passed in by the caller, nothing here touches the hardware.
+
+enum blinker_event_t
+{
+    BLINKER_EVENT_NET   = 1 << 0,
+    BLINKER_EVENT_LAN   = 1 << 1,
+    BLINKER_EVENT_TIMER = 1 << 2,
+    BLINKER_EVENT_USER  = 1 << 3
+};
+
+enum blinker_due_t
+{
+    BLINKER_DUE_KEEPALIVE,
+    BLINKER_DUE_HEARTBEAT,
+    BLINKER_DUE_STORAGE,
+    BLINKER_DUE_UPDATE,
+    BLINKER_DUE_WHEEL,
+    BLINKER_DUE_NUM
+};
+
+class BlinkerEventLoop
+{
+    public :
+        BlinkerEventLoop();
+
+        // safe from ticker callbacks
+        void signal(uint8_t events)             { _events |= events; }
+        uint8_t pending() const                 { return _events; }
+        uint8_t take();
+
+        void at(uint8_t slot, uint32_t when);
+        void cancel(uint8_t slot)               { _armed &= ~(1 << slot); }
+        uint32_t idleFor(uint32_t now, uint32_t limit) const;
+
+        void ran(bool woken);
+        void slept(uint32_t ms);
+
+        uint32_t iterations() const             { return _iterations; }
+        uint32_t wakeups() const                { return _wakeups; }
+        uint32_t sleeps() const                 { return _sleeps; }
+        uint32_t sleptTime() const              { return _sleptTime; }
+
+    private :
+        uint32_t            _due[BLINKER_DUE_NUM];
+        uint32_t            _iterations;
+        uint32_t            _wakeups;
+        uint32_t            _sleeps;
+        uint32_t            _sleptTime;
+        volatile uint8_t    _events;
+        uint8_t             _armed;
+};
+
+extern BlinkerEventLoop BLINKER_LOOP;
+
+#endif
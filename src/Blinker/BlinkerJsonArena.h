@@ -0,0 +1,192 @@
+#ifndef BLINKER_JSON_ARENA_H
+#define BLINKER_JSON_ARENA_H
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+#include "BlinkerMetrics.h"
+#include "../modules/ArduinoJson/ArduinoJson.h"
+
+// Json documents of the library parse sites.
+//
+// BLINKER_JSON_DOC(name) declares a JsonDocument & for the current scope.
+// On ESP8266 and ESP32 it is taken from BLINKER_JSON_ARENA_NUM documents
+// reserved at build time and given back, cleared, when the scope ends, so
+// parsing a message no longer allocates. A parse site that calls into
+// another one takes the next slot. Nesting deeper than the arena logs an
+// error and falls back to a heap document for that scope.
+//
+// The most bytes a slot held and the most documents live at once are kept
+// as high water marks and reported with the metrics.
+//
+// With BLINKER_WITH_NET_TASK two tasks parse at once, the arena gets a
+// third slot and slots are claimed with atomic bit operations.
+//
+// Other boards keep a heap document per scope, a static reservation would
+// cost them more than it saves.
+
+#if defined(ESP8266) || defined(ESP32)
+
+class BlinkerJsonArena
+{
+    public :
+        BlinkerJsonArena()
+            : _busy(0)
+            , _depth(0)
+            , _depthPeak(0)
+            , _usagePeak(0)
+            , _overflows(0)
+        {}
+
+        JsonDocument * acquire();
+        void release(JsonDocument * doc);
+
+        uint8_t depth() const                   { return _depth; }
+        uint8_t depthPeak() const               { return _depthPeak; }
+        size_t usagePeak() const                { return _usagePeak; }
+        uint32_t overflows() const              { return _overflows; }
+
+    private :
+        StaticJsonDocument<BLINKER_JSON_ARENA_SIZE> _doc[BLINKER_JSON_ARENA_NUM];
+        uint8_t     _busy;
+        uint8_t     _depth;
+        uint8_t     _depthPeak;
+        size_t      _usagePeak;
+        uint32_t    _overflows;
+
+        void enter();
+};
+
+// One document for a scope, from the arena when a slot is free
+class BlinkerJsonLease
+{
+    public :
+        BlinkerJsonLease();
+        ~BlinkerJsonLease();
+
+        JsonDocument & doc()                    { return *_doc; }
+
+    private :
+        JsonDocument *          _doc;
+        DynamicJsonDocument *   _heap;
+
+        BlinkerJsonLease(const BlinkerJsonLease &);
+        BlinkerJsonLease & operator=(const BlinkerJsonLease &);
+};
+
+BlinkerJsonArena BLINKER_JSON_ARENA;
+
+#define BLINKER_JSON_DOC(name)  BlinkerJsonLease _lease_##name; \
+                                JsonDocument & name = _lease_##name.doc()
+
+void BlinkerJsonArena::enter()
+{
+    #if defined(BLINKER_WITH_NET_TASK)
+        uint8_t depth = __atomic_add_fetch(&_depth, 1, __ATOMIC_RELAXED);
+    #else
+        uint8_t depth = ++_depth;
+    #endif
+
+    if (depth > _depthPeak)
+    {
+        _depthPeak = depth;
+        BLINKER_METRIC_HIGH(BLINKER_GAUGE_JSON_DEPTH, depth);
+    }
+}
+
+// NULL when every slot is taken
+JsonDocument * BlinkerJsonArena::acquire()
+{
+    enter();
+
+    for (uint8_t slot = 0; slot < BLINKER_JSON_ARENA_NUM; slot++)
+    {
+        uint8_t bit = 1 << slot;
+
+        #if defined(BLINKER_WITH_NET_TASK)
+            if (__atomic_fetch_or(&_busy, bit, __ATOMIC_ACQUIRE) & bit) continue;
+        #else
+            if (_busy & bit) continue;
+
+            _busy |= bit;
+        #endif
+
+        return &_doc[slot];
+    }
+
+    #if defined(BLINKER_WITH_NET_TASK)
+        __atomic_add_fetch(&_overflows, 1, __ATOMIC_RELAXED);
+    #else
+        _overflows++;
+    #endif
+    BLINKER_ERR_LOG(BLINKER_F("json arena nested too deep: "), _depth);
+
+    return NULL;
+}
+
+// NULL gives back the depth of a heap fallback
+void BlinkerJsonArena::release(JsonDocument * doc)
+{
+    #if defined(BLINKER_WITH_NET_TASK)
+        __atomic_sub_fetch(&_depth, 1, __ATOMIC_RELAXED);
+    #else
+        if (_depth) _depth--;
+    #endif
+
+    if (doc == NULL) return;
+
+    for (uint8_t slot = 0; slot < BLINKER_JSON_ARENA_NUM; slot++)
+    {
+        if (doc != &_doc[slot]) continue;
+
+        size_t used = doc->memoryUsage();
+
+        if (used > _usagePeak)
+        {
+            _usagePeak = used;
+            BLINKER_METRIC_HIGH(BLINKER_GAUGE_JSON_PEAK, used);
+            BLINKER_LOG_ALL(BLINKER_F("json arena peak: "), used, \
+                            BLINKER_F("/"), doc->capacity());
+        }
+
+        doc->clear();
+
+        #if defined(BLINKER_WITH_NET_TASK)
+            __atomic_fetch_and(&_busy, (uint8_t)~(1 << slot), __ATOMIC_RELEASE);
+        #else
+            _busy &= ~(1 << slot);
+        #endif
+        return;
+    }
+}
+
+BlinkerJsonLease::BlinkerJsonLease()
+    : _doc(BLINKER_JSON_ARENA.acquire())
+    , _heap(NULL)
+{
+    if (_doc == NULL)
+    {
+        _heap = new DynamicJsonDocument(BLINKER_JSON_ARENA_SIZE);
+        _doc = _heap;
+    }
+}
+
+BlinkerJsonLease::~BlinkerJsonLease()
+{
+    if (_heap)
+    {
+        delete _heap;
+        BLINKER_JSON_ARENA.release(NULL);
+    }
+    else
+    {
+        BLINKER_JSON_ARENA.release(_doc);
+    }
+}
+
+#else
+
+#define BLINKER_JSON_DOC(name)  DynamicJsonDocument name(1024)
+
+#endif
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef BLINKER_JSON_SCANNER_H
+#define BLINKER_JSON_SCANNER_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "BlinkerConfig.h"
+
+// Single pass JSON scanner for the builds without ArduinoJson.
+//
+// Bytes are fed one at a time, from a buffered line or straight from a
+// stream. feed() tells when a member of the top level object is complete:
+// key() and value() then hold it, index() is -1 for a scalar member and
+// the position for an element of a member array. The end of such an array
+// is reported on its own with its length in count(). Nested objects and
+// deeper arrays are skipped. An attached handler gets every event as it
+// happens, for a stream nobody keeps the bytes of.
+//
+// Keys and values live in fixed slots. A value outgrowing its slot, like
+// the text of an input widget, continues on the heap up to
+// BLINKER_MAX_READ_SIZE and is released with the next value. A key longer
+// than its slot, or a value past that limit, is cut and flagged by
+// truncated().
+
+enum blinker_json_event_t
+{
+    BLINKER_JSON_NONE       = 0,
+    BLINKER_JSON_VALUE      = 1 << 0,
+    BLINKER_JSON_ARRAY_END  = 1 << 1,
+    BLINKER_JSON_END        = 1 << 2,
+    BLINKER_JSON_BEGIN      = 1 << 3
+};
+
+class BlinkerJsonScanner;
+
+typedef void (*blinker_json_handler_t)(void * arg, BlinkerJsonScanner & scan, uint8_t event);
+
+class BlinkerJsonScanner
+{
+    public :
+        BlinkerJsonScanner()
+            : _long(NULL), _longSize(0), _handler(NULL), _arg(NULL)
+        { reset(); }
+        ~BlinkerJsonScanner()       { free(_long); }
+
+        void reset();
+        uint8_t feed(char c);
+        void attach(blinker_json_handler_t handler, void * arg)
+        { _handler = handler; _arg = arg; }
+
+        char * key()                { return _key; }
+        const char * value() const  { return _long ? _long : _value; }
+        int8_t index() const        { return _index; }
+        uint8_t count() const       { return _count; }
+        bool isString() const       { return _string; }
+        bool truncated() const      { return _truncated; }
+
+    private :
+        enum { CAPTURE_NONE, CAPTURE_KEY, CAPTURE_VALUE };
+
+        char    _key[BLINKER_JSON_KEY_SIZE];
+        char    _value[BLINKER_JSON_VALUE_SIZE];
+        char *  _long;
+        uint16_t _longSize;
+        blinker_json_handler_t _handler;
+        void *  _arg;
+        uint8_t _keyLen;
+        uint16_t _valueLen;
+        uint8_t _depth;
+        uint8_t _capture;
+        int8_t  _index;
+        uint8_t _count;
+        bool    _expectKey;
+        bool    _inArray;
+        bool    _inString;
+        bool    _escape;
+        bool    _bare;
+        bool    _string;
+        bool    _truncated;
+
+        void start(bool quoted);
+        void append(char c);
+        void appendValue(char c);
+        void release();
+        uint8_t finish();
+        uint8_t structural(char c);
+};
+
+void BlinkerJsonScanner::reset()
+{
+    release();
+    _key[0] = '\0';
+    _value[0] = '\0';
+    _keyLen = 0;
+    _valueLen = 0;
+    _depth = 0;
+    _capture = CAPTURE_NONE;
+    _index = -1;
+    _count = 0;
+    _expectKey = false;
+    _inArray = false;
+    _inString = false;
+    _escape = false;
+    _bare = false;
+    _string = false;
+    _truncated = false;
+}
+
+// A string or bare token starts, decide what it is part of
+void BlinkerJsonScanner::start(bool quoted)
+{
+    _capture = CAPTURE_NONE;
+
+    if (_depth == 1 && _expectKey)
+    {
+        _capture = CAPTURE_KEY;
+        _expectKey = false;
+        _keyLen = 0;
+        _key[0] = '\0';
+        _truncated = false;
+    }
+    else if (_depth == 1 || (_depth == 2 && _inArray))
+    {
+        _capture = CAPTURE_VALUE;
+        release();
+        _valueLen = 0;
+        _value[0] = '\0';
+        _string = quoted;
+
+        if (!_inArray) _index = -1;
+        else if (_count < 0x7F) _index = _count++;
+    }
+}
+
+void BlinkerJsonScanner::append(char c)
+{
+    if (_capture == CAPTURE_KEY)
+    {
+        if (_keyLen + 1 < BLINKER_JSON_KEY_SIZE)
+        {
+            _key[_keyLen++] = c;
+            _key[_keyLen] = '\0';
+        }
+        else _truncated = true;
+    }
+    else if (_capture == CAPTURE_VALUE) appendValue(c);
+}
+
+// In the slot while it fits, then on the heap a slot at a time
+void BlinkerJsonScanner::appendValue(char c)
+{
+    char * buf = _long ? _long : _value;
+    uint16_t size = _long ? _longSize : BLINKER_JSON_VALUE_SIZE;
+
+    if (_valueLen + 1 >= size)
+    {
+        if (size >= BLINKER_MAX_READ_SIZE)
+        {
+            _truncated = true;
+            return;
+        }
+
+        char * grown = (char *)realloc(_long, size + BLINKER_JSON_VALUE_SIZE);
+
+        if (!grown)
+        {
+            _truncated = true;
+            return;
+        }
+
+        if (!_long) memcpy(grown, _value, _valueLen + 1);
+
+        _long = grown;
+        _longSize = size + BLINKER_JSON_VALUE_SIZE;
+        buf = _long;
+    }
+
+    buf[_valueLen++] = c;
+    buf[_valueLen] = '\0';
+}
+
+void BlinkerJsonScanner::release()
+{
+    free(_long);
+    _long = NULL;
+    _longSize = 0;
+}
+
+// A string or bare token ended
+uint8_t BlinkerJsonScanner::finish()
+{
+    uint8_t capture = _capture;
+
+    _capture = CAPTURE_NONE;
+
+    return capture == CAPTURE_VALUE ? BLINKER_JSON_VALUE : BLINKER_JSON_NONE;
+}
+
+uint8_t BlinkerJsonScanner::structural(char c)
+{
+    switch (c)
+    {
+        case '{' :
+            if (_depth == 0) reset();
+            if (_depth < 0xFF) _depth++;
+            _expectKey = _depth == 1;
+            return _depth == 1 ? BLINKER_JSON_BEGIN : BLINKER_JSON_NONE;
+
+        case '[' :
+            if (_depth == 1)
+            {
+                _inArray = true;
+                _count = 0;
+            }
+            if (_depth < 0xFF) _depth++;
+            return BLINKER_JSON_NONE;
+
+        case ']' :
+        case '}' :
+            if (_depth == 0) return BLINKER_JSON_NONE;
+            _depth--;
+            if (_depth == 1 && _inArray && c == ']')
+            {
+                _inArray = false;
+                return BLINKER_JSON_ARRAY_END;
+            }
+            return _depth == 0 ? BLINKER_JSON_END : BLINKER_JSON_NONE;
+
+        case ',' :
+            if (_depth == 1) _expectKey = true;
+            return BLINKER_JSON_NONE;
+
+        case '"' :
+            _inString = true;
+            start(true);
+            return BLINKER_JSON_NONE;
+
+        case ':' :
+        case ' ' :
+        case '\t' :
+        case '\r' :
+        case '\n' :
+            return BLINKER_JSON_NONE;
+
+        default :
+            // numbers, true, false, null
+            if (_depth == 0) return BLINKER_JSON_NONE;
+            _bare = true;
+            start(false);
+            append(c);
+            return BLINKER_JSON_NONE;
+    }
+}
+
+uint8_t BlinkerJsonScanner::feed(char c)
+{
+    uint8_t event = BLINKER_JSON_NONE;
+
+    if (_inString)
+    {
+        if (_escape)
+        {
+            _escape = false;
+            switch (c)
+            {
+                case 'n' : c = '\n'; break;
+                case 't' : c = '\t'; break;
+                case 'r' : c = '\r'; break;
+                case 'b' : c = '\b'; break;
+                case 'f' : c = '\f'; break;
+                default : break;
+            }
+            append(c);
+        }
+        else if (c == '\\') _escape = true;
+        else if (c == '"')
+        {
+            _inString = false;
+            event = finish();
+        }
+        else append(c);
+    }
+    else if (_bare)
+    {
+        if (c == ',' || c == ']' || c == '}' || c == ' ' ||
+            c == '\t' || c == '\r' || c == '\n')
+        {
+            _bare = false;
+            event = finish();
+            event |= structural(c);
+        }
+        else append(c);
+    }
+    else
+    {
+        event = structural(c);
+    }
+
+    if (event && _handler) _handler(_arg, *this, event);
+
+    return event;
+}
+
+#endif
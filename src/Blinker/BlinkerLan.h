@@ -0,0 +1,274 @@
+#ifndef BLINKER_LAN_H
+#define BLINKER_LAN_H
+
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+#include "BlinkerMetrics.h"
+#include "../modules/ArduinoJson/ArduinoJson.h"
+
+// Local WebSocket clients of a device.
+//
+// Every connected client gets the device replies. Each client has its own
+// send budget, much larger than the cloud one, and a short queue. A client
+// over budget or with a full TCP window keeps a backlog without holding up
+// the others. The oldest frame is dropped when its queue is full, the
+// newest state is the one that matters. Queued frames are shared between
+// clients. Clients that connect with "msgpack" in the url get MessagePack
+// binary frames, converted once per message.
+//
+// Frames go out through the function given to begin() and time is passed
+// in, nothing here touches the network.
+
+typedef bool (*blinker_lan_send_t)(uint8_t num, const uint8_t * data, size_t len, bool binary);
+
+struct blinker_lan_frame_t
+{
+    uint16_t    refs;
+    uint16_t    len;
+    bool        binary;
+    uint8_t     data[1];
+};
+
+class BlinkerLan
+{
+    public :
+        BlinkerLan() : _send(NULL), _dropped(0)
+        {
+            memset(_client, 0, sizeof(_client));
+        }
+
+        void begin(blinker_lan_send_t send)     { _send = send; }
+
+        void connect(uint8_t num, bool binary, uint32_t now);
+        void disconnect(uint8_t num);
+        uint8_t clients() const;
+
+        uint8_t broadcast(const char * data, uint32_t now);
+        void flush(uint32_t now);
+
+        uint32_t dropped() const                { return _dropped; }
+
+    private :
+        struct blinker_lan_client_t
+        {
+            blinker_lan_frame_t *   queue[BLINKER_LAN_QUEUE_SIZE];
+            uint32_t                budgetFrom;
+            uint8_t                 budget;
+            uint8_t                 head;
+            uint8_t                 count;
+            bool                    connected;
+            bool                    binary;
+        };
+
+        blinker_lan_client_t    _client[BLINKER_LAN_MAX_CLIENTS];
+        blinker_lan_send_t      _send;
+        uint32_t                _dropped;
+
+        bool take(blinker_lan_client_t & c, uint32_t now);
+        void push(blinker_lan_client_t & c, blinker_lan_frame_t * f);
+        void pop(blinker_lan_client_t & c);
+
+        blinker_lan_frame_t * frame(size_t len);
+        blinker_lan_frame_t * pack(const char * data);
+        void release(blinker_lan_frame_t * f);
+};
+
+void BlinkerLan::connect(uint8_t num, bool binary, uint32_t now)
+{
+    if (num >= BLINKER_LAN_MAX_CLIENTS) return;
+
+    disconnect(num);
+
+    blinker_lan_client_t & c = _client[num];
+
+    c.connected = true;
+    c.binary = binary;
+    c.budget = BLINKER_LAN_MSG_LIMIT;
+    c.budgetFrom = now;
+}
+
+void BlinkerLan::disconnect(uint8_t num)
+{
+    if (num >= BLINKER_LAN_MAX_CLIENTS) return;
+
+    blinker_lan_client_t & c = _client[num];
+
+    while (c.count) pop(c);
+    c.connected = false;
+}
+
+uint8_t BlinkerLan::clients() const
+{
+    uint8_t n = 0;
+
+    for (uint8_t num = 0; num < BLINKER_LAN_MAX_CLIENTS; num++)
+    {
+        if (_client[num].connected) n++;
+    }
+    return n;
+}
+
+// Sends to every client, straight away when it has budget and nothing
+// queued. Returns the number of clients that got or queued the message.
+uint8_t BlinkerLan::broadcast(const char * data, uint32_t now)
+{
+    if (_send == NULL) return 0;
+
+    size_t len = strlen(data);
+    blinker_lan_frame_t * text = NULL;
+    blinker_lan_frame_t * bin = NULL;
+    bool packed = false;
+    uint8_t reached = 0;
+
+    for (uint8_t num = 0; num < BLINKER_LAN_MAX_CLIENTS; num++)
+    {
+        blinker_lan_client_t & c = _client[num];
+
+        if (!c.connected) continue;
+
+        if (c.binary && !packed)
+        {
+            bin = pack(data);
+            packed = true;
+        }
+
+        bool binary = c.binary && bin;
+
+        if (c.count == 0 && take(c, now))
+        {
+            bool sent = binary ? _send(num, bin->data, bin->len, true)
+                               : _send(num, (const uint8_t *)data, len, false);
+
+            if (sent)
+            {
+                reached++;
+                continue;
+            }
+        }
+
+        if (!binary && text == NULL)
+        {
+            text = frame(len);
+            if (text) memcpy(text->data, data, len);
+        }
+
+        blinker_lan_frame_t * f = binary ? bin : text;
+
+        if (f)
+        {
+            push(c, f);
+            reached++;
+        }
+    }
+
+    // frames keep living in the queues that hold them
+    release(text);
+    release(bin);
+
+    return reached;
+}
+
+void BlinkerLan::flush(uint32_t now)
+{
+    if (_send == NULL) return;
+
+    for (uint8_t num = 0; num < BLINKER_LAN_MAX_CLIENTS; num++)
+    {
+        blinker_lan_client_t & c = _client[num];
+
+        while (c.count && take(c, now))
+        {
+            blinker_lan_frame_t * f = c.queue[c.head];
+
+            // a binary client gets the text frame when pack() failed
+            if (!_send(num, f->data, f->len, f->binary)) break;
+
+            pop(c);
+        }
+    }
+}
+
+bool BlinkerLan::take(blinker_lan_client_t & c, uint32_t now)
+{
+    if (now - c.budgetFrom >= BLINKER_LAN_MSG_SPAN)
+    {
+        c.budgetFrom = now;
+        c.budget = BLINKER_LAN_MSG_LIMIT;
+    }
+
+    if (c.budget == 0) return false;
+
+    c.budget--;
+    return true;
+}
+
+void BlinkerLan::push(blinker_lan_client_t & c, blinker_lan_frame_t * f)
+{
+    if (c.count == BLINKER_LAN_QUEUE_SIZE)
+    {
+        pop(c);
+        _dropped++;
+        BLINKER_METRIC_COUNT(BLINKER_CNT_DROP_LAN);
+    }
+
+    c.queue[(c.head + c.count) % BLINKER_LAN_QUEUE_SIZE] = f;
+    c.count++;
+    f->refs++;
+}
+
+void BlinkerLan::pop(blinker_lan_client_t & c)
+{
+    release(c.queue[c.head]);
+    c.head = (c.head + 1) % BLINKER_LAN_QUEUE_SIZE;
+    c.count--;
+}
+
+// New frames hold one reference for their creator. They have a byte past
+// len for the terminator ArduinoJson writes.
+blinker_lan_frame_t * BlinkerLan::frame(size_t len)
+{
+    if (len > 0xFFFF) return NULL;
+
+    blinker_lan_frame_t * f = (blinker_lan_frame_t*)malloc(
+                                offsetof(blinker_lan_frame_t, data) + len + 1);
+
+    if (f == NULL)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("lan frame alloc failed"));
+        return NULL;
+    }
+
+    f->refs = 1;
+    f->len = len;
+    f->binary = false;
+    return f;
+}
+
+// MessagePack form of a json message, NULL when it doesn't parse
+blinker_lan_frame_t * BlinkerLan::pack(const char * data)
+{
+    DynamicJsonDocument doc(BLINKER_MAX_SEND_SIZE);
+
+    if (deserializeJson(doc, data)) return NULL;
+
+    blinker_lan_frame_t * f = frame(measureMsgPack(doc));
+
+    if (f)
+    {
+        serializeMsgPack(doc, (char *)f->data, f->len + 1);
+        f->binary = true;
+    }
+
+    return f;
+}
+
+void BlinkerLan::release(blinker_lan_frame_t * f)
+{
+    if (f && --f->refs == 0) free(f);
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef BLINKER_METRICS_H
+#define BLINKER_METRICS_H
+
+#if defined(BLINKER_WITH_METRICS)
+
+#include <string.h>
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+#include "BlinkerSupervisor.h"
+
+// Runtime counters of the library, read from the fleet side.
+//
+// Counters, low/high water gauges and histograms with power of two buckets
+// live in fixed arrays, an update is a few integer operations and never
+// allocates. The registry goes out as one compact json object every
+// BLINKER_METRICS_REPORT_TIME over MQTT and answers a {"get":"metrics"}
+// query from the app or a LAN client:
+//
+//   {"c":[counters],"g":[gauges],"r":[wifi,mqtt,auth connects],
+//    "h":[[parse us buckets],[server ms buckets]]}
+//
+// Bucket i counts the values of bit length i, trailing empty buckets are
+// left out.
+
+enum blinker_counter_t
+{
+    BLINKER_CNT_MQTT_IN,
+    BLINKER_CNT_MQTT_OUT,
+    BLINKER_CNT_WS_IN,
+    BLINKER_CNT_WS_OUT,
+    BLINKER_CNT_DROP_SPAN,      // checkPrintSpan()
+    BLINKER_CNT_DROP_CAN_PRINT, // checkCanPrint()
+    BLINKER_CNT_DROP_LAN,       // LAN queue overflow
+    BLINKER_CNT_BRIDGE_LAN,     // bridge messages taken from the LAN
+    BLINKER_CNT_BRIDGE_CLOUD,   // LAN bridge messages resent over the cloud
+    BLINKER_CNT_NUM
+};
+
+enum blinker_gauge_t
+{
+    BLINKER_GAUGE_HEAP_MIN,
+    BLINKER_GAUGE_BLOCK_MIN,    // largest free block
+    BLINKER_GAUGE_MESH_QUEUE,   // deepest mesh queue seen
+    BLINKER_GAUGE_JSON_PEAK,    // most bytes used in a json arena slot
+    BLINKER_GAUGE_JSON_DEPTH,   // most json documents live at once
+    BLINKER_GAUGE_NUM
+};
+
+enum blinker_histogram_t
+{
+    BLINKER_HIST_PARSE_US,
+    BLINKER_HIST_SERVER_MS,
+    BLINKER_HIST_NUM
+};
+
+class BlinkerMetrics
+{
+    public :
+        BlinkerMetrics() { clear(); }
+
+        void clear();
+
+        void count(uint8_t c)                   { _counter[c]++; }
+        void low(uint8_t g, uint32_t v)         { if (_gauge[g] == 0 || v < _gauge[g]) _gauge[g] = v; }
+        void high(uint8_t g, uint32_t v)        { if (v > _gauge[g]) _gauge[g] = v; }
+        void record(uint8_t h, uint32_t v);
+        void sampleHeap();
+
+        uint32_t counter(uint8_t c) const       { return _counter[c]; }
+        uint32_t gauge(uint8_t g) const         { return _gauge[g]; }
+        uint16_t bucket(uint8_t h, uint8_t b) const { return _bucket[h][b]; }
+
+        void json(String & out) const;
+
+    private :
+        uint32_t    _counter[BLINKER_CNT_NUM];
+        uint32_t    _gauge[BLINKER_GAUGE_NUM];
+        uint16_t    _bucket[BLINKER_HIST_NUM][BLINKER_METRICS_BUCKETS];
+};
+
+// Records the time spent in a scope into a histogram
+class BlinkerMetricsTimer
+{
+    public :
+        BlinkerMetricsTimer(uint8_t h, bool us) : _h(h), _us(us), _start(now()) {}
+        ~BlinkerMetricsTimer();
+
+    private :
+        uint8_t     _h;
+        bool        _us;
+        uint32_t    _start;
+
+        uint32_t now() const                    { return _us ? micros() : millis(); }
+};
+
+BlinkerMetrics BLINKER_METRICS;
+
+#define BLINKER_METRIC_COUNT(c)         BLINKER_METRICS.count(c)
+#define BLINKER_METRIC_HIGH(g, v)       BLINKER_METRICS.high(g, v)
+#define BLINKER_METRIC_TIME_US(h)       BlinkerMetricsTimer _metricsTimer(h, true)
+#define BLINKER_METRIC_TIME_MS(h)       BlinkerMetricsTimer _metricsTimer(h, false)
+
+void BlinkerMetrics::clear()
+{
+    memset(_counter, 0, sizeof(_counter));
+    memset(_gauge, 0, sizeof(_gauge));
+    memset(_bucket, 0, sizeof(_bucket));
+}
+
+void BlinkerMetrics::record(uint8_t h, uint32_t v)
+{
+    uint8_t b = 0;
+
+    while (v && b < BLINKER_METRICS_BUCKETS - 1)
+    {
+        v >>= 1;
+        b++;
+    }
+
+    if (_bucket[h][b] < 0xFFFF) _bucket[h][b]++;
+}
+
+void BlinkerMetrics::sampleHeap()
+{
+    #if defined(ESP8266)
+        low(BLINKER_GAUGE_HEAP_MIN, ESP.getFreeHeap());
+        low(BLINKER_GAUGE_BLOCK_MIN, ESP.getMaxFreeBlockSize());
+    #elif defined(ESP32)
+        low(BLINKER_GAUGE_HEAP_MIN, ESP.getFreeHeap());
+        low(BLINKER_GAUGE_BLOCK_MIN, ESP.getMaxAllocHeap());
+    #endif
+}
+
+void BlinkerMetrics::json(String & out) const
+{
+    char buf[12];
+
+    out = BLINKER_F("{\"c\":[");
+    for (uint8_t c = 0; c < BLINKER_CNT_NUM; c++)
+    {
+        if (c) out += BLINKER_F(",");
+        out += ultoa(_counter[c], buf, 10);
+    }
+
+    out += BLINKER_F("],\"g\":[");
+    for (uint8_t g = 0; g < BLINKER_GAUGE_NUM; g++)
+    {
+        if (g) out += BLINKER_F(",");
+        out += ultoa(_gauge[g], buf, 10);
+    }
+
+    out += BLINKER_F("],\"r\":[");
+    for (uint8_t link = 0; link < BLINKER_LINK_NUM; link++)
+    {
+        if (link) out += BLINKER_F(",");
+        out += ultoa(BLINKER_SUPERVISOR.connects(link), buf, 10);
+    }
+
+    out += BLINKER_F("],\"h\":[");
+    for (uint8_t h = 0; h < BLINKER_HIST_NUM; h++)
+    {
+        uint8_t used = BLINKER_METRICS_BUCKETS;
+
+        while (used && _bucket[h][used - 1] == 0) used--;
+
+        out += h ? BLINKER_F(",[") : BLINKER_F("[");
+        for (uint8_t b = 0; b < used; b++)
+        {
+            if (b) out += BLINKER_F(",");
+            out += ultoa(_bucket[h][b], buf, 10);
+        }
+        out += BLINKER_F("]");
+    }
+    out += BLINKER_F("]}");
+}
+
+BlinkerMetricsTimer::~BlinkerMetricsTimer()
+{
+    BLINKER_METRICS.record(_h, now() - _start);
+}
+
+#else
+
+#define BLINKER_METRIC_COUNT(c)         do {} while(0)
+#define BLINKER_METRIC_HIGH(g, v)       do {} while(0)
+#define BLINKER_METRIC_TIME_US(h)       do {} while(0)
+#define BLINKER_METRIC_TIME_MS(h)       do {} while(0)
+
+#endif
+
+#endif
@@ -5,6 +5,11 @@
 #include "BlinkerDebug.h"
 #include "BlinkerStream.h"
 #include "BlinkerUtility.h"
+#include "../Functions/BlinkerWidgetDelta.h"
+
+#if defined(BLINKER_ARDUINOJSON)
+    #include "BlinkerJsonArena.h"
+#endif
 
 enum _blinker_state_t
 {
@@ -65,7 +70,13 @@ class BlinkerProtocol
         void flush();
         void checkState(bool state = true)      { isCheck = state; }
         void print(const String & data);
-        void print(const String & key, const String & data);
+        bool print(const String & key, const String & data);
+        // the widget waits for the message its print went into
+        void pendDelta(BlinkerWidgetDelta * delta);
+        // a member written in place, its value goes at the pointer returned,
+        // room bytes at most, endMember() keeps it or takes it back out
+        char * beginMember(const char * key, size_t klen, size_t & room, bool replace = true);
+        bool endMember(bool keep);
 
         #if defined(BLINKER_MQTT) || defined(BLINKER_PRO) || \
             defined(BLINKER_AT_MQTT) || defined(BLINKER_MQTT_AT) || \
@@ -75,16 +86,27 @@ class BlinkerProtocol
             defined(BLINKER_PRO_ESP) || defined(BLINKER_WIFI_SUBDEVICE)
             int aliPrint(const String & data)   { return isInit ? conn->aliPrint(data) : false; }
             int duerPrint(const String & data, bool report = false)  { return isInit ? conn->duerPrint(data, report) : false; }
+            int aliPrint(const char * data)     { return isInit ? conn->aliPrint(data) : false; }
+            int duerPrint(const char * data, bool report = false)    { return isInit ? conn->duerPrint(data, report) : false; }
             #if !defined(BLINKER_GPRS_AIR202) && !defined(BLINKER_NBIOT_SIM7020) && \
                 !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202)
             int miPrint(const String & data)  { return isInit ? conn->miPrint(data) : false; }
+            int miPrint(const char * data)    { return isInit ? conn->miPrint(data) : false; }
             #endif
             // void ping() { if (isInit) conn->ping(); }
             #if !defined(BLINKER_MQTT_AT)
             int bPrint(char * name, const String & data) { return isInit ? conn->bPrint(name, data) : false; }
+            #if defined(BLINKER_WITH_BRIDGE_LAN)
+            void bridgePeer(const char * name, const char * key) { if (isInit) conn->bridgePeer(name, key); }
+            #endif
             int autoPrint(unsigned long id)  { return isInit ? conn->autoPrint(id) : false; }
             void sharers(const String & data) { if (isInit) conn->sharers(data); }
             int needFreshShare() { if (isInit) return conn->needFreshShare(); else return false; }
+            uint8_t replyTo() { return isInit ? conn->replyTo() : BLINKER_MQTT_FROM_AUTHER; }
+            void replyTo(uint8_t num) { if (isInit) conn->replyTo(num); }
+            #if defined(BLINKER_WITH_NET_TASK)
+            bool netJob(void (*job)(void *), void * arg) { return isInit && conn->netJob(job, arg); }
+            #endif
             #endif
         #endif
 
@@ -187,6 +209,10 @@ class BlinkerProtocol
         bool                isCheck = true;
         uint32_t            autoFormatFreshTime;
         char*               _sendBuf;
+        size_t              _memberAt = 0;
+        char                _memberTail = '\0';
+        bool                _memberOpen = false;
+        BlinkerWidgetDelta  *_pendingDeltas = NULL;
         blinker_callback_with_string_arg_t  _availableFunc = NULL;
 
     // #if defined(BLINKER_LOWPOWER_AIR202)
@@ -238,8 +264,9 @@ class BlinkerProtocol
         int printNow();
         void _timerPrint(const String & n);
         int _print(char * n, bool needCheckLength = true);
+        void settleDeltas(bool sent);
 
-        void autoFormatData(const String & key, const String & jsonValue);
+        bool autoFormatData(const String & key, const String & jsonValue);
     // #endif
 };
 
@@ -277,17 +304,20 @@ void BlinkerProtocol::checkAutoFormat()
     {
         if ((millis() - autoFormatFreshTime) >= BLINKER_MSG_AUTOFORMAT_TIMEOUT)
         {
+            bool sent = false;
+
             if (strlen(_sendBuf))
             {
                 // #if !defined(BLINKER_LOWPOWER_AIR202)
                 #if defined(BLINKER_ARDUINOJSON)
-                    _print(_sendBuf);
+                    sent = _print(_sendBuf);
                 #else
                     strcat(_sendBuf, "}");
-                    _print(_sendBuf);
+                    sent = _print(_sendBuf);
                 #endif
                 // #endif
             }
+            settleDeltas(sent);
             free(_sendBuf);
             autoFormat = false;
             BLINKER_LOG_FreeHeap_ALL();
@@ -307,6 +337,7 @@ int BlinkerProtocol::printNow()
             if (_print(_sendBuf)) print_state = BLINKER_SUCCESS;
         #endif
 
+        settleDeltas(print_state == BLINKER_SUCCESS);
         free(_sendBuf);
         autoFormat = false;
         BLINKER_LOG_FreeHeap_ALL();
@@ -325,6 +356,7 @@ void BlinkerProtocol::_timerPrint(const String & n)
     {
         checkFormat();
         checkState(false);
+        settleDeltas(false);
         strcpy(_sendBuf, n.c_str());
     }
     else
@@ -343,10 +375,10 @@ int BlinkerProtocol::_print(char * n, bool needCheckLength)
         // BLINKER_LOG_FreeHeap_ALL();
         BLINKER_LOG_ALL(BLINKER_F("Proto print..."));
         BLINKER_LOG_FreeHeap_ALL();
-        conn->print(n, isCheck);
+        int state = conn->print(n, isCheck);
         if (!isCheck) isCheck = true;
 
-        return true;
+        return state;
     }
     else {
         BLINKER_ERR_LOG(BLINKER_F("SEND DATA BYTES MAX THAN LIMIT!"));
@@ -359,6 +391,7 @@ void BlinkerProtocol::print(const String & data)
 {
     #if !defined(BLINKER_LOWPOWER_AIR202)
     checkFormat();
+    settleDeltas(false);
     strcpy(_sendBuf, data.c_str());
     _print(_sendBuf);
     free(_sendBuf);
@@ -367,14 +400,132 @@ void BlinkerProtocol::print(const String & data)
     #endif
 }
 
-void BlinkerProtocol::print(const String & key, const String & data)
+bool BlinkerProtocol::print(const String & key, const String & data)
+{
+    checkFormat();
+    bool added = autoFormatData(key, data);
+    if ((millis() - autoFormatFreshTime) >= BLINKER_MSG_AUTOFORMAT_TIMEOUT)
+    {
+        autoFormatFreshTime = millis();
+    }
+
+    return added;
+}
+
+// Opens key in the message being batched like autoFormatData() adds a
+// member, an earlier member of the same key is replaced. The value is then
+// written right after it, the closing brace kept aside.
+char * BlinkerProtocol::beginMember(const char * key, size_t klen, size_t & room, bool replace)
 {
     checkFormat();
-    autoFormatData(key, data);
+
+    room = 0;
+    _memberOpen = false;
+
+    #if defined(BLINKER_ARDUINOJSON)
+        if (replace && strlen(_sendBuf) && strstr(_sendBuf, key))
+        {
+            BLINKER_JSON_DOC(jsonBuffer);
+            deserializeJson(jsonBuffer, (const char *)_sendBuf);
+            JsonObject root = jsonBuffer.as<JsonObject>();
+
+            if (root.containsKey(key))
+            {
+                root.remove(key);
+                serializeJson(root, _sendBuf, BLINKER_MAX_SEND_SIZE);
+            }
+        }
+
+        if (strcmp(_sendBuf, "{}") == 0) _sendBuf[0] = '\0';
+
+        // the whole message, closing brace included
+        size_t limit = BLINKER_MAX_SEND_BUFFER_SIZE;
+        size_t len = strlen(_sendBuf);
+
+        _memberAt = len ? len - 1 : 0;
+        _memberTail = len ? '}' : '\0';
+    #else
+        // the closing brace goes on when it's sent
+        size_t limit = BLINKER_MAX_SEND_BUFFER_SIZE - 1;
+        size_t len = strlen(_sendBuf);
+
+        _memberAt = len;
+        _memberTail = '\0';
+    #endif
+
+    if (limit > BLINKER_MAX_SEND_SIZE - 1) limit = BLINKER_MAX_SEND_SIZE - 1;
+
+    // the separator, the quoted key and its colon, the closing brace
+    if (_memberAt + klen + 5 > limit) return NULL;
+
+    char * p = _sendBuf + _memberAt;
+
+    *p++ = _memberAt ? ',' : '{';
+    *p++ = '"';
+    memcpy(p, key, klen);
+    p += klen;
+    *p++ = '"';
+    *p++ = ':';
+    *p = '\0';
+
+    room = limit - (p - _sendBuf) - 1;
+    _memberOpen = true;
+
+    return p;
+}
+
+bool BlinkerProtocol::endMember(bool keep)
+{
+    if (!_memberOpen) return false;
+
+    _memberOpen = false;
+
+    if (!keep)
+    {
+        _sendBuf[_memberAt] = _memberTail;
+        if (_memberTail) _sendBuf[_memberAt + 1] = '\0';
+
+        return false;
+    }
+
+    #if defined(BLINKER_ARDUINOJSON)
+        size_t end = strlen(_sendBuf);
+
+        _sendBuf[end] = '}';
+        _sendBuf[end + 1] = '\0';
+    #endif
+
     if ((millis() - autoFormatFreshTime) >= BLINKER_MSG_AUTOFORMAT_TIMEOUT)
     {
         autoFormatFreshTime = millis();
     }
+
+    return true;
+}
+
+void BlinkerProtocol::pendDelta(BlinkerWidgetDelta * delta)
+{
+    for (BlinkerWidgetDelta * d = _pendingDeltas; d; d = d->pendingNext)
+    {
+        if (d == delta) return;
+    }
+
+    delta->pendingNext = _pendingDeltas;
+    _pendingDeltas = delta;
+}
+
+// the message the widgets printed into was published, or dropped, a
+// widget only remembers its print once it really went out
+void BlinkerProtocol::settleDeltas(bool sent)
+{
+    while (_pendingDeltas)
+    {
+        BlinkerWidgetDelta * delta = _pendingDeltas;
+
+        _pendingDeltas = delta->pendingNext;
+        delta->pendingNext = NULL;
+        delta->sent(sent);
+    }
 }
 
 void BlinkerProtocol::checkFormat()
@@ -387,7 +538,7 @@ void BlinkerProtocol::checkFormat()
     }
 }
 
-void BlinkerProtocol::autoFormatData(const String & key, const String & jsonValue)
+bool BlinkerProtocol::autoFormatData(const String & key, const String & jsonValue)
 {
     #if defined(BLINKER_ARDUINOJSON)
         BLINKER_LOG_ALL(BLINKER_F("autoFormatData key: "), key, \
@@ -399,7 +550,7 @@ void BlinkerProtocol::autoFormatData(const String & key, const String & jsonValu
         {
 
             // DynamicJsonBuffer jsonSendBuffer;
-            DynamicJsonDocument jsonBuffer(1024);
+            BLINKER_JSON_DOC(jsonBuffer);
 
             if (strlen(_sendBuf)) {
                 BLINKER_LOG_ALL(BLINKER_F("add"));
@@ -453,7 +604,7 @@ void BlinkerProtocol::autoFormatData(const String & key, const String & jsonValu
         if (_data.length() > BLINKER_MAX_SEND_BUFFER_SIZE)
         {
             BLINKER_ERR_LOG(BLINKER_F("FORMAT DATA SIZE IS MAX THAN LIMIT: "), BLINKER_MAX_SEND_BUFFER_SIZE);
-            return;
+            return false;
         }
 
         strcpy(_sendBuf, _data.c_str());
@@ -467,7 +618,7 @@ void BlinkerProtocol::autoFormatData(const String & key, const String & jsonValu
         if ((strlen(_sendBuf) + jsonValue.length()) >= BLINKER_MAX_SEND_BUFFER_SIZE)
         {
             BLINKER_ERR_LOG(BLINKER_F("FORMAT DATA SIZE IS MAX THAN LIMIT"));
-            return;
+            return false;
         }
 
         if (strlen(_sendBuf) > 0) {
@@ -479,6 +630,8 @@ void BlinkerProtocol::autoFormatData(const String & key, const String & jsonValu
             strcpy(_sendBuf, data.c_str());
         }
     #endif
+
+    return true;
 }
 
 // #elif defined(BLINKER_LOWPOWER_AIR202)
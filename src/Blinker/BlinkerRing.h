@@ -0,0 +1,87 @@
+#ifndef BLINKER_RING_H
+#define BLINKER_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Single producer, single consumer queue of fixed slots.
+//
+// One task fills the free slot in place and push()es it, the other reads
+// the oldest slot in place and pop()s it. Each index is written by one
+// side only, so neither side ever waits or takes a lock. A full queue
+// refuses new elements, what to drop is left to the producer.
+//
+// Nothing here is board specific, on a host std::thread can stand in for
+// the two cores.
+
+template <typename T, uint8_t SLOTS>
+class BlinkerRing
+{
+    static_assert(SLOTS && (SLOTS & (SLOTS - 1)) == 0,
+                "ring slots must be a power of two");
+
+    public :
+        BlinkerRing() : _head(0), _tail(0) {}
+
+        // producer side
+        T * back();
+        void push();
+
+        // consumer side
+        T * front();
+        void pop();
+
+        uint8_t size() const;
+        bool full() const                       { return size() == SLOTS; }
+
+    private :
+        T                       _slot[SLOTS];
+        std::atomic<uint32_t>   _head;  // elements popped
+        std::atomic<uint32_t>   _tail;  // elements pushed
+};
+
+// The slot to fill next, NULL when full
+template <typename T, uint8_t SLOTS>
+T * BlinkerRing<T, SLOTS>::back()
+{
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+
+    if (tail - _head.load(std::memory_order_acquire) == SLOTS) return NULL;
+
+    return &_slot[tail % SLOTS];
+}
+
+template <typename T, uint8_t SLOTS>
+void BlinkerRing<T, SLOTS>::push()
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+// The oldest element, NULL when empty
+template <typename T, uint8_t SLOTS>
+T * BlinkerRing<T, SLOTS>::front()
+{
+    uint32_t head = _head.load(std::memory_order_relaxed);
+
+    if (head == _tail.load(std::memory_order_acquire)) return NULL;
+
+    return &_slot[head % SLOTS];
+}
+
+template <typename T, uint8_t SLOTS>
+void BlinkerRing<T, SLOTS>::pop()
+{
+    _head.store(_head.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+template <typename T, uint8_t SLOTS>
+uint8_t BlinkerRing<T, SLOTS>::size() const
+{
+    return _tail.load(std::memory_order_acquire) -
+            _head.load(std::memory_order_acquire);
+}
+
+#endif
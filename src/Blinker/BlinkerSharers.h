@@ -0,0 +1,136 @@
+#ifndef BLINKER_SHARERS_H
+#define BLINKER_SHARERS_H
+
+#include <string.h>
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+#include "../modules/ArduinoJson/ArduinoJson.h"
+
+// Users a device is shared with.
+//
+// Each slot holds a 64 bit FNV-1a hash of the uuid next to the uuid, a
+// message is matched by comparing hashes and only a hit compares the uuid.
+// A fresh list from the server is applied as a diff: sharers still in it
+// keep their slot, dropped ones free theirs, new ones take free slots.
+// A slot number handed out for a reply stays valid across refreshes unless
+// that sharer was removed, then uuid() gives NULL.
+
+class BlinkerSharers
+{
+    public :
+        BlinkerSharers() : _count(0)
+        {
+            memset(_hash, 0, sizeof(_hash));
+            memset(_uuid, 0, sizeof(_uuid));
+        }
+
+        uint8_t find(const char * uuid) const;
+        const char * uuid(uint8_t num) const;
+        uint8_t count() const                   { return _count; }
+
+        void update(const JsonArray & users);
+
+    private :
+        uint64_t    _hash[BLINKER_MQTT_MAX_SHARERS_NUM];    // 0 marks a free slot
+        char        _uuid[BLINKER_MQTT_MAX_SHARERS_NUM][BLINKER_MQTT_USER_UUID_SIZE + 1];
+        uint8_t     _count;
+
+        static uint64_t hash(const char * uuid);
+        static bool valid(const char * uuid);
+};
+
+uint64_t BlinkerSharers::hash(const char * uuid)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (*uuid)
+    {
+        h ^= (uint8_t)*uuid++;
+        h *= 0x100000001b3ULL;
+    }
+
+    return h ? h : 1;
+}
+
+bool BlinkerSharers::valid(const char * uuid)
+{
+    return uuid && strlen(uuid) == BLINKER_MQTT_USER_UUID_SIZE;
+}
+
+// The slot of uuid, BLINKER_MQTT_FROM_AUTHER when it isn't a sharer
+uint8_t BlinkerSharers::find(const char * uuid) const
+{
+    if (!valid(uuid)) return BLINKER_MQTT_FROM_AUTHER;
+
+    uint64_t h = hash(uuid);
+
+    for (uint8_t num = 0; num < BLINKER_MQTT_MAX_SHARERS_NUM; num++)
+    {
+        if (_hash[num] == h &&
+            memcmp(_uuid[num], uuid, BLINKER_MQTT_USER_UUID_SIZE) == 0)
+        {
+            return num;
+        }
+    }
+
+    return BLINKER_MQTT_FROM_AUTHER;
+}
+
+const char * BlinkerSharers::uuid(uint8_t num) const
+{
+    if (num >= BLINKER_MQTT_MAX_SHARERS_NUM || _hash[num] == 0) return NULL;
+
+    return _uuid[num];
+}
+
+// Like the server list, the first entry that isn't a uuid ends it
+void BlinkerSharers::update(const JsonArray & users)
+{
+    bool    keep[BLINKER_MQTT_MAX_SHARERS_NUM];
+    uint8_t listed = 0;
+
+    memset(keep, 0, sizeof(keep));
+
+    while (listed < BLINKER_MQTT_MAX_SHARERS_NUM &&
+            valid(users[listed].as<const char *>()))
+    {
+        uint8_t num = find(users[listed].as<const char *>());
+
+        if (num < BLINKER_MQTT_MAX_SHARERS_NUM) keep[num] = true;
+
+        listed++;
+    }
+
+    for (uint8_t num = 0; num < BLINKER_MQTT_MAX_SHARERS_NUM; num++)
+    {
+        if (_hash[num] == 0 || keep[num]) continue;
+
+        BLINKER_LOG_ALL(BLINKER_F("sharer removed: "), _uuid[num]);
+
+        _hash[num] = 0;
+        _uuid[num][0] = '\0';
+        _count--;
+    }
+
+    for (uint8_t user = 0; user < listed; user++)
+    {
+        const char * uuid = users[user].as<const char *>();
+
+        if (find(uuid) < BLINKER_MQTT_MAX_SHARERS_NUM) continue;
+
+        for (uint8_t num = 0; num < BLINKER_MQTT_MAX_SHARERS_NUM; num++)
+        {
+            if (_hash[num]) continue;
+
+            BLINKER_LOG_ALL(BLINKER_F("sharer added: "), uuid, BLINKER_F(", slot: "), num);
+
+            _hash[num] = hash(uuid);
+            memcpy(_uuid[num], uuid, BLINKER_MQTT_USER_UUID_SIZE + 1);
+            _count++;
+            break;
+        }
+    }
+}
+
+#endif
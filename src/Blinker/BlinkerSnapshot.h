@@ -0,0 +1,363 @@
+#ifndef BLINKER_SNAPSHOT_H
+#define BLINKER_SNAPSHOT_H
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+
+// Last known state of every widget, served as a whole on a heartbeat.
+//
+// A widget print only carries the attributes that changed, the snapshot
+// merges them in place into the object it keeps for that widget. All of
+// them share one buffer of BLINKER_SNAPSHOT_SIZE bytes, a print costs no
+// allocation. The full state is packed into as few messages of at most
+// BLINKER_SNAPSHOT_PACKET_SIZE bytes as first-fit decreasing finds, and the
+// packets are kept until a widget changes, so heartbeats in a row reuse the
+// same bytes.
+
+class BlinkerSnapshot
+{
+    public :
+        BlinkerSnapshot()
+            : _count(0), _used(0), _packed(NULL), _packets(0)
+            , _dirty(false), _printed(false), _collected(0), _hasCollected(false)
+        {}
+
+        void update(const char * key, const char * value);
+
+        // The heartbeat callback may only be skipped when widgets were
+        // printed since it last ran, from the loop then, and for no longer
+        // than BLINKER_SNAPSHOT_TTL. A sketch printing from the callback
+        // alone has it run on every heartbeat.
+        bool stale(uint32_t now) const
+        {
+            return !_hasCollected || _count == 0 || !_printed ||
+                    (now - _collected) >= BLINKER_SNAPSHOT_TTL;
+        }
+        void collected(uint32_t now)
+        {
+            _collected = now;
+            _hasCollected = true;
+            _printed = false;
+        }
+
+        uint8_t pack();
+        const char * packet(uint8_t num) const;
+
+        uint8_t count() const           { return _count; }
+
+    private :
+        // key '\0' value '\0' of every widget, one after the other
+        char        _buf[BLINKER_SNAPSHOT_SIZE];
+        uint16_t    _at[BLINKER_SNAPSHOT_NUM];
+        uint8_t     _count;
+        uint16_t    _used;
+        char *      _packed;
+        uint8_t     _packets;
+        bool        _dirty;
+        bool        _printed;
+        uint32_t    _collected;
+        bool        _hasCollected;
+
+        const char * key(uint8_t num) const     { return _buf + _at[num]; }
+        const char * value(uint8_t num) const
+        {
+            return key(num) + strlen(key(num)) + 1;
+        }
+
+        size_t length(uint8_t num) const
+        {
+            return strlen(key(num)) + strlen(value(num)) + 3;
+        }
+
+        static bool member(const char *& p, const char *& key, size_t & klen,
+                            const char *& end);
+        static bool contains(const char * obj, const char * key, size_t klen);
+        static size_t merge(const char * old, const char * value, char * out, size_t room);
+        static void reverse(char * from, char * to);
+};
+
+// Steps over the next member of a json object, p starts after the '{' or a
+// ','. The member spans from key - 1 to end.
+bool BlinkerSnapshot::member(const char *& p, const char *& key, size_t & klen,
+                            const char *& end)
+{
+    while (*p == ' ' || *p == ',') p++;
+
+    if (*p != '"') return false;
+
+    key = ++p;
+    while (*p && *p != '"') p += (*p == '\\' && p[1]) ? 2 : 1;
+    if (*p != '"') return false;
+    klen = p - key;
+
+    int8_t depth = 0;
+    bool quoted = false;
+
+    for (p++; *p; p++)
+    {
+        if (quoted)
+        {
+            if (*p == '\\' && p[1]) p++;
+            else if (*p == '"') quoted = false;
+        }
+        else if (*p == '"') quoted = true;
+        else if (*p == '[' || *p == '{') depth++;
+        else if (*p == ']' || *p == '}')
+        {
+            if (depth == 0) break;
+            depth--;
+        }
+        else if (*p == ',' && depth == 0) break;
+    }
+
+    end = p;
+
+    return *p != '\0';
+}
+
+bool BlinkerSnapshot::contains(const char * obj, const char * key, size_t klen)
+{
+    const char * p = obj + 1;
+    const char * k;
+    const char * end;
+    size_t len;
+
+    while (member(p, k, len, end))
+    {
+        if (len == klen && memcmp(k, key, klen) == 0) return true;
+    }
+
+    return false;
+}
+
+// The members of value followed by the members of old it doesn't set, 0
+// when it takes more than room bytes
+size_t BlinkerSnapshot::merge(const char * old, const char * value, char * out, size_t room)
+{
+    size_t vlen = strlen(value);
+
+    if (vlen + 1 > room) return 0;
+
+    memcpy(out, value, vlen - 1);
+    char * o = out + vlen - 1;
+
+    const char * p = old + 1;
+    const char * key;
+    const char * end;
+    size_t klen;
+
+    while (member(p, key, klen, end))
+    {
+        if (contains(value, key, klen)) continue;
+
+        size_t len = end - key + 1;
+
+        if ((size_t)(o - out) + len + 3 > room) return 0;
+
+        if (o > out + 1) *o++ = ',';
+        memcpy(o, key - 1, len);
+        o += len;
+    }
+
+    *o++ = '}';
+    *o = '\0';
+
+    return o - out;
+}
+
+void BlinkerSnapshot::reverse(char * from, char * to)
+{
+    while (from < --to)
+    {
+        char c = *from;
+
+        *from++ = *to;
+        *to = c;
+    }
+}
+
+void BlinkerSnapshot::update(const char * key, const char * value)
+{
+    uint8_t num = 0;
+    bool added = false;
+
+    _printed = true;
+
+    while (num < _count && strcmp(this->key(num), key)) num++;
+
+    if (num == _count)
+    {
+        size_t klen = strlen(key);
+
+        if (_count == BLINKER_SNAPSHOT_NUM || _used + klen + 2 > BLINKER_SNAPSHOT_SIZE)
+        {
+            BLINKER_ERR_LOG(BLINKER_F("snapshot full, widget not kept: "), key);
+            return;
+        }
+
+        _at[num] = _used;
+        memcpy(_buf + _used, key, klen + 1);
+        _used += klen + 1;
+        _buf[_used++] = '\0';
+        _count++;
+        added = true;
+    }
+
+    // the new value is put together in the free room behind the last
+    // widget, then swapped in for the old one
+    char * old = (char *)this->value(num);
+    char * out = _buf + _used;
+    size_t room = BLINKER_SNAPSHOT_SIZE - _used;
+    size_t len;
+
+    if (old[0] == '{' && value[0] == '{')
+    {
+        len = merge(old, value, out, room);
+    }
+    else
+    {
+        len = strlen(value);
+
+        if (len + 1 > room) len = 0;
+        else memcpy(out, value, len + 1);
+    }
+
+    if (len == 0 && value[0])
+    {
+        BLINKER_ERR_LOG(BLINKER_F("snapshot full, widget not kept: "), key);
+
+        if (added)
+        {
+            _count--;
+            _used = _at[num];
+        }
+        return;
+    }
+
+    size_t olen = strlen(old);
+
+    if (olen == len && memcmp(old, out, len) == 0) return;
+
+    // old rest new -> rest new -> new rest
+    char * rest = old + olen + 1;
+    size_t rlen = out - rest;
+
+    memmove(old, rest, rlen);
+    memmove(old + rlen, out, len + 1);
+    reverse(old, old + rlen);
+    reverse(old + rlen, old + rlen + len + 1);
+    reverse(old, old + rlen + len + 1);
+
+    for (uint8_t n = num + 1; n < _count; n++) _at[n] = _at[n] + len - olen;
+    _used = _used + len - olen;
+    _dirty = true;
+}
+
+// Number of packets holding the state, rebuilt only after a change
+uint8_t BlinkerSnapshot::pack()
+{
+    if (!_dirty) return _packets;
+
+    uint8_t order[BLINKER_SNAPSHOT_NUM];
+    uint8_t bin[BLINKER_SNAPSHOT_NUM];
+    size_t  used[BLINKER_SNAPSHOT_NUM];
+    size_t  total = 0;
+    uint8_t bins = 0;
+
+    for (uint8_t num = 0; num < _count; num++)
+    {
+        uint8_t at = num;
+
+        while (at && length(order[at - 1]) < length(num))
+        {
+            order[at] = order[at - 1];
+            at--;
+        }
+        order[at] = num;
+    }
+
+    // every packet holds "{" members "}", the braces take the room of the
+    // comma the first member doesn't need
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        uint8_t num = order[i];
+        size_t  len = length(num) + 1;
+
+        if (len + 1 > BLINKER_SNAPSHOT_PACKET_SIZE)
+        {
+            BLINKER_ERR_LOG(BLINKER_F("widget state too long for a packet: "), key(num));
+            bin[num] = BLINKER_SNAPSHOT_NUM;
+            continue;
+        }
+
+        uint8_t b = 0;
+        while (b < bins && used[b] + len > BLINKER_SNAPSHOT_PACKET_SIZE) b++;
+        if (b == bins) used[bins++] = 1;
+
+        bin[num] = b;
+        used[b] += len;
+    }
+
+    for (uint8_t b = 0; b < bins; b++) total += used[b] + 1;
+
+    free(_packed);
+    _packed = (char*)malloc(total ? total : 1);
+    _packets = 0;
+    _dirty = false;
+
+    if (_packed == NULL)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("snapshot alloc failed"));
+        _dirty = true;
+        return 0;
+    }
+
+    char * o = _packed;
+
+    for (uint8_t b = 0; b < bins; b++)
+    {
+        char * start = o;
+
+        for (uint8_t num = 0; num < _count; num++)
+        {
+            if (bin[num] != b) continue;
+
+            char sep = (o == start) ? '{' : ',';
+
+            *o++ = sep;
+            *o++ = '"';
+            strcpy(o, key(num));
+            o += strlen(o);
+            *o++ = '"';
+            *o++ = ':';
+            strcpy(o, value(num));
+            o += strlen(o);
+        }
+
+        *o++ = '}';
+        *o++ = '\0';
+    }
+
+    _packets = bins;
+
+    BLINKER_LOG_ALL(BLINKER_F("snapshot packed, widgets: "), _count,
+                    BLINKER_F(", packets: "), _packets);
+
+    return _packets;
+}
+
+const char * BlinkerSnapshot::packet(uint8_t num) const
+{
+    if (num >= _packets) return NULL;
+
+    const char * p = _packed;
+
+    while (num--) p += strlen(p) + 1;
+
+    return p;
+}
+
+#endif
@@ -11,11 +11,22 @@
 //     #include "Blinker/BlinkerMQTTATBase.h"
 // #endif
 
+#include "BlinkerConfig.h"
 #include "BlinkerUtility.h"
 
+#if !defined(BLINKER_ARDUINOJSON)
+    class BlinkerJsonScanner;
+#endif
+
 class BlinkerStream
 {
     public :
+        #if !defined(BLINKER_ARDUINOJSON)
+            // an adapter reading a byte stream feeds every byte of a
+            // message to scan as it arrives, false if it only has lines
+            virtual bool attachScanner(BlinkerJsonScanner * scan) { return false; }
+        #endif
+
     // #if defined(BLINKER_LOWPOWER_AIR202)
     //     virtual void begin(const char* _key, const char* _deviceType, String _imei) = 0;
     //     virtual char * deviceName() = 0;
@@ -40,13 +51,22 @@ class BlinkerStream
             defined(BLINKER_PRO_ESP) || defined(BLINKER_WIFI_SUBDEVICE)
                 virtual int aliPrint(const String & data) = 0;
                 virtual int duerPrint(const String & data, bool report = false) = 0;
+                // replies built in a buffer, adapters that can send them
+                // without a String override these
+                virtual int aliPrint(const char * data)     { return aliPrint(String(data)); }
+                virtual int duerPrint(const char * data, bool report = false) { return duerPrint(String(data), report); }
                 #if !defined(BLINKER_GPRS_AIR202) && !defined(BLINKER_NBIOT_SIM7020) && \
                     !defined(BLINKER_PRO_SIM7020) && !defined(BLINKER_PRO_AIR202)
                 virtual int miPrint(const String & data) = 0;
+                virtual int miPrint(const char * data)      { return miPrint(String(data)); }
                 #endif
                 // virtual void ping() = 0;
             #if !defined(BLINKER_MQTT_AT)
                 virtual int bPrint(char * name, const String & data) = 0;
+                #if defined(BLINKER_WITH_BRIDGE_LAN)
+                // a bridge key resolved to name, for the LAN path
+                virtual void bridgePeer(const char * name, const char * key) {}
+                #endif
                 virtual int autoPrint(unsigned long id) = 0;
                 virtual void sharers(const String & data);
                 virtual int aligenieAvail() = 0;
@@ -56,6 +76,14 @@ class BlinkerStream
                 virtual int miAvail() = 0;
                 #endif
                 virtual int needFreshShare() = 0;
+                // the sharer a reply goes to, cleared after each print
+                virtual uint8_t replyTo() { return BLINKER_MQTT_FROM_AUTHER; }
+                virtual void replyTo(uint8_t num) {}
+                #if defined(BLINKER_WITH_NET_TASK)
+                // runs job(arg) after every pass of the network task,
+                // false while there's no such task
+                virtual bool netJob(void (*job)(void *), void * arg) { return false; }
+                #endif
             #endif
         #endif
 
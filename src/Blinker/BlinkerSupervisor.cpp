@@ -0,0 +1,113 @@
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+
+#include <string.h>
+
+#include "BlinkerSupervisor.h"
+
+BlinkerSupervisor BLINKER_SUPERVISOR;
+
+BlinkerSupervisor::BlinkerSupervisor()
+    : _rand(0x9E3779B9UL)
+    , _lastFailure(0)
+    , _lastReason(BLINKER_FAIL_NONE)
+    , _rejected(false)
+{
+    memset(_link, 0, sizeof(_link));
+}
+
+uint32_t BlinkerSupervisor::jitter(uint32_t span)
+{
+    // xorshift32, seeded from the hardware rng by the adapters
+    _rand ^= _rand << 13;
+    _rand ^= _rand >> 17;
+    _rand ^= _rand << 5;
+
+    return span ? _rand % span : 0;
+}
+
+void BlinkerSupervisor::hold(uint8_t link, uint32_t now, uint32_t wait)
+{
+    _link[link].waitFrom = now;
+    _link[link].wait = wait;
+}
+
+bool BlinkerSupervisor::ready(uint8_t link, uint32_t now) const
+{
+    return (now - _link[link].waitFrom) >= _link[link].wait;
+}
+
+uint32_t BlinkerSupervisor::retryIn(uint8_t link, uint32_t now) const
+{
+    uint32_t passed = now - _link[link].waitFrom;
+
+    return passed >= _link[link].wait ? 0 : _link[link].wait - passed;
+}
+
+void BlinkerSupervisor::attempt(uint8_t link, uint32_t now)
+{
+    blinker_link_state_t & l = _link[link];
+
+    if (!l.down)
+    {
+        l.down = true;
+        l.downSince = now;
+    }
+    l.attempts++;
+}
+
+void BlinkerSupervisor::success(uint8_t link, uint32_t now)
+{
+    blinker_link_state_t & l = _link[link];
+
+    if (l.down) l.connectTime = now - l.downSince;
+    l.down = false;
+    l.failures = 0;
+    l.connects++;
+    hold(link, now, 0);
+
+    if (link == BLINKER_LINK_AUTH)
+    {
+        // Fresh credentials, the broker gets a new try straight away
+        _rejected = false;
+        _link[BLINKER_LINK_MQTT].failures = 0;
+        hold(BLINKER_LINK_MQTT, now, 0);
+    }
+    else if (link == BLINKER_LINK_WIFI)
+    {
+        // Fast resume, whoever shared the access point comes back with us
+        _link[BLINKER_LINK_MQTT].failures = 0;
+        hold(BLINKER_LINK_MQTT, now, jitter(BLINKER_RECONNECT_BASE));
+    }
+}
+
+void BlinkerSupervisor::failure(uint8_t link, uint32_t now, uint8_t reason)
+{
+    blinker_link_state_t & l = _link[link];
+
+    if (l.failures < 0xFFFF) l.failures++;
+
+    _lastReason = reason;
+    _lastFailure = now;
+    if (reason == BLINKER_FAIL_REJECTED) _rejected = true;
+
+    // An access point takes a while to associate, don't cut it short
+    uint32_t base = link == BLINKER_LINK_WIFI ? BLINKER_RECONNECT_WIFI_BASE
+                                              : BLINKER_RECONNECT_BASE;
+    uint8_t  shift = l.failures - 1 > 16 ? 16 : l.failures - 1;
+    uint32_t window = base << shift;
+
+    if (window > BLINKER_RECONNECT_MAX || window < base)
+    {
+        window = BLINKER_RECONNECT_MAX;
+    }
+
+    hold(link, now, window / 2 + jitter(window / 2 + 1));
+}
+
+bool BlinkerSupervisor::needReauth() const
+{
+    return _rejected ||
+        _link[BLINKER_LINK_MQTT].failures >= BLINKER_RECONNECT_REAUTH;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef BLINKER_SUPERVISOR_H
+#define BLINKER_SUPERVISOR_H
+
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include <Arduino.h>
+    #else
+        #include <WProgram.h>
+    #endif
+#else
+    #include <stdint.h>
+#endif
+
+#include "BlinkerConfig.h"
+
+// Paces reconnects of the WiFi, MQTT and cloud auth links.
+//
+// Every failure doubles the retry window of its link up to a cap and waits a
+// random time inside the upper half of it, devices dropped by the same
+// outage don't come back in lockstep. A MQTT link that comes back with
+// WiFi resumes with its cached credentials after a short jitter. Only a
+// broker rejection or too many failed resumes ask for a new cloud auth.
+//
+// Time is passed in by the caller, nothing here touches the hardware.
+
+enum blinker_link_t
+{
+    BLINKER_LINK_WIFI,
+    BLINKER_LINK_MQTT,
+    BLINKER_LINK_AUTH,
+    BLINKER_LINK_NUM
+};
+
+enum blinker_fail_t
+{
+    BLINKER_FAIL_NONE,
+    BLINKER_FAIL_WIFI,
+    BLINKER_FAIL_MQTT,
+    BLINKER_FAIL_REJECTED,
+    BLINKER_FAIL_AUTH
+};
+
+class BlinkerSupervisor
+{
+    public :
+        BlinkerSupervisor();
+
+        void seed(uint32_t s)                   { if (s) _rand = s; }
+
+        bool ready(uint8_t link, uint32_t now) const;
+        void attempt(uint8_t link, uint32_t now);
+        void success(uint8_t link, uint32_t now);
+        void failure(uint8_t link, uint32_t now, uint8_t reason);
+        uint32_t retryIn(uint8_t link, uint32_t now) const;
+
+        bool needReauth() const;
+
+        uint32_t attempts(uint8_t link) const   { return _link[link].attempts; }
+        uint32_t connects(uint8_t link) const   { return _link[link].connects; }
+        uint16_t failures(uint8_t link) const   { return _link[link].failures; }
+        uint32_t connectTime(uint8_t link) const{ return _link[link].connectTime; }
+        uint8_t  lastReason() const             { return _lastReason; }
+        uint32_t lastFailure() const            { return _lastFailure; }
+
+    private :
+        struct blinker_link_state_t
+        {
+            uint32_t attempts;
+            uint32_t connects;
+            uint32_t downSince;
+            uint32_t waitFrom;
+            uint32_t wait;
+            uint32_t connectTime;
+            uint16_t failures;
+            bool     down;
+        };
+
+        blinker_link_state_t    _link[BLINKER_LINK_NUM];
+        uint32_t                _rand;
+        uint32_t                _lastFailure;
+        uint8_t                 _lastReason;
+        bool                    _rejected;
+
+        uint32_t jitter(uint32_t span);
+        void hold(uint8_t link, uint32_t now, uint32_t wait);
+};
+
+extern BlinkerSupervisor BLINKER_SUPERVISOR;
+
+#endif
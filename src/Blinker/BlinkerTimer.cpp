@@ -3,9 +3,10 @@
 #include "BlinkerConfig.h"
 #include "BlinkerDebug.h"
 #include "BlinkerTimer.h"
+#include "BlinkerEventLoop.h"
 
-Ticker cdTicker;
-Ticker lpTicker;
+BlinkerWheelTimer cdTicker;
+BlinkerWheelTimer lpTicker;
 Ticker tmTicker;
 
 bool _cdRunState = false;
@@ -32,9 +33,7 @@ uint32_t _cdData;
 // bool     _cdStop = true;
 
 uint32_t _lpTime1;
-uint32_t _lpTime1_start;
 uint32_t _lpTime2;
-uint32_t _lpTime2_start;
 uint32_t _lpData;
 bool     _lpStop = true;
 
@@ -56,56 +55,15 @@ void disableTimer() {
 
 void _cd_callback()
 {
-    uint32_t cd_during = millis() -_cdStart;
-    uint32_t cd_remain = _cdTime1 * 60 - cd_during / 1000;
-
-    if (_cdTime1 * 60 > BLINKER_ONE_HOUR_TIME) {
-        if (cd_remain > 0) {
-            if (cd_remain > BLINKER_ONE_HOUR_TIME) cd_remain = BLINKER_ONE_HOUR_TIME;
-
-            cdTicker.once(cd_remain, _cd_callback);
-
-            return;
-        }
-    }
     // _cdState = false;
     _cdTrigged = true;
+    BLINKER_LOOP.signal(BLINKER_EVENT_TIMER);
     
     BLINKER_LOG_ALL(BLINKER_F("countdown trigged!"));
 }
 
 void _lp_callback()
 {
-    if (_lpRun1) {
-        uint32_t lp_1_during = millis() -_lpTime1_start;
-        uint32_t lp_1_remain = _lpTime1 * 60 - lp_1_during / 1000;
-
-        if (_lpTime1 * 60 > BLINKER_ONE_HOUR_TIME) {
-            if (lp_1_remain > 0) {
-                if (lp_1_remain > BLINKER_ONE_HOUR_TIME) lp_1_remain = BLINKER_ONE_HOUR_TIME;
-
-                lpTicker.once(lp_1_remain, _lp_callback);
-
-                return;
-            }
-        }
-    }
-    else {
-        uint32_t lp_2_during = millis() -_lpTime2_start;
-        uint32_t lp_2_remain = _lpTime2 * 60 - lp_2_during / 1000;
-
-        if (_lpTime2 * 60 > BLINKER_ONE_HOUR_TIME) {
-            if (lp_2_remain > 0) {
-                if (lp_2_remain > BLINKER_ONE_HOUR_TIME) lp_2_remain = BLINKER_ONE_HOUR_TIME;
-
-                lpTicker.once(lp_2_remain, _lp_callback);
-
-                return;
-            }
-        }
-    }
-
-
     _lpRun1 = !_lpRun1;
     if (_lpRun1) {
         _lpTrigged_times++;
@@ -127,6 +85,7 @@ void _lp_callback()
         lpTicker.once(_lpTime2 * 60, _lp_callback);
     }
     _lpTrigged = true;
+    BLINKER_LOOP.signal(BLINKER_EVENT_TIMER);
 
     BLINKER_LOG_ALL(BLINKER_F("loop trigged!"));
 }
@@ -136,6 +95,7 @@ void timingHandle(uint8_t cbackData)
     uint8_t task = cbackData;
     
     _tmTrigged = true;
+    BLINKER_LOOP.signal(BLINKER_EVENT_TIMER);
 
     triggedTask = task;
 }
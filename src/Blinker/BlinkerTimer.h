@@ -6,8 +6,11 @@
 #include <Ticker.h>
 #include <EEPROM.h>
 
-extern Ticker cdTicker;
-extern Ticker lpTicker;
+#include "BlinkerWheel.h"
+
+// countdown and loop run on the wheel, the whole time in one go
+extern BlinkerWheelTimer cdTicker;
+extern BlinkerWheelTimer lpTicker;
 extern Ticker tmTicker;
 
 extern bool _cdRunState;
@@ -34,9 +37,7 @@ extern uint32_t _cdData;
 // bool     _cdStop = true;
 
 extern uint32_t _lpTime1;
-extern uint32_t _lpTime1_start;
 extern uint32_t _lpTime2;
-extern uint32_t _lpTime2_start;
 extern uint32_t _lpData;
 extern bool     _lpStop;
 
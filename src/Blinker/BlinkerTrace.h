@@ -0,0 +1,112 @@
+#ifndef BLINKER_TRACE_H
+#define BLINKER_TRACE_H
+
+#if defined(BLINKER_WITH_TRACE)
+
+#include <stdio.h>
+
+#include "BlinkerConfig.h"
+#include "BlinkerDebug.h"
+
+// Post-mortem trace of the connection life cycle.
+//
+// BLINKER_TRACE(id, a, b) stores the event id, millis() and two integers in
+// a RAM ring, nothing is formatted when recording. The ring is read back
+// after an incident with dump() over serial or with a {"get":"trace"}
+// query, the newest events answer first. The event ids are in BlinkerDebug.h
+// so the adapters can trace before this header is included.
+
+struct blinker_trace_t
+{
+    uint32_t    time;
+    int32_t     a;
+    int32_t     b;
+    uint16_t    id;
+};
+
+class BlinkerTrace
+{
+    public :
+        BlinkerTrace() : _head(0), _count(0) {}
+
+        void add(uint16_t id, int32_t a, int32_t b);
+        void clear()            { _head = 0; _count = 0; }
+        uint8_t count() const   { return _count; }
+
+        void dump(Stream & s) const;
+        void json(String & out, size_t limit) const;
+
+    private :
+        blinker_trace_t _ring[BLINKER_TRACE_SIZE];
+        uint8_t         _head;
+        uint8_t         _count;
+
+        const blinker_trace_t & at(uint8_t age) const;
+        size_t format(const blinker_trace_t & e, char * buf, size_t len) const;
+};
+
+BlinkerTrace BLINKER_TRACE_RING;
+
+void blinker_trace(uint16_t id, int32_t a, int32_t b)
+{
+    BLINKER_TRACE_RING.add(id, a, b);
+}
+
+void BlinkerTrace::add(uint16_t id, int32_t a, int32_t b)
+{
+    blinker_trace_t & e = _ring[_head];
+
+    e.time = millis();
+    e.id = id;
+    e.a = a;
+    e.b = b;
+
+    _head = (_head + 1) % BLINKER_TRACE_SIZE;
+    if (_count < BLINKER_TRACE_SIZE) _count++;
+}
+
+// age 0 is the newest event
+const blinker_trace_t & BlinkerTrace::at(uint8_t age) const
+{
+    return _ring[(_head + BLINKER_TRACE_SIZE - 1 - age) % BLINKER_TRACE_SIZE];
+}
+
+size_t BlinkerTrace::format(const blinker_trace_t & e, char * buf, size_t len) const
+{
+    return snprintf(buf, len, "[%lu,%u,%ld,%ld]", (unsigned long)e.time,
+                    (unsigned)e.id, (long)e.a, (long)e.b);
+}
+
+void BlinkerTrace::dump(Stream & s) const
+{
+    char buf[48];
+
+    s.println(BLINKER_F("trace [ms,id,a,b]:"));
+    for (uint8_t age = _count; age > 0; age--)
+    {
+        format(at(age - 1), buf, sizeof(buf));
+        s.println(buf);
+    }
+}
+
+// Newest first, stops before out grows over limit
+void BlinkerTrace::json(String & out, size_t limit) const
+{
+    char buf[48];
+
+    out = BLINKER_F("[");
+    for (uint8_t age = 0; age < _count; age++)
+    {
+        size_t len = format(at(age), buf, sizeof(buf));
+
+        if (out.length() + len + 2 > limit) break;
+
+        if (age) out += BLINKER_F(",");
+        out += buf;
+    }
+    out += BLINKER_F("]");
+}
+
+#endif
+
+#endif
@@ -36,6 +36,20 @@ String macDeviceName()
 }
 #endif
 
+uint32_t BlinkerCRC32(const char * data, size_t len, uint32_t crc)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= (uint8_t)*data++;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
 String STRING_find_string(const String & src, const String & targetStart, const String & targetEnd, uint8_t skipNum) {
     int addr_start = src.indexOf(targetStart);
     int addr_end;
@@ -91,6 +91,11 @@ extern "C" {
                     _id = nodeId;
                     _authState = false;
                     _new = true;
+                    _name = NULL;
+                    _key = NULL;
+                    _type = NULL;
+                    _auth = NULL;
+                    _dId = NULL;
                 }
 
                 bool isNew() { return _new; }
@@ -101,6 +106,7 @@ extern "C" {
                     const String & type, uint16_t vas)
                 {
                     _new = false;
+                    free(_name); free(_key); free(_type);
                     _name = (char*)malloc((name.length()+1)*sizeof(char));
                     strcpy(_name, name.c_str());
                     _key = (char*)malloc((key.length()+1)*sizeof(char));
@@ -117,6 +123,7 @@ extern "C" {
 
                 void authData(const String & key, const String & name)
                 {
+                    free(_auth); free(_dId);
                     _auth = (char*)malloc((key.length()+1)*sizeof(char));
                     strcpy(_auth, key.c_str());
                     _dId = (char*)malloc((name.length()+1)*sizeof(char));
@@ -173,6 +180,8 @@ const T& BlinkerMin(const T& a, const T& b) { return (b < a) ? b : a; }
 template<class T>
 const T& BlinkerMax(const T& a, const T& b) { return (b < a) ? a : b; }
 
+uint32_t BlinkerCRC32(const char * data, size_t len, uint32_t crc = 0);
+
 String STRING_find_string(const String & src, const String & targetStart, const String & targetEnd, uint8_t skipNum);
 
 bool STRING_contains_string(const String & src, const String & key);
@@ -0,0 +1,236 @@
+#if defined(ESP8266) || defined(ESP32)
+
+#include <string.h>
+
+#include "BlinkerWheel.h"
+#include "BlinkerDebug.h"
+
+#define BLINKER_WHEEL_MASK  (BLINKER_WHEEL_SLOTS - 1)
+
+BlinkerWheel BLINKER_WHEEL;
+
+void BlinkerWheelTimer::arm(uint32_t ms, uint32_t period, blinker_wheel_callback_t func)
+{
+    detach();
+
+    uint32_t base = BLINKER_WHEEL._running ? BLINKER_WHEEL._time - 1
+                                            : BLINKER_WHEEL.now(millis());
+
+    if (ms > BLINKER_WHEEL_MAX_DELAY) ms = BLINKER_WHEEL_MAX_DELAY;
+
+    _expires = base + ms;
+    _period = period;
+    _func = func;
+
+    BLINKER_WHEEL.add(this);
+    BLINKER_WHEEL._count++;
+}
+
+void BlinkerWheelTimer::detach()
+{
+    if (_pprev == NULL) return;
+
+    *_pprev = _next;
+    if (_next) _next->_pprev = _pprev;
+
+    _next = NULL;
+    _pprev = NULL;
+
+    BLINKER_WHEEL._count--;
+}
+
+BlinkerWheel::BlinkerWheel()
+    : _time(0)
+    , _count(0)
+    , _running(false)
+    , _baseMs(0)
+    , _baseTime(0)
+    , _ppm(0)
+    , _synced(false)
+    , _syncMs(0)
+    , _syncUnix(0)
+{
+    memset(_slot, 0, sizeof(_slot));
+}
+
+uint32_t BlinkerWheel::now(uint32_t ms) const
+{
+    uint32_t elapsed = ms - _baseMs;
+
+    return _baseTime + elapsed + (int32_t)((int64_t)elapsed * _ppm / 1000000);
+}
+
+void BlinkerWheel::rebase(uint32_t ms)
+{
+    _baseTime = now(ms);
+    _baseMs = ms;
+}
+
+// Links t in the slot of the level its delay falls in
+void BlinkerWheel::add(BlinkerWheelTimer * t)
+{
+    uint32_t expires = t->_expires;
+    uint32_t delay = expires - _time;
+    uint8_t  level = 0;
+
+    if ((int32_t)delay < 0)
+    {
+        expires = _time;
+    }
+    else
+    {
+        while (level < BLINKER_WHEEL_LEVELS - 1 &&
+                delay >> (BLINKER_WHEEL_BITS * (level + 1)))
+        {
+            level++;
+        }
+
+        // beyond the last level, placed again when that slot comes down
+        if (delay >> (BLINKER_WHEEL_BITS * BLINKER_WHEEL_LEVELS))
+        {
+            expires = _time + (1UL << (BLINKER_WHEEL_BITS * BLINKER_WHEEL_LEVELS)) - 1;
+        }
+    }
+
+    BlinkerWheelTimer ** head =
+        &_slot[level][(expires >> (BLINKER_WHEEL_BITS * level)) & BLINKER_WHEEL_MASK];
+
+    t->_next = *head;
+    if (t->_next) t->_next->_pprev = &t->_next;
+    t->_pprev = head;
+    *head = t;
+}
+
+// Moves the current slot of level down to the levels below it
+void BlinkerWheel::cascade(uint8_t level)
+{
+    uint8_t num = (_time >> (BLINKER_WHEEL_BITS * level)) & BLINKER_WHEEL_MASK;
+    BlinkerWheelTimer * list = _slot[level][num];
+
+    _slot[level][num] = NULL;
+
+    while (list)
+    {
+        BlinkerWheelTimer * t = list;
+
+        list = t->_next;
+        add(t);
+    }
+}
+
+void BlinkerWheel::advance(uint32_t ms)
+{
+    if ((ms - _baseMs) >= (1UL << 20)) rebase(ms);
+
+    uint32_t target = now(ms);
+
+    while ((int32_t)(target - _time) >= 0)
+    {
+        if (_count == 0)
+        {
+            _time = target + 1;
+            break;
+        }
+
+        uint8_t num = _time & BLINKER_WHEEL_MASK;
+
+        if (num == 0)
+        {
+            for (uint8_t level = 1; level < BLINKER_WHEEL_LEVELS; level++)
+            {
+                cascade(level);
+
+                if ((_time >> (BLINKER_WHEEL_BITS * level)) & BLINKER_WHEEL_MASK) break;
+            }
+        }
+
+        BlinkerWheelTimer * list = _slot[0][num];
+
+        _slot[0][num] = NULL;
+        if (list) list->_pprev = &list;
+
+        _time++;
+        _running = true;
+
+        while (list)
+        {
+            BlinkerWheelTimer * t = list;
+            blinker_wheel_callback_t func = t->_func;
+
+            t->detach();
+
+            if (t->_period)
+            {
+                // keeps the phase, skips the periods the loop missed
+                uint32_t late = _time - 1 - t->_expires;
+
+                t->_expires += (late / t->_period + 1) * t->_period;
+
+                add(t);
+                _count++;
+            }
+
+            if (func) func();
+        }
+
+        _running = false;
+    }
+}
+
+uint32_t BlinkerWheel::idleFor(uint32_t ms, uint32_t limit)
+{
+    if (_count == 0) return limit;
+
+    // higher levels only come down when level 0 wraps
+    uint32_t due = (_time + BLINKER_WHEEL_MASK) & ~(uint32_t)BLINKER_WHEEL_MASK;
+
+    for (uint8_t num = 0; num < BLINKER_WHEEL_SLOTS; num++)
+    {
+        if (_slot[0][(_time + num) & BLINKER_WHEEL_MASK])
+        {
+            if ((int32_t)(_time + num - due) < 0) due = _time + num;
+            break;
+        }
+    }
+
+    int32_t left = (int32_t)(due - now(ms));
+
+    if (left <= 0) return 0;
+
+    return (uint32_t)left < limit ? left : limit;
+}
+
+// The rate millis() runs at against NTP, from two readings far enough apart
+void BlinkerWheel::sync(uint32_t ms, uint64_t unixMs)
+{
+    if (!_synced)
+    {
+        _synced = true;
+        _syncMs = ms;
+        _syncUnix = unixMs;
+        return;
+    }
+
+    uint32_t local = ms - _syncMs;
+
+    if (local < BLINKER_WHEEL_SYNC_TIME / 2) return;
+
+    int64_t real = (int64_t)(unixMs - _syncUnix);
+    int64_t ppm = (real - (int64_t)local) * 1000000 / (int64_t)local;
+
+    _syncMs = ms;
+    _syncUnix = unixMs;
+
+    if (ppm > BLINKER_WHEEL_MAX_PPM || ppm < -BLINKER_WHEEL_MAX_PPM)
+    {
+        BLINKER_LOG_ALL(BLINKER_F("ntp time stepped, drift kept: "), _ppm);
+        return;
+    }
+
+    rebase(ms);
+    _ppm = (int32_t)ppm;
+
+    BLINKER_LOG_ALL(BLINKER_F("timer drift ppm: "), _ppm);
+}
+
+#endif
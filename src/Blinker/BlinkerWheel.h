@@ -0,0 +1,118 @@
+#ifndef BLINKER_WHEEL_H
+#define BLINKER_WHEEL_H
+
+#if defined(ARDUINO)
+    #if ARDUINO >= 100
+        #include <Arduino.h>
+    #else
+        #include <WProgram.h>
+    #endif
+#else
+    #include <stdint.h>
+    #include <stddef.h>
+#endif
+
+#include "BlinkerConfig.h"
+
+// Software timers on a hierarchical timing wheel.
+//
+// Five levels of 64 slots each cover 1 ms, 64 ms, 4 s, 4.4 min and 4.7 h
+// per slot, 12 days in all. Arming a timer puts it in the slot of the
+// level its delay falls in, firing takes the current level 0 slot as a
+// whole, a higher slot is moved down a level each time the one below
+// wraps. Both are O(1) whatever the number of timers. Longer delays wait
+// in the last level and are placed again as the wheel turns.
+//
+// The wheel runs on millis() corrected by the drift measured against NTP
+// time, sync() is fed the unix time now and then. Callbacks run from
+// advance(), on the loop, not from an interrupt. A timer armed from a
+// callback counts from the tick that fired, so chained steps don't drift.
+
+extern "C" {
+    typedef void (*blinker_wheel_callback_t)(void);
+}
+
+class BlinkerWheel;
+
+class BlinkerWheelTimer
+{
+    public :
+        BlinkerWheelTimer()
+            : _next(NULL), _pprev(NULL), _expires(0), _period(0), _func(NULL)
+        {}
+        ~BlinkerWheelTimer()                    { detach(); }
+
+        // same calls as the ESP Ticker, attach repeats
+        void once(float seconds, blinker_wheel_callback_t func)
+        {
+            once_ms((uint32_t)(seconds * 1000.0), func);
+        }
+        void once_ms(uint32_t ms, blinker_wheel_callback_t func)
+        {
+            arm(ms, 0, func);
+        }
+        void attach(float seconds, blinker_wheel_callback_t func)
+        {
+            attach_ms((uint32_t)(seconds * 1000.0), func);
+        }
+        void attach_ms(uint32_t ms, blinker_wheel_callback_t func)
+        {
+            arm(ms, ms ? ms : 1, func);
+        }
+        void detach();
+
+        bool active() const                     { return _pprev != NULL; }
+
+    private :
+        BlinkerWheelTimer *         _next;
+        BlinkerWheelTimer **        _pprev;     // the pointer pointing here
+        uint32_t                    _expires;
+        uint32_t                    _period;
+        blinker_wheel_callback_t    _func;
+
+        void arm(uint32_t ms, uint32_t period, blinker_wheel_callback_t func);
+
+        BlinkerWheelTimer(const BlinkerWheelTimer &);
+        BlinkerWheelTimer & operator=(const BlinkerWheelTimer &);
+
+        friend class BlinkerWheel;
+};
+
+class BlinkerWheel
+{
+    public :
+        BlinkerWheel();
+
+        void advance(uint32_t ms);
+        void sync(uint32_t ms, uint64_t unixMs);
+
+        // ms the loop may sleep before a timer can be due, limit at most
+        uint32_t idleFor(uint32_t ms, uint32_t limit);
+
+        uint32_t now(uint32_t ms) const;
+        int32_t ppm() const                     { return _ppm; }
+        uint16_t count() const                  { return _count; }
+
+    private :
+        BlinkerWheelTimer * _slot[BLINKER_WHEEL_LEVELS][BLINKER_WHEEL_SLOTS];
+        uint32_t            _time;      // next tick to run
+        uint16_t            _count;
+        bool                _running;
+
+        uint32_t            _baseMs;
+        uint32_t            _baseTime;
+        int32_t             _ppm;
+        bool                _synced;
+        uint32_t            _syncMs;
+        uint64_t            _syncUnix;
+
+        void add(BlinkerWheelTimer * t);
+        void cascade(uint8_t level);
+        void rebase(uint32_t ms);
+
+        friend class BlinkerWheelTimer;
+};
+
+extern BlinkerWheel BLINKER_WHEEL;
+
+#endif
@@ -23,6 +23,11 @@ class BlinkerESPGateway : public BlinkerApi
             BLINKER_LOG(BLINKER_F("ESP_Gateway initialized..."));
         }
 
+        void meshWeight(uint8_t priority, uint16_t weight)
+        { Transp.meshWeight(priority, weight); }
+        uint32_t meshQueueDepth(uint8_t priority)
+        { return Transp.meshQueueDepth(priority); }
+
     private :
         BlinkerGateway Transp;
 };
@@ -3,6 +3,7 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerVoice.h"
 
 class BLINKERALIGENIE
 {
@@ -66,313 +67,104 @@ class BLINKERALIGENIE
 
         void powerState(const String & state, uint8_t num)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_POWERSTATE);
-            payload += BLINKER_F("\":\"");
-            payload += state;
-            if (num != 0)
-            {
-                payload += BLINKER_F("\",\"num\":");
-                payload += STRING_format(num);
-            }
-            else
-            {
-                payload += BLINKER_F("\"");
-            }            
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 0 & 0x01) {
-                free(aState);
-            }
-
-            aState = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aState, payload.c_str());
+            aState.set(state);
+            aNum = num;
 
             _fresh |= 0x01 << 0;
         }
 
         void powerState(const String & state)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_POWERSTATE);
-            payload += BLINKER_F("\":\"");
-            payload += state;
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 0 & 0x01) {
-                free(aState);
-            }
-
-            aState = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aState, payload.c_str());
-
-            _fresh |= 0x01 << 0;
+            powerState(state, 0);
         }
 
         void color(const String & clr)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_COLOR_);
-            payload += BLINKER_F("\":\"");
-            payload += clr;
-            payload += BLINKER_F("\",");
-            payload += BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_COLOR);
-            payload += BLINKER_F("\":\"");
-            payload += clr;
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 1 & 0x01) {
-                free(aColor);
-            }
-
-            aColor = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aColor, payload.c_str());
+            aColor.set(clr);
 
             _fresh |= 0x01 << 1;
         }
 
         void mode(const String & md)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_MODE);
-            payload += BLINKER_F("\":\"");
-            payload += md;
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 2 & 0x01) {
-                free(aMode);
-            }
-
-            aMode = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aMode, payload.c_str());
+            aMode.set(md);
 
             _fresh |= 0x01 << 2;
         }
 
         void colorTemp(int clrTemp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_COLORTEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(clrTemp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 3 & 0x01) {
-                free(aCtemp);
-            }
-
-            aCtemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aCtemp, payload.c_str());
+            aCtemp.set((int32_t)clrTemp);
 
             _fresh |= 0x01 << 3;
         }
 
         void brightness(int bright)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_BRIGHTNESS);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(bright);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 4 & 0x01) {
-                free(aBright);
-            }
-
-            aBright = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aBright, payload.c_str());
+            aBright.set((int32_t)bright);
 
             _fresh |= 0x01 << 4;
         }
 
         void temp(double _temp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_TEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_temp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 5 & 0x01) {
-                free(aTemp);
-            }
-
-            aTemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aTemp, payload.c_str());
+            aTemp.set(_temp);
 
             _fresh |= 0x01 << 5;
         }
 
         void temp(float _temp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_TEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_temp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 5 & 0x01) {
-                free(aTemp);
-            }
-
-            aTemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aTemp, payload.c_str());
+            aTemp.set((double)_temp);
 
             _fresh |= 0x01 << 5;
         }
 
         void temp(int _temp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_TEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_temp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 5 & 0x01) {
-                free(aTemp);
-            }
-
-            aTemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aTemp, payload.c_str());
+            aTemp.set((int32_t)_temp);
 
             _fresh |= 0x01 << 5;
         }
 
         void humi(double _humi)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_HUMI);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_humi);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 6 & 0x01) {
-                free(aHumi);
-            }
-
-            aHumi = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aHumi, payload.c_str());
+            aHumi.set(_humi);
 
             _fresh |= 0x01 << 6;
         }
 
         void humi(float _humi)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_HUMI);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_humi);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 6 & 0x01) {
-                free(aHumi);
-            }
-
-            aHumi = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aHumi, payload.c_str());
+            aHumi.set((double)_humi);
 
             _fresh |= 0x01 << 6;
         }
 
         void humi(int _humi)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_HUMI);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_humi);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 6 & 0x01) {
-                free(aHumi);
-            }
-
-            aHumi = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aHumi, payload.c_str());
+            aHumi.set((int32_t)_humi);
 
             _fresh |= 0x01 << 6;
         }
 
         void pm25(double _pm25)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_PM25);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_pm25);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 7 & 0x01) {
-                free(aPm25);
-            }
-
-            aPm25 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aPm25, payload.c_str());
+            aPm25.set(_pm25);
 
             _fresh |= 0x01 << 7;
         }
 
         void pm25(float _pm25)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_PM25);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_pm25);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 7 & 0x01) {
-                free(aPm25);
-            }
-
-            aPm25 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aPm25, payload.c_str());
+            aPm25.set((double)_pm25);
 
             _fresh |= 0x01 << 7;
         }
 
         void pm25(int _pm25)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_PM25);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_pm25);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 7 & 0x01) {
-                free(aPm25);
-            }
-
-            aPm25 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aPm25, payload.c_str());
+            aPm25.set((int32_t)_pm25);
 
             _fresh |= 0x01 << 7;
         }
@@ -380,97 +172,83 @@ class BLINKERALIGENIE
         void print()
         {
             if (_fresh == 0) return;
-            
-            String aliData;
+
+            BlinkerVoicePayload aliData;
 
             if (_fresh >> 0 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aState;
-                
-                free(aState);
+                aliData.key(BLINKER_CMD_POWERSTATE);
+                aliData.str(aState.text);
+
+                if (aNum != 0)
+                {
+                    BlinkerVoiceValue num;
+                    num.set((uint32_t)aNum);
+
+                    aliData.key(BLINKER_CMD_NUM);
+                    aliData.raw(num.text);
+                }
             }
 
             if (_fresh >> 1 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aColor;
-                
-                free(aColor);
+                aliData.key(BLINKER_CMD_COLOR_);
+                aliData.str(aColor.text);
+                aliData.key(BLINKER_CMD_COLOR);
+                aliData.str(aColor.text);
             }
 
             if (_fresh >> 2 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aMode;
-                
-                free(aMode);
+                aliData.key(BLINKER_CMD_MODE);
+                aliData.str(aMode.text);
             }
 
             if (_fresh >> 3 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aCtemp;
-                
-                free(aCtemp);
+                aliData.key(BLINKER_CMD_COLORTEMP);
+                aliData.str(aCtemp.text);
             }
 
             if (_fresh >> 4 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aBright;
-                
-                free(aBright);
+                aliData.key(BLINKER_CMD_BRIGHTNESS);
+                aliData.str(aBright.text);
             }
 
             if (_fresh >> 5 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aTemp;
-                
-                free(aTemp);
+                aliData.key(BLINKER_CMD_TEMP);
+                aliData.str(aTemp.text);
             }
 
             if (_fresh >> 6 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aHumi;
-                
-                free(aHumi);
+                aliData.key(BLINKER_CMD_HUMI);
+                aliData.str(aHumi.text);
             }
 
             if (_fresh >> 7 & 0x01) {
-                if (aliData.length()) aliData += BLINKER_F(",");
-                else aliData += BLINKER_F("{");
-                
-                aliData += aPm25;
-                
-                free(aPm25);
+                aliData.key(BLINKER_CMD_PM25);
+                aliData.str(aPm25.text);
             }
 
-            aliData += BLINKER_F("}");
+            aliData.close();
 
             _fresh = 0;
 
-            Blinker.aligeniePrint(aliData);
+            if (aliData.full())
+            {
+                BLINKER_ERR_LOG(BLINKER_F("AliGenie reply too long"));
+                return;
+            }
+
+            Blinker.aligeniePrint(aliData.c_str());
         }
 
     private :
-        char * aState;
-        char * aColor;
-        char * aMode;
-        char * aCtemp;
-        char * aBright;
-        char * aTemp;
-        char * aHumi;
-        char * aPm25;
+        BlinkerVoiceText  aState;
+        BlinkerVoiceText  aColor;
+        BlinkerVoiceText  aMode;
+        BlinkerVoiceValue aCtemp;
+        BlinkerVoiceValue aBright;
+        BlinkerVoiceValue aTemp;
+        BlinkerVoiceValue aHumi;
+        BlinkerVoiceValue aPm25;
+        uint8_t aNum = 0;
         uint8_t _fresh = 0;
 };
 
@@ -0,0 +1,198 @@
+#ifndef BLINKER_BRIDGE_CACHE_H
+#define BLINKER_BRIDGE_CACHE_H
+
+#if (defined(ESP8266) || defined(ESP32))
+
+#include "../Blinker/BlinkerConfig.h"
+#include "../Blinker/BlinkerDebug.h"
+#include "../Blinker/BlinkerUtility.h"
+#include <EEPROM.h>
+
+// Keeps the device names bridge keys resolved to in EEPROM, so a reboot
+// doesn't send one https query per bridge before connecting.
+//
+// Layout: check byte | entry count | crc32 of the entries | entries. An
+// entry holds the hash of the bridge key, the time the name was resolved
+// and the name. When the table is full the oldest entry is replaced.
+// Expired names are still loaded, BlinkerApi queries them again in the
+// background and keeps the cached name while the cloud can't answer.
+//
+// The table takes EEPROM 3072-3583 (BLINKER_EEP_ADDR_BRIDGE,
+// BLINKER_BRIDGE_CACHE_SIZE), the boot log says so the first time it is
+// read. Define BLINKER_WITHOUT_BRIDGE_CACHE to leave it free.
+
+struct blinker_bridge_entry_t
+{
+    uint32_t    key;
+    uint32_t    resolved;
+    char        name[BLINKER_BRIDGE_NAME_SIZE];
+};
+
+class BlinkerBridgeCache
+{
+    public :
+        BlinkerBridgeCache() : _warned(false) {}
+
+        bool load(const char * key, String & name, uint32_t & resolved);
+        void save(const char * key, const String & name, uint32_t resolved);
+
+    private :
+        bool    _warned;
+
+        uint8_t entries();
+        int addr(uint8_t num)
+        {
+            return BLINKER_EEP_ADDR_BRIDGE + BLINKER_BRIDGE_CACHE_HEAD_SIZE +
+                    num * sizeof(blinker_bridge_entry_t);
+        }
+        uint32_t crc(uint8_t count);
+};
+
+// Entries of a valid table, EEPROM has to be open
+uint8_t BlinkerBridgeCache::entries()
+{
+    uint8_t  check;
+    uint8_t  count;
+    uint32_t stored;
+
+    EEPROM.get(BLINKER_EEP_ADDR_BRIDGE, check);
+    EEPROM.get(BLINKER_EEP_ADDR_BRIDGE + 1, count);
+    EEPROM.get(BLINKER_EEP_ADDR_BRIDGE + 2, stored);
+
+    if (check != BLINKER_BRIDGE_CACHE_CHECK || count > BLINKER_BRIDGE_CACHE_NUM)
+    {
+        return 0;
+    }
+
+    if (crc(count) != stored)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("cached bridge names corrupted"));
+        return 0;
+    }
+
+    return count;
+}
+
+uint32_t BlinkerBridgeCache::crc(uint8_t count)
+{
+    blinker_bridge_entry_t entry;
+    uint32_t crc = 0;
+
+    for (uint8_t num = 0; num < count; num++)
+    {
+        EEPROM.get(addr(num), entry);
+        crc = BlinkerCRC32((const char *)&entry, sizeof(entry), crc);
+    }
+
+    return crc;
+}
+
+bool BlinkerBridgeCache::load(const char * key, String & name, uint32_t & resolved)
+{
+#if defined(BLINKER_WITHOUT_BRIDGE_CACHE)
+    return false;
+#else
+    uint32_t hash = BlinkerCRC32(key, strlen(key));
+    blinker_bridge_entry_t entry;
+    bool found = false;
+
+    if (!_warned)
+    {
+        BLINKER_LOG(BLINKER_F(
+            "\n==========================================================="
+            "\n=============== Blinker bridge cache init! ================"
+            "\nWarning!EEPROM address 3072-3583 is used for Bridge names!"
+            "\n============= DON'T USE THESE EEPROM ADDRESS! ============="
+            "\n===========================================================\n"));
+
+        _warned = true;
+    }
+
+    EEPROM.begin(BLINKER_EEP_SIZE);
+    uint8_t count = entries();
+    for (uint8_t num = 0; num < count; num++)
+    {
+        EEPROM.get(addr(num), entry);
+
+        if (entry.key == hash)
+        {
+            found = true;
+            break;
+        }
+    }
+    EEPROM.end();
+
+    if (!found)
+    {
+        BLINKER_LOG_ALL(BLINKER_F("no cached bridge name: "), key);
+        return false;
+    }
+
+    entry.name[BLINKER_BRIDGE_NAME_SIZE - 1] = '\0';
+    name = entry.name;
+    resolved = entry.resolved;
+
+    return true;
+#endif
+}
+
+void BlinkerBridgeCache::save(const char * key, const String & name, uint32_t resolved)
+{
+#if !defined(BLINKER_WITHOUT_BRIDGE_CACHE)
+    if (name.length() >= BLINKER_BRIDGE_NAME_SIZE)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("bridge name too long to cache: "), name);
+        return;
+    }
+
+    uint32_t hash = BlinkerCRC32(key, strlen(key));
+    blinker_bridge_entry_t entry;
+
+    EEPROM.begin(BLINKER_EEP_SIZE);
+    uint8_t count = entries();
+    uint8_t slot = count;
+    uint8_t oldest = 0;
+    uint32_t oldestTime = 0;
+
+    for (uint8_t num = 0; num < count; num++)
+    {
+        EEPROM.get(addr(num), entry);
+
+        if (entry.key == hash)
+        {
+            slot = num;
+            break;
+        }
+
+        if (num == 0 || entry.resolved < oldestTime)
+        {
+            oldest = num;
+            oldestTime = entry.resolved;
+        }
+    }
+
+    if (slot == count)
+    {
+        if (count < BLINKER_BRIDGE_CACHE_NUM) count++;
+        else slot = oldest;
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    entry.key = hash;
+    entry.resolved = resolved;
+    strcpy(entry.name, name.c_str());
+
+    EEPROM.put(addr(slot), entry);
+    EEPROM.put(BLINKER_EEP_ADDR_BRIDGE, (uint8_t)BLINKER_BRIDGE_CACHE_CHECK);
+    EEPROM.put(BLINKER_EEP_ADDR_BRIDGE + 1, count);
+    EEPROM.put(BLINKER_EEP_ADDR_BRIDGE + 2, crc(count));
+    EEPROM.commit();
+    EEPROM.end();
+
+    BLINKER_LOG_ALL(BLINKER_F("bridge name cached: "), name);
+#endif
+}
+
+#endif
+
+#endif
@@ -3,13 +3,22 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerWidgetWriter.h"
 
 class BlinkerButton
 {
     public :
+        template <size_t N>
+        BlinkerButton(const char (&_name)[N], blinker_callback_with_string_arg_t _func = NULL)
+            : buttonName(_name)
+        {
+            wNum = Blinker.attachWidget((char*)_name, _func);
+        }
+
         BlinkerButton(char _name[], blinker_callback_with_string_arg_t _func = NULL)
         {
             wNum = Blinker.attachWidget(_name, _func);
+            if (wNum) buttonName = BlinkerWidgetName(Blinker.widgetName_str(wNum));
         }
 
         void attach(blinker_callback_with_string_arg_t _func)
@@ -19,79 +28,23 @@ class BlinkerButton
             Blinker.freshAttachWidget(Blinker.widgetName_str(wNum), _func);
         }
 
-        void icon(const String & _icon)
-        {
-            if (_fresh >> 0 & 0x01) free(bicon);
-
-            bicon = (char*)malloc((_icon.length()+1)*sizeof(char));
-            strcpy(bicon, _icon.c_str());
-
-            _fresh |= 0x01 << 0;
-        }
-
-        void color(const String & _clr)
-        {
-            if (_fresh >> 1 & 0x01) free(iconClr);
-
-            iconClr = (char*)malloc((_clr.length()+1)*sizeof(char));
-            strcpy(iconClr, _clr.c_str());
-
-            _fresh |= 0x01 << 1;
-        }
+        void icon(const String & _icon)     { fresh(0, bicon.set(_icon)); }
+        void color(const String & _clr)     { fresh(1, iconClr.set(_clr)); }
 
         template <typename T>
-        void content(T _con)
-        {
-            if (_fresh >> 2 & 0x01) free(bcon);
-
-            String _bcon = STRING_format(_con);
-            bcon = (char*)malloc((_bcon.length()+1)*sizeof(char));
-            strcpy(bcon, _bcon.c_str());
-
-            _fresh |= 0x01 << 2;
-        }
+        void content(T _con)                { fresh(2, bcon.set(_con)); }
 
         template <typename T>
-        void text(T _text)
-        {
-            if (_fresh >> 3 & 0x01) free(btext);
-
-            String _btext = STRING_format(_text);
-            btext = (char*)malloc((_btext.length()+1)*sizeof(char));
-            strcpy(btext, _btext.c_str());
-
-            _fresh |= 0x01 << 3;
-        }
+        void text(T _text)                  { fresh(3, btext.set(_text)); }
 
         template <typename T1, typename T2>
         void text(T1 _text1, T2 _text2)
         {
-            if (_fresh >> 3 & 0x01) free(btext);
-
-            String _btext = STRING_format(_text1);
-            btext = (char*)malloc((_btext.length()+1)*sizeof(char));
-            strcpy(btext, _btext.c_str());
-
-            _fresh |= 0x01 << 3;
-
-            if (_fresh >> 4 & 0x01) free(btext1);
-
-            _btext = STRING_format(_text2);
-            btext1 = (char*)malloc((_btext.length()+1)*sizeof(char));
-            strcpy(btext1, _btext.c_str());
-
-            _fresh |= 0x01 << 4;
+            fresh(3, btext.set(_text1));
+            fresh(4, btext1.set(_text2));
         }
 
-        void textColor(const String & _clr)
-        {
-            if (_fresh >> 5 & 0x01) free(textClr);
-
-            textClr = (char*)malloc((_clr.length()+1)*sizeof(char));
-            strcpy(textClr, _clr.c_str());
-
-            _fresh |= 0x01 << 5;
-        }
+        void textColor(const String & _clr) { fresh(5, textClr.set(_clr)); }
 
         void print() { print(""); }
 
@@ -103,118 +56,71 @@ class BlinkerButton
                 return;
             }
 
-            String buttonData;
+            BlinkerWidgetWriter data = Blinker.widgetBegin(buttonName);
+            encode(data, _state);
+
+            _fresh = 0;
+            bicon.release();
+            iconClr.release();
+            bcon.release();
+            btext.release();
+            btext1.release();
+            textClr.release();
+
+            Blinker.widgetEnd(buttonName, data);
+        }
 
+    private :
+        uint8_t wNum;
+        BlinkerWidgetName buttonName;
+        
+        BlinkerWidgetValue bicon;
+        BlinkerWidgetValue iconClr;
+        BlinkerWidgetValue bcon;
+        BlinkerWidgetValue btext;
+        BlinkerWidgetValue btext1;
+        BlinkerWidgetValue textClr;
+        uint8_t _fresh = 0;
+
+        // an attribute that couldn't be stored isn't sent
+        void fresh(uint8_t bit, bool set)
+        {
+            if (set) _fresh |= 0x01 << bit;
+            else _fresh &= ~(0x01 << bit);
+        }
+
+        void encode(BlinkerWidgetWriter & w, const String & _state)
+        {
             if (_state.length())
             {
-                buttonData += BLINKER_F("{\"");
-                buttonData += BLINKER_F(BLINKER_CMD_SWITCH);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (_state);
-                buttonData += BLINKER_F("\"");
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_SWITCH), _state);
             }
-            
             if (_fresh >> 0 & 0x01)
             {
-                if (buttonData.length()) buttonData += BLINKER_F(",");
-                else buttonData += BLINKER_F("{");
-                
-                buttonData += BLINKER_F("\"");
-                buttonData += BLINKER_F(BLINKER_CMD_ICON);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (bicon);
-                buttonData += BLINKER_F("\"");
-                
-                free(bicon);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_ICON), bicon.c_str());
             }
-            
             if (_fresh >> 1 & 0x01)
             {
-                if (buttonData.length()) buttonData += BLINKER_F(",");
-                else buttonData += STRING_format(BLINKER_F("{"));
-                
-                buttonData += BLINKER_F("\"");
-                buttonData += BLINKER_F(BLINKER_CMD_COLOR);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (iconClr);
-                buttonData += BLINKER_F("\"");
-                
-                free(iconClr);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_COLOR), iconClr.c_str());
             }
-            
             if (_fresh >> 2 & 0x01)
             {
-                if (buttonData.length()) buttonData += BLINKER_F(",");
-                else buttonData += BLINKER_F("{");
-                
-                buttonData += BLINKER_F("\"");
-                buttonData += BLINKER_F(BLINKER_CMD_CONTENT);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (bcon);
-                buttonData += BLINKER_F("\"");
-                
-                free(bcon);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_CONTENT), bcon.c_str());
             }
-            
             if (_fresh >> 3 & 0x01)
             {
-                if (buttonData.length()) buttonData += BLINKER_F(",");
-                else buttonData += BLINKER_F("{");
-
-                buttonData += BLINKER_F("\"");
-                buttonData += BLINKER_F(BLINKER_CMD_TEXT);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (btext);
-                buttonData += BLINKER_F("\"");
-                
-                free(btext);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_TEXT), btext.c_str());
             }
-            
             if (_fresh >> 4 & 0x01)
             {
-                if (buttonData.length()) buttonData += BLINKER_F(",");
-                else buttonData += BLINKER_F("{");
-                
-                buttonData += BLINKER_F("\"");
-                buttonData += BLINKER_F(BLINKER_CMD_TEXT1);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (btext1);
-                buttonData += BLINKER_F("\"");
-                
-                free(btext1);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_TEXT1), btext1.c_str());
             }
-            
             if (_fresh >> 5 & 0x01)
             {
-                if (buttonData.length()) buttonData += BLINKER_F(",");
-                else buttonData += BLINKER_F("{");
-                
-                buttonData += BLINKER_F("\"");
-                buttonData += BLINKER_F(BLINKER_CMD_TEXTCOLOR);
-                buttonData += BLINKER_F("\":\"");
-                buttonData += (textClr);
-                buttonData += BLINKER_F("\"");
-                
-                free(textClr);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_TEXTCOLOR), textClr.c_str());
             }
-
-            buttonData += BLINKER_F("}");
-
-            _fresh = 0;
-
-            Blinker.printArray(Blinker.widgetName_str(wNum), buttonData);
+            w.close();
         }
-
-    private :
-        uint8_t wNum;
-        
-        char * bicon;
-        char * iconClr;
-        char * bcon;
-        char * btext;
-        char * btext1;
-        char * textClr;
-        uint8_t _fresh = 0;
 };
 
 #endif
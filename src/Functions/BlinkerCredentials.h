@@ -0,0 +1,166 @@
+#ifndef BLINKER_CREDENTIALS_H
+#define BLINKER_CREDENTIALS_H
+
+#if (defined(ESP8266) || defined(ESP32))
+
+#include "../Blinker/BlinkerConfig.h"
+#include "../Blinker/BlinkerDebug.h"
+#include "../Blinker/BlinkerUtility.h"
+#include <EEPROM.h>
+
+// Keeps the MQTT credentials of the last successful device auth in EEPROM,
+// so later boots can connect to the broker without the HTTPS auth request.
+//
+// Layout: check byte | payload length | hash of the request id | crc32 of
+// the payload | payload. The payload is a compact auth reply holding only
+// the detail fields connectServer() needs. The request id covers everything
+// sent with the auth request, a different authKey or device type won't
+// match the stored credentials.
+//
+// The cache takes EEPROM 3584-4095 (BLINKER_EEP_ADDR_CREDENTIALS,
+// BLINKER_CREDENTIALS_SIZE), the boot log says so the first time it is
+// read. Define BLINKER_WITHOUT_CREDENTIALS_CACHE to leave it free.
+
+class BlinkerCredentials
+{
+    public :
+        BlinkerCredentials() : _warned(false) {}
+
+        bool load(const String & id, String & payload);
+        void save(const String & id, const JsonObject & detail, const char * authKey = NULL);
+        void clear();
+
+    private :
+        bool    _warned;
+};
+
+bool BlinkerCredentials::load(const String & id, String & payload)
+{
+#if defined(BLINKER_WITHOUT_CREDENTIALS_CACHE)
+    return false;
+#else
+    uint8_t  check;
+    uint16_t len;
+    uint32_t idHash;
+    uint32_t crc;
+
+    if (!_warned)
+    {
+        BLINKER_LOG(BLINKER_F(
+            "\n==========================================================="
+            "\n============= Blinker credentials cache init! ============="
+            "\nWarning!EEPROM address 3584-4095 is used for Credentials!"
+            "\n============= DON'T USE THESE EEPROM ADDRESS! ============="
+            "\n===========================================================\n"));
+
+        _warned = true;
+    }
+
+    EEPROM.begin(BLINKER_EEP_SIZE);
+    EEPROM.get(BLINKER_EEP_ADDR_CREDENTIALS, check);
+    EEPROM.get(BLINKER_EEP_ADDR_CREDENTIALS + 1, len);
+    EEPROM.get(BLINKER_EEP_ADDR_CREDENTIALS + 3, idHash);
+    EEPROM.get(BLINKER_EEP_ADDR_CREDENTIALS + 7, crc);
+
+    if (check != BLINKER_CREDENTIALS_CHECK || len == 0 ||
+        len > BLINKER_CREDENTIALS_SIZE - BLINKER_CREDENTIALS_HEAD_SIZE ||
+        idHash != BlinkerCRC32(id.c_str(), id.length()))
+    {
+        EEPROM.end();
+
+        BLINKER_LOG_ALL(BLINKER_F("no cached credentials"));
+        return false;
+    }
+
+    payload = "";
+    payload.reserve(len);
+    for (uint16_t i = 0; i < len; i++)
+    {
+        payload += (char)EEPROM.read(BLINKER_EEP_ADDR_CREDENTIALS + BLINKER_CREDENTIALS_HEAD_SIZE + i);
+    }
+    EEPROM.end();
+
+    if (payload.length() != len || BlinkerCRC32(payload.c_str(), len, idHash) != crc)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("cached credentials corrupted"));
+        payload = "";
+        return false;
+    }
+
+    BLINKER_LOG_ALL(BLINKER_F("use cached credentials"));
+    return true;
+#endif
+}
+
+void BlinkerCredentials::save(const String & id, const JsonObject & detail, const char * authKey)
+{
+#if !defined(BLINKER_WITHOUT_CREDENTIALS_CACHE)
+    DynamicJsonDocument jsonBuffer(512);
+    JsonObject cache = jsonBuffer.createNestedObject(BLINKER_CMD_DETAIL);
+
+    const char * keys[] = {
+        BLINKER_CMD_DEVICENAME, BLINKER_CMD_IOTID, BLINKER_CMD_IOTTOKEN,
+        BLINKER_CMD_PRODUCTKEY, BLINKER_CMD_BROKER, BLINKER_CMD_UUID,
+        BLINKER_CMD_KEY
+    };
+
+    size_t copied = 0;
+    for (uint8_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+    {
+        if (detail.containsKey(keys[i]))
+        {
+            cache[keys[i]] = detail[keys[i]];
+            copied++;
+        }
+    }
+    if (authKey)
+    {
+        cache[BLINKER_CMD_AUTHKEY] = authKey;
+        copied++;
+    }
+
+    String payload;
+    serializeJson(jsonBuffer, payload);
+
+    // A short document drops values silently, never cache partial credentials
+    if (cache.size() != copied ||
+        payload.length() > BLINKER_CREDENTIALS_SIZE - BLINKER_CREDENTIALS_HEAD_SIZE)
+    {
+        BLINKER_ERR_LOG(BLINKER_F("credentials too long to cache"));
+        clear();
+        return;
+    }
+
+    uint16_t len = payload.length();
+    uint32_t idHash = BlinkerCRC32(id.c_str(), id.length());
+    uint32_t crc = BlinkerCRC32(payload.c_str(), len, idHash);
+
+    EEPROM.begin(BLINKER_EEP_SIZE);
+    EEPROM.put(BLINKER_EEP_ADDR_CREDENTIALS, (uint8_t)BLINKER_CREDENTIALS_CHECK);
+    EEPROM.put(BLINKER_EEP_ADDR_CREDENTIALS + 1, len);
+    EEPROM.put(BLINKER_EEP_ADDR_CREDENTIALS + 3, idHash);
+    EEPROM.put(BLINKER_EEP_ADDR_CREDENTIALS + 7, crc);
+    for (uint16_t i = 0; i < len; i++)
+    {
+        EEPROM.write(BLINKER_EEP_ADDR_CREDENTIALS + BLINKER_CREDENTIALS_HEAD_SIZE + i, payload[i]);
+    }
+    EEPROM.commit();
+    EEPROM.end();
+
+    BLINKER_LOG_ALL(BLINKER_F("credentials cached: "), len);
+#endif
+}
+
+void BlinkerCredentials::clear()
+{
+    EEPROM.begin(BLINKER_EEP_SIZE);
+    EEPROM.put(BLINKER_EEP_ADDR_CREDENTIALS, (uint8_t)0);
+    EEPROM.commit();
+    EEPROM.end();
+
+    BLINKER_LOG_ALL(BLINKER_F("credentials cleared"));
+}
+
+#endif
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerVoice.h"
 
 class BLINKERMIOT
 {
@@ -66,383 +67,125 @@ class BLINKERMIOT
 
         void powerState(const String & state, uint8_t num)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_POWERSTATE);
-            payload += BLINKER_F("\":");
-
-            if (state == "on")
-            {
-                payload += "true";
-            }
-            else
-            {
-                payload += "false";
-            }
-            
-            if (num != 0)
-            {
-                payload += BLINKER_F(",\"num\":");
-                payload += STRING_format(num);
-            }
-            else
-            {
-                payload += BLINKER_F("");
-            }            
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 0 & 0x01) {
-                free(aState);
-            }
-
-            aState = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aState, payload.c_str());
+            aState = (state == BLINKER_CMD_ON);
+            aNum = num;
 
             _fresh |= 0x01 << 0;
         }
 
         void powerState(const String & state)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_POWERSTATE);
-            payload += BLINKER_F("\":");
-
-            if (state == "on")
-            {
-                payload += "true";
-            }
-            else
-            {
-                payload += "false";
-            }
-            
-            // payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 0 & 0x01) {
-                free(aState);
-            }
-
-            aState = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aState, payload.c_str());
-
-            _fresh |= 0x01 << 0;
+            powerState(state, 0);
         }
 
         void color(uint32_t clr)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_COLOR_);
-            payload += BLINKER_F("\":");
-            payload += STRING_format(clr);
-            payload += BLINKER_F(",");
-            payload += BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_COLOR);
-            payload += BLINKER_F("\":");
-            payload += STRING_format(clr);
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 1 & 0x01) {
-                free(aColor);
-            }
-
-            aColor = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aColor, payload.c_str());
+            aColor.set(clr);
 
             _fresh |= 0x01 << 1;
         }
 
         void mode(uint8_t md)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_MODE);
-            payload += BLINKER_F("\":");
-            payload += STRING_format(md);
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 2 & 0x01) {
-                free(aMode);
-            }
-
-            aMode = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aMode, payload.c_str());
+            aMode.set((uint32_t)md);
 
             _fresh |= 0x01 << 2;
         }
 
         void colorTemp(int clrTemp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_COLORTEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(clrTemp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 3 & 0x01) {
-                free(aCtemp);
-            }
-
-            aCtemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aCtemp, payload.c_str());
+            aCtemp.set((int32_t)clrTemp);
 
             _fresh |= 0x01 << 3;
         }
 
         void brightness(int bright)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_BRIGHTNESS);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(bright);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 4 & 0x01) {
-                free(aBright);
-            }
-
-            aBright = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aBright, payload.c_str());
+            aBright.set((int32_t)bright);
 
             _fresh |= 0x01 << 4;
         }
 
         void temp(double _temp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_TEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_temp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 5 & 0x01) {
-                free(aTemp);
-            }
-
-            aTemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aTemp, payload.c_str());
+            aTemp.set(_temp);
 
             _fresh |= 0x01 << 5;
         }
 
         void temp(float _temp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_TEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_temp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 5 & 0x01) {
-                free(aTemp);
-            }
-
-            aTemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aTemp, payload.c_str());
+            aTemp.set((double)_temp);
 
             _fresh |= 0x01 << 5;
         }
 
         void temp(int _temp)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_TEMP);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_temp);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 5 & 0x01) {
-                free(aTemp);
-            }
-
-            aTemp = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aTemp, payload.c_str());
+            aTemp.set((int32_t)_temp);
 
             _fresh |= 0x01 << 5;
         }
 
         void humi(double _humi)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_HUMI);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_humi);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 6 & 0x01) {
-                free(aHumi);
-            }
-
-            aHumi = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aHumi, payload.c_str());
+            aHumi.set(_humi);
 
             _fresh |= 0x01 << 6;
         }
 
         void humi(float _humi)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_HUMI);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_humi);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 6 & 0x01) {
-                free(aHumi);
-            }
-
-            aHumi = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aHumi, payload.c_str());
+            aHumi.set((double)_humi);
 
             _fresh |= 0x01 << 6;
         }
 
         void humi(int _humi)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_HUMI);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_humi);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 6 & 0x01) {
-                free(aHumi);
-            }
-
-            aHumi = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aHumi, payload.c_str());
+            aHumi.set((int32_t)_humi);
 
             _fresh |= 0x01 << 6;
         }
 
         void pm25(double _pm25)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_PM25);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_pm25);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 7 & 0x01) {
-                free(aPm25);
-            }
-
-            aPm25 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aPm25, payload.c_str());
+            aPm25.set(_pm25);
 
             _fresh |= 0x01 << 7;
         }
 
         void pm25(float _pm25)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_PM25);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_pm25);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 7 & 0x01) {
-                free(aPm25);
-            }
-
-            aPm25 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aPm25, payload.c_str());
+            aPm25.set((double)_pm25);
 
             _fresh |= 0x01 << 7;
         }
 
         void pm25(int _pm25)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_PM25);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_pm25);
-            payload += BLINKER_F("\"");
-
-            // Blinker.aligeniePrint(payload);
-
-            if (_fresh >> 7 & 0x01) {
-                free(aPm25);
-            }
-
-            aPm25 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aPm25, payload.c_str());
+            aPm25.set((int32_t)_pm25);
 
             _fresh |= 0x01 << 7;
         }
 
         void co2(double _co2)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_CO2);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_co2);
-            payload += BLINKER_F("\"");
-
-            if (_fresh >> 8 & 0x01) {
-                free(aCO2);
-            }
-
-            aCO2 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aCO2, payload.c_str());
+            aCO2.set(_co2);
 
             _fresh |= 0x01 << 8;
         }
 
         void co2(float _co2)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_CO2);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_co2);
-            payload += BLINKER_F("\"");
-
-            if (_fresh >> 8 & 0x01) {
-                free(aCO2);
-            }
-
-            aCO2 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aCO2, payload.c_str());
+            aCO2.set((double)_co2);
 
             _fresh |= 0x01 << 8;
         }
 
         void co2(int _co2)
         {
-            String payload = BLINKER_F("\"");
-            payload += STRING_format(BLINKER_CMD_CO2);
-            payload += BLINKER_F("\":\"");
-            payload += STRING_format(_co2);
-            payload += BLINKER_F("\"");
-
-            if (_fresh >> 8 & 0x01) {
-                free(aCO2);
-            }
-
-            aCO2 = (char*)malloc((payload.length()+1)*sizeof(char));
-            strcpy(aCO2, payload.c_str());
+            aCO2.set((int32_t)_co2);
 
             _fresh |= 0x01 << 8;
         }
@@ -450,107 +193,89 @@ class BLINKERMIOT
         void print()
         {
             if (_fresh == 0) return;
-            
-            String miData;
+
+            BlinkerVoicePayload miData;
 
             if (_fresh >> 0 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aState;
-                
-                free(aState);
+                miData.key(BLINKER_CMD_POWERSTATE);
+                miData.raw(aState ? BLINKER_CMD_TRUE : BLINKER_CMD_FALSE);
+
+                if (aNum != 0)
+                {
+                    BlinkerVoiceValue num;
+                    num.set((uint32_t)aNum);
+
+                    miData.key(BLINKER_CMD_NUM);
+                    miData.raw(num.text);
+                }
             }
 
             if (_fresh >> 1 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aColor;
-                
-                free(aColor);
+                miData.key(BLINKER_CMD_COLOR_);
+                miData.raw(aColor.text);
+                miData.key(BLINKER_CMD_COLOR);
+                miData.raw(aColor.text);
             }
 
             if (_fresh >> 2 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aMode;
-                
-                free(aMode);
+                miData.key(BLINKER_CMD_MODE);
+                miData.raw(aMode.text);
             }
 
             if (_fresh >> 3 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aCtemp;
-                
-                free(aCtemp);
+                miData.key(BLINKER_CMD_COLORTEMP);
+                miData.str(aCtemp.text);
             }
 
             if (_fresh >> 4 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aBright;
-                
-                free(aBright);
+                miData.key(BLINKER_CMD_BRIGHTNESS);
+                miData.str(aBright.text);
             }
 
             if (_fresh >> 5 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aTemp;
-                
-                free(aTemp);
+                miData.key(BLINKER_CMD_TEMP);
+                miData.str(aTemp.text);
             }
 
             if (_fresh >> 6 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aHumi;
-                
-                free(aHumi);
+                miData.key(BLINKER_CMD_HUMI);
+                miData.str(aHumi.text);
             }
 
             if (_fresh >> 7 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aPm25;
-                
-                free(aPm25);
+                miData.key(BLINKER_CMD_PM25);
+                miData.str(aPm25.text);
             }
 
             if (_fresh >> 8 & 0x01) {
-                if (miData.length()) miData += BLINKER_F(",");
-                else miData += BLINKER_F("{");
-                
-                miData += aCO2;
-                
-                free(aCO2);
+                miData.key(BLINKER_CMD_CO2);
+                miData.str(aCO2.text);
             }
 
-            miData += BLINKER_F("}");
+            miData.close();
 
             _fresh = 0;
 
-            Blinker.miotPrint(miData);
+            if (miData.full())
+            {
+                BLINKER_ERR_LOG(BLINKER_F("MIOT reply too long"));
+                return;
+            }
+
+            Blinker.miotPrint(miData.c_str());
         }
 
     private :
-        char * aState;
-        char * aColor;
-        char * aMode;
-        char * aCtemp;
-        char * aBright;
-        char * aTemp;
-        char * aHumi;
-        char * aPm25;
-        char * aCO2;  
+        BlinkerVoiceValue aColor;
+        BlinkerVoiceValue aMode;
+        BlinkerVoiceValue aCtemp;
+        BlinkerVoiceValue aBright;
+        BlinkerVoiceValue aTemp;
+        BlinkerVoiceValue aHumi;
+        BlinkerVoiceValue aPm25;
+        BlinkerVoiceValue aCO2;
+        bool     aState = false;
+        uint8_t  aNum = 0;
         uint16_t _fresh = 0;
 };
 
@@ -3,59 +3,43 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerWidgetWriter.h"
+#include "BlinkerWidgetDelta.h"
 
 class BlinkerNumber
 {
     public :
+        template <size_t N>
+        BlinkerNumber(const char (&_name)[N])
+            : numName(_name)
+        {}
+
         BlinkerNumber(char _name[])
         {
-            numName = (char*)malloc((strlen(_name)+1)*sizeof(char));
-            strcpy(numName, _name);
+            char * name = (char*)malloc((strlen(_name)+1)*sizeof(char));
+            strcpy(name, _name);
+            numName = BlinkerWidgetName(name);
         }
         
-        void icon(const String & _icon)
-        {
-            if (_fresh >> 0 & 0x01) free(nicon);
-
-            nicon = (char*)malloc((_icon.length()+1)*sizeof(char));
-            strcpy(nicon, _icon.c_str());
-
-            _fresh |= 0x01 << 0;
-        }
-
-        void color(const String & _clr)
-        {
-            if (_fresh >> 1 & 0x01) free(ncolor);
-
-            ncolor = (char*)malloc((_clr.length()+1)*sizeof(char));
-            strcpy(ncolor, _clr.c_str());
-
-            _fresh |= 0x01 << 1;
-        }
-
-        void unit(const String & _unit)
-        {
-            if (_fresh >> 2 & 0x01) free(nunit);
-
-            nunit = (char*)malloc((_unit.length()+1)*sizeof(char));
-            strcpy(nunit, _unit.c_str());
-
-            _fresh |= 0x01 << 2;
-        }
+        void icon(const String & _icon)     { fresh(0, nicon.set(_icon)); }
+        void color(const String & _clr)     { fresh(1, ncolor.set(_clr)); }
+        void unit(const String & _unit)     { fresh(2, nunit.set(_unit)); }
 
         template <typename T>
         void text(T _text)
         {
             if (isnan(_text)) return;
 
-            if (_fresh >> 3 & 0x01) free(ntext);
-
-            String _ntext = STRING_format(_text);
-            ntext = (char*)malloc((_ntext.length()+1)*sizeof(char));
-            strcpy(ntext, _ntext.c_str());
+            fresh(3, ntext.set(_text));
+        }
 
-            _fresh |= 0x01 << 3;
+        // see BlinkerWidgetDelta
+        void deadband(float absolute, float relative = 0)
+        {
+            _delta.deadband(absolute, relative);
         }
+        void interval(uint32_t ms)          { _delta.interval(ms); }
+        void refresh(uint32_t ms)           { _delta.refresh(ms); }
         
         void print(char value)              { _print(STRING_format(value)); }
         void print(unsigned char value)     { _print(STRING_format(value)); }
@@ -67,90 +51,71 @@ class BlinkerNumber
         void print()                        { _print(""); }
     
     private :
-        char * numName;
-        char * nicon;// = "";
-        char * ncolor;// = "";
-        char * nunit;// = "";
-        char * ntext;
+        BlinkerWidgetName numName;
+        BlinkerWidgetValue nicon;
+        BlinkerWidgetValue ncolor;
+        BlinkerWidgetValue nunit;
+        BlinkerWidgetValue ntext;
         uint8_t _fresh = 0;
+        BlinkerWidgetDelta _delta;
 
         void _print(const String & value)
         {
             if (_fresh == 0 && value.length() == 0) return;
 
-            String numberData = "";
-
             if (value.length())
             {
-                numberData += BLINKER_F("{\"");
-                numberData += BLINKER_F(BLINKER_CMD_VALUE);
-                numberData += BLINKER_F("\":");
-                numberData += value;
-                
-                Blinker.printNumArray(numName, value);
+                Blinker.printNumArray((char*)numName.c_str(), value);
+
+                if (!_delta.pass(strtod(value.c_str(), NULL), _fresh != 0,
+                                Blinker.heartbeating(), millis()))
+                {
+                    return;
+                }
             }
 
-            if (_fresh >> 0 & 0x01)
-            {
-                if (numberData.length()) numberData += BLINKER_F(",");
-                else numberData += BLINKER_F("{");
+            BlinkerWidgetWriter data = Blinker.widgetBegin(numName);
+            encode(data, value);
 
-                numberData += BLINKER_F("\"");
-                numberData += BLINKER_F(BLINKER_CMD_ICON);
-                numberData += BLINKER_F("\":\"");
-                numberData += nicon;
-                numberData += BLINKER_F("\"");
+            _fresh = 0;
+            nicon.release();
+            ncolor.release();
+            nunit.release();
+            ntext.release();
 
-                free(nicon);
+            Blinker.widgetEnd(numName, data, &_delta);
+        }
+
+        // an attribute that couldn't be stored isn't sent
+        void fresh(uint8_t bit, bool set)
+        {
+            if (set) _fresh |= 0x01 << bit;
+            else _fresh &= ~(0x01 << bit);
+        }
+
+        void encode(BlinkerWidgetWriter & w, const String & value)
+        {
+            if (value.length())
+            {
+                w.raw(BLINKER_WIDGET_RAW(BLINKER_CMD_VALUE), value);
+            }
+            if (_fresh >> 0 & 0x01)
+            {
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_ICON), nicon.c_str());
             }
-            
             if (_fresh >> 1 & 0x01)
             {
-                if (numberData.length()) numberData += BLINKER_F(",");
-                else numberData += BLINKER_F("{");
-
-                numberData += BLINKER_F("\"");
-                numberData += BLINKER_F(BLINKER_CMD_COLOR);
-                numberData += BLINKER_F("\":\"");
-                numberData += ncolor;
-                numberData += BLINKER_F("\"");
-
-                free(ncolor);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_COLOR), ncolor.c_str());
             }
-            
             if (_fresh >> 2 & 0x01)
             {
-                if (numberData.length()) numberData += BLINKER_F(",");
-                else numberData += BLINKER_F("{");
-
-                numberData += BLINKER_F("\"");
-                numberData += BLINKER_F(BLINKER_CMD_UNIT);
-                numberData += BLINKER_F("\":\"");
-                numberData += nunit;
-                numberData += BLINKER_F("\"");
-
-                free(nunit);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_UNIT), nunit.c_str());
             }
-
             if (_fresh >> 3 & 0x01)
             {
-                if (numberData.length()) numberData += BLINKER_F(",");
-                else numberData += BLINKER_F("{");
-
-                numberData += BLINKER_F("\"");
-                numberData += BLINKER_F(BLINKER_CMD_TEXT);
-                numberData += BLINKER_F("\":\"");
-                numberData += (ntext);
-                numberData += BLINKER_F("\"");
-
-                free(ntext);
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_TEXT), ntext.c_str());
             }
-
-            numberData += BLINKER_F("}");
-
-            _fresh = 0;
-
-            Blinker.printArray(numName, numberData);
+            w.close();
         }
 };
 
@@ -0,0 +1,237 @@
+#ifndef BLINKER_QUERY_H
+#define BLINKER_QUERY_H
+
+#if (defined(ESP8266) || defined(ESP32))
+
+#include "../Blinker/BlinkerConfig.h"
+#include "../Blinker/BlinkerDebug.h"
+#include "../Blinker/BlinkerUtility.h"
+
+#if defined(ESP8266)
+    #include <WiFiClientSecureBearSSL.h>
+
+    typedef BearSSL::WiFiClientSecure   BlinkerQueryClient;
+#else
+    #include <WiFiClientSecure.h>
+
+    typedef WiFiClientSecure            BlinkerQueryClient;
+#endif
+
+// A GET on the blinker server spread over Blinker.run() passes, for the
+// queries run() makes on its own: the sharer list and the bridge names.
+// blinkerServer() waits for the whole reply, here every pass takes one
+// step and returns. connect() still does the TLS handshake in one go, the
+// wait for the server and the reading of the reply don't hold the loop.
+//
+// With BLINKER_WITH_NET_TASK the network task takes the steps and the app
+// task only starts the query and reads the reply, see BlinkerApi::queryRun().
+// state() is the only field both tasks touch while a query runs. It is
+// stored with release and loaded with acquire: the task that sees a new
+// state also sees the fields written before it, the reply on DONE and the
+// path on CONNECT.
+
+enum blinker_query_state_t
+{
+    BLINKER_QUERY_IDLE,
+    BLINKER_QUERY_CONNECT,
+    BLINKER_QUERY_HEAD,
+    BLINKER_QUERY_BODY,
+    BLINKER_QUERY_DONE,
+    BLINKER_QUERY_FAIL
+};
+
+class BlinkerQuery
+{
+    public :
+        BlinkerQuery()
+            : _client(NULL), _state(BLINKER_QUERY_IDLE), _type(0), _tag(0)
+        {}
+
+        ~BlinkerQuery() { end(); }
+
+        // Starts a GET of path, false while another query runs
+        bool begin(uint8_t type, uint8_t tag, const String & path);
+        // One step, returns the state
+        uint8_t run();
+        // Frees the client, back to idle
+        void end();
+
+        uint8_t state() const   { return __atomic_load_n(&_state, __ATOMIC_ACQUIRE); }
+        bool busy() const       { return state() != BLINKER_QUERY_IDLE; }
+        bool finished() const
+        {
+            uint8_t s = state();
+
+            return s == BLINKER_QUERY_DONE || s == BLINKER_QUERY_FAIL;
+        }
+        uint8_t type() const    { return _type; }
+        uint8_t tag() const     { return _tag; }
+        // The body of a 200 reply
+        const String & reply() const { return _reply; }
+
+    private :
+        BlinkerQueryClient *        _client;
+        uint8_t                     _state;
+        uint8_t                     _type;
+        uint8_t                     _tag;
+        String                      _path;
+        String                      _line;
+        String                      _reply;
+        uint32_t                    _time;
+        int32_t                     _length;
+        int                         _code;
+
+        uint8_t fail(const String & why)
+        {
+            BLINKER_ERR_LOG_ALL(BLINKER_F("query failed: "), why);
+            return set(BLINKER_QUERY_FAIL);
+        }
+        uint8_t set(uint8_t s)
+        {
+            __atomic_store_n(&_state, s, __ATOMIC_RELEASE);
+            return s;
+        }
+        void head();
+};
+
+bool BlinkerQuery::begin(uint8_t type, uint8_t tag, const String & path)
+{
+    if (busy()) return false;
+
+    _type = type;
+    _tag = tag;
+    _path = BLINKER_F("/api/v1/user/device");
+    _path += path;
+    _line = "";
+    _reply = "";
+    _length = -1;
+    _code = 0;
+
+    BLINKER_LOG_ALL(BLINKER_F("query begin: "), _path);
+
+    set(BLINKER_QUERY_CONNECT);
+
+    return true;
+}
+
+uint8_t BlinkerQuery::run()
+{
+    switch (state())
+    {
+        case BLINKER_QUERY_CONNECT :
+            _client = new BlinkerQueryClient;
+            _client->setInsecure();
+            #if defined(ESP8266)
+                _client->setTimeout(BLINKER_QUERY_TIMEOUT);
+            #else
+                // seconds on ESP32
+                _client->setTimeout(BLINKER_QUERY_TIMEOUT / 1000);
+            #endif
+
+            if (!_client->connect(BLINKER_SERVER_HOST, 443))
+            {
+                return fail(BLINKER_F("connect"));
+            }
+
+            // HTTP/1.0, the reply isn't chunked and ends with the connection
+            _client->print(BLINKER_F("GET "));
+            _client->print(_path);
+            _client->print(BLINKER_F(" HTTP/1.0\r\nHost: "));
+            _client->print(BLINKER_F(BLINKER_SERVER_HOST));
+            _client->print(BLINKER_F("\r\n\r\n"));
+
+            _time = millis();
+            return set(BLINKER_QUERY_HEAD);
+        case BLINKER_QUERY_HEAD :
+            head();
+            break;
+        case BLINKER_QUERY_BODY :
+            while (_client->available() &&
+                (_length < 0 || (int32_t)_reply.length() < _length))
+            {
+                _reply += (char)_client->read();
+            }
+
+            if ((_length >= 0 && (int32_t)_reply.length() >= _length) ||
+                (!_client->connected() && !_client->available()))
+            {
+                BLINKER_LOG_ALL(BLINKER_F("query reply: "), _reply);
+
+                return set(_code == 200 ? BLINKER_QUERY_DONE : BLINKER_QUERY_FAIL);
+            }
+            break;
+        default :
+            return state();
+    }
+
+    if (state() == BLINKER_QUERY_FAIL) return BLINKER_QUERY_FAIL;
+
+    if (millis() - _time >= BLINKER_QUERY_TIMEOUT)
+    {
+        return fail(BLINKER_F("timeout"));
+    }
+
+    if (state() == BLINKER_QUERY_HEAD && !_client->connected() &&
+        !_client->available())
+    {
+        return fail(BLINKER_F("closed"));
+    }
+
+    return state();
+}
+
+// Reads the status line and the headers that have arrived
+void BlinkerQuery::head()
+{
+    while (_client->available())
+    {
+        char c = _client->read();
+
+        if (c != '\n')
+        {
+            if (c != '\r') _line += c;
+            continue;
+        }
+
+        if (_line.length() == 0)
+        {
+            BLINKER_LOG_ALL(BLINKER_F("query status: "), _code);
+
+            set(BLINKER_QUERY_BODY);
+            return;
+        }
+
+        if (_code == 0)
+        {
+            // HTTP/1.1 200 OK
+            int at = _line.indexOf(' ');
+
+            _code = at > 0 ? _line.substring(at + 1).toInt() : -1;
+        }
+        else if (_line.startsWith(BLINKER_F("Content-Length:")) ||
+                _line.startsWith(BLINKER_F("content-length:")))
+        {
+            _length = _line.substring(15).toInt();
+        }
+
+        _line = "";
+    }
+}
+
+void BlinkerQuery::end()
+{
+    if (_client)
+    {
+        _client->stop();
+        delete _client;
+        _client = NULL;
+    }
+
+    _line = "";
+    _path = "";
+    set(BLINKER_QUERY_IDLE);
+}
+
+#endif
+
+#endif
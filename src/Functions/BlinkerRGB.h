@@ -3,14 +3,23 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerWidgetWriter.h"
+#include "BlinkerWidgetDelta.h"
 
 class BlinkerRGB
 {
     public :
+        template <size_t N>
+        BlinkerRGB(const char (&_name)[N], blinker_callback_with_rgb_arg_t _func = NULL)
+            : rgbName(_name)
+        {
+            wNum = Blinker.attachWidget((char*)_name, _func);
+        }
+
         BlinkerRGB(char _name[], blinker_callback_with_rgb_arg_t _func = NULL)
-            // : rgbName(_name)
         {
             wNum = Blinker.attachWidget(_name, _func);
+            if (wNum) rgbName = BlinkerWidgetName(Blinker.widgetName_rgb(wNum));
         }
 
         void attach(blinker_callback_with_rgb_arg_t _func)
@@ -22,45 +31,47 @@ class BlinkerRGB
 
         void brightness(uint8_t _bright) { rgbrightness = _bright; }
 
+        // see BlinkerWidgetDelta
+        void interval(uint32_t ms)          { _delta.interval(ms); }
+        void refresh(uint32_t ms)           { _delta.refresh(ms); }
+
         void print(uint8_t _r, uint8_t _g, uint8_t _b)
         {
-            if (wNum == 0) return;
-
-            String rgbData = BLINKER_F("[");
-            rgbData += STRING_format(_r);
-            rgbData += BLINKER_F(",");
-            rgbData += STRING_format(_g);
-            rgbData += BLINKER_F(",");
-            rgbData += STRING_format(_b);
-            rgbData += BLINKER_F(",");
-            rgbData += STRING_format(rgbrightness);
-            rgbData += BLINKER_F("]");
-
-            Blinker.printArray(Blinker.widgetName_rgb(wNum), rgbData);
+            print(_r, _g, _b, rgbrightness);
         }
 
         void print(uint8_t _r, uint8_t _g, uint8_t _b, uint8_t _bright)
         {
-            if (wNum == 0) {
-                return;
+            if (wNum == 0) return;
+
+            // "[255,255,255,255]"
+            char rgbData[18];
+            uint8_t value[4] = { _r, _g, _b, _bright };
+            char * p = rgbData;
+
+            *p++ = '[';
+            for (uint8_t i = 0; i < 4; i++)
+            {
+                if (i) *p++ = ',';
+                utoa(value[i], p, 10);
+                p += strlen(p);
             }
+            *p++ = ']';
+            *p = '\0';
+
+            if (!_delta.pass(rgbData, Blinker.heartbeating(), millis())) return;
+
+            BlinkerWidgetWriter data = Blinker.widgetBegin(rgbName);
+            data.write(rgbData, p - rgbData);
 
-            String rgbData = BLINKER_F("[");
-            rgbData += STRING_format(_r);
-            rgbData += BLINKER_F(",");
-            rgbData += STRING_format(_g);
-            rgbData += BLINKER_F(",");
-            rgbData += STRING_format(_b);
-            rgbData += BLINKER_F(",");
-            rgbData += STRING_format(_bright);
-            rgbData += BLINKER_F("]");
-
-            Blinker.printArray(Blinker.widgetName_rgb(wNum), rgbData);
+            Blinker.widgetEnd(rgbName, data, &_delta);
         }
 
     private :
         uint8_t wNum;
+        BlinkerWidgetName rgbName;
         uint8_t rgbrightness = 0;
+        BlinkerWidgetDelta _delta;
 };
 
 #endif
@@ -3,14 +3,23 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerWidgetWriter.h"
+#include "BlinkerWidgetDelta.h"
 
 class BlinkerSlider
 {
     public :
+        template <size_t N>
+        BlinkerSlider(const char (&_name)[N], blinker_callback_with_int32_arg_t _func = NULL)
+            : sliderName(_name)
+        {
+            wNum = Blinker.attachWidget((char*)_name, _func);
+        }
+
         BlinkerSlider(char _name[], blinker_callback_with_int32_arg_t _func = NULL)
-            // : sliderName(_name)
         {
             wNum = Blinker.attachWidget(_name, _func);
+            if (wNum) sliderName = BlinkerWidgetName(Blinker.widgetName_int(wNum));
         }
         
         void attach(blinker_callback_with_int32_arg_t _func)
@@ -20,15 +29,15 @@ class BlinkerSlider
             Blinker.freshAttachWidget(Blinker.widgetName_int(wNum), _func);
         }
         
-        void color(const String & _clr)
-        {
-            if (_fresh >> 0 & 0x01) free(textClr);
+        void color(const String & _clr)     { fresh(0, textClr.set(_clr)); }
 
-            textClr = (char*)malloc((_clr.length()+1)*sizeof(char));
-            strcpy(textClr, _clr.c_str());
-
-            _fresh |= 0x01 << 0;
+        // see BlinkerWidgetDelta
+        void deadband(float absolute, float relative = 0)
+        {
+            _delta.deadband(absolute, relative);
         }
+        void interval(uint32_t ms)          { _delta.interval(ms); }
+        void refresh(uint32_t ms)           { _delta.refresh(ms); }
         
         void print(char value)              { _print(STRING_format(value)); }
         void print(unsigned char value)     { _print(STRING_format(value)); }
@@ -41,8 +50,10 @@ class BlinkerSlider
     
     private :
         uint8_t wNum;
-        char * textClr;
+        BlinkerWidgetName sliderName;
+        BlinkerWidgetValue textClr;
         uint8_t _fresh = 0;
+        BlinkerWidgetDelta _delta;
 
         void _print(const String & n)
         {
@@ -52,35 +63,40 @@ class BlinkerSlider
                 return;
             }
 
-            String sliderData;
-
-            if (n.length())
+            if (n.length() &&
+                !_delta.pass(strtod(n.c_str(), NULL), _fresh != 0,
+                            Blinker.heartbeating(), millis()))
             {
-                sliderData += BLINKER_F("{\"");
-                sliderData += BLINKER_F(BLINKER_CMD_VALUE);
-                sliderData += BLINKER_F("\":");
-                sliderData += n;
+                return;
             }
 
-            if (_fresh >> 0 & 0x01)
-            {
-                if (sliderData.length()) sliderData += BLINKER_F(",");
-                else sliderData += BLINKER_F("{");
-
-                sliderData += BLINKER_F("\"");
-                sliderData += BLINKER_F(BLINKER_CMD_COLOR);
-                sliderData += BLINKER_F("\":\"");
-                sliderData += (textClr);
-                sliderData += BLINKER_F("\"");
+            BlinkerWidgetWriter data = Blinker.widgetBegin(sliderName);
+            encode(data, n);
 
-                free(textClr);
-            }
+            _fresh = 0;
+            textClr.release();
 
-            sliderData += BLINKER_F("}");
+            Blinker.widgetEnd(sliderName, data, &_delta);
+        }
 
-            _fresh = 0;
+        // an attribute that couldn't be stored isn't sent
+        void fresh(uint8_t bit, bool set)
+        {
+            if (set) _fresh |= 0x01 << bit;
+            else _fresh &= ~(0x01 << bit);
+        }
 
-            Blinker.printArray(Blinker.widgetName_int(wNum), sliderData);
+        void encode(BlinkerWidgetWriter & w, const String & n)
+        {
+            if (n.length())
+            {
+                w.raw(BLINKER_WIDGET_RAW(BLINKER_CMD_VALUE), n);
+            }
+            if (_fresh >> 0 & 0x01)
+            {
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_COLOR), textClr.c_str());
+            }
+            w.close();
         }
 };
 
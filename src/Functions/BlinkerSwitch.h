@@ -17,7 +17,11 @@ class BlinkerSwitch
         }
         void print(const String & _state)
         {
-            Blinker.print(BLINKER_CMD_BUILTIN_SWITCH, _state);
+            String state = BLINKER_F("\"");
+            state += _state;
+            state += BLINKER_F("\"");
+
+            Blinker.printWidget(BLINKER_CMD_BUILTIN_SWITCH, state);
         }
     
     private :
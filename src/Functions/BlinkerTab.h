@@ -3,14 +3,25 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerWidgetWriter.h"
 
 class BlinkerTab
 {
     public :
+        template <size_t N>
+        BlinkerTab(const char (&_name)[N], blinker_callback_with_table_arg_t _func = NULL,
+                    blinker_callback_t _func2 = NULL)
+            : tabName(_name)
+        {
+            wNum = Blinker.attachWidget((char*)_name, _func, _func2);
+            tabSet = 0;
+        }
+
         BlinkerTab(char _name[], blinker_callback_with_table_arg_t _func = NULL,
                     blinker_callback_t _func2 = NULL)
         {
             wNum = Blinker.attachWidget(_name, _func, _func2);
+            if (wNum) tabName = BlinkerWidgetName(Blinker.widgetName_tab(wNum));
             tabSet = 0;
         }
 
@@ -55,36 +66,24 @@ class BlinkerTab
         {
             if (wNum == 0) return;
 
-            String tabData = "";
-
-            tabData += BLINKER_F("{\"");
-            tabData += BLINKER_F(BLINKER_CMD_VALUE);
-            tabData += BLINKER_F("\":\"");
-            // tabData += (_state);
-            if (tabSet & 1 << 4) tabData += BLINKER_F("1");
-            else tabData += BLINKER_F("0");
-            
-            if (tabSet & 1 << 3) tabData += BLINKER_F("1");
-            else tabData += BLINKER_F("0");
-            
-            if (tabSet & 1 << 2) tabData += BLINKER_F("1");
-            else tabData += BLINKER_F("0");
-            
-            if (tabSet & 1 << 1) tabData += BLINKER_F("1");
-            else tabData += BLINKER_F("0");
+            char tabs[6];
+            char * p = tabs;
 
-            if (tabSet & 1 << 0) tabData += BLINKER_F("1");
-            else tabData += BLINKER_F("0");
-            
-            tabData += BLINKER_F("\"}");
+            for (int8_t i = 4; i >= 0; i--) *p++ = (tabSet & 1 << i) ? '1' : '0';
+            *p = '\0';
 
             tabSet = 0;
 
-            Blinker.printArray(Blinker.widgetName_tab(wNum), tabData);
+            BlinkerWidgetWriter data = Blinker.widgetBegin(tabName);
+            data.str(BLINKER_WIDGET_STR(BLINKER_CMD_VALUE), tabs);
+            data.close();
+
+            Blinker.widgetEnd(tabName, data);
         }
 
     private :
         uint8_t wNum;
+        BlinkerWidgetName tabName;
         uint8_t tabSet;
 };
 
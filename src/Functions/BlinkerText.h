@@ -3,14 +3,22 @@
 
 #include "../Blinker/BlinkerConfig.h"
 #include "../Blinker/BlinkerUtility.h"
+#include "BlinkerWidgetWriter.h"
+#include "BlinkerWidgetDelta.h"
 
 class BlinkerText
 {
     public :
+        template <size_t N>
+        BlinkerText(const char (&_name)[N])
+            : textName(_name)
+        {}
+
         BlinkerText(char _name[])
         {
-            textName = (char*)malloc((strlen(_name)+1)*sizeof(char));
-            strcpy(textName, _name);
+            char * name = (char*)malloc((strlen(_name)+1)*sizeof(char));
+            strcpy(name, _name);
+            textName = BlinkerWidgetName(name);
         }
         
         template <typename T>
@@ -18,39 +26,7 @@ class BlinkerText
         {
             // if (isnan(_text)) return;
 
-            String textData = BLINKER_F("{\"");
-            textData += BLINKER_F(BLINKER_CMD_TEXT);
-            textData += BLINKER_F("\":\"");
-            textData += STRING_format(_text);
-            textData += BLINKER_F("\"");
-            if (_fresh >> 0 & 0x01)
-            {
-                
-                textData += BLINKER_F(",\"");
-                textData += BLINKER_F(BLINKER_CMD_ICON);
-                textData += BLINKER_F("\":\"");
-                textData += nicon;
-                textData += BLINKER_F("\"");
-
-                free(nicon);
-            }
-
-            if (_fresh >> 1 & 0x01)
-            {
-                textData += BLINKER_F(",\"");
-                textData += BLINKER_F(BLINKER_CMD_COLOR);
-                textData += BLINKER_F("\":\"");
-                textData += ncolor;
-                textData += BLINKER_F("\"");
-
-                free(ncolor);
-            }
-
-            textData += BLINKER_F("}");
-
-            _fresh = 0;
-
-            Blinker.printArray(textName, textData);
+            if (ntext.set(_text)) _print(false);
         }
 
         template <typename T1, typename T2>
@@ -58,71 +34,73 @@ class BlinkerText
         {
             // if (isnan(_text1) || isnan(_text2)) return;
 
-            String textData = BLINKER_F("{\"");
-            textData += BLINKER_F(BLINKER_CMD_TEXT);
-            textData += BLINKER_F("\":\"");
-            textData += STRING_format(_text1);
-            textData += BLINKER_F("\",\"");
-            textData += BLINKER_F(BLINKER_CMD_TEXT1);
-            textData += BLINKER_F("\":\"");
-            textData += STRING_format(_text2);
-            textData += BLINKER_F("\"");
+            if (ntext.set(_text1) && ntext1.set(_text2)) _print(true);
+            else ntext.release();
+        }
 
-            if (_fresh >> 0 & 0x01)
-            {
-                
-                textData += BLINKER_F(",\"");
-                textData += BLINKER_F(BLINKER_CMD_ICON);
-                textData += BLINKER_F("\":\"");
-                textData += nicon;
-                textData += BLINKER_F("\"");
+        void icon(const String & _icon)     { fresh(0, nicon.set(_icon)); }
+        void color(const String & _clr)     { fresh(1, ncolor.set(_clr)); }
 
-                free(nicon);
-            }
-
-            if (_fresh >> 1 & 0x01)
-            {
-                textData += BLINKER_F(",\"");
-                textData += BLINKER_F(BLINKER_CMD_COLOR);
-                textData += BLINKER_F("\":\"");
-                textData += ncolor;
-                textData += BLINKER_F("\"");
+        // see BlinkerWidgetDelta
+        void interval(uint32_t ms)          { _delta.interval(ms); }
+        void refresh(uint32_t ms)           { _delta.refresh(ms); }
+    
+    private :
+        BlinkerWidgetValue nicon;
+        BlinkerWidgetValue ncolor;
+        BlinkerWidgetValue ntext;
+        BlinkerWidgetValue ntext1;
+        BlinkerWidgetName textName;
+        uint8_t _fresh = 0;
+        BlinkerWidgetDelta _delta;
 
-                free(ncolor);
-            }
+        void _print(bool both)
+        {
+            BlinkerWidgetWriter data = Blinker.widgetBegin(textName);
+            encode(data, both);
 
-            textData += BLINKER_F("}");
+            ntext.release();
+            ntext1.release();
 
-            _fresh = 0;
+            if (data.full() ||
+                _delta.pass(data.c_str(), Blinker.heartbeating(), millis()))
+            {
+                _fresh = 0;
+                nicon.release();
+                ncolor.release();
 
-            Blinker.printArray(textName, textData);
+                Blinker.widgetEnd(textName, data, &_delta);
+            }
+            else
+            {
+                Blinker.widgetEnd(textName, data, &_delta, false);
+            }
         }
 
-        void icon(const String & _icon)
+        // an attribute that couldn't be stored isn't sent
+        void fresh(uint8_t bit, bool set)
         {
-            if (_fresh >> 0 & 0x01) free(nicon);
-
-            nicon = (char*)malloc((_icon.length()+1)*sizeof(char));
-            strcpy(nicon, _icon.c_str());
-
-            _fresh |= 0x01 << 0;
+            if (set) _fresh |= 0x01 << bit;
+            else _fresh &= ~(0x01 << bit);
         }
 
-        void color(const String & _clr)
+        void encode(BlinkerWidgetWriter & w, bool both)
         {
-            if (_fresh >> 1 & 0x01) free(ncolor);
-
-            ncolor = (char*)malloc((_clr.length()+1)*sizeof(char));
-            strcpy(ncolor, _clr.c_str());
-
-            _fresh |= 0x01 << 1;
+            w.str(BLINKER_WIDGET_STR(BLINKER_CMD_TEXT), ntext.c_str());
+            if (both)
+            {
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_TEXT1), ntext1.c_str());
+            }
+            if (_fresh >> 0 & 0x01)
+            {
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_ICON), nicon.c_str());
+            }
+            if (_fresh >> 1 & 0x01)
+            {
+                w.str(BLINKER_WIDGET_STR(BLINKER_CMD_COLOR), ncolor.c_str());
+            }
+            w.close();
         }
-    
-    private :
-        char * nicon;// = "";
-        char * ncolor;// = "";
-        char * textName;
-        uint8_t _fresh = 0;
 };
 
 #endif
@@ -15,19 +15,17 @@ extern "C" {
     typedef void (*blinker_callback_t)(void);
 }
 
+// One shot ticker for the boards without BLINKER_WHEEL, the sketch calls
+// run() from its loop.
 class BlinkerTicker
 {
     public :
         BlinkerTicker() {}
-            // : day_time(0)
-            // , os_time(0)
-        // {}
-
-        // void freshTime(uint32_t time_s) { day_time = time_s; os_time = millis(); }
 
         void attach(uint32_t seconds, blinker_callback_t func)
         {
-            aim_time = seconds;
+            start_time = millis();
+            aim_time = seconds * 1000;
             tickerFunc = func;
 
             isRun = true;
@@ -35,35 +33,22 @@ class BlinkerTicker
 
         void detach() { isRun = false; }
 
+        bool active() const { return isRun; }
+
         void run()
         {
-            if (millis() - os_time >= 1000 && millis() - os_time < 2000)
-            {
-                os_time += 1000;
-                tick_time ++;
-            }
-            else if (millis() - os_time >= 2000)
-            {
-                tick_time += (millis() - os_time) / 1000;
-                os_time = millis();
-            }
-
-            if (isRun)
+            if (isRun && millis() - start_time >= aim_time)
             {
-                if (tick_time - aim_time >= 0 && tick_time - aim_time < 60)
-                {
-                    BLINKER_LOG_ALL(BLINKER_F("ticker trigged"));
-                    isRun = false;
+                BLINKER_LOG_ALL(BLINKER_F("ticker trigged"));
+                isRun = false;
 
-                    if (tickerFunc) tickerFunc();
-                }
+                if (tickerFunc) tickerFunc();
             }
         }
 
     protected :
-        uint32_t tick_time;
-        uint32_t os_time;
-        uint32_t aim_time;
+        uint32_t start_time = 0;
+        uint32_t aim_time = 0;
         bool     isRun = false;
 
         blinker_callback_t tickerFunc = NULL;
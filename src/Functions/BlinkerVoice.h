@@ -0,0 +1,192 @@
+#ifndef BLINKER_VOICE_H
+#define BLINKER_VOICE_H
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "../Blinker/BlinkerConfig.h"
+#include "../Blinker/BlinkerDebug.h"
+
+// Shared pieces of the AliGenie, DuerOS and MIOT bindings.
+//
+// Replies are kept as typed values in fixed slots and written straight
+// into one stack buffer when printed, answering a query no longer
+// allocates per field. Incoming keys are decoded once into
+// blinker_voice_key_t so the parsers can switch on them.
+
+enum blinker_voice_key_t
+{
+    BLINKER_VOICE_UNKNOWN,
+    BLINKER_VOICE_STATE,
+    BLINKER_VOICE_POWERSTATE,
+    BLINKER_VOICE_NUM,
+    BLINKER_VOICE_COLOR,
+    BLINKER_VOICE_COLOR_,
+    BLINKER_VOICE_MODE,
+    BLINKER_VOICE_CANCELMODE,
+    BLINKER_VOICE_COLORTEMP,
+    BLINKER_VOICE_UPCOLORTEMP,
+    BLINKER_VOICE_DOWNCOLORTEMP,
+    BLINKER_VOICE_BRIGHTNESS,
+    BLINKER_VOICE_UPBRIGHTNESS,
+    BLINKER_VOICE_DOWNBRIGHTNESS,
+    BLINKER_VOICE_TEMP,
+    BLINKER_VOICE_HUMI,
+    BLINKER_VOICE_PM25,
+    BLINKER_VOICE_PM10,
+    BLINKER_VOICE_CO2,
+    BLINKER_VOICE_AQI,
+    BLINKER_VOICE_TIME
+};
+
+uint8_t blinkerVoiceKey(const char * key)
+{
+    static const struct
+    {
+        const char *    name;
+        uint8_t         key;
+    } keys[] = {
+        { BLINKER_CMD_POWERSTATE,       BLINKER_VOICE_POWERSTATE },
+        { BLINKER_CMD_NUM,              BLINKER_VOICE_NUM },
+        { BLINKER_CMD_STATE,            BLINKER_VOICE_STATE },
+        { BLINKER_CMD_COLOR,            BLINKER_VOICE_COLOR },
+        { BLINKER_CMD_COLOR_,           BLINKER_VOICE_COLOR_ },
+        { BLINKER_CMD_MODE,             BLINKER_VOICE_MODE },
+        { BLINKER_CMD_CANCELMODE,       BLINKER_VOICE_CANCELMODE },
+        { BLINKER_CMD_COLORTEMP,        BLINKER_VOICE_COLORTEMP },
+        { BLINKER_CMD_UPCOLORTEMP,      BLINKER_VOICE_UPCOLORTEMP },
+        { BLINKER_CMD_DOWNCOLORTEMP,    BLINKER_VOICE_DOWNCOLORTEMP },
+        { BLINKER_CMD_BRIGHTNESS,       BLINKER_VOICE_BRIGHTNESS },
+        { BLINKER_CMD_UPBRIGHTNESS,     BLINKER_VOICE_UPBRIGHTNESS },
+        { BLINKER_CMD_DOWNBRIGHTNESS,   BLINKER_VOICE_DOWNBRIGHTNESS },
+        { BLINKER_CMD_TEMP,             BLINKER_VOICE_TEMP },
+        { BLINKER_CMD_HUMI,             BLINKER_VOICE_HUMI },
+        { BLINKER_CMD_PM25,             BLINKER_VOICE_PM25 },
+        { BLINKER_CMD_PM10,             BLINKER_VOICE_PM10 },
+        { BLINKER_CMD_CO2,              BLINKER_VOICE_CO2 },
+        { BLINKER_CMD_AQI,              BLINKER_VOICE_AQI },
+        { BLINKER_CMD_TIME_ALL,         BLINKER_VOICE_TIME }
+    };
+
+    if (key == NULL) return BLINKER_VOICE_UNKNOWN;
+
+    for (uint8_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+    {
+        if (strcmp(key, keys[i].name) == 0) return keys[i].key;
+    }
+    return BLINKER_VOICE_UNKNOWN;
+}
+
+// Numbers arrive either as JSON numbers or as strings
+template <typename T>
+int32_t blinkerVoiceInt(const T & value)
+{
+    const char * s = value.template as<const char *>();
+
+    return s ? atol(s) : value.template as<int32_t>();
+}
+
+// A value as it goes on the wire, numbers keep the formatting of the
+// overload they were set with. Numbers take BlinkerVoiceValue, names
+// BlinkerVoiceText.
+template <size_t N>
+class BlinkerVoiceSlot
+{
+    public :
+        BlinkerVoiceSlot() { text[0] = '\0'; }
+
+        void set(const char * s)
+        {
+            size_t len = strlen(s);
+
+            if (len >= N)
+            {
+                // Cut before the character that doesn't fit whole, a mode
+                // or color name is often UTF-8
+                len = N - 1;
+                while (len && ((uint8_t)s[len] & 0xC0) == 0x80) len--;
+
+                BLINKER_ERR_LOG(BLINKER_F("voice value truncated: "), s);
+            }
+
+            memcpy(text, s, len);
+            text[len] = '\0';
+        }
+
+        void set(const String & s)  { set(s.c_str()); }
+
+        void set(int32_t num)       { ltoa(num, text, 10); }
+
+        void set(uint32_t num)      { ultoa(num, text, 10); }
+
+        void set(double num)
+        {
+            // Two decimals like String(double), clamped to fit the slot
+            if (num > 999999999.0) num = 999999999.0;
+            else if (num < -999999999.0) num = -999999999.0;
+
+            dtostrf(num, 1, 2, text);
+        }
+
+        char text[N];
+};
+
+typedef BlinkerVoiceSlot<BLINKER_VOICE_VALUE_SIZE>  BlinkerVoiceValue;
+typedef BlinkerVoiceSlot<BLINKER_VOICE_TEXT_SIZE>   BlinkerVoiceText;
+
+// Fixed capacity writer of one JSON object, members are added in order.
+template <size_t N>
+class BlinkerVoiceWriter
+{
+    public :
+        BlinkerVoiceWriter() : _len(0), _full(false) { _buf[0] = '\0'; }
+
+        // Opens the object or separates the next member
+        void key(const char * k)
+        {
+            put(_len ? ',' : '{');
+            str(k);
+            put(':');
+        }
+
+        void str(const char * s)
+        {
+            put('"');
+            while (*s)
+            {
+                if (*s == '"' || *s == '\\') put('\\');
+                put(*s++);
+            }
+            put('"');
+        }
+
+        void raw(const char * s)    { while (*s) put(*s++); }
+
+        void raw(char c)            { put(c); }
+
+        void close()                { if (_len) put('}'); }
+
+        const char * c_str() const  { return _buf; }
+        size_t length() const       { return _len; }
+        bool full() const           { return _full; }
+
+    private :
+        char    _buf[N];
+        size_t  _len;
+        bool    _full;
+
+        void put(char c)
+        {
+            if (_len + 1 >= N)
+            {
+                _full = true;
+                return;
+            }
+            _buf[_len++] = c;
+            _buf[_len] = '\0';
+        }
+};
+
+typedef BlinkerVoiceWriter<BLINKER_VOICE_PAYLOAD_SIZE> BlinkerVoicePayload;
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef BLINKER_WIDGET_DELTA_H
+#define BLINKER_WIDGET_DELTA_H
+
+#include <math.h>
+#include <string.h>
+
+#include "../Blinker/BlinkerConfig.h"
+
+// Decides whether a widget print goes out, by comparing it with the last
+// one sent.
+//
+// Numbers compare their value against a deadband, the larger of an
+// absolute step and a fraction of the last value. Other widgets compare a
+// hash of the whole message. A change closer than the minimum interval to
+// the last message is dropped, the next print after it goes out. An
+// unchanged print still goes out once the refresh time passed, 0 never
+// refreshes. Whatever is printed from the heartbeat callback goes out.
+//
+// A print that passes is only remembered as sent once sent() confirms the
+// publish, a lost one leaves the last sent state as it was and the next
+// print goes out again.
+
+class BlinkerWidgetDelta
+{
+    public :
+        BlinkerWidgetDelta()
+            : pendingNext(NULL), _time(0), _hash(0), _value(0)
+            , _nextTime(0), _nextHash(0), _nextValue(0)
+            , _absolute(0), _relative(0)
+            , _interval(BLINKER_WIDGET_MIN_INTERVAL)
+            , _refresh(BLINKER_WIDGET_REFRESH_TIME), _sent(false), _pending(false)
+        {}
+
+        void deadband(float absolute, float relative = 0)
+        {
+            _absolute = fabs(absolute);
+            _relative = fabs(relative);
+        }
+        void interval(uint32_t ms)      { _interval = ms; }
+        void refresh(uint32_t ms)       { _refresh = ms; }
+
+        // a numeric value, attrs when other attributes are in the message
+        // compared with the print still on its way when there is one, it's
+        // what the app sees next
+        bool pass(double value, bool attrs, bool force, uint32_t now)
+        {
+            double last = _pending ? _nextValue : _value;
+            double band = _absolute;
+
+            if (_relative * fabs(last) > band) band = _relative * fabs(last);
+
+            bool changed = attrs || (band > 0 ? fabs(value - last) > band
+                                                : value != last);
+
+            if (!check(changed, force, now)) return false;
+
+            _nextValue = value;
+            return true;
+        }
+
+        bool pass(const char * data, bool force, uint32_t now)
+        {
+            uint32_t h = 0x811c9dc5;
+
+            while (*data)
+            {
+                h ^= (uint8_t)*data++;
+                h *= 0x01000193;
+            }
+
+            if (!check(h != (_pending ? _nextHash : _hash), force, now)) return false;
+
+            _nextHash = h;
+            return true;
+        }
+
+        // the message carrying the last print that passed was published,
+        // or was lost
+        void sent(bool ok)
+        {
+            if (!_pending) return;
+
+            if (ok)
+            {
+                _time = _nextTime;
+                _hash = _nextHash;
+                _value = _nextValue;
+                _sent = true;
+            }
+
+            _pending = false;
+        }
+
+        bool pending() const            { return _pending; }
+
+        // BlinkerProtocol chains the widgets waiting on the message it fills
+        BlinkerWidgetDelta * pendingNext;
+
+    private :
+        uint32_t    _time;
+        uint32_t    _hash;
+        double      _value;
+        uint32_t    _nextTime;
+        uint32_t    _nextHash;
+        double      _nextValue;
+        float       _absolute;
+        float       _relative;
+        uint32_t    _interval;
+        uint32_t    _refresh;
+        bool        _sent;
+        bool        _pending;
+
+        bool check(bool changed, bool force, uint32_t now)
+        {
+        #if !defined(BLINKER_WITHOUT_WIDGET_DELTA)
+            if (_sent && !force)
+            {
+                if (changed && (now - _time) < _interval) return false;
+
+                if (!changed && (_refresh == 0 || (now - _time) < _refresh))
+                {
+                    return false;
+                }
+            }
+        #endif
+
+            _nextTime = now;
+            _nextHash = _hash;
+            _nextValue = _value;
+            _pending = true;
+
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef BLINKER_WIDGET_WRITER_H
+#define BLINKER_WIDGET_WRITER_H
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "../Blinker/BlinkerConfig.h"
+#include "../Blinker/BlinkerDebug.h"
+#include "../Blinker/BlinkerUtility.h"
+
+// Shared encoder of the widget updates.
+//
+// Key fragments are string literals put together by the preprocessor, quote
+// and colon included, and kept in flash. A widget named by a string literal
+// keeps the literal and its length as they are. Only the values are
+// formatted at runtime, in a single pass straight into the message
+// BlinkerProtocol is batching, no String is built for a print.
+
+#define BLINKER_WIDGET_STR(key)     BLINKER_F("\"" key "\":\"")
+#define BLINKER_WIDGET_RAW(key)     BLINKER_F("\"" key "\":")
+
+// The name of a widget, the key its updates go under. A string literal is
+// taken as it is, other names must outlive the widget.
+class BlinkerWidgetName
+{
+    public :
+        BlinkerWidgetName() : _name(""), _len(0) {}
+
+        template <size_t N>
+        BlinkerWidgetName(const char (&name)[N]) : _name(name), _len(N - 1) {}
+
+        explicit BlinkerWidgetName(const char * name)
+            : _name(name), _len(strlen(name))
+        {}
+
+        const char * c_str() const  { return _name; }
+        size_t length() const       { return _len; }
+
+    private :
+        const char *    _name;
+        size_t          _len;
+};
+
+// A widget attribute set between two prints. The buffer is freed once the
+// print took it, an attribute that couldn't be stored is dropped.
+class BlinkerWidgetValue
+{
+    public :
+        BlinkerWidgetValue() : _buf(NULL), _cap(0) {}
+        ~BlinkerWidgetValue() { free(_buf); }
+
+        bool set(const char * s, size_t len)
+        {
+            if (len + 1 > _cap)
+            {
+                char * buf = (char*)realloc(_buf, len + 1);
+
+                if (buf == NULL)
+                {
+                    BLINKER_ERR_LOG(BLINKER_F("widget value alloc failed"));
+                    release();
+                    return false;
+                }
+                _buf = buf;
+                _cap = len + 1;
+            }
+            memcpy(_buf, s, len);
+            _buf[len] = '\0';
+
+            return true;
+        }
+
+        bool set(const char * s)    { return set(s, strlen(s)); }
+        bool set(const String & s)  { return set(s.c_str(), s.length()); }
+
+        template <typename T>
+        bool set(T value)           { return set(STRING_format(value)); }
+
+        void release()
+        {
+            free(_buf);
+            _buf = NULL;
+            _cap = 0;
+        }
+
+        const char * c_str() const  { return _buf ? _buf : ""; }
+
+    private :
+        char *  _buf;
+        size_t  _cap;
+
+        BlinkerWidgetValue(const BlinkerWidgetValue &);
+        BlinkerWidgetValue & operator=(const BlinkerWidgetValue &);
+};
+
+// Writes the value of one widget update into the room the message being
+// batched has left for it, kept NUL terminated. What doesn't fit marks the
+// writer full and the update is dropped whole.
+class BlinkerWidgetWriter
+{
+    public :
+        BlinkerWidgetWriter(char * buf, size_t room)
+            : _buf(buf), _room(room), _len(0), _full(buf == NULL)
+        {
+            if (_buf) *_buf = '\0';
+        }
+
+        // key is a BLINKER_WIDGET_STR() fragment, the value gets quoted
+        void str(const __FlashStringHelper * key, const char * value)
+        {
+            member(key);
+            put(value, strlen(value));
+            put('"');
+        }
+
+        void str(const __FlashStringHelper * key, const String & value)
+        {
+            member(key);
+            put(value.c_str(), value.length());
+            put('"');
+        }
+
+        // key is a BLINKER_WIDGET_RAW() fragment, the value is written as is
+        void raw(const __FlashStringHelper * key, const char * value)
+        {
+            member(key);
+            put(value, strlen(value));
+        }
+
+        void raw(const __FlashStringHelper * key, const String & value)
+        {
+            member(key);
+            put(value.c_str(), value.length());
+        }
+
+        // a whole value the widget encoded itself
+        void write(const char * value, size_t len)  { put(value, len); }
+
+        void close()                { if (_len) put('}'); }
+
+        size_t length() const       { return _len; }
+        bool full() const           { return _full; }
+        const char * c_str() const  { return _buf ? _buf : ""; }
+
+    private :
+        char *      _buf;
+        size_t      _room;
+        size_t      _len;
+        bool        _full;
+
+        void member(const __FlashStringHelper * key)
+        {
+            PGM_P p = reinterpret_cast<PGM_P>(key);
+            size_t len = strlen_P(p);
+
+            put(_len ? ',' : '{');
+            if (!room(len)) return;
+
+            memcpy_P(_buf + _len, p, len);
+            _len += len;
+            _buf[_len] = '\0';
+        }
+
+        void put(const char * s, size_t len)
+        {
+            if (!room(len)) return;
+
+            memcpy(_buf + _len, s, len);
+            _len += len;
+            _buf[_len] = '\0';
+        }
+
+        void put(char c)            { put(&c, 1); }
+
+        bool room(size_t len)
+        {
+            if (!_full && len > _room - _len) _full = true;
+
+            return !_full;
+        }
+};
+
+#endif
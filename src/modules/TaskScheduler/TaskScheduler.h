@@ -145,7 +145,14 @@
 //
 // v3.0.2:
 //    2018-11-11 - bug: default constructor is ambiguous when Status Request objects are enabled (github issue #65 & #68)
-#if defined(ESP8266) || defined(ESP32)
+//
+// v3.0.3 (blinker):
+//    2026-10-19 - _TASK_HEAP_QUEUE compilation option: enabled tasks are kept in a binary heap ordered by their
+//                 next run time, execute() only visits the tasks which are due instead of walking the entire chain
+//    2026-10-19 - new Scheduler method timeUntilNextTask() - how long the caller may sleep before execute() has work
+//    2026-10-19 - bug: disable() accessed the task after OnDisable deleted it
+//    2026-10-19 - addTask() returns false when the queue cannot grow for the task
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
 #include <Arduino.h>
 #include "TaskSchedulerDeclarations.h"
 
@@ -168,6 +175,7 @@
 // #define _TASK_INLINE		       // Make all methods "inline" - needed to support some multi-tab, multi-file implementations
 // #define _TASK_TIMEOUT           // Support for overall task timeout
 // #define _TASK_OO_CALLBACKS      // Support for callbacks via inheritance
+// #define _TASK_HEAP_QUEUE        // Keep enabled tasks in a queue ordered by next run time, execute() only visits due tasks
 
  #ifdef _TASK_MICRO_RES
 
@@ -207,7 +215,7 @@ extern "C" {
 #endif  // _TASK_SLEEP_ON_IDLE_RUN
 
 
-#if !defined (ARDUINO_ARCH_ESP8266) && !defined (ARDUINO_ARCH_ESP32)
+#if defined (ARDUINO) && !defined (ARDUINO_ARCH_ESP8266) && !defined (ARDUINO_ARCH_ESP32)
 #ifdef _TASK_STD_FUNCTION
     #error Support for std::function only for ESP8266 or ESP32 architecture
 #undef _TASK_STD_FUNCTION
@@ -222,6 +230,15 @@ extern "C" {
     Scheduler* iCurrentScheduler;
 #endif // _TASK_PRIORITY
 
+// Every change of a task's schedule has to reposition it in the queue.
+// Run times are compared as signed differences, so intervals and delays
+// must stay below 2^31 time units (~24 days, or ~35 minutes with _TASK_MICRO_RES)
+#ifdef _TASK_HEAP_QUEUE
+#define _TASK_REQUEUE()     requeue()
+#else
+#define _TASK_REQUEUE()
+#endif  // _TASK_HEAP_QUEUE
+
 
 // ------------------ TaskScheduler implementation --------------------
 
@@ -404,8 +421,45 @@ void Task::reset() {
 	iStarttime = 0;
 	iStatus.timeout = false;
 #endif  // _TASK_TIMEOUT
+
+#ifdef _TASK_HEAP_QUEUE
+    iNextRun = 0;
+    iHeapIndex = _TASK_HEAP_NONE;
+    iDeferNext = NULL;
+#endif  // _TASK_HEAP_QUEUE
+}
+
+/** Returns the next time the scheduler has to look at the task:
+ * its next iteration, its timeout, or the next pass if it is about
+ * to be disabled or waits for a StatusRequest
+ */
+unsigned long Task::nextRun() {
+#ifdef _TASK_STATUS_REQUEST
+    if ( iStatus.waiting ) return iPreviousMillis;
+#endif  // _TASK_STATUS_REQUEST
+
+    if ( iIterations == 0 ) return iPreviousMillis;
+
+    unsigned long t = iPreviousMillis + iDelay;
+
+#ifdef _TASK_TIMEOUT
+    if ( iTimeout ) {
+        unsigned long o = iStarttime + iTimeout + 1;
+        if ( (long) (o - t) < 0 ) t = o;
+    }
+#endif  // _TASK_TIMEOUT
+
+    return t;
 }
 
+#ifdef _TASK_HEAP_QUEUE
+/** Repositions the task in its scheduler's queue after a change of schedule
+ */
+void Task::requeue() {
+    if (iScheduler) iScheduler->requeue(*this);
+}
+#endif  // _TASK_HEAP_QUEUE
+
 /** Explicitly set Task execution parameters
  * @param aInterval - execution interval in ms
  * @param aIterations - number of iterations, use -1 for no limit
@@ -425,6 +479,7 @@ void Task::set(unsigned long aInterval, long aIterations, TaskCallback aCallback
 
     setInterval(aInterval);
     iSetIterations = iIterations = aIterations;
+    _TASK_REQUEUE();
 }
 
 /** Sets number of iterations for the task
@@ -433,6 +488,7 @@ void Task::set(unsigned long aInterval, long aIterations, TaskCallback aCallback
  */
 void Task::setIterations(long aIterations) {
     iSetIterations = iIterations = aIterations;
+    _TASK_REQUEUE();
 }
 
 #ifndef _TASK_OO_CALLBACKS
@@ -449,6 +505,7 @@ void Task::yield (TaskCallback aCallback) {
     // a series of callback methods
     iRunCounter--;
     if ( iIterations >= 0 ) iIterations++;
+    _TASK_REQUEUE();
 }
 
 /** Prepare task for next step iteration following yielding of control to the scheduler
@@ -457,6 +514,7 @@ void Task::yield (TaskCallback aCallback) {
 void Task::yieldOnce (TaskCallback aCallback) {
     yield(aCallback);
     iIterations = 1;
+    _TASK_REQUEUE();
 }
 #endif // _TASK_OO_CALLBACKS
 
@@ -503,6 +561,8 @@ void Task::enable() {
             iMyStatusRequest.setWaiting();
         }
 #endif // _TASK_STATUS_REQUEST
+
+        _TASK_REQUEUE();
     }
 }
 
@@ -527,11 +587,13 @@ void Task::enableDelayed(unsigned long aDelay) {
 void Task::setTimeout(unsigned long aTimeout, bool aReset) {
 	iTimeout = aTimeout;
 	if (aReset) resetTimeout();
+    _TASK_REQUEUE();
 }
 
 void Task::resetTimeout() {
 	iStarttime = _TASK_TIME_FUNCTION();
 	iStatus.timeout = false;
+    _TASK_REQUEUE();
 }
 
 unsigned long Task::getTimeout() {
@@ -561,6 +623,7 @@ void Task::delay(unsigned long aDelay) {
 //  if (!aDelay) aDelay = iInterval;
     iDelay = aDelay ? aDelay : iInterval;
     iPreviousMillis = _TASK_TIME_FUNCTION(); // - iInterval + aDelay;
+    _TASK_REQUEUE();
 }
 
 /** Schedules next iteration of Task for execution immediately (if enabled)
@@ -569,6 +632,7 @@ void Task::delay(unsigned long aDelay) {
  */
 void Task::forceNextIteration() {
     iPreviousMillis = _TASK_TIME_FUNCTION() - (iDelay = iInterval);
+    _TASK_REQUEUE();
 }
 
 /** Sets the execution interval.
@@ -590,6 +654,7 @@ bool Task::disable() {
     bool previousEnabled = iStatus.enabled;
     iStatus.enabled = false;
     iStatus.inonenable = false;
+    _TASK_REQUEUE();    // before OnDisable, which may delete the task
 
 #ifdef _TASK_OO_CALLBACKS
     if (previousEnabled) {
@@ -597,15 +662,16 @@ bool Task::disable() {
     if (previousEnabled && iOnDisable) {
 #endif // _TASK_OO_CALLBACKS
 
-        Task *current = iScheduler->iCurrent;
-        iScheduler->iCurrent = this;
+        Scheduler *scheduler = iScheduler;  // OnDisable may delete the task
+        Task *current = scheduler->iCurrent;
+        scheduler->iCurrent = this;
 #ifdef _TASK_OO_CALLBACKS
         OnDisable();
 #else
         iOnDisable();
 #endif // _TASK_OO_CALLBACKS
 
-        iScheduler->iCurrent = current;
+        scheduler->iCurrent = current;
     }
 #ifdef _TASK_STATUS_REQUEST
     iMyStatusRequest.signalComplete();
@@ -620,6 +686,7 @@ bool Task::disable() {
 void Task::restart() {
     enable();
 	iIterations = iSetIterations;
+    _TASK_REQUEUE();
 }
 
 /** Restarts task delayed
@@ -628,6 +695,7 @@ void Task::restart() {
 void Task::restartDelayed(unsigned long aDelay) {
     enableDelayed(aDelay);
 	iIterations = iSetIterations;
+    _TASK_REQUEUE();
 }
 
 bool Task::isFirstIteration() { return (iRunCounter <= 1); }
@@ -664,15 +732,25 @@ void* Task::getLtsPointer() { return iLTS; }
  * Creates a scheduler with an empty execution chain.
  */
 Scheduler::Scheduler() {
+#ifdef _TASK_HEAP_QUEUE
+    iHeap = NULL;
+    iHeapSize = 0;
+#endif  // _TASK_HEAP_QUEUE
     init();
 }
 
+#ifdef _TASK_HEAP_QUEUE
+Scheduler::~Scheduler() {
+    free(iHeap);
+}
+#else
 /*
 Scheduler::~Scheduler() {
 #ifdef _TASK_SLEEP_ON_IDLE_RUN
 #endif // _TASK_SLEEP_ON_IDLE_RUN
 }
 */
+#endif  // _TASK_HEAP_QUEUE
 
 /** Initializes all internal varaibles
  */
@@ -681,6 +759,13 @@ void Scheduler::init() {
     iLast = NULL;
     iCurrent = NULL;
 
+#ifdef _TASK_HEAP_QUEUE
+    iHeapCount = 0;
+    iTaskCount = 0;
+    iDeferred = NULL;
+    iRunning = NULL;
+#endif  // _TASK_HEAP_QUEUE
+
 #ifdef _TASK_PRIORITY
     iHighPriority = NULL;
 #endif  // _TASK_PRIORITY
@@ -693,12 +778,28 @@ void Scheduler::init() {
 /** Appends task aTask to the tail of the execution chain.
  * @param &aTask - reference to the Task to be appended.
  * @note Task can only be part of the chain once.
+ * @note With _TASK_HEAP_QUEUE the queue grows here, so a task
+ * the queue has no memory for is not added at all.
+ * @return false if the task was not added for lack of memory
  */
- void Scheduler::addTask(Task& aTask) {
+bool Scheduler::addTask(Task& aTask) {
 
 // Avoid adding task twice to the same scheduler
     if (aTask.iScheduler == this)
-        return;
+        return true;
+
+#ifdef _TASK_HEAP_QUEUE
+    if (iTaskCount == iHeapSize) {
+        unsigned int size = iHeapSize ? iHeapSize * 2 : 8;
+        Task **heap = (Task**) realloc(iHeap, size * sizeof(Task*));
+
+        if (heap == NULL) return false;
+
+        iHeap = heap;
+        iHeapSize = size;
+    }
+    iTaskCount++;
+#endif  // _TASK_HEAP_QUEUE
 
     aTask.iScheduler = this;
 // First task situation:
@@ -714,12 +815,27 @@ void Scheduler::init() {
 // "Previous" last task gets linked to this one - as this one becomes the last one
     aTask.iNext = NULL;
     iLast = &aTask;
+
+#ifdef _TASK_HEAP_QUEUE
+    requeue(aTask);
+#endif  // _TASK_HEAP_QUEUE
+    return true;
 }
 
 /** Deletes specific Task from the execution chain
  * @param &aTask - reference to the task to be deleted from the chain
  */
 void Scheduler::deleteTask(Task& aTask) {
+#ifdef _TASK_HEAP_QUEUE
+    if (aTask.iScheduler == this) {
+        if (aTask.iHeapIndex >= 0) heapRemove(aTask);
+        if (aTask.iHeapIndex == _TASK_HEAP_DEFERRED) undefer(aTask);
+        if (&aTask == iRunning) iRunning = NULL;     // deleted by its own callback
+        aTask.iHeapIndex = _TASK_HEAP_NONE;
+        iTaskCount--;
+    }
+#endif  // _TASK_HEAP_QUEUE
+
 	aTask.iScheduler = NULL;
     if (aTask.iPrev == NULL) {
         if (aTask.iNext == NULL) {
@@ -819,7 +935,12 @@ void Scheduler::startNow( bool aRecursive ) {
 
     iCurrent = iFirst;
     while (iCurrent) {
-        if ( iCurrent->iStatus.enabled ) iCurrent->iPreviousMillis = t - iCurrent->iDelay;
+        if ( iCurrent->iStatus.enabled ) {
+            iCurrent->iPreviousMillis = t - iCurrent->iDelay;
+#ifdef _TASK_HEAP_QUEUE
+            requeue(*iCurrent);
+#endif  // _TASK_HEAP_QUEUE
+        }
         iCurrent = iCurrent->iNext;
     }
 
@@ -850,6 +971,41 @@ long Scheduler::timeUntilNextIteration(Task& aTask) {
     return ( d );
 }
 
+/** Returns number millis or micros until execute() has a task to run,
+ * including the higher priority schedulers, so the caller can sleep that long.
+ * Tasks waiting on a StatusRequest, timing out or finishing count as due when
+ * they have to be checked. Returns -1 if no task is enabled.
+ */
+long Scheduler::timeUntilNextTask() {
+    long d = -1;
+    unsigned long m = _TASK_TIME_FUNCTION();
+
+#ifdef _TASK_HEAP_QUEUE
+    if ( iDeferred ) d = 0;
+    else if ( iHeapCount ) {
+        long n = (long) (iHeap[0]->iNextRun - m);
+        d = n < 0 ? 0 : n;
+    }
+#else
+    for (Task *t = iFirst; t; t = t->iNext) {
+        if ( !t->iStatus.enabled ) continue;
+
+        long n = (long) (t->nextRun() - m);
+        if ( n < 0 ) n = 0;
+        if ( d < 0 || n < d ) d = n;
+    }
+#endif  // _TASK_HEAP_QUEUE
+
+#ifdef _TASK_PRIORITY
+    if ( iHighPriority ) {
+        long h = iHighPriority->timeUntilNextTask();
+        if ( h >= 0 && (d < 0 || h < d) ) d = h;
+    }
+#endif  // _TASK_PRIORITY
+
+    return ( d );
+}
+
 Task& Scheduler::currentTask() { return *iCurrent; }
 
 #ifdef _TASK_LTS_POINTER
@@ -861,115 +1017,273 @@ bool Scheduler::isOverrun() { return (iCurrent->iOverrun < 0); }
 
 
 
-/** Makes one pass through the execution chain.
- * Tasks are executed in the order they were added to the chain
- * There is no concept of priority
- * Different pseudo "priority" could be achieved
- * by running task more frequently
+#ifdef _TASK_HEAP_QUEUE
+
+/** Queue maintenance. The queue is a binary min-heap on Task::iNextRun,
+ * each queued task knows its position so it can be moved or removed
+ * without a search.
  */
-bool Scheduler::execute() {
-    bool     idleRun = true;
-    register unsigned long m, i;  // millis, interval;
+void Scheduler::heapSet(unsigned int aPos, Task* aTask) {
+    iHeap[aPos] = aTask;
+    aTask->iHeapIndex = aPos;
+}
 
-#ifdef _TASK_SLEEP_ON_IDLE_RUN
-#if defined (ARDUINO_ARCH_ESP8266) || defined (ARDUINO_ARCH_ESP32)
-      unsigned long t1 = micros();
-      unsigned long t2 = 0;
-#endif  // ARDUINO_ARCH_ESP8266
-#endif // _TASK_SLEEP_ON_IDLE_RUN
+void Scheduler::heapUp(unsigned int aPos) {
+    Task *t = iHeap[aPos];
 
-	Task *nextTask;  // support for deleting the task in the onDisable method
-    iCurrent = iFirst;
+    while (aPos) {
+        unsigned int parent = (aPos - 1) / 2;
+        if ( (long) (t->iNextRun - iHeap[parent]->iNextRun) >= 0 ) break;
+        heapSet(aPos, iHeap[parent]);
+        aPos = parent;
+    }
+    heapSet(aPos, t);
+}
 
-#ifdef _TASK_PRIORITY
-    // If lower priority scheduler does not have a single task in the chain
-    // the higher priority scheduler still has to have a chance to run
-        if (!iCurrent && iHighPriority) iHighPriority->execute();
-        iCurrentScheduler = this;
-#endif  // _TASK_PRIORITY
+void Scheduler::heapDown(unsigned int aPos) {
+    Task *t = iHeap[aPos];
+
+    for (;;) {
+        unsigned int child = aPos * 2 + 1;
+        if (child >= iHeapCount) break;
+        if (child + 1 < iHeapCount &&
+            (long) (iHeap[child + 1]->iNextRun - iHeap[child]->iNextRun) < 0) child++;
+        if ( (long) (iHeap[child]->iNextRun - t->iNextRun) >= 0 ) break;
+        heapSet(aPos, iHeap[child]);
+        aPos = child;
+    }
+    heapSet(aPos, t);
+}
 
+void Scheduler::heapRemove(Task& aTask) {
+    unsigned int pos = aTask.iHeapIndex;
+    Task *last = iHeap[--iHeapCount];
 
-    while (iCurrent) {
+    aTask.iHeapIndex = _TASK_HEAP_NONE;
+    if (pos == iHeapCount) return;
 
-#ifdef _TASK_PRIORITY
-    // If scheduler for higher priority tasks is set, it's entire chain is executed on every pass of the base scheduler
-        if (iHighPriority) idleRun = iHighPriority->execute() && idleRun;
-        iCurrentScheduler = this;
-#endif  // _TASK_PRIORITY
-		nextTask = iCurrent->iNext;
-        do {
-            if ( iCurrent->iStatus.enabled ) {
+    heapSet(pos, last);
+    heapUp(pos);
+    heapDown(last->iHeapIndex);
+}
+
+void Scheduler::undefer(Task& aTask) {
+    Task **p = &iDeferred;
+
+    while (*p && *p != &aTask) p = &(*p)->iDeferNext;
+    if (*p) *p = aTask.iDeferNext;
+    aTask.iDeferNext = NULL;
+    aTask.iHeapIndex = _TASK_HEAP_NONE;
+}
+
+/** Queues, moves or removes a task according to its current schedule
+ * @param &aTask - reference to a task of this scheduler
+ */
+void Scheduler::requeue(Task& aTask) {
+    int pos = aTask.iHeapIndex;
+
+    if (pos == _TASK_HEAP_RUNNING) return;      // execute() queues it after the callback
+    if (pos == _TASK_HEAP_DEFERRED) {           // queued at the end of the pass
+        if ( !aTask.iStatus.enabled ) undefer(aTask);
+        return;
+    }
+
+    if ( !aTask.iStatus.enabled ) {
+        if (pos >= 0) heapRemove(aTask);
+        return;
+    }
+
+    aTask.iNextRun = aTask.nextRun();
+    if (pos < 0) {
+        if (iHeapCount == iHeapSize) return;    // cannot happen, addTask() sized the queue for the whole chain
+        pos = iHeapCount++;
+        heapSet(pos, &aTask);
+    }
+    heapUp(pos);
+    heapDown(aTask.iHeapIndex);
+}
+
+#endif  // _TASK_HEAP_QUEUE
+
+/** Checks the current task and runs its callback method if it is due,
+ * disables it on the last iteration, on a timeout, and handles StatusRequest waiting
+ * @param &idleRun - set to false if a callback method was invoked
+ */
+void Scheduler::runCurrent(bool& idleRun) {
+    register unsigned long m, i;  // millis, interval;
+
+    do {
+        if ( iCurrent->iStatus.enabled ) {
 
 #ifdef _TASK_WDT_IDS
-    // For each task the control points are initialized to avoid confusion because of carry-over:
-                iCurrent->iControlPoint = 0;
+// For each task the control points are initialized to avoid confusion because of carry-over:
+            iCurrent->iControlPoint = 0;
 #endif  // _TASK_WDT_IDS
 
-    // Disable task on last iteration:
-                if (iCurrent->iIterations == 0) {
-                    iCurrent->disable();
-                    break;
-                }
-                m = _TASK_TIME_FUNCTION();
-                i = iCurrent->iInterval;
+// Disable task on last iteration:
+            if (iCurrent->iIterations == 0) {
+                iCurrent->disable();
+                break;
+            }
+            m = _TASK_TIME_FUNCTION();
+            i = iCurrent->iInterval;
 
 #ifdef _TASK_TIMEOUT
 	// Disable task on a timeout
 				if ( iCurrent->iTimeout && (m - iCurrent->iStarttime > iCurrent->iTimeout) ) {
 					iCurrent->iStatus.timeout = true;
 					iCurrent->disable();
-                    break;
+                break;
 				}
 #endif // _TASK_TIMEOUT
 
 #ifdef  _TASK_STATUS_REQUEST
-    // If StatusRequest object was provided, and still pending, and task is waiting, this task should not run
-    // Otherwise, continue with execution as usual.  Tasks waiting to StatusRequest need to be rescheduled according to
-    // how they were placed into waiting state (waitFor or waitForDelayed)
-                if ( iCurrent->iStatus.waiting ) {
-                    if ( (iCurrent->iStatusRequest)->pending() ) break;
-                    if (iCurrent->iStatus.waiting == _TASK_SR_NODELAY) {
-                        iCurrent->iPreviousMillis = m - (iCurrent->iDelay = i);
-                    }
-                    else {
-                        iCurrent->iPreviousMillis = m;
-                    }
-                    iCurrent->iStatus.waiting = 0;
+// If StatusRequest object was provided, and still pending, and task is waiting, this task should not run
+// Otherwise, continue with execution as usual.  Tasks waiting to StatusRequest need to be rescheduled according to
+// how they were placed into waiting state (waitFor or waitForDelayed)
+            if ( iCurrent->iStatus.waiting ) {
+                if ( (iCurrent->iStatusRequest)->pending() ) {
+#ifdef _TASK_HEAP_QUEUE
+                    iCurrent->iPreviousMillis = m;  // keeps the queue key of the waiting task current
+#endif  // _TASK_HEAP_QUEUE
+                    break;
+                }
+                if (iCurrent->iStatus.waiting == _TASK_SR_NODELAY) {
+                    iCurrent->iPreviousMillis = m - (iCurrent->iDelay = i);
+                }
+                else {
+                    iCurrent->iPreviousMillis = m;
                 }
+                iCurrent->iStatus.waiting = 0;
+            }
 #endif  // _TASK_STATUS_REQUEST
 
-                if ( m - iCurrent->iPreviousMillis < iCurrent->iDelay ) break;
+            if ( m - iCurrent->iPreviousMillis < iCurrent->iDelay ) break;
 
-                if ( iCurrent->iIterations > 0 ) iCurrent->iIterations--;  // do not decrement (-1) being a signal of never-ending task
-                iCurrent->iRunCounter++;
-                iCurrent->iPreviousMillis += iCurrent->iDelay;
+            if ( iCurrent->iIterations > 0 ) iCurrent->iIterations--;  // do not decrement (-1) being a signal of never-ending task
+            iCurrent->iRunCounter++;
+            iCurrent->iPreviousMillis += iCurrent->iDelay;
 
 #ifdef _TASK_TIMECRITICAL
-    // Updated_previous+current interval should put us into the future, so iOverrun should be positive or zero.
-    // If negative - the task is behind (next execution time is already in the past)
-                unsigned long p = iCurrent->iPreviousMillis;
-                iCurrent->iOverrun = (long) ( p + i - m );
-                iCurrent->iStartDelay = (long) ( m - p );
+// Updated_previous+current interval should put us into the future, so iOverrun should be positive or zero.
+// If negative - the task is behind (next execution time is already in the past)
+            unsigned long p = iCurrent->iPreviousMillis;
+            iCurrent->iOverrun = (long) ( p + i - m );
+            iCurrent->iStartDelay = (long) ( m - p );
 #endif  // _TASK_TIMECRITICAL
 
-                iCurrent->iDelay = i;
+            iCurrent->iDelay = i;
 
 #ifdef _TASK_OO_CALLBACKS
-                idleRun = !iCurrent->Callback();
+            idleRun = !iCurrent->Callback();
 #else
-                if ( iCurrent->iCallback ) {
-                    iCurrent->iCallback();
-                    idleRun = false;
-                }
+            if ( iCurrent->iCallback ) {
+                iCurrent->iCallback();
+                idleRun = false;
+            }
 #endif // _TASK_OO_CALLBACKS
 
+        }
+    } while (0);    //guaranteed single run - allows use of "break" to exit
+}
+
+/** Makes one pass through the execution chain.
+ * Tasks are executed in the order they were added to the chain
+ * There is no concept of priority
+ * Different pseudo "priority" could be achieved
+ * by running task more frequently
+ *
+ * With _TASK_HEAP_QUEUE only the tasks which are due are visited, earliest first.
+ * Each task runs at most once per pass, a task which is still behind schedule
+ * after running waits for the next pass like it does in the chain.
+ */
+bool Scheduler::execute() {
+    bool     idleRun = true;
+
+#ifdef _TASK_SLEEP_ON_IDLE_RUN
+#if defined (ARDUINO_ARCH_ESP8266) || defined (ARDUINO_ARCH_ESP32)
+      unsigned long t1 = micros();
+      unsigned long t2 = 0;
+#endif  // ARDUINO_ARCH_ESP8266
+#endif // _TASK_SLEEP_ON_IDLE_RUN
+
+#ifdef _TASK_HEAP_QUEUE
+    unsigned long now = _TASK_TIME_FUNCTION();
+    unsigned int  budget = iTaskCount;  // bounds the pass if callbacks keep re-enabling each other
+
+    for (;;) {
+
+#ifdef _TASK_PRIORITY
+    // If scheduler for higher priority tasks is set, it is executed before every due task of the base scheduler
+    // and at least once per pass
+        if (iHighPriority) idleRun = iHighPriority->execute() && idleRun;
+        iCurrentScheduler = this;
+#endif  // _TASK_PRIORITY
+
+        if ( !iHeapCount || !budget || (long) (iHeap[0]->iNextRun - now) > 0 ) break;
+        budget--;
+
+        iCurrent = iRunning = iHeap[0];
+        heapRemove(*iCurrent);
+        iCurrent->iHeapIndex = _TASK_HEAP_RUNNING;
+
+        runCurrent(idleRun);
+
+        if (iRunning) {     // the task was not deleted by its callback methods
+            iRunning->iHeapIndex = _TASK_HEAP_NONE;
+            if ( iRunning->iStatus.enabled ) {
+                if ( (long) (iRunning->nextRun() - now) <= 0 ) {
+                    iRunning->iHeapIndex = _TASK_HEAP_DEFERRED;
+                    iRunning->iDeferNext = iDeferred;
+                    iDeferred = iRunning;
+                }
+                else {
+                    requeue(*iRunning);
+                }
             }
-        } while (0);    //guaranteed single run - allows use of "break" to exit
+            iRunning = NULL;
+        }
+#if defined (ARDUINO_ARCH_ESP8266) || defined (ARDUINO_ARCH_ESP32)
+        yield();
+#endif  // ARDUINO_ARCH_ESP8266
+    }
+
+    while (iDeferred) {
+        Task *t = iDeferred;
+        iDeferred = t->iDeferNext;
+        t->iDeferNext = NULL;
+        t->iHeapIndex = _TASK_HEAP_NONE;
+        requeue(*t);
+    }
+    iCurrent = NULL;
+
+#else
+	Task *nextTask;  // support for deleting the task in the onDisable method
+    iCurrent = iFirst;
+
+#ifdef _TASK_PRIORITY
+    // If lower priority scheduler does not have a single task in the chain
+    // the higher priority scheduler still has to have a chance to run
+        if (!iCurrent && iHighPriority) iHighPriority->execute();
+        iCurrentScheduler = this;
+#endif  // _TASK_PRIORITY
+
+
+    while (iCurrent) {
+
+#ifdef _TASK_PRIORITY
+    // If scheduler for higher priority tasks is set, it's entire chain is executed on every pass of the base scheduler
+        if (iHighPriority) idleRun = iHighPriority->execute() && idleRun;
+        iCurrentScheduler = this;
+#endif  // _TASK_PRIORITY
+		nextTask = iCurrent->iNext;
+        runCurrent(idleRun);
         iCurrent = nextTask;
 #if defined (ARDUINO_ARCH_ESP8266) || defined (ARDUINO_ARCH_ESP32)
         yield();
 #endif  // ARDUINO_ARCH_ESP8266
     }
+#endif  // _TASK_HEAP_QUEUE
 
 #ifdef _TASK_SLEEP_ON_IDLE_RUN
     if (idleRun && iAllowSleep) {
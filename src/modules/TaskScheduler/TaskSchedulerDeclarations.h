@@ -1,6 +1,6 @@
 // Cooperative multitasking library for Arduino
 // Copyright (c) 2015-2017 Anatoli Arkhipenko
-#if defined(ESP8266) || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
 #include <stddef.h>
 #include <stdint.h>
 
@@ -23,6 +23,7 @@
 // #define _TASK_INLINE			   // Make all methods "inline" - needed to support some multi-tab, multi-file implementations
 // #define _TASK_TIMEOUT           // Support for overall task timeout
 // #define _TASK_OO_CALLBACKS      // Support for dynamic callback method binding
+// #define _TASK_HEAP_QUEUE        // Keep enabled tasks in a queue ordered by next run time, execute() only visits due tasks
 
 #ifdef _TASK_DEBUG
     #define _TASK_SCOPE  public
@@ -38,6 +39,12 @@
 #define TASK_NOTIMEOUT			0
 #endif
 
+#ifdef _TASK_HEAP_QUEUE
+#define _TASK_HEAP_NONE       (-1)  // task is not queued
+#define _TASK_HEAP_RUNNING    (-2)  // task is being executed, execute() queues it again afterwards
+#define _TASK_HEAP_DEFERRED   (-3)  // task ran during the current pass and is due again, queued at the end of the pass
+#endif  // _TASK_HEAP_QUEUE
+
 #ifdef _TASK_PRIORITY
     class Scheduler;
     extern Scheduler* iCurrentScheduler;
@@ -217,6 +224,11 @@ class Task {
 
   _TASK_SCOPE:
     INLINE void reset();
+    INLINE unsigned long nextRun();
+
+#ifdef _TASK_HEAP_QUEUE
+    INLINE void requeue();
+#endif  // _TASK_HEAP_QUEUE
 
     volatile __task_status    iStatus;
     volatile unsigned long    iInterval;             // execution interval in milliseconds (or microseconds). 0 - immediate
@@ -259,15 +271,25 @@ class Task {
 	unsigned long            iTimeout;				 // Task overall timeout
 	unsigned long 			 iStarttime;			 // millis at task start time
 #endif // _TASK_TIMEOUT
+
+#ifdef _TASK_HEAP_QUEUE
+    unsigned long             iNextRun;              // next time the scheduler has to look at the task, the queue key
+    int                       iHeapIndex;            // position in the scheduler's queue or one of the _TASK_HEAP_ states
+    Task                     *iDeferNext;            // next task deferred to the end of the current pass
+#endif  // _TASK_HEAP_QUEUE
 };
 
 class Scheduler {
   friend class Task;
   public:
     INLINE Scheduler();
+#ifdef _TASK_HEAP_QUEUE
+    INLINE ~Scheduler();
+#else
 //	~Scheduler();
+#endif  // _TASK_HEAP_QUEUE
     INLINE void init();
-    INLINE void addTask(Task& aTask);
+    INLINE bool addTask(Task& aTask);                   // Returns false if the queue has no room for the task (_TASK_HEAP_QUEUE)
     INLINE void deleteTask(Task& aTask);
     INLINE void disableAll(bool aRecursive = true);
     INLINE void enableAll(bool aRecursive = true);
@@ -275,6 +297,7 @@ class Scheduler {
     INLINE void startNow(bool aRecursive = true);       // reset ALL active tasks to immediate execution NOW.
     INLINE Task& currentTask() ;
     INLINE long timeUntilNextIteration(Task& aTask);    // return number of ms until next iteration of a given Task
+    INLINE long timeUntilNextTask();                    // return number of ms until execute() has a task to run, -1 if none is enabled
 
 #ifdef _TASK_SLEEP_ON_IDLE_RUN
     INLINE void allowSleep(bool aState = true);
@@ -294,8 +317,28 @@ class Scheduler {
 #endif  // _TASK_PRIORITY
 
   _TASK_SCOPE:
+    INLINE void runCurrent(bool& idleRun);
+
+#ifdef _TASK_HEAP_QUEUE
+    INLINE void requeue(Task& aTask);
+    INLINE void heapSet(unsigned int aPos, Task* aTask);
+    INLINE void heapUp(unsigned int aPos);
+    INLINE void heapDown(unsigned int aPos);
+    INLINE void heapRemove(Task& aTask);
+    INLINE void undefer(Task& aTask);
+#endif  // _TASK_HEAP_QUEUE
+
     Task       *iFirst, *iLast, *iCurrent;        // pointers to first, last and current tasks in the chain
 
+#ifdef _TASK_HEAP_QUEUE
+    Task      **iHeap;                            // enabled tasks, binary min-heap on Task::iNextRun
+    unsigned int iHeapCount;                      // number of queued tasks
+    unsigned int iHeapSize;                       // allocated queue slots, grows with the chain in addTask()
+    unsigned int iTaskCount;                      // number of tasks in the chain
+    Task       *iDeferred;                        // tasks deferred to the end of the current pass
+    Task       *iRunning;                         // task being executed, NULL if it was deleted by its callbacks
+#endif  // _TASK_HEAP_QUEUE
+
 #ifdef _TASK_SLEEP_ON_IDLE_RUN
     bool        iAllowSleep;                      // indication if putting avr to IDLE_SLEEP mode is allowed by the program at this time.
 #endif  // _TASK_SLEEP_ON_IDLE_RUN
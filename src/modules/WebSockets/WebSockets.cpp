@@ -210,10 +210,7 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
     uint8_t buffer[WEBSOCKETS_MAX_HEADER_SIZE] = { 0 };
 
     uint8_t headerSize;
-    uint8_t * headerPtr;
-    uint8_t * payloadPtr = payload;
-    bool useInternBuffer = false;
-    bool ret             = true;
+    bool ret = true;
 
     // calculate header Size
     if(length < 126) {
@@ -228,87 +225,106 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
         headerSize += 4;
     }
 
-#ifdef WEBSOCKETS_USE_BIG_MEM
-    // only for ESP since AVR has less HEAP
-    // try to send data in one TCP package (only if some free Heap is there)
-    if(!headerToPayload && ((length > 0) && (length < 1400)) && (GET_FREE_HEAP > 6000)) {
-        DEBUG_WEBSOCKETS("[WS][%d][sendFrame] pack to one TCP package...\n", client->num);
-        uint8_t * dataPtr = (uint8_t *)malloc(length + WEBSOCKETS_MAX_HEADER_SIZE);
-        if(dataPtr) {
-            memcpy((dataPtr + WEBSOCKETS_MAX_HEADER_SIZE), payload, length);
-            headerToPayload = true;
-            useInternBuffer = true;
-            payloadPtr      = dataPtr;
-        }
-    }
+#ifndef NODEBUG_WEBSOCKETS
+    unsigned long start = micros();
 #endif
 
-    // set Header Pointer
     if(headerToPayload) {
-        // calculate offset in payload
-        headerPtr = (payloadPtr + (WEBSOCKETS_MAX_HEADER_SIZE - headerSize));
+        // header has be added to payload
+        // payload is forced to reserved 14 Byte but we may not need all based on the length and mask settings
+        // offset in payload is calculatetd 14 - headerSize
+        // the payload is sent as is, masked with a zero key
+        createHeader(&payload[(WEBSOCKETS_MAX_HEADER_SIZE - headerSize)], opcode, length, client->cIsClient, maskKey, fin);
+
+        if(write(client, &payload[(WEBSOCKETS_MAX_HEADER_SIZE - headerSize)], (length + headerSize)) != (length + headerSize)) {
+            ret = false;
+        }
     } else {
-        headerPtr = &buffer[0];
+        if(client->cIsClient) {
+            for(uint8_t x = 0; x < sizeof(maskKey); x++) {
+                maskKey[x] = random(0xFF);
+            }
+        }
+
+        createHeader(&buffer[0], opcode, length, client->cIsClient, maskKey, fin);
+
+        ret = writeFrame(client, &buffer[0], headerSize, payload, length, client->cIsClient ? maskKey : NULL);
     }
 
-    if(client->cIsClient && useInternBuffer) {
-        // if we use a Intern Buffer we can modify the data
-        // by this fact its possible the do the masking
-        for(uint8_t x = 0; x < sizeof(maskKey); x++) {
-            maskKey[x] = random(0xFF);
-        }
+    DEBUG_WEBSOCKETS("[WS][%d][sendFrame] sending Frame Done (%luus).\n", client->num, (micros() - start));
+
+    return ret;
+}
+
+/**
+ * write a frame in one piece without a heap copy per frame
+ * header and payload are put together on the stack when they fit,
+ * a bigger frame in the TX buffer the client keeps.
+ * payloads are masked on the way, the caller's data stays untouched
+ * @param client WSclient_t *   ptr to the client struct
+ * @param header uint8_t *      ptr to the frame header
+ * @param headerSize uint8_t    size of the header
+ * @param payload uint8_t *     ptr to the payload
+ * @param length size_t         length of the payload
+ * @param maskKey uint8_t *     mask key or NULL
+ * @return true if ok
+ */
+bool WebSockets::writeFrame(WSclient_t * client, uint8_t * header, uint8_t headerSize, uint8_t * payload, size_t length, uint8_t * maskKey) {
+    uint8_t stage[WEBSOCKETS_TX_STAGE_SIZE];
+    uint8_t * out = &stage[0];
+
+    if(!payload) {
+        length = 0;
     }
 
-    createHeader(headerPtr, opcode, length, client->cIsClient, maskKey, fin);
+    if(headerSize + length > sizeof(stage)) {
+        out = txBuffer(client, headerSize + length);
+    }
 
-    if(client->cIsClient && useInternBuffer) {
-        uint8_t * dataMaskPtr;
+    if(out) {
+        memcpy(out, header, headerSize);
 
-        if(headerToPayload) {
-            dataMaskPtr = (payloadPtr + WEBSOCKETS_MAX_HEADER_SIZE);
-        } else {
-            dataMaskPtr = payloadPtr;
+        if(maskKey) {
+            for(size_t x = 0; x < length; x++) {
+                out[headerSize + x] = payload[x] ^ maskKey[x & 3];
+            }
+        } else if(length) {
+            memcpy(&out[headerSize], payload, length);
         }
 
-        for(size_t x = 0; x < length; x++) {
-            dataMaskPtr[x] = (dataMaskPtr[x] ^ maskKey[x % 4]);
-        }
+        return write(client, out, headerSize + length) == headerSize + length;
     }
 
-#ifndef NODEBUG_WEBSOCKETS
-    unsigned long start = micros();
-#endif
+    // no memory for the TX buffer, the payload follows the header from the
+    // caller's buffer, a masked one through the stack buffer
+    DEBUG_WEBSOCKETS("[WS][%d][writeFrame] no TX buffer for %u byte, writing in parts\n", client->num, length);
 
-    if(headerToPayload) {
-        // header has be added to payload
-        // payload is forced to reserved 14 Byte but we may not need all based on the length and mask settings
-        // offset in payload is calculatetd 14 - headerSize
-        if(write(client, &payloadPtr[(WEBSOCKETS_MAX_HEADER_SIZE - headerSize)], (length + headerSize)) != (length + headerSize)) {
-            ret = false;
-        }
-    } else {
-        // send header
-        if(write(client, &buffer[0], headerSize) != headerSize) {
-            ret = false;
+    if(write(client, header, headerSize) != headerSize) {
+        return false;
+    }
+
+    if(!maskKey) {
+        return write(client, payload, length) == length;
+    }
+
+    for(size_t offset = 0; offset < length;) {
+        size_t n = length - offset;
+        if(n > sizeof(stage)) {
+            n = sizeof(stage);
         }
 
-        if(payloadPtr && length > 0) {
-            // send payload
-            if(write(client, &payloadPtr[0], length) != length) {
-                ret = false;
-            }
+        for(size_t x = 0; x < n; x++) {
+            stage[x] = payload[offset + x] ^ maskKey[(offset + x) & 3];
         }
-    }
 
-    DEBUG_WEBSOCKETS("[WS][%d][sendFrame] sending Frame Done (%luus).\n", client->num, (micros() - start));
+        if(write(client, &stage[0], n) != n) {
+            return false;
+        }
 
-#ifdef WEBSOCKETS_USE_BIG_MEM
-    if(useInternBuffer && payloadPtr) {
-        free(payloadPtr);
+        offset += n;
     }
-#endif
 
-    return ret;
+    return true;
 }
 
 /**
@@ -442,8 +458,15 @@ void WebSockets::handleWebsocketCb(WSclient_t * client) {
     }
 
     if(header->payloadLen > 0) {
+#if defined(WEBSOCKETS_RX_CHUNK_SIZE) && (WEBSOCKETS_NETWORK_TYPE != NETWORK_ESP8266_ASYNC)
+        if(header->payloadLen > WEBSOCKETS_RX_CHUNK_SIZE && header->opCode <= WSop_binary) {
+            handleWebsocketChunks(client);
+            return;
+        }
+#endif
+
         // if text data we need one more
-        payload = (uint8_t *)malloc(header->payloadLen + 1);
+        payload = rxBuffer(client, header->payloadLen + 1);
 
         if(!payload) {
             DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] to less memory to handle payload %d!\n", client->num, header->payloadLen);
@@ -463,10 +486,7 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
             payload[header->payloadLen] = 0x00;
 
             if(header->mask) {
-                //decode XOR
-                for(size_t i = 0; i < header->payloadLen; i++) {
-                    payload[i] = (payload[i] ^ header->maskKey[i % 4]);
-                }
+                unmask(payload, header->payloadLen, header->maskKey, 0);
             }
         }
 
@@ -509,10 +529,6 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
                 break;
         }
 
-        if(payload) {
-            free(payload);
-        }
-
         // reset input
         client->cWsRXsize = 0;
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
@@ -522,11 +538,146 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
 
     } else {
         DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] missing data!\n", client->num);
-        free(payload);
         clientDisconnect(client, 1002);
     }
 }
 
+#if defined(WEBSOCKETS_RX_CHUNK_SIZE)
+/**
+ * deliver a big data frame in chunks of WEBSOCKETS_RX_CHUNK_SIZE
+ * the chunks are reported like the frames of a fragmented message
+ * @param client WSclient_t *  ptr to the client struct
+ */
+void WebSockets::handleWebsocketChunks(WSclient_t * client) {
+    WSMessageHeader_t * header = &client->cWsHeaderDecode;
+    uint8_t * payload          = rxBuffer(client, WEBSOCKETS_RX_CHUNK_SIZE + 1);
+    size_t offset              = 0;
+
+    if(!payload) {
+        DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] to less memory to handle payload %d!\n", client->num, header->payloadLen);
+        clientDisconnect(client, 1011);
+        return;
+    }
+
+    while(offset < header->payloadLen) {
+        size_t length = header->payloadLen - offset;
+        if(length > WEBSOCKETS_RX_CHUNK_SIZE) {
+            length = WEBSOCKETS_RX_CHUNK_SIZE;
+        }
+
+        if(!readCb(client, payload, length, NULL)) {
+            DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] missing data!\n", client->num);
+            clientDisconnect(client, 1002);
+            return;
+        }
+
+        payload[length] = 0x00;
+
+        if(header->mask) {
+            unmask(payload, length, header->maskKey, offset);
+        }
+
+        WSopcode_t opcode = (offset == 0) ? header->opCode : WSop_continuation;
+        offset += length;
+
+        messageReceived(client, opcode, payload, length, header->fin && (offset == header->payloadLen));
+
+        if(client->status != WSC_CONNECTED) {
+            // closed from the callback
+            return;
+        }
+    }
+
+    // reset input
+    client->cWsRXsize = 0;
+}
+#endif
+
+/**
+ * get the RX buffer of the client with at least size byte
+ * the buffer only grows and is released when the client disconnects
+ * @param client WSclient_t *  ptr to the client struct
+ * @param size size_t
+ * @return ptr to the buffer or NULL
+ */
+uint8_t * WebSockets::rxBuffer(WSclient_t * client, size_t size) {
+    if(size > client->cWsRxBufSize) {
+        uint8_t * buf = (uint8_t *)realloc(client->cWsRxBuf, size);
+        if(!buf) {
+            return NULL;
+        }
+        client->cWsRxBuf     = buf;
+        client->cWsRxBufSize = size;
+    }
+    return client->cWsRxBuf;
+}
+
+/**
+ * get the TX buffer of the client with at least size byte
+ * like the RX buffer it only grows and is released on disconnect
+ * @param client WSclient_t *  ptr to the client struct
+ * @param size size_t
+ * @return ptr to the buffer or NULL
+ */
+uint8_t * WebSockets::txBuffer(WSclient_t * client, size_t size) {
+    if(size > client->cWsTxBufSize) {
+        uint8_t * buf = (uint8_t *)realloc(client->cWsTxBuf, size);
+        if(!buf) {
+            return NULL;
+        }
+        client->cWsTxBuf     = buf;
+        client->cWsTxBufSize = size;
+    }
+    return client->cWsTxBuf;
+}
+
+void WebSockets::bufferFree(WSclient_t * client) {
+    free(client->cWsRxBuf);
+    client->cWsRxBuf     = NULL;
+    client->cWsRxBufSize = 0;
+
+    free(client->cWsTxBuf);
+    client->cWsTxBuf     = NULL;
+    client->cWsTxBufSize = 0;
+}
+
+/**
+ * decode XOR in place
+ * @param data uint8_t *        ptr to the data
+ * @param length size_t         length of the data
+ * @param maskKey uint8_t *     the 4 byte mask key
+ * @param offset size_t         position of data in the frame payload
+ */
+void WebSockets::unmask(uint8_t * data, size_t length, const uint8_t * maskKey, size_t offset) {
+    uint8_t key[4];
+
+    for(uint8_t x = 0; x < 4; x++) {
+        key[x] = maskKey[(offset + x) & 3];
+    }
+
+    size_t i = 0;
+
+    // word at a time once data is aligned
+    while(i < length && ((uintptr_t)&data[i] & 3)) {
+        data[i] ^= key[i & 3];
+        i++;
+    }
+
+    if(length - i >= 4) {
+        uint8_t k[4] = { key[i & 3], key[(i + 1) & 3], key[(i + 2) & 3], key[(i + 3) & 3] };
+        uint32_t word;
+        memcpy(&word, k, 4);
+
+        for(; i + 4 <= length; i += 4) {
+            *(uint32_t *)&data[i] ^= word;
+        }
+    }
+
+    for(; i < length; i++) {
+        data[i] ^= key[i & 3];
+    }
+}
+
 /**
  * generate the key for Sec-WebSocket-Accept
  * @param clientKey String
@@ -90,6 +90,17 @@
 // max size of the WS Message Header
 #define WEBSOCKETS_MAX_HEADER_SIZE (14)
 
+// define to deliver data frames bigger than this in fragments of this size,
+// as WStype_FRAGMENT_* events the sketch has to put together again
+// otherwise a frame is read whole, up to WEBSOCKETS_MAX_DATA_SIZE
+//#define WEBSOCKETS_RX_CHUNK_SIZE (1024)
+
+// frames up to this size are sent in one write from a stack buffer,
+// bigger ones from a buffer each client keeps until it disconnects
+#ifndef WEBSOCKETS_TX_STAGE_SIZE
+#define WEBSOCKETS_TX_STAGE_SIZE (256)
+#endif
+
 #if !defined(WEBSOCKETS_NETWORK_TYPE)
 // select Network type based
 #if defined(ESP8266) || defined(ESP31B)
@@ -268,6 +279,11 @@ typedef struct {
     uint8_t cWsHeader[WEBSOCKETS_MAX_HEADER_SIZE];    ///< RX WS Message buffer
     WSMessageHeader_t cWsHeaderDecode;
 
+    uint8_t * cWsRxBuf  = NULL;    ///< RX payload buffer, kept between messages
+    size_t cWsRxBufSize = 0;       ///< allocated size of cWsRxBuf
+    uint8_t * cWsTxBuf  = NULL;    ///< TX frame buffer for frames bigger than the stack stage
+    size_t cWsTxBufSize = 0;       ///< allocated size of cWsTxBuf
+
     String base64Authorization;    ///< Base64 encoded Auth request
     String plainAuthorization;     ///< Base64 encoded Auth request
 
@@ -315,6 +331,14 @@ class WebSockets {
     bool handleWebsocketWaitFor(WSclient_t * client, size_t size);
     void handleWebsocketCb(WSclient_t * client);
     void handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t * payload);
+#if defined(WEBSOCKETS_RX_CHUNK_SIZE)
+    void handleWebsocketChunks(WSclient_t * client);
+#endif
+
+    uint8_t * rxBuffer(WSclient_t * client, size_t size);
+    uint8_t * txBuffer(WSclient_t * client, size_t size);
+    void bufferFree(WSclient_t * client);
+    static void unmask(uint8_t * data, size_t length, const uint8_t * maskKey, size_t offset);
 
     String acceptKey(String & clientKey);
     String base64_encode(uint8_t * data, size_t length);
@@ -322,6 +346,7 @@ class WebSockets {
     bool readCb(WSclient_t * client, uint8_t * out, size_t n, WSreadWaitCb cb);
     virtual size_t write(WSclient_t * client, uint8_t * out, size_t n);
     size_t write(WSclient_t * client, const char * out);
+    bool writeFrame(WSclient_t * client, uint8_t * header, uint8_t headerSize, uint8_t * payload, size_t length, uint8_t * maskKey);
 
     void enableHeartbeat(WSclient_t * client, uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
     void handleHBTimeout(WSclient_t * client);
@@ -52,6 +52,8 @@ class Adafruit_MQTT_Client : public Adafruit_MQTT {
   bool connected();
   uint16_t readPacket(uint8_t *buffer, uint16_t maxlen, int16_t timeout);
   bool sendPacket(uint8_t *buffer, uint16_t len);
+  // bytes waiting on the socket, lets callers skip readSubscription()
+  int available() { return client->available(); }
 
  private:
   Client* client;
@@ -127,7 +127,8 @@ class Mesh : public painlessmesh::Mesh<MeshConnection> {
 
   void initStation() {
     stationScan.init(this, _meshSSID, _meshPassword, _meshPort);
-    mScheduler->addTask(stationScan.task);
+    if (!mScheduler->addTask(stationScan.task))
+      Log(logger::ERROR, "initStation(): Out of memory, no station scan\n");
     stationScan.task.enable();
   }
 
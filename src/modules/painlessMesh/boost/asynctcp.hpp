@@ -64,8 +64,29 @@ class AsyncClient {
     return len;
   }
 
+  // Queue data for send(), like tcp_write() does on the ESP
+  size_t add(const char* data, size_t size,
+             uint8_t apiflags = ASYNC_WRITE_FLAG_COPY) {
+    size_t room = this->space();
+    if (size > room) size = room;
+    memcpy(mWriteBuffer + mPending, data, size);
+    mPending += size;
+    return size;
+  }
+
+  // Send what add() queued, one write at a time
+  bool send() {
+    if (writing || mPending == 0) return false;
+    writing = true;
+    auto len = mPending;
+    mPending = 0;
+    mSocket.async_send(
+        boost::asio::buffer(mWriteBuffer, len),
+        [&](auto& ec, auto len) { this->handleWrite(ec, len); });
+    return true;
+  }
+
   // Dummy functions for compatibility with ESPAsycnTCP
-  void send() {}
   void setNoDelay(bool value = true) {}
   void setRxTimeout(uint32_t timeout) {}
   const char* errorToString(int8_t error) { return ""; }
@@ -129,7 +150,7 @@ class AsyncClient {
   size_t space() {
     // This could be more intelligent, but simple and safe for now
     if (writing) return 0;
-    return TCP_MSS;
+    return TCP_MSS - mPending;
   }
 
   bool canSend() { return this->space() > 0; }
@@ -150,6 +171,7 @@ class AsyncClient {
   char mInputBuffer[TCP_MSS];
   char mWriteBuffer[TCP_MSS];
   bool writing = false;
+  size_t mPending = 0;
 
   bool disconnectCalled = false;
 
@@ -255,7 +277,7 @@ class AsyncServer {
   void* _connect_cb_arg = 0;
 
   void initAccept() {
-    AsyncClient* client = new AsyncClient(mAcceptor.get_io_service());
+    AsyncClient* client = new AsyncClient(_io_service);
     mAcceptor.async_accept(
         client->socket(), [this, client](const boost::system::error_code& e) {
           if (!e && this->_connect_cb) {
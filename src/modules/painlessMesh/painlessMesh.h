@@ -1,10 +1,11 @@
 #ifndef _EASY_MESH_H_
 #define _EASY_MESH_H_
 
-#if defined(ESP8266) || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32) || defined(PAINLESSMESH_BOOST)
 
 #define _TASK_PRIORITY  // Support for layered scheduling priority
 #define _TASK_STD_FUNCTION
+#define _TASK_HEAP_QUEUE  // Only visit due tasks on update()
 
 #include <Arduino.h>
 #include <functional>
@@ -12,7 +13,8 @@
 #include <memory>
 #include "painlessmesh/configuration.hpp"
 using namespace std;
-#ifdef ESP32
+#if defined(PAINLESSMESH_BOOST)
+#elif defined(ESP32)
 // #include <AsyncTCP.h>
 #include "../AsyncTCP/AsyncTCP.h"
 #include <WiFi.h>
@@ -27,6 +29,8 @@ using namespace std;
 #include "painlessMeshSTA.h"
 
 #include "arduino/wifi.hpp"
+#elif defined(PAINLESSMESH_BOOST)
+#include "painlessMeshConnection.h"
 #endif
 
 #ifdef PAINLESSMESH_ENABLE_OTA
@@ -5,7 +5,7 @@
 //  Created by Bill Gray on 7/26/16.
 //
 //
-#if defined(ESP8266) || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32) || defined(PAINLESSMESH_BOOST)
 #include "painlessMeshConnection.h"
 #include "painlessMesh.h"
 
@@ -17,8 +17,6 @@ using namespace painlessmesh;
 
 extern LogClass Log;
 
-static painlessmesh::buffer::temp_buffer_t shared_buffer;
-
 ICACHE_FLASH_ATTR MeshConnection::MeshConnection(
     AsyncClient *client_ptr, painlessmesh::Mesh<MeshConnection> *pMesh,
     bool is_station) {
@@ -28,6 +26,9 @@ ICACHE_FLASH_ATTR MeshConnection::MeshConnection(
   client = client_ptr;
 
   client->setNoDelay(true);
+  for (size_t i = 0; i < PAINLESSMESH_PRIORITIES; ++i)
+    if (mesh->priorityWeights[i] > 0)
+      sentBuffer.setWeight(i, mesh->priorityWeights[i]);
   if (station) {  // we are the station, start nodeSync
     Log(CONNECTION, "meshConnectedCb(): we are STA\n");
   } else {
@@ -70,8 +71,14 @@ void MeshConnection::initTCPCallbacks() {
         if (self->mesh->semaphoreTake()) {
           Log(COMMUNICATION, "onData(): fromId=%u\n", self ? self->nodeId : 0);
 
-          self->receiveBuffer.push(static_cast<const char *>(data), len,
-                                   shared_buffer);
+          if (!self->receiveBuffer.push(static_cast<const char *>(data),
+                                        len)) {
+            Log(ERROR, "onData(): Out of memory, dropping %u\n",
+                self->nodeId);
+            self->close();
+            self->mesh->semaphoreGive();
+            return;
+          }
 
           // Signal that we are done
           self->client->ack(len);
@@ -110,28 +117,29 @@ void MeshConnection::initTCPCallbacks() {
 
 void MeshConnection::initTasks() {
   using namespace logger;
+  bool scheduled = true;
 
   timeOutTask.set(NODE_TIMEOUT, TASK_ONCE, [self = this->shared_from_this()]() {
     Log(CONNECTION, "Time out reached\n");
     self->close();
   });
-  mesh->mScheduler->addTask(timeOutTask);
+  if (!mesh->mScheduler->addTask(timeOutTask)) scheduled = false;
 
   this->nodeSyncTask.set(
       TASK_MINUTE, TASK_FOREVER, [self = this->shared_from_this()]() {
         Log(SYNC, "nodeSyncTask(): request with %u\n", self->nodeId);
         router::send<protocol::NodeSyncRequest, MeshConnection>(
-            self->request(self->mesh->asNodeTree()), self);
+            self->mesh->syncPackage<protocol::NodeSyncRequest>(self), self);
         self->timeOutTask.disable();
         self->timeOutTask.restartDelayed();
       });
-  mesh->mScheduler->addTask(this->nodeSyncTask);
+  if (!mesh->mScheduler->addTask(this->nodeSyncTask)) scheduled = false;
   if (station)
     this->nodeSyncTask.enable();
   else
     this->nodeSyncTask.enableDelayed(10 * TASK_SECOND);
 
-  receiveBuffer = painlessmesh::buffer::ReceiveBuffer<TSTRING>();
+  receiveBuffer.clear();
   readBufferTask.set(
       TASK_SECOND, TASK_FOREVER, [self = this->shared_from_this()]() {
         Log(GENERAL, "readBufferTask()\n");
@@ -145,7 +153,7 @@ void MeshConnection::initTasks() {
               self->mesh->callbackList, self->mesh->getNodeTime());
         }
       });
-  mesh->mScheduler->addTask(readBufferTask);
+  if (!mesh->mScheduler->addTask(readBufferTask)) scheduled = false;
   readBufferTask.enableDelayed();
 
   sentBufferTask.set(
@@ -159,8 +167,13 @@ void MeshConnection::initTasks() {
             self->sentBufferTask.delay(100 * TASK_MILLISECOND);
         }
       });
-  mesh->mScheduler->addTask(sentBufferTask);
+  if (!mesh->mScheduler->addTask(sentBufferTask)) scheduled = false;
   sentBufferTask.enableDelayed();
+
+  // A task the scheduler had no room for never runs, the link won't work
+  if (!scheduled)
+    Log(ERROR, "initTasks(): Out of memory, tasks of %u not scheduled\n",
+        this->nodeId);
 }
 
 void ICACHE_FLASH_ATTR MeshConnection::close() {
@@ -185,6 +198,10 @@ void ICACHE_FLASH_ATTR MeshConnection::close() {
   this->client->onData(NULL, NULL);
   this->client->onAck(NULL, NULL);
 
+  // Our part of the layout lost a branch, the totals keep its traffic
+  mesh->layoutChangedAt = mesh->getNodeTime();
+  mesh->closedTraffic += this->traffic;
+
   mesh->addTask(
       [mesh = this->mesh, nodeId = this->nodeId, station = this->station]() {
         Log(CONNECTION, "closingTask(): dropping %u now= %u\n", nodeId,
@@ -220,28 +237,31 @@ void ICACHE_FLASH_ATTR MeshConnection::close() {
 }
 
 bool ICACHE_FLASH_ATTR MeshConnection::addMessage(TSTRING &message,
-                                                  bool priority) {
+                                                  uint8_t priority,
+                                                  uint32_t dest) {
   if (ESP.getFreeHeap() - message.length() >=
       MIN_FREE_MEMORY) {  // If memory heap is enough, queue the message
-    if (priority) {
-      sentBuffer.push(message, priority);
+    // Every lane is limited so a flood of telemetry can't crowd out sync. The
+    // control lane is limited per destination, commands for one sub-device
+    // don't hold up those for the others behind this hop. A full queue
+    // refuses the new message, the queued ones stay
+    auto queued = priority == painlessmesh::protocol::PRIORITY_CONTROL
+                      ? sentBuffer.size(priority, dest)
+                      : sentBuffer.size(priority);
+    size_t limit = priority == painlessmesh::protocol::PRIORITY_CONTROL
+                       ? PAINLESSMESH_CONTROL_QUEUE
+                       : MAX_MESSAGE_QUEUE;
+    if (queued < limit) {
+      if (!sentBuffer.push(message, priority, dest)) return false;
       Log(COMMUNICATION,
-          "addMessage(): Package sent to queue beginning -> %d , "
-          "FreeMem: %d\n",
+          "addMessage(): Package sent to queue end -> %d , FreeMem: "
+          "%d\n",
           sentBuffer.size(), ESP.getFreeHeap());
     } else {
-      if (sentBuffer.size() < MAX_MESSAGE_QUEUE) {
-        sentBuffer.push(message, priority);
-        Log(COMMUNICATION,
-            "addMessage(): Package sent to queue end -> %d , FreeMem: "
-            "%d\n",
-            sentBuffer.size(), ESP.getFreeHeap());
-      } else {
-        Log(ERROR, "addMessage(): Message queue full -> %d , FreeMem: %d\n",
-            sentBuffer.size(), ESP.getFreeHeap());
-        sentBufferTask.forceNextIteration();
-        return false;
-      }
+      Log(ERROR, "addMessage(): Message queue full -> %d , FreeMem: %d\n",
+          sentBuffer.size(), ESP.getFreeHeap());
+      sentBufferTask.forceNextIteration();
+      return false;
     }
     sentBufferTask.forceNextIteration();
     return true;
@@ -259,33 +279,31 @@ bool ICACHE_FLASH_ATTR MeshConnection::writeNext() {
     Log(COMMUNICATION, "writeNext(): sendQueue is empty\n");
     return false;
   }
-  auto len = sentBuffer.requestLength(shared_buffer.length);
   auto snd_len = client->space();
-  if (len > snd_len) len = snd_len;
-  if (len > 0) {
-    // sentBuffer.read(len, shared_buffer);
-    // auto written = client->write(shared_buffer.buffer, len, 1);
-    auto data_ptr = sentBuffer.readPtr(len);
-    auto written = client->write(data_ptr, len, 1);
-    if (written == len) {
-      Log(COMMUNICATION, "writeNext(): Package sent\n");
-      client->send();  // TODO only do this for priority messages
-      sentBuffer.freeRead();
-      sentBufferTask.forceNextIteration();
-      return true;
-    } else if (written == 0) {
-      Log(DEBUG, "writeNext(): tcp_write Failed node=%u. Resending later\n",
-          nodeId);
-      return false;
-    } else {
-      Log(ERROR,
-          "writeNext(): Less written than requested. Please report bug on "
-          "the issue tracker\n");
-      return false;
-    }
-  } else {
+  if (snd_len == 0) {
     Log(COMMUNICATION, "writeNext(): tcp_sndbuf not enough space\n");
     return false;
   }
+  // Hand the segments to the tcp stack one by one, and send them all at once
+  size_t written = 0;
+  while (!sentBuffer.empty() && written < snd_len) {
+    size_t len;
+    auto data_ptr = sentBuffer.peek(len);
+    if (len > snd_len - written) len = snd_len - written;
+    auto added = client->add(data_ptr, len, ASYNC_WRITE_FLAG_COPY);
+    if (added == 0) break;
+    sentBuffer.consume(added);
+    written += added;
+  }
+  if (written > 0) {
+    Log(COMMUNICATION, "writeNext(): Package sent\n");
+    client->send();  // TODO only do this for priority messages
+    sentBufferTask.forceNextIteration();
+    return true;
+  } else {
+    Log(DEBUG, "writeNext(): tcp_write Failed node=%u. Resending later\n",
+        nodeId);
+    return false;
+  }
 }
 #endif
@@ -1,10 +1,11 @@
 #ifndef _PAINLESS_MESH_CONNECTION_H_
 #define _PAINLESS_MESH_CONNECTION_H_
 
-#if defined(ESP8266) || defined(ESP32)
+#if defined(ESP8266) || defined(ESP32) || defined(PAINLESSMESH_BOOST)
 
 #define _TASK_PRIORITY  // Support for layered scheduling priority
 #define _TASK_STD_FUNCTION
+#define _TASK_HEAP_QUEUE  // Only visit due tasks on update()
 #include "../TaskScheduler/TaskSchedulerDeclarations.h"
 
 #ifdef ESP32
@@ -37,10 +38,12 @@ class MeshConnection : public painlessmesh::layout::Neighbour,
   // for timeout
   uint32_t timeDelayLastRequested = 0;
 
-  bool addMessage(TSTRING &message, bool priority = false);
+  bool addMessage(TSTRING &message,
+                  uint8_t priority = painlessmesh::protocol::PRIORITY_TELEMETRY,
+                  uint32_t dest = 0);
   bool writeNext();
-  painlessmesh::buffer::ReceiveBuffer<TSTRING> receiveBuffer;
-  painlessmesh::buffer::SentBuffer<TSTRING> sentBuffer;
+  painlessmesh::buffer::SegmentedReceiveBuffer<TSTRING> receiveBuffer;
+  painlessmesh::buffer::SegmentedSentBuffer<TSTRING> sentBuffer;
 
   Task nodeSyncTask;
   Task timeSyncTask;
@@ -2,6 +2,7 @@
 #define _PAINLESS_MESH_BUFFER_HPP_
 
 #include <list>
+#include <new>
 
 #include <Arduino.h>
 #include "configuration.hpp"
@@ -10,6 +11,20 @@
 #define TCP_MSS 1024
 #endif
 
+// Size of the segments used by SegmentedReceiveBuffer and SegmentedSentBuffer
+#ifndef PAINLESSMESH_SEGMENT_SIZE
+#define PAINLESSMESH_SEGMENT_SIZE 128
+#endif
+
+// Number of released segments kept for reuse, shared by all connections
+#ifndef PAINLESSMESH_SEGMENT_POOL
+#ifdef ESP32
+#define PAINLESSMESH_SEGMENT_POOL 128
+#else
+#define PAINLESSMESH_SEGMENT_POOL 48
+#endif
+#endif
+
 namespace painlessmesh {
 namespace buffer {
 
@@ -222,6 +237,516 @@ inline void SentBuffer<std::string>::stringEraseFront(std::string &string,
 };
 #endif
 
+/**
+ * Fixed size block of buffered data
+ *
+ * The extra byte is always '\0', so any stretch of data that ends at the end
+ * of the segment can be read as a c string in place.
+ */
+struct segment_t {
+  segment_t *next = NULL;
+  char data[PAINLESSMESH_SEGMENT_SIZE + 1];
+};
+
+/**
+ * \brief Recycles segments, so buffering messages doesn't fragment the heap
+ */
+class SegmentPool {
+ public:
+  /**
+   * Get a segment, NULL if out of memory
+   */
+  segment_t *acquire() {
+    segment_t *seg = freeList;
+    if (seg) {
+      freeList = seg->next;
+      --pooled;
+    } else {
+      seg = new (std::nothrow) segment_t();
+      if (!seg) return NULL;
+      seg->data[PAINLESSMESH_SEGMENT_SIZE] = '\0';
+    }
+    seg->next = NULL;
+    return seg;
+  }
+
+  /**
+   * Give back a chain of segments
+   */
+  void release(segment_t *seg) {
+    while (seg) {
+      auto next = seg->next;
+      if (pooled < PAINLESSMESH_SEGMENT_POOL) {
+        seg->next = freeList;
+        freeList = seg;
+        ++pooled;
+      } else {
+        delete seg;
+      }
+      seg = next;
+    }
+  }
+
+  /**
+   * Number of segments waiting for reuse
+   */
+  size_t available() { return pooled; }
+
+ private:
+  segment_t *freeList = NULL;
+  size_t pooled = 0;
+};
+
+inline SegmentPool &segmentPool() {
+  static SegmentPool pool;
+  return pool;
+}
+
+/**
+ * \brief FIFO of bytes stored in a chain of pooled segments
+ */
+class SegmentQueue {
+ public:
+  SegmentQueue() {}
+  SegmentQueue(const SegmentQueue &) = delete;
+  SegmentQueue &operator=(const SegmentQueue &) = delete;
+  ~SegmentQueue() { clear(); }
+
+  /**
+   * Append the data, either completely or (when out of memory) not at all
+   */
+  bool append(const char *data, size_t length) {
+    size_t room = tail ? PAINLESSMESH_SEGMENT_SIZE - writePos : 0;
+    segment_t *extra = NULL;
+    segment_t *extraTail = NULL;
+    while (room < length) {
+      auto seg = segmentPool().acquire();
+      if (!seg) {
+        segmentPool().release(extra);
+        return false;
+      }
+      if (extraTail)
+        extraTail->next = seg;
+      else
+        extra = seg;
+      extraTail = seg;
+      room += PAINLESSMESH_SEGMENT_SIZE;
+    }
+
+    size += length;
+    while (length > 0) {
+      if (!tail || writePos == PAINLESSMESH_SEGMENT_SIZE) {
+        auto seg = extra;
+        extra = extra->next;
+        seg->next = NULL;
+        if (tail)
+          tail->next = seg;
+        else
+          head = seg;
+        tail = seg;
+        writePos = 0;
+      }
+      auto len = std::min(length, PAINLESSMESH_SEGMENT_SIZE - writePos);
+      memcpy(tail->data + writePos, data, len);
+      writePos += len;
+      data += len;
+      length -= len;
+    }
+    return true;
+  }
+
+  /**
+   * Pointer to the oldest data
+   *
+   * \param length Set to the number of bytes readable at the pointer
+   */
+  char *peek(size_t &length) {
+    if (size == 0) {
+      length = 0;
+      return NULL;
+    }
+    length = std::min(size, PAINLESSMESH_SEGMENT_SIZE - readPos);
+    return head->data + readPos;
+  }
+
+  /**
+   * Number of bytes before the first occurrence of c, size() if not found
+   */
+  size_t find(char c) {
+    size_t offset = 0;
+    auto seg = head;
+    auto pos = readPos;
+    while (seg && offset < size) {
+      auto len = std::min(size - offset, PAINLESSMESH_SEGMENT_SIZE - pos);
+      auto found = static_cast<const char *>(memchr(seg->data + pos, c, len));
+      if (found) return offset + (found - (seg->data + pos));
+      offset += len;
+      seg = seg->next;
+      pos = 0;
+    }
+    return size;
+  }
+
+  /**
+   * Call func(ptr, len) for each contiguous piece of the oldest length bytes
+   */
+  template <typename F>
+  void forEach(size_t length, F func) {
+    auto seg = head;
+    auto pos = readPos;
+    length = std::min(length, size);
+    while (seg && length > 0) {
+      auto len = std::min(length, PAINLESSMESH_SEGMENT_SIZE - pos);
+      func(seg->data + pos, len);
+      length -= len;
+      seg = seg->next;
+      pos = 0;
+    }
+  }
+
+  /**
+   * Remove the oldest length bytes, releasing emptied segments
+   */
+  void consume(size_t length) {
+    length = std::min(length, size);
+    size -= length;
+    while (length > 0) {
+      auto len = std::min(length, PAINLESSMESH_SEGMENT_SIZE - readPos);
+      readPos += len;
+      length -= len;
+      if (readPos == PAINLESSMESH_SEGMENT_SIZE || (size == 0 && head == tail))
+        popSegment();
+    }
+  }
+
+  /**
+   * Remove the newest length bytes, releasing emptied segments
+   */
+  void truncate(size_t length) {
+    length = std::min(length, size);
+    auto keep = size - length;
+    if (keep == 0) {
+      clear();
+      return;
+    }
+    auto seg = head;
+    size_t offset = PAINLESSMESH_SEGMENT_SIZE - readPos;
+    while (offset < keep) {
+      seg = seg->next;
+      offset += PAINLESSMESH_SEGMENT_SIZE;
+    }
+    segmentPool().release(seg->next);
+    seg->next = NULL;
+    tail = seg;
+    writePos = PAINLESSMESH_SEGMENT_SIZE - (offset - keep);
+    size = keep;
+  }
+
+  bool empty() { return size == 0; }
+
+  size_t length() { return size; }
+
+  void clear() {
+    segmentPool().release(head);
+    head = tail = NULL;
+    readPos = writePos = size = 0;
+  }
+
+ private:
+  segment_t *head = NULL;
+  segment_t *tail = NULL;
+  size_t readPos = 0;
+  size_t writePos = 0;
+  size_t size = 0;
+
+  void popSegment() {
+    auto seg = head;
+    head = head->next;
+    seg->next = NULL;
+    segmentPool().release(seg);
+    if (!head) {
+      tail = NULL;
+      writePos = 0;
+    }
+    readPos = 0;
+  }
+};
+
+/**
+ * \brief ReceiveBuffer variant that stores the stream in pooled segments
+ *
+ * Incoming data is copied once into the segments, a string is only created
+ * when a complete message is read with front().
+ */
+template <class T>
+class SegmentedReceiveBuffer {
+ public:
+  /**
+   * Push received data into the buffer
+   *
+   * \return false if we ran out of memory, the stream is broken in that case
+   */
+  bool push(const char *cstr, size_t length) {
+    while (length > 0) {
+      auto end = static_cast<const char *>(memchr(cstr, '\0', length));
+      size_t len = end ? end - cstr : length;
+      if (len > 0) {
+        if (!queue.append(cstr, len)) return false;
+        partial += len;
+      }
+      if (end) {
+        ++len;
+        // Skip empty messages
+        if (partial > 0) {
+          if (!queue.append("", 1)) return false;
+          ++messages;
+          partial = 0;
+        }
+      }
+      cstr += len;
+      length -= len;
+    }
+    return true;
+  }
+
+  /**
+   * Get the oldest message from the buffer
+   */
+  T front() {
+    T msg;
+    if (empty()) return msg;
+    auto length = queue.find('\0');
+    msg.reserve(length);
+    // Every piece ends either in the '\0' ending the message or at the end of
+    // a segment (followed by its spare '\0'), so it is a valid c string
+    queue.forEach(length, [this, &msg](const char *piece, size_t) {
+      stringAppend(msg, piece);
+    });
+    return msg;
+  }
+
+  /**
+   * Remove the oldest message from the buffer
+   */
+  void pop_front() {
+    if (empty()) return;
+    queue.consume(queue.find('\0') + 1);
+    --messages;
+  }
+
+  /**
+   * Is the buffer empty
+   */
+  bool empty() { return messages == 0; }
+
+  /**
+   * Clear the buffer
+   */
+  void clear() {
+    queue.clear();
+    messages = 0;
+    partial = 0;
+  }
+
+ private:
+  SegmentQueue queue;
+  size_t messages = 0;
+  size_t partial = 0;
+
+  inline void stringAppend(T &buffer, const char *cstr) { buffer.concat(cstr); }
+};
+
+#ifdef PAINLESSMESH_ENABLE_STD_STRING
+template <>
+inline void SegmentedReceiveBuffer<std::string>::stringAppend(
+    std::string &buffer, const char *cstr) {
+  buffer.append(cstr);
+}
+#endif
+
+/**
+ * \brief SentBuffer variant that stores the messages in pooled segments
+ *
+ * Messages are queued in N lanes, lane 0 being the most important. Lanes are
+ * served by deficit round robin: every turn a lane may send its weight times
+ * PAINLESSMESH_SEGMENT_SIZE bytes, a message is always finished before
+ * another lane gets its turn. A busy low priority lane therefore delays a
+ * higher priority message by at most one turn.
+ */
+template <class T, size_t N = PAINLESSMESH_PRIORITIES>
+class SegmentedSentBuffer {
+ public:
+  SegmentedSentBuffer() {
+    // Default weights: every lane gets four times the share of the next one
+    uint16_t weight = 1;
+    for (size_t i = N; i > 0; --i) {
+      lanes[i - 1].weight = weight;
+      weight *= 4;
+    }
+  }
+
+  /**
+   * Push a message into the buffer
+   *
+   * \param lane Lane to queue the message in, 0 has the highest priority
+   * \param dest Node the message is for, counted by size(lane, dest)
+   *
+   * \return false if we ran out of memory
+   */
+  bool push(const T &message, size_t lane = N - 1, uint32_t dest = 0) {
+    auto &l = lanes[std::min(lane, N - 1)];
+    if (!l.dests.append(reinterpret_cast<const char *>(&dest), sizeof(dest)))
+      return false;
+    // Include the '\0' that separates the messages on the wire
+    if (!l.queue.append(message.c_str(), message.length() + 1)) {
+      l.dests.truncate(sizeof(dest));
+      return false;
+    }
+    ++l.messages;
+    return true;
+  }
+
+  /**
+   * Contiguous data of the message that is being sent
+   *
+   * \param length Set to the number of bytes readable at the pointer, at most
+   * up to and including the '\0' ending the message
+   */
+  const char *peek(size_t &length) {
+    auto lane = current();
+    if (!lane) {
+      length = 0;
+      return NULL;
+    }
+    auto ptr = lane->queue.peek(length);
+    auto end = static_cast<const char *>(memchr(ptr, '\0', length));
+    if (end) length = end - ptr + 1;
+    return ptr;
+  }
+
+  /**
+   * Remove data that was handed to the network
+   *
+   * \param length Bytes to remove, at most the length returned by peek()
+   */
+  void consume(size_t length) {
+    auto lane = current();
+    if (!lane || length == 0) return;
+    size_t available;
+    auto ptr = lane->queue.peek(available);
+    auto finished = ptr[length - 1] == '\0';
+    lane->queue.consume(length);
+    lane->deficit -= length;
+    if (finished) {
+      --lane->messages;
+      lane->dests.consume(sizeof(uint32_t));
+      active = NULL;
+    } else {
+      active = lane;
+    }
+  }
+
+  /**
+   * Set the share of the link a lane gets, relative to the other lanes
+   *
+   * A weight of 0 is treated as 1, no lane is ever starved.
+   */
+  void setWeight(size_t lane, uint16_t weight) {
+    if (lane >= N) return;
+    lanes[lane].weight = std::max(weight, (uint16_t)1);
+  }
+
+  bool empty() { return size() == 0; }
+
+  void clear() {
+    for (auto &&lane : lanes) {
+      lane.queue.clear();
+      lane.dests.clear();
+      lane.messages = 0;
+      lane.deficit = 0;
+      lane.granted = false;
+    }
+    active = NULL;
+    turn = 0;
+  }
+
+  /**
+   * Number of queued messages
+   */
+  size_t size() {
+    size_t total = 0;
+    for (auto &&lane : lanes) total += lane.messages;
+    return total;
+  }
+
+  /**
+   * Number of messages queued in a lane
+   */
+  size_t size(size_t lane) {
+    if (lane >= N) return 0;
+    return lanes[lane].messages;
+  }
+
+  /**
+   * Number of messages queued in a lane for one destination
+   */
+  size_t size(size_t lane, uint32_t dest) {
+    if (lane >= N) return 0;
+    size_t count = 0;
+    auto &dests = lanes[lane].dests;
+    // The ids never straddle a segment, see the static_assert below
+    dests.forEach(dests.length(),
+                  [dest, &count](const char *piece, size_t len) {
+                    for (size_t i = 0; i + sizeof(uint32_t) <= len;
+                         i += sizeof(uint32_t)) {
+                      uint32_t id;
+                      memcpy(&id, piece + i, sizeof(id));
+                      if (id == dest) ++count;
+                    }
+                  });
+    return count;
+  }
+
+ private:
+  static_assert(PAINLESSMESH_SEGMENT_SIZE % sizeof(uint32_t) == 0,
+                "A segment must hold whole destination ids");
+
+  struct lane_t {
+    SegmentQueue queue;
+    SegmentQueue dests;  // Destination of every queued message, oldest first
+    size_t messages = 0;
+    uint16_t weight = 1;
+    int32_t deficit = 0;
+    bool granted = false;  // Quantum already added this turn
+  };
+
+  lane_t lanes[N];
+  lane_t *active = NULL;  // Lane with a partially sent message
+  size_t turn = 0;
+
+  lane_t *current() {
+    if (active) return active;
+    if (empty()) return NULL;
+    // Terminates: a waiting lane gains a quantum every turn until it may send
+    while (true) {
+      auto &lane = lanes[turn];
+      if (lane.messages > 0) {
+        if (lane.deficit > 0) return &lane;
+        if (!lane.granted) {
+          lane.deficit += (int32_t)lane.weight * PAINLESSMESH_SEGMENT_SIZE;
+          lane.granted = true;
+          continue;
+        }
+      } else {
+        // Idle lanes don't save up credit
+        lane.deficit = 0;
+      }
+      lane.granted = false;
+      turn = (turn + 1) % N;
+    }
+  }
+};
+
 }  // namespace buffer
 }  // namespace painlessmesh
 #endif
@@ -6,26 +6,44 @@
 
 #define _TASK_PRIORITY // Support for layered scheduling priority
 #define _TASK_STD_FUNCTION
+#define _TASK_HEAP_QUEUE // Only visit due tasks on update()
 
 #include "../../TaskScheduler/TaskSchedulerDeclarations.h"
 
 #define ARDUINOJSON_USE_LONG_LONG 1
+#ifdef PAINLESSMESH_BOOST
+#define ARDUINOJSON_ENABLE_STD_STRING 1
+#else
 #undef ARDUINOJSON_ENABLE_STD_STRING
+#endif
 // #include <ArduinoJson.h>
 #ifndef ARDUINOJSON_VERSION_MAJOR
 #include "../../ArduinoJson/ArduinoJson.h"
 #endif
+#ifdef PAINLESSMESH_BOOST
+#undef ARDUINOJSON_ENABLE_ARDUINO_STRING
+#else
 #undef ARDUINOJSON_ENABLE_STD_STRING
+#endif
 
+#ifndef PAINLESSMESH_BOOST
 // Enable (arduino) wifi support
 #define PAINLESSMESH_ENABLE_ARDUINO_WIFI
 
 // Enable OTA support
 #define PAINLESSMESH_ENABLE_OTA
+#endif
 
 #define NODE_TIMEOUT 5 * TASK_SECOND
 
-#ifdef ESP32
+// Largest pool routePackage() grows to for one package, 20 KB on the ESP.
+// Counted in slots, so a 64 bit host build takes the same packages.
+#define PAINLESSMESH_MAX_CAPACITY (1280 * JSON_OBJECT_SIZE(1))
+
+// With PAINLESSMESH_BOOST the asio stand-in below takes the place of the
+// AsyncTCP of the platform
+#if defined(PAINLESSMESH_BOOST)
+#elif defined(ESP32)
 #include <WiFi.h>
 // #include <AsyncTCP.h>
 #include "../../AsyncTCP/AsyncTCP.h"
@@ -35,7 +53,16 @@
 #include "../../ESPAsyncTCP/ESPAsyncTCP.h"
 #endif // ESP32
 
+// PAINLESSMESH_BOOST builds the mesh on a host, over the boost asio
+// stand-in for AsyncTCP, e.g. for the simulation in extras/mesh
+#ifdef PAINLESSMESH_BOOST
+#include "../boost/asynctcp.hpp"
+
+#define PAINLESSMESH_ENABLE_STD_STRING
+typedef std::string TSTRING;
+#else
 typedef String TSTRING;
+#endif
 
 // backward compatibility
 template <typename T>
@@ -47,8 +74,10 @@ class Mesh;
 };
 };  // namespace painlessmesh
 
+#ifdef PAINLESSMESH_ENABLE_ARDUINO_WIFI
 /** A convenience typedef to access the mesh class*/
 using painlessMesh = painlessmesh::wifi::Mesh;
+#endif
 
 #ifdef ESP32
 #define MAX_CONN 10
@@ -56,4 +85,13 @@ using painlessMesh = painlessmesh::wifi::Mesh;
 #define MAX_CONN 4
 #endif // DEBUG
 
+// Number of traffic classes (protocol::Priority), one send lane each
+#define PAINLESSMESH_PRIORITIES 3
+
+// Max unsent control messages per destination on a connection, newer ones
+// are refused
+#ifndef PAINLESSMESH_CONTROL_QUEUE
+#define PAINLESSMESH_CONTROL_QUEUE 10
+#endif
+
 #endif
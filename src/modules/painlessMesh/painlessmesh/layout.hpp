@@ -2,6 +2,8 @@
 #define _PAINLESS_MESH_LAYOUT_HPP_
 
 #include <list>
+#include <algorithm>
+#include <map>
 #include <memory>
 
 #include "protocol.hpp"
@@ -33,12 +35,87 @@ inline protocol::NodeTree excludeRoute(protocol::NodeTree&& tree,
   return tree;
 }
 
+/**
+ * FNV-1a step hashing the four bytes of value into h
+ */
+inline uint32_t hashCombine(uint32_t h, uint32_t value) {
+  for (auto i = 0; i < 4; ++i) {
+    h ^= (value >> (8 * i)) & 0xFF;
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+/**
+ * Start the hash of a node with the given number of subs
+ *
+ * The hash of each sub should then be added using hashCombine and the
+ * result passed through hashFinish.
+ */
+inline uint32_t hashStart(uint32_t nodeId, bool root, size_t noSubs) {
+  auto h = hashCombine(2166136261UL, nodeId);
+  h = hashCombine(h, root);
+  return hashCombine(h, noSubs);
+}
+
+inline uint32_t hashFinish(uint32_t h) { return h == 0 ? 1 : h; }
+
+/**
+ * Hash of a (sub)tree, never 0
+ *
+ * Stubs (subs with a hash but no subs) contribute their stored hash, so a
+ * delta encoded tree hashes to the same value as the full tree.
+ */
+inline uint32_t hash(const protocol::NodeTree& tree) {
+  if (tree.hash && tree.subs.empty()) return tree.hash;
+  auto h = hashStart(tree.nodeId, tree.root, tree.subs.size());
+  for (auto&& s : tree.subs) h = hashCombine(h, hash(s));
+  return hashFinish(h);
+}
+
+/**
+ * Packages and bytes exchanged over a connection
+ *
+ * Bytes include the '\0' separating the packages on the wire.
+ */
+struct Traffic {
+  uint32_t packagesSent = 0;
+  uint32_t bytesSent = 0;
+  uint32_t packagesReceived = 0;
+  uint32_t bytesReceived = 0;
+
+  Traffic& operator+=(const Traffic& b) {
+    packagesSent += b.packagesSent;
+    bytesSent += b.bytesSent;
+    packagesReceived += b.packagesReceived;
+    bytesReceived += b.bytesReceived;
+    return *this;
+  }
+};
+
 template <class T>
 class Layout {
  public:
   size_t stability = 0;
   std::list<std::shared_ptr<T> > subs;
 
+  /**
+   * Highest protocol::WireFormat this node offers to its neighbours
+   */
+  uint8_t wireFormat = protocol::WIRE_JSON;
+
+  /**
+   * Node time of the last change in our part of the layout
+   *
+   * Once all nodes report the same value the mesh has converged.
+   */
+  uint32_t layoutChangedAt = 0;
+
+  /**
+   * Traffic of the connections closed so far
+   */
+  Traffic closedTraffic;
+
   /** Return the nodeId of the node that we are running on.
    *
    * On the ESP hardware nodeId is uniquely calculated from the MAC address of
@@ -54,6 +131,65 @@ class Layout {
     return nt;
   }
 
+  /**
+   * Create a node sync package (request or reply) for a neighbour
+   *
+   * Avoids copying the layout: branches the neighbour already has, according
+   * to the hash it acknowledged last, are sent as stubs with only their
+   * nodeId and hash. Neighbours that never acknowledge a hash get the full
+   * tree.
+   */
+  template <class P>
+  P syncPackage(std::shared_ptr<T> conn) {
+    P pkg;
+    pkg.from = nodeId;
+    pkg.nodeId = nodeId;
+    pkg.dest = conn->nodeId;
+    pkg.root = root;
+    if (wireFormat > protocol::WIRE_JSON) pkg.wire = wireFormat;
+    if (conn->nodeId != 0) pkg.known = layout::hash(*conn);
+
+    auto delta = conn->peerKnown != 0 && conn->peerKnown == conn->sentHash;
+    std::map<uint32_t, uint32_t> sent;
+    size_t noSubs = 0;
+    for (auto&& s : subs)
+      if (s->nodeId != 0 && s->nodeId != conn->nodeId) ++noSubs;
+    auto h = hashStart(nodeId, root, noSubs);
+    for (auto&& s : subs) {
+      if (s->nodeId == 0 || s->nodeId == conn->nodeId) continue;
+      auto subHash = layout::hash(*s);
+      h = hashCombine(h, subHash);
+      sent[s->nodeId] = subHash;
+      auto prev = conn->sentBranches.find(s->nodeId);
+      if (delta && prev != conn->sentBranches.end() &&
+          prev->second == subHash) {
+        auto stub = protocol::NodeTree(s->nodeId, false);
+        stub.hash = subHash;
+        pkg.subs.push_back(stub);
+      } else {
+        pkg.subs.push_back(protocol::NodeTree(*s));
+      }
+    }
+    pkg.hash = hashFinish(h);
+
+    conn->sentHash = pkg.hash;
+    conn->sentBranches = std::move(sent);
+    return pkg;
+  }
+
+  /**
+   * Traffic of this node since it started
+   *
+   * A closed connection folds its counters into closedTraffic, so only the
+   * open ones are summed here.
+   */
+  Traffic traffic() {
+    Traffic total = closedTraffic;
+    for (auto&& s : subs)
+      if (s->connected) total += s->traffic;
+    return total;
+  }
+
  protected:
   uint32_t nodeId = 0;
   bool root = false;
@@ -77,6 +213,65 @@ class Neighbour : public protocol::NodeTree {
   // Inherit constructors
   using protocol::NodeTree::NodeTree;
 
+  /**
+   * protocol::WireFormat agreed upon with this neighbour
+   */
+  uint8_t wireFormat = protocol::WIRE_JSON;
+
+  /**
+   * Traffic exchanged with this neighbour
+   */
+  Traffic traffic;
+
+  /**
+   * Hash of the tree the neighbour reports to hold of us
+   */
+  uint32_t peerKnown = 0;
+
+  /**
+   * Hash of the last tree we sent, and of each of its branches by nodeId
+   */
+  uint32_t sentHash = 0;
+  std::map<uint32_t, uint32_t> sentBranches;
+
+  /**
+   * Whether the tree is the one we already hold, without looking at its subs
+   */
+  bool unchanged(const protocol::NodeTree& tree) {
+    return tree.hash != 0 && nodeId != 0 && nodeId == tree.nodeId &&
+           tree.hash == layout::hash(*this);
+  }
+
+  /**
+   * Replace the stubs in the tree with the branches we hold
+   *
+   * \return false if a stub refers to a branch we don't know (anymore), in
+   * which case the tree can't be used and a full sync is needed
+   */
+  bool resolveSubs(protocol::NodeTree& tree) {
+    for (auto&& s : tree.subs) {
+      if (s.hash == 0 || !s.subs.empty()) continue;
+      auto known = std::find_if(
+          subs.begin(), subs.end(),
+          [&s](const protocol::NodeTree& b) { return b.nodeId == s.nodeId; });
+      if (known == subs.end() || layout::hash(*known) != s.hash) return false;
+      s = (*known);
+    }
+    tree.hash = 0;
+    return true;
+  }
+
+  /**
+   * Agree on a wire format from the one advertised in a node sync
+   *
+   * \param local The highest format we support
+   * \param remote The format advertised by the neighbour (0 if none)
+   */
+  void negotiateWire(uint8_t local, uint8_t remote) {
+    if (remote < protocol::WIRE_JSON) remote = protocol::WIRE_JSON;
+    wireFormat = std::min(local, remote);
+  }
+
   /**
    * Is the passed nodesync valid
    *
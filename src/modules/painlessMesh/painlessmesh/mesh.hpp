@@ -87,6 +87,41 @@ class Mesh : public ntp::MeshTime, public plugin::PackageHandler<T> {
    */
   bool isRoot() { return this->root; };
 
+  /**
+   * Offer a more compact wire format to the neighbours
+   *
+   * With protocol::WIRE_MSGPACK packages are exchanged as MessagePack with
+   * every neighbour that supports it, other neighbours keep using json. The
+   * format is agreed during the next node sync with each neighbour.
+   */
+  void setWireFormat(protocol::WireFormat format) {
+    this->wireFormat = format;
+  };
+
+  /**
+   * Set the share of each link a traffic class gets
+   *
+   * Every connection serves its classes by weighted round robin, a class
+   * gets weight times 128 bytes each turn. The defaults are 16 for
+   * protocol::PRIORITY_CONTROL, 4 for PRIORITY_SYNC and 1 for
+   * PRIORITY_TELEMETRY.
+   */
+  void setPriorityWeight(protocol::Priority priority, uint16_t weight) {
+    if (priority >= PAINLESSMESH_PRIORITIES) return;
+    priorityWeights[priority] = weight;
+    for (auto &&conn : this->subs) conn->sentBuffer.setWeight(priority, weight);
+  }
+
+  /**
+   * Number of messages of a traffic class waiting to be sent, summed over
+   * all connections
+   */
+  size_t queueDepth(protocol::Priority priority) {
+    size_t depth = 0;
+    for (auto &&conn : this->subs) depth += conn->sentBuffer.size(priority);
+    return depth;
+  }
+
   void setDebugMsgTypes(uint16_t types) { Log.setLogLevel(types); }
 
   /**
@@ -116,17 +151,35 @@ class Mesh : public ntp::MeshTime, public plugin::PackageHandler<T> {
     return;
   }
 
+  /** Time until update() has maintenance work to do
+   *
+   * The loop can sleep this long when nothing else needs it.
+   *
+   * @return milliseconds until the next task is due, -1 if no task is enabled
+   */
+  long timeUntilNextTask(void) {
+    long wait = 0;
+    if (semaphoreTake()) {
+      wait = mScheduler->timeUntilNextTask();
+      semaphoreGive();
+    }
+    return wait;
+  }
+
   /** Send message to a specific node
    *
    * @param destId The nodeId of the node to send it to.
    * @param msg The message to send
+   * @param priority Traffic class of the message, relaying nodes keep it
    *
    * @return true if everything works, false if not.
    */
-  bool sendSingle(uint32_t destId, TSTRING msg) {
+  bool sendSingle(uint32_t destId, TSTRING msg,
+                  protocol::Priority priority = protocol::PRIORITY_TELEMETRY) {
     Log(logger::COMMUNICATION, "sendSingle(): dest=%u msg=%s\n", destId,
         msg.c_str());
-    auto single = painlessmesh::protocol::Single(this->nodeId, destId, msg);
+    auto single =
+        painlessmesh::protocol::Single(this->nodeId, destId, msg, priority);
     return painlessmesh::router::send<T>(single, (*this));
   }
 
@@ -333,7 +386,7 @@ class Mesh : public ntp::MeshTime, public plugin::PackageHandler<T> {
       Log(S_TIME, "startTimeSync(): Requesting %u to adopt our time\n",
           conn->nodeId);
     }
-    router::send<protocol::TimeSync, T>(timeSync, conn, true);
+    router::send<protocol::TimeSync, T>(timeSync, conn);
   }
 
   bool closeConnectionSTA() {
@@ -371,6 +424,9 @@ class Mesh : public ntp::MeshTime, public plugin::PackageHandler<T> {
   /// Is the node a root node
   bool shouldContainRoot;
 
+  /// Weights set with setPriorityWeight(), 0 keeps the buffer default
+  uint16_t priorityWeights[PAINLESSMESH_PRIORITIES] = {};
+
   Scheduler *mScheduler;
 
   /**
@@ -90,7 +90,7 @@ void initTimeSync(protocol::NodeTree mesh, std::shared_ptr<T> connection,
         connection->nodeId);
   }
 
-  router::send<protocol::TimeSync, T>(timeSync, connection, true);
+  router::send<protocol::TimeSync, T>(timeSync, connection);
 }
 
 template <class T, class U>
@@ -110,12 +110,12 @@ void handleTimeSync(T& mesh, painlessmesh::protocol::TimeSync timeSync,
           "node: %u\n",
           conn->nodeId);
       timeSync.reply(mesh.getNodeTime());
-      router::send<painlessmesh::protocol::TimeSync>(timeSync, conn, true);
+      router::send<painlessmesh::protocol::TimeSync>(timeSync, conn);
       break;
 
     case (painlessmesh::protocol::TIME_REQUEST):
       timeSync.reply(receivedAt, mesh.getNodeTime());
-      router::send<painlessmesh::protocol::TimeSync>(timeSync, conn, true);
+      router::send<painlessmesh::protocol::TimeSync>(timeSync, conn);
 
       Log(logger::S_TIME,
           "handleTimeSync(): timeSyncStatus with %u completed\n", conn->nodeId);
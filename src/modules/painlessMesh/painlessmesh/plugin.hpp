@@ -165,7 +165,10 @@ class PackageHandler : public layout::Layout<T> {
 
     std::shared_ptr<Task> task =
         std::make_shared<Task>(aInterval, aIterations, aCallback);
-    scheduler.addTask((*task));
+    if (!scheduler.addTask((*task))) {
+      Log(ERROR, "addTask(): Out of memory, task not scheduled\n");
+      return task;
+    }
     task->enable();
     taskList.push_front(task);
     return task;
@@ -36,6 +36,37 @@ enum Type {
   SINGLE = 9      // application data for a single node
 };
 
+/**
+ * Wire formats a node can speak
+ *
+ * The format is negotiated per connection during node sync: a node advertises
+ * the highest format it supports and both sides use the lowest of the two.
+ * Nodes that don't advertise anything only understand WIRE_JSON.
+ */
+enum WireFormat { WIRE_JSON = 1, WIRE_MSGPACK = 2 };
+
+/**
+ * First byte of a MessagePack encoded package.
+ *
+ * 0xC1 is never used by MessagePack and can not start a json string, so it
+ * safely tells both formats apart.
+ */
+#define PAINLESSMESH_MSGPACK_MARKER 0xC1
+
+/**
+ * Traffic classes, each connection queues them in their own lane
+ *
+ * Lanes are served by weighted round robin, so a class with a higher weight
+ * gets a bigger share of the link but no class is starved. Node and time
+ * sync packages are classed as PRIORITY_SYNC, application data defaults to
+ * PRIORITY_TELEMETRY. PAINLESSMESH_PRIORITIES holds the number of classes.
+ */
+enum Priority {
+  PRIORITY_CONTROL = 0,
+  PRIORITY_SYNC = 1,
+  PRIORITY_TELEMETRY = 2
+};
+
 enum TimeType {
   TIME_SYNC_ERROR = -1,
   TIME_SYNC_REQUEST,
@@ -60,18 +91,25 @@ class Single : public PackageInterface {
   uint32_t from;
   uint32_t dest;
   TSTRING msg = "";
+  /**
+   * Traffic class, kept in the package so relaying nodes queue it the same way
+   */
+  uint8_t priority = PRIORITY_TELEMETRY;
 
   Single() {}
-  Single(uint32_t fromID, uint32_t destID, TSTRING& message) {
+  Single(uint32_t fromID, uint32_t destID, TSTRING& message,
+         uint8_t prio = PRIORITY_TELEMETRY) {
     from = fromID;
     dest = destID;
     msg = message;
+    priority = prio;
   }
 
   Single(JsonObject jsonObj) {
     dest = jsonObj["dest"].as<uint32_t>();
     from = jsonObj["from"].as<uint32_t>();
     msg = jsonObj["msg"].as<TSTRING>();
+    if (jsonObj.containsKey("prio")) priority = jsonObj["prio"].as<uint8_t>();
   }
 
   JsonObject addTo(JsonObject&& jsonObj) const {
@@ -79,11 +117,12 @@ class Single : public PackageInterface {
     jsonObj["dest"] = dest;
     jsonObj["from"] = from;
     jsonObj["msg"] = msg;
+    if (priority != PRIORITY_TELEMETRY) jsonObj["prio"] = priority;
     return jsonObj;
   }
 
   size_t jsonObjectSize() const {
-    return JSON_OBJECT_SIZE(4) + round(1.1 * msg.length());
+    return JSON_OBJECT_SIZE(5) + round(1.1 * msg.length());
   }
 };
 
@@ -103,7 +142,7 @@ class Broadcast : public Single {
   }
 
   size_t jsonObjectSize() const {
-    return JSON_OBJECT_SIZE(4) + round(1.1 * msg.length());
+    return JSON_OBJECT_SIZE(5) + round(1.1 * msg.length());
   }
 };
 
@@ -112,6 +151,13 @@ class NodeTree : public PackageInterface {
   uint32_t nodeId = 0;
   bool root = false;
   std::list<NodeTree> subs;
+  /**
+   * Hash of the tree, 0 if not known
+   *
+   * In node sync packages a sub with a hash and without subs is a stub,
+   * standing in for the branch the receiver already knows.
+   */
+  uint32_t hash = 0;
 
   NodeTree() {}
 
@@ -127,6 +173,8 @@ class NodeTree : public PackageInterface {
     else
       nodeId = jsonObj["from"].as<uint32_t>();
 
+    if (jsonObj.containsKey("hash")) hash = jsonObj["hash"].as<uint32_t>();
+
     if (jsonObj.containsKey("subs")) {
       auto jsonArr = jsonObj["subs"].as<JsonArray>();
       for (size_t i = 0; i < jsonArr.size(); ++i) {
@@ -138,6 +186,7 @@ class NodeTree : public PackageInterface {
   JsonObject addTo(JsonObject&& jsonObj) const {
     jsonObj["nodeId"] = nodeId;
     if (root) jsonObj["root"] = root;
+    if (hash) jsonObj["hash"] = hash;
     if (subs.size() > 0) {
       JsonArray subsArr = jsonObj.createNestedArray("subs");
       for (auto&& s : subs) {
@@ -171,6 +220,7 @@ class NodeTree : public PackageInterface {
   size_t jsonObjectSize() const {
     size_t base = 1;
     if (root) ++base;
+    if (hash) ++base;
     if (subs.size() > 0) ++base;
     size_t size = JSON_OBJECT_SIZE(base);
     if (subs.size() > 0) size += JSON_ARRAY_SIZE(subs.size());
@@ -182,6 +232,7 @@ class NodeTree : public PackageInterface {
     nodeId = 0;
     subs.clear();
     root = false;
+    hash = 0;
   }
 };
 
@@ -193,6 +244,8 @@ class NodeSyncRequest : public NodeTree {
   int type = NODE_SYNC_REQUEST;
   uint32_t from;
   uint32_t dest;
+  uint8_t wire = 0;  // Advertised WireFormat, 0 if not advertised
+  uint32_t known = 0;  // Hash of the tree we hold of dest, 0 if none
 
   NodeSyncRequest() {}
   NodeSyncRequest(uint32_t fromID, uint32_t destID, std::list<NodeTree> subTree,
@@ -207,6 +260,8 @@ class NodeSyncRequest : public NodeTree {
   NodeSyncRequest(JsonObject jsonObj) : NodeTree(jsonObj) {
     dest = jsonObj["dest"].as<uint32_t>();
     from = jsonObj["from"].as<uint32_t>();
+    if (jsonObj.containsKey("wire")) wire = jsonObj["wire"].as<uint8_t>();
+    if (jsonObj.containsKey("known")) known = jsonObj["known"].as<uint32_t>();
   }
 
   JsonObject addTo(JsonObject&& jsonObj) const {
@@ -214,6 +269,8 @@ class NodeSyncRequest : public NodeTree {
     jsonObj["type"] = type;
     jsonObj["dest"] = dest;
     jsonObj["from"] = from;
+    if (wire > 0) jsonObj["wire"] = wire;
+    if (known) jsonObj["known"] = known;
     return jsonObj;
   }
 
@@ -229,6 +286,9 @@ class NodeSyncRequest : public NodeTree {
   size_t jsonObjectSize() const {
     size_t base = 4;
     if (root) ++base;
+    if (wire > 0) ++base;
+    if (hash) ++base;
+    if (known) ++base;
     if (subs.size() > 0) ++base;
     size_t size = JSON_OBJECT_SIZE(base);
     if (subs.size() > 0) size += JSON_ARRAY_SIZE(subs.size());
@@ -368,6 +428,64 @@ class TimeDelay : public TimeSync {
   }
 };
 
+namespace wire {
+/**
+ * Encode a binary buffer with Consistent Overhead Byte Stuffing
+ *
+ * The result contains no '\0' bytes, so it can travel through the '\0'
+ * separated mesh buffers unchanged. Overhead is at most one byte per 254.
+ *
+ * @param out Buffer of at least cobsMaxSize(length) bytes
+ * @return Number of bytes written
+ */
+inline size_t cobsEncode(const uint8_t* data, size_t length, uint8_t* out) {
+  size_t write = 1;
+  size_t code_pos = 0;
+  uint8_t code = 1;
+  for (size_t i = 0; i < length; ++i) {
+    if (data[i] == 0) {
+      out[code_pos] = code;
+      code_pos = write++;
+      code = 1;
+    } else {
+      out[write++] = data[i];
+      if (++code == 0xFF) {
+        out[code_pos] = code;
+        code_pos = write++;
+        code = 1;
+      }
+    }
+  }
+  out[code_pos] = code;
+  return write;
+}
+
+/**
+ * Decode a Consistent Overhead Byte Stuffing buffer
+ *
+ * Decoding can be done in place (out == data).
+ *
+ * @return Number of decoded bytes, 0 on malformed input
+ */
+inline size_t cobsDecode(const uint8_t* data, size_t length, uint8_t* out) {
+  size_t read = 0;
+  size_t write = 0;
+  while (read < length) {
+    uint8_t code = data[read];
+    if (code == 0 || read + code > length + 1) return 0;
+    ++read;
+    for (uint8_t i = 1; i < code; ++i) out[write++] = data[read++];
+    if (code < 0xFF && read < length) out[write++] = 0;
+  }
+  return write;
+}
+
+/**
+ * Upper bound of the encoded size of length bytes
+ */
+inline size_t cobsMaxSize(size_t length) { return length + length / 254 + 1; }
+}  // namespace wire
+
 /**
  * Can store any package variant
  *
@@ -380,14 +498,15 @@ class Variant {
   /**
    * Create Variant object from a json string
    *
+   * Strings starting with PAINLESSMESH_MSGPACK_MARKER are decoded as
+   * MessagePack instead.
+   *
    * @param json The json string containing a package
    */
   Variant(std::string json)
       : jsonBuffer(JSON_OBJECT_SIZE(5) + JSON_OBJECT_SIZE(4) +
                    2 * json.length()) {
-    error = deserializeJson(jsonBuffer, json,
-                            DeserializationOption::NestingLimit(255));
-    if (!error) jsonObj = jsonBuffer.as<JsonObject>();
+    deserialize(json.c_str(), json.length());
   }
 
   /**
@@ -397,9 +516,7 @@ class Variant {
    * @param capacity The capacity to reserve for parsing the string
    */
   Variant(std::string json, size_t capacity) : jsonBuffer(capacity) {
-    error = deserializeJson(jsonBuffer, json,
-                            DeserializationOption::NestingLimit(255));
-    if (!error) jsonObj = jsonBuffer.as<JsonObject>();
+    deserialize(json.c_str(), json.length());
   }
 #endif
 
@@ -407,14 +524,15 @@ class Variant {
   /**
    * Create Variant object from a json string
    *
+   * Strings starting with PAINLESSMESH_MSGPACK_MARKER are decoded as
+   * MessagePack instead.
+   *
    * @param json The json string containing a package
    */
   Variant(String json)
       : jsonBuffer(JSON_OBJECT_SIZE(5) + JSON_OBJECT_SIZE(4) +
                    2 * json.length()) {
-    error = deserializeJson(jsonBuffer, json,
-                            DeserializationOption::NestingLimit(255));
-    if (!error) jsonObj = jsonBuffer.as<JsonObject>();
+    deserialize(json.c_str(), json.length());
   }
 
   /**
@@ -424,9 +542,7 @@ class Variant {
    * @param capacity The capacity to reserve for parsing the string
    */
   Variant(String json, size_t capacity) : jsonBuffer(capacity) {
-    error = deserializeJson(jsonBuffer, json,
-                            DeserializationOption::NestingLimit(255));
-    if (!error) jsonObj = jsonBuffer.as<JsonObject>();
+    deserialize(json.c_str(), json.length());
   }
 #endif
   /**
@@ -546,6 +662,22 @@ class Variant {
     return router::ROUTING_ERROR;
   }
 
+  /**
+   * Traffic class of the package
+   */
+  uint8_t priority() {
+    if (jsonObj.containsKey("prio")) {
+      auto prio = jsonObj["prio"].as<uint8_t>();
+      if (prio < PAINLESSMESH_PRIORITIES) return prio;
+    }
+
+    auto type = this->type();
+    if (type == NODE_SYNC_REQUEST || type == NODE_SYNC_REPLY ||
+        type == TIME_SYNC || type == TIME_DELAY)
+      return PRIORITY_SYNC;
+    return PRIORITY_TELEMETRY;
+  }
+
   /**
    * Destination node of the package
    */
@@ -582,11 +714,54 @@ class Variant {
   }
 #endif
 
+  /**
+   * Print a variant to a string in the WIRE_MSGPACK format
+   *
+   * The package is serialized as MessagePack and stuffed (COBS) so that it
+   * contains no '\0' bytes, prefixed with PAINLESSMESH_MSGPACK_MARKER.
+   */
+  template <typename S>
+  void printMsgPackTo(S& str) {
+    auto size = measureMsgPack(jsonObj);
+    auto encodedSize = wire::cobsMaxSize(size);
+    auto raw = new uint8_t[size + encodedSize + 2];
+    auto encoded = raw + size;
+    // ArduinoJson keeps one byte for the null terminator, which is
+    // overwritten by the marker below
+    serializeMsgPack(jsonObj, reinterpret_cast<char*>(raw), size + 1);
+    encoded[0] = PAINLESSMESH_MSGPACK_MARKER;
+    auto length = wire::cobsEncode(raw, size, encoded + 1);
+    encoded[length + 1] = '\0';
+    str = reinterpret_cast<char*>(encoded);
+    delete[] raw;
+  }
+
   DeserializationError error = DeserializationError::Ok;
 
  private:
   DynamicJsonDocument jsonBuffer;
   JsonObject jsonObj;
+
+  void deserialize(const char* data, size_t length) {
+    if (length > 0 &&
+        static_cast<uint8_t>(data[0]) == PAINLESSMESH_MSGPACK_MARKER) {
+      auto raw = new uint8_t[length];
+      auto size = wire::cobsDecode(
+          reinterpret_cast<const uint8_t*>(data) + 1, length - 1, raw);
+      if (size == 0)
+        error = DeserializationError::InvalidInput;
+      else
+        // Passing a const pointer makes ArduinoJson copy the strings, so the
+        // temporary buffer can be released straight away
+        error = deserializeMsgPack(jsonBuffer, (const uint8_t*)raw, size,
+                                   DeserializationOption::NestingLimit(255));
+      delete[] raw;
+    } else {
+      error = deserializeJson(jsonBuffer, data, length,
+                              DeserializationOption::NestingLimit(255));
+    }
+    if (!error) jsonObj = jsonBuffer.as<JsonObject>();
+  }
 };
 
 template <>
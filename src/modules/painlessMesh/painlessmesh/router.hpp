@@ -70,71 +70,89 @@ std::shared_ptr<T> findRoute(layout::Layout<T> tree, uint32_t nodeId) {
   });
 }
 
-template <class T, class U>
-bool send(T package, std::shared_ptr<U> conn, bool priority = false) {
-  auto variant = painlessmesh::protocol::Variant(package);
+/**
+ * Serialize a package in the wire format agreed with the connection
+ */
+template <class U>
+TSTRING serialize(protocol::Variant& variant, std::shared_ptr<U> conn) {
   TSTRING msg;
-  variant.printTo(msg);
-  return conn->addMessage(msg, priority);
+  if (conn->wireFormat >= protocol::WIRE_MSGPACK)
+    variant.printMsgPackTo(msg);
+  else
+    variant.printTo(msg);
+  return msg;
 }
 
+/**
+ * Queue a serialized package on the connection and account for it
+ *
+ * \param priority Traffic class (protocol::Priority) of the package
+ * \param dest Node the package is for, 0 for a broadcast
+ */
 template <class U>
-bool send(protocol::Variant variant, std::shared_ptr<U> conn,
-          bool priority = false) {
-  TSTRING msg;
-  variant.printTo(msg);
-  return conn->addMessage(msg, priority);
+bool queue(std::shared_ptr<U> conn, TSTRING& msg, uint8_t priority,
+           uint32_t dest) {
+  if (!conn->addMessage(msg, priority, dest)) return false;
+  ++conn->traffic.packagesSent;
+  conn->traffic.bytesSent += msg.length() + 1;
+  return true;
 }
 
 template <class T, class U>
-bool send(T package, layout::Layout<U> layout) {
+bool send(T package, std::shared_ptr<U> conn) {
   auto variant = painlessmesh::protocol::Variant(package);
-  TSTRING msg;
-  variant.printTo(msg);
-  auto conn = findRoute<U>(layout, variant.dest);
-  if (conn) return conn->addMessage(msg);
-  return false;
+  TSTRING msg = serialize<U>(variant, conn);
+  return queue<U>(conn, msg, variant.priority(), variant.dest());
 }
 
 template <class U>
-bool send(protocol::Variant variant, layout::Layout<U> layout) {
-  TSTRING msg;
-  variant.printTo(msg);
-  auto conn = findRoute<U>(layout, variant.dest());
-  if (conn) return conn->addMessage(msg);
-  return false;
+bool send(protocol::Variant variant, std::shared_ptr<U> conn) {
+  TSTRING msg = serialize<U>(variant, conn);
+  return queue<U>(conn, msg, variant.priority(), variant.dest());
 }
 
 template <class T, class U>
-size_t broadcast(T package, layout::Layout<U> layout, uint32_t exclude) {
+bool send(T package, layout::Layout<U> layout) {
   auto variant = painlessmesh::protocol::Variant(package);
-  TSTRING msg;
-  variant.printTo(msg);
-  size_t i = 0;
-  for (auto&& conn : layout.subs) {
-    if (conn->nodeId != 0 && conn->nodeId != exclude) {
-      auto sent = conn->addMessage(msg);
-      if (sent) ++i;
-    }
-  }
-  return i;
+  auto conn = findRoute<U>(layout, variant.dest());
+  if (!conn) return false;
+  TSTRING msg = serialize<U>(variant, conn);
+  return queue<U>(conn, msg, variant.priority(), variant.dest());
+}
+
+template <class U>
+bool send(protocol::Variant variant, layout::Layout<U> layout) {
+  auto conn = findRoute<U>(layout, variant.dest());
+  if (!conn) return false;
+  TSTRING msg = serialize<U>(variant, conn);
+  return queue<U>(conn, msg, variant.priority(), variant.dest());
 }
 
 template <class T>
 size_t broadcast(protocol::Variant variant, layout::Layout<T> layout,
                  uint32_t exclude) {
-  TSTRING msg;
-  variant.printTo(msg);
+  // Serialize lazily, at most once per wire format
+  TSTRING json, msgpack;
+  auto priority = variant.priority();
   size_t i = 0;
   for (auto&& conn : layout.subs) {
     if (conn->nodeId != 0 && conn->nodeId != exclude) {
-      auto sent = conn->addMessage(msg);
+      auto& msg =
+          (conn->wireFormat >= protocol::WIRE_MSGPACK) ? msgpack : json;
+      if (msg.length() == 0) msg = serialize<T>(variant, conn);
+      auto sent = queue<T>(conn, msg, priority, 0);
       if (sent) ++i;
     }
   }
   return i;
 }
 
+template <class T, class U>
+size_t broadcast(T package, layout::Layout<U> layout, uint32_t exclude) {
+  auto variant = painlessmesh::protocol::Variant(package);
+  return broadcast<U>(variant, layout, exclude);
+}
+
 template <class T>
 void routePackage(layout::Layout<T> layout, std::shared_ptr<T> connection,
                   TSTRING pkg, MeshCallbackList<T> cbl, uint32_t receivedAt) {
@@ -142,11 +160,14 @@ void routePackage(layout::Layout<T> layout, std::shared_ptr<T> connection,
   static size_t baseCapacity = 512;
   Log(COMMUNICATION, "routePackage(): Recvd from %u: %s\n", connection->nodeId,
       pkg.c_str());
+  ++connection->traffic.packagesReceived;
+  connection->traffic.bytesReceived += pkg.length() + 1;
   // Using a ptr so we can overwrite it if we need to grow capacity.
   // Bug in copy constructor with grown capacity can cause segmentation fault
   auto variant =
       std::make_shared<protocol::Variant>(pkg, pkg.length() + baseCapacity);
-  while (variant->error == 3 && baseCapacity <= 20480) {
+  while (variant->error == 3 &&
+         baseCapacity <= PAINLESSMESH_MAX_CAPACITY) {
     // Not enough memory, adapt scaling (variant::capacityScaling) and log the
     // new value
     Log(DEBUG,
@@ -216,7 +237,10 @@ void handleNodeSync(T& mesh, protocol::NodeTree newTree,
       Log(logger::S_TIME, "timeSyncTask(): %u\n", conn->nodeId);
       mesh.startTimeSync(conn);
     });
-    mesh.mScheduler->addTask(conn->timeSyncTask);
+    if (!mesh.mScheduler->addTask(conn->timeSyncTask))
+      Log(logger::ERROR,
+          "handleNodeSync(): Out of memory, no time sync with %u\n",
+          conn->nodeId);
     if (conn->station)
       // We are STA, request time immediately
       conn->timeSyncTask.enable();
@@ -227,6 +251,7 @@ void handleNodeSync(T& mesh, protocol::NodeTree newTree,
   }
 
   if (conn->updateSubs(newTree)) {
+    mesh.layoutChangedAt = mesh.getNodeTime();
     if (mesh.changedConnectionsCallback) mesh.changedConnectionsCallback();
     layout::syncLayout(mesh, conn->nodeId);
   } else {
@@ -235,6 +260,30 @@ void handleNodeSync(T& mesh, protocol::NodeTree newTree,
   }
 }
 
+/**
+ * Handle a node sync package that might be delta encoded
+ *
+ * Unchanged trees are recognised by their hash alone, stubs are replaced by
+ * the branches we hold. If a stub can't be resolved we sync again, our next
+ * package tells the neighbour which tree we hold so it sends it in full.
+ */
+template <class T, class U>
+void handleNodeSyncPackage(T& mesh, protocol::NodeSyncRequest& newTree,
+                           std::shared_ptr<U> conn) {
+  conn->peerKnown = newTree.known;
+  if (!conn->newConnection && conn->unchanged(newTree)) {
+    Log(logger::SYNC, "handleNodeSync(): %u unchanged\n", conn->nodeId);
+    conn->nodeSyncTask.delay();
+    mesh.stability += std::min(1000 - mesh.stability, (size_t)25);
+  } else if (conn->resolveSubs(newTree)) {
+    handleNodeSync<T, U>(mesh, newTree, conn);
+  } else {
+    Log(logger::SYNC, "handleNodeSync(): unknown branch from %u\n",
+        conn->nodeId);
+    conn->nodeSyncTask.forceNextIteration();
+  }
+}
+
 template <class T, typename U>
 router::MeshCallbackList<U> addPackageCallback(
     router::MeshCallbackList<U>&& callbackList, T& mesh) {
@@ -244,9 +293,13 @@ router::MeshCallbackList<U> addPackageCallback(
       [&mesh](protocol::Variant variant, std::shared_ptr<U> connection,
               uint32_t receivedAt) {
         auto newTree = variant.to<protocol::NodeSyncRequest>();
-        handleNodeSync<T, U>(mesh, newTree, connection);
+        handleNodeSyncPackage<T, U>(mesh, newTree, connection);
+        // Reply in the old format, the requester only switches after reading
+        // our advertisement
         send<protocol::NodeSyncReply>(
-            connection->reply(std::move(mesh.asNodeTree())), connection, true);
+            mesh.template syncPackage<protocol::NodeSyncReply>(connection),
+            connection);
+        connection->negotiateWire(mesh.wireFormat, newTree.wire);
         return false;
       });
 
@@ -256,7 +309,8 @@ router::MeshCallbackList<U> addPackageCallback(
       [&mesh](protocol::Variant variant, std::shared_ptr<U> connection,
               uint32_t receivedAt) {
         auto newTree = variant.to<protocol::NodeSyncReply>();
-        handleNodeSync<T, U>(mesh, newTree, connection);
+        handleNodeSyncPackage<T, U>(mesh, newTree, connection);
+        connection->negotiateWire(mesh.wireFormat, newTree.wire);
         connection->timeOutTask.disable();
         return false;
       });